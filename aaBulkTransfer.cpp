@@ -0,0 +1,274 @@
+#include "aaBulkTransfer.hpp"
+#include "esp_log.h"
+#include <cstring>
+#include <utility>
+
+static const char* TAG = "AA_BULK";
+
+/***********************************************************/
+/* AaBulkTransfer class definition                         */
+/***********************************************************/
+
+AaBulkTransfer::AaBulkTransfer(UniqueIdentifier const controllerID, AecpSendHandler sendHandler, size_t const window, std::chrono::milliseconds const timeout, uint32_t const maxRetries) noexcept
+    : _controllerID(controllerID), _sendHandler(std::move(sendHandler)), _window(std::clamp<size_t>(window, 1u, MaxWindow)), _timeout(timeout), _maxRetries(maxRetries)
+{
+}
+
+void AaBulkTransfer::setCompletedHandler(CompletedHandler handler) noexcept
+{
+    _completedHandler = std::move(handler);
+}
+
+void AaBulkTransfer::setPayloadNegotiator(AecpPayloadNegotiator* negotiator) noexcept
+{
+    _negotiator = negotiator;
+}
+
+void AaBulkTransfer::setTimeoutHandler(AecpTimeoutHandler handler) noexcept
+{
+    _timeoutHandler = std::move(handler);
+}
+
+bool AaBulkTransfer::read(UniqueIdentifier const targetEntityID, MacAddress const& targetAddress, uint64_t const address, uint8_t* destination, size_t const length, AecpClock::time_point const now)
+{
+    if (destination == nullptr)
+    {
+        ESP_LOGE(TAG, "No destination buffer");
+        return false;
+    }
+    _destination = destination;
+    _source = nullptr;
+    return start(AaMode::READ, targetEntityID, targetAddress, address, length, now);
+}
+
+bool AaBulkTransfer::write(UniqueIdentifier const targetEntityID, MacAddress const& targetAddress, uint64_t const address, const uint8_t* source, size_t const length, AecpClock::time_point const now)
+{
+    if (source == nullptr)
+    {
+        ESP_LOGE(TAG, "No source buffer");
+        return false;
+    }
+    _destination = nullptr;
+    _source = source;
+    return start(AaMode::WRITE, targetEntityID, targetAddress, address, length, now);
+}
+
+void AaBulkTransfer::abort() noexcept
+{
+    _running = false;
+    for (auto& slot : _slots)
+    {
+        slot.inUse = false;
+    }
+}
+
+bool AaBulkTransfer::handleAecpdu(Aecpdu const& aecpdu, AecpClock::time_point const now)
+{
+    if (!_running || aecpdu.getMessageType() != AecpMessageType::ADDRESS_ACCESS_RESPONSE || aecpdu.getControllerEntityID() != _controllerID || aecpdu.getTargetEntityID() != _targetEntityID)
+    {
+        return false;
+    }
+
+    auto const it = std::find_if(_slots.begin(), _slots.end(), [&aecpdu](Slot const& slot)
+    {
+        return slot.inUse && slot.message.getSequenceID() == aecpdu.getSequenceID();
+    });
+    if (it == _slots.end())
+    {
+        return false;
+    }
+    // A big response from a target not allowed to send them is dropped, and the command resent on timeout
+    if (_negotiator != nullptr && !_negotiator->onAecpduReceived(_targetEntityID, static_cast<AaAecpdu const&>(aecpdu).getLength()))
+    {
+        return false;
+    }
+    auto& slot = *it;
+
+    auto const status = static_cast<AaCommandStatus>(aecpdu.getStatus());
+    if (status != AaCommandStatus::Success)
+    {
+        ESP_LOGE(TAG, "AA command refused at 0x%llx with status %u", static_cast<unsigned long long>(_address + slot.chunk * _chunkSize), static_cast<unsigned>(status));
+        complete(status, now);
+        return true;
+    }
+    if (!completeChunk(slot, static_cast<AaAecpdu const&>(aecpdu)))
+    {
+        complete(AaCommandStatus::ProtocolError, now);
+        return true;
+    }
+
+    slot.inUse = false;
+    if (_completedChunks == _chunkCount)
+    {
+        complete(AaCommandStatus::Success, now);
+    }
+    else
+    {
+        fill(now);
+    }
+    return true;
+}
+
+void AaBulkTransfer::checkTimeouts(AecpClock::time_point const now)
+{
+    if (!_running)
+    {
+        return;
+    }
+
+    for (auto& slot : _slots)
+    {
+        if (!slot.inUse || slot.timeout > now)
+        {
+            continue;
+        }
+        if (++slot.retries > _maxRetries)
+        {
+            ESP_LOGE(TAG, "AA command at 0x%llx timed out", static_cast<unsigned long long>(_address + slot.chunk * _chunkSize));
+            // Chunks are indexed by their size, so a fallback to standard AECPDUs only applies to the next transfer
+            if (_negotiator != nullptr)
+            {
+                _negotiator->onCommandTimedOut(_targetEntityID, Aecpdu::HEADER_LENGTH + AaAecpdu::HeaderLength + AaAecpdu::TlvHeaderLength + _chunkSize);
+            }
+            complete(AaCommandStatus::TimedOut, now);
+            return;
+        }
+        // Resend only this chunk, with a new sequenceID so a late response is not mistaken
+        send(slot, now);
+    }
+}
+
+bool AaBulkTransfer::isRunning() const noexcept
+{
+    return _running;
+}
+
+size_t AaBulkTransfer::getTransferredLength() const noexcept
+{
+    return _transferred;
+}
+
+double AaBulkTransfer::getBytesPerSecond(AecpClock::time_point const now) const noexcept
+{
+    auto const elapsed = std::chrono::duration<double>(now - _startTime).count();
+    return elapsed > 0.0 ? static_cast<double>(_transferred) / elapsed : 0.0;
+}
+
+bool AaBulkTransfer::start(AaMode const mode, UniqueIdentifier const targetEntityID, MacAddress const& targetAddress, uint64_t const address, size_t const length, AecpClock::time_point const now)
+{
+    if (_running)
+    {
+        ESP_LOGE(TAG, "A transfer is already running");
+        return false;
+    }
+    if (length == 0u || !_sendHandler)
+    {
+        ESP_LOGE(TAG, "Nothing to transfer");
+        return false;
+    }
+
+    _mode = mode;
+    _targetEntityID = targetEntityID;
+    _targetAddress = targetAddress;
+    _address = address;
+    _length = length;
+    // A READ TLV is sent with room for its data, and comes back filled
+    auto const sendLength = _negotiator != nullptr ? _negotiator->getMaximumSendLength(targetEntityID) : Aecpdu::MAXIMUM_SEND_LENGTH;
+    auto const recvLength = _negotiator != nullptr ? _negotiator->getMaximumRecvLength() : Aecpdu::MAXIMUM_RECV_LENGTH;
+    _chunkSize = AaAecpdu::getMaximumTlvDataLength(mode == AaMode::READ ? std::min(sendLength, recvLength) : sendLength);
+    _chunkCount = (length + _chunkSize - 1u) / _chunkSize;
+    _nextChunk = 0u;
+    _completedChunks = 0u;
+    _transferred = 0u;
+    _startTime = now;
+    _running = true;
+    for (auto& slot : _slots)
+    {
+        slot.inUse = false;
+    }
+
+    fill(now);
+    return true;
+}
+
+void AaBulkTransfer::fill(AecpClock::time_point const now)
+{
+    size_t inflight = static_cast<size_t>(std::count_if(_slots.begin(), _slots.end(), [](Slot const& slot)
+    {
+        return slot.inUse;
+    }));
+
+    for (auto& slot : _slots)
+    {
+        if (!_running || _nextChunk >= _chunkCount || inflight >= _window)
+        {
+            return;
+        }
+        if (slot.inUse)
+        {
+            continue;
+        }
+
+        auto const chunk = _nextChunk++;
+        auto const offset = chunk * _chunkSize;
+        auto const size = std::min(_chunkSize, _length - offset);
+
+        slot.message = AaAecpdu{ false };
+        slot.message.setTargetEntityID(_targetEntityID);
+        slot.message.setControllerEntityID(_controllerID);
+        slot.message.setStatus(AecpStatus::SUCCESS);
+        if (_mode == AaMode::READ)
+        {
+            slot.message.addTlv(Tlv{ _address + offset, size });
+        }
+        else
+        {
+            slot.message.addTlv(Tlv{ _address + offset, AaMode::WRITE, _source + offset, size });
+        }
+        slot.chunk = chunk;
+        slot.retries = 0u;
+        slot.inUse = true;
+        ++inflight;
+        send(slot, now);
+    }
+}
+
+void AaBulkTransfer::send(Slot& slot, AecpClock::time_point const now)
+{
+    slot.message.setSequenceID(_sequenceID++);
+    slot.timeout = now + getAecpTimeout(_timeoutHandler, _targetEntityID, _timeout);
+    _sendHandler(slot.message, _targetAddress);
+}
+
+bool AaBulkTransfer::completeChunk(Slot& slot, AaAecpdu const& response)
+{
+    auto const offset = slot.chunk * _chunkSize;
+    auto const size = std::min(_chunkSize, _length - offset);
+
+    if (_mode == AaMode::READ)
+    {
+        auto const& tlvs = response.getTlvData();
+        if (tlvs.size() != 1u || tlvs[0].getAddress() != _address + offset || tlvs[0].size() != size)
+        {
+            ESP_LOGE(TAG, "Unexpected READ response at 0x%llx", static_cast<unsigned long long>(_address + offset));
+            return false;
+        }
+        // Placed by address, whatever the order of the responses
+        std::memcpy(_destination + offset, tlvs[0].data(), size);
+    }
+
+    ++_completedChunks;
+    _transferred += size;
+    return true;
+}
+
+void AaBulkTransfer::complete(AaCommandStatus const status, AecpClock::time_point const now)
+{
+    abort();
+    auto const duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - _startTime);
+    ESP_LOGI(TAG, "AA transfer of %zu bytes ended with status %u in %lld ms (%.0f bytes/s)", _transferred, static_cast<unsigned>(status), static_cast<long long>(duration.count()), getBytesPerSecond(now));
+    if (_completedHandler)
+    {
+        _completedHandler(status, _transferred, duration);
+    }
+}
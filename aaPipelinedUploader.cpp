@@ -0,0 +1,254 @@
+#include "aaPipelinedUploader.hpp"
+#include "esp_log.h"
+#include <algorithm>
+#include <utility>
+
+static const char* TAG = "AA_UPLOAD";
+
+/***********************************************************/
+/* AaPipelinedUploader class definition                    */
+/***********************************************************/
+
+AaPipelinedUploader::AaPipelinedUploader(UniqueIdentifier const controllerID, AecpSendHandler sendHandler, size_t const window, std::chrono::milliseconds const timeout, uint32_t const maxRetries) noexcept
+    : _controllerID(controllerID), _sendHandler(std::move(sendHandler)), _window(std::clamp<size_t>(window, 1u, MaxWindow)), _timeout(timeout), _maxRetries(maxRetries)
+{
+}
+
+void AaPipelinedUploader::setProgressHandler(ProgressHandler handler) noexcept
+{
+    _progressHandler = std::move(handler);
+}
+
+void AaPipelinedUploader::setCompletedHandler(CompletedHandler handler) noexcept
+{
+    _completedHandler = std::move(handler);
+}
+
+void AaPipelinedUploader::setPayloadNegotiator(AecpPayloadNegotiator* negotiator) noexcept
+{
+    _negotiator = negotiator;
+}
+
+void AaPipelinedUploader::setTimeoutHandler(AecpTimeoutHandler handler) noexcept
+{
+    _timeoutHandler = std::move(handler);
+}
+
+bool AaPipelinedUploader::start(UniqueIdentifier const targetEntityID, MacAddress const& targetAddress, uint64_t const address, const uint8_t* data, size_t const length, AecpClock::time_point const now)
+{
+    if (_running)
+    {
+        ESP_LOGE(TAG, "An upload is already running");
+        return false;
+    }
+    if (data == nullptr || length == 0u || !_sendHandler)
+    {
+        ESP_LOGE(TAG, "Nothing to upload");
+        return false;
+    }
+
+    _targetEntityID = targetEntityID;
+    _targetAddress = targetAddress;
+    _address = address;
+    _data = data;
+    _length = length;
+    _chunkSize = AaAecpdu::getMaximumTlvDataLength(_negotiator != nullptr ? _negotiator->getMaximumSendLength(targetEntityID) : Aecpdu::MAXIMUM_SEND_LENGTH);
+    _nextOffset = 0u;
+    _acknowledged = 0u;
+    _retries = 0u;
+    _startTime = now;
+    _running = true;
+    for (auto& slot : _slots)
+    {
+        slot.inUse = false;
+    }
+
+    fill(now);
+    return true;
+}
+
+void AaPipelinedUploader::abort() noexcept
+{
+    _running = false;
+    for (auto& slot : _slots)
+    {
+        slot.inUse = false;
+    }
+}
+
+bool AaPipelinedUploader::handleAecpdu(Aecpdu const& aecpdu, AecpClock::time_point const now)
+{
+    if (!_running || aecpdu.getMessageType() != AecpMessageType::ADDRESS_ACCESS_RESPONSE || aecpdu.getControllerEntityID() != _controllerID || aecpdu.getTargetEntityID() != _targetEntityID)
+    {
+        return false;
+    }
+
+    auto const it = std::find_if(_slots.begin(), _slots.end(), [&aecpdu](Slot const& slot)
+    {
+        return slot.inUse && slot.message.getSequenceID() == aecpdu.getSequenceID();
+    });
+    if (it == _slots.end())
+    {
+        // Response to a command dropped by a rewind
+        return false;
+    }
+    // A big response from a target not allowed to send them is dropped, and the command resent on timeout
+    if (_negotiator != nullptr && !_negotiator->onAecpduReceived(_targetEntityID, static_cast<AaAecpdu const&>(aecpdu).getLength()))
+    {
+        return false;
+    }
+    auto& slot = *it;
+    slot.inUse = false;
+
+    auto const status = static_cast<AaCommandStatus>(aecpdu.getStatus());
+    switch (status)
+    {
+        case AaCommandStatus::Success:
+        {
+            // Data is stored in order, so everything up to this TLV is stored
+            auto const end = slot.offset + slot.size;
+            if (end > _acknowledged)
+            {
+                _acknowledged = end;
+                _retries = 0u;
+                if (_progressHandler)
+                {
+                    _progressHandler(_acknowledged, _length);
+                }
+            }
+            if (_acknowledged >= _length)
+            {
+                complete(AaCommandStatus::Success, now);
+            }
+            else
+            {
+                fill(now);
+            }
+            break;
+        }
+        case AaCommandStatus::DataInvalid:
+            // A previous TLV did not make it
+            rewind(now);
+            break;
+        default:
+            ESP_LOGE(TAG, "Upload refused at offset 0x%llx with status %u", static_cast<unsigned long long>(slot.offset), static_cast<unsigned>(status));
+            complete(status, now);
+            break;
+    }
+    return true;
+}
+
+void AaPipelinedUploader::checkTimeouts(AecpClock::time_point const now)
+{
+    if (!_running)
+    {
+        return;
+    }
+
+    for (auto& slot : _slots)
+    {
+        if (!slot.inUse || slot.timeout > now)
+        {
+            continue;
+        }
+        // Only the response was lost if a later TLV was acknowledged
+        if (slot.offset + slot.size <= _acknowledged)
+        {
+            slot.inUse = false;
+            continue;
+        }
+        rewind(now);
+        return;
+    }
+    fill(now);
+}
+
+bool AaPipelinedUploader::isRunning() const noexcept
+{
+    return _running;
+}
+
+uint64_t AaPipelinedUploader::getAcknowledgedLength() const noexcept
+{
+    return _acknowledged;
+}
+
+double AaPipelinedUploader::getBytesPerSecond(AecpClock::time_point const now) const noexcept
+{
+    auto const elapsed = std::chrono::duration<double>(now - _startTime).count();
+    return elapsed > 0.0 ? static_cast<double>(_acknowledged) / elapsed : 0.0;
+}
+
+void AaPipelinedUploader::fill(AecpClock::time_point const now)
+{
+    size_t inflight = static_cast<size_t>(std::count_if(_slots.begin(), _slots.end(), [](Slot const& slot)
+    {
+        return slot.inUse;
+    }));
+
+    for (auto& slot : _slots)
+    {
+        if (!_running || _nextOffset >= _length || inflight >= _window)
+        {
+            return;
+        }
+        if (slot.inUse)
+        {
+            continue;
+        }
+
+        auto const size = std::min<size_t>(_chunkSize, _length - _nextOffset);
+        slot.message = AaAecpdu{ false };
+        slot.message.setTargetEntityID(_targetEntityID);
+        slot.message.setControllerEntityID(_controllerID);
+        slot.message.setSequenceID(_sequenceID++);
+        slot.message.setStatus(AecpStatus::SUCCESS);
+        slot.message.addTlv(Tlv{ _address + _nextOffset, AaMode::WRITE, _data + _nextOffset, size });
+        slot.offset = _nextOffset;
+        slot.size = size;
+        slot.timeout = now + getAecpTimeout(_timeoutHandler, _targetEntityID, _timeout);
+        slot.inUse = true;
+
+        _nextOffset += size;
+        ++inflight;
+        _sendHandler(slot.message, _targetAddress);
+    }
+}
+
+void AaPipelinedUploader::rewind(AecpClock::time_point const now)
+{
+    if (++_retries > _maxRetries)
+    {
+        // The entity may silently drop big AECPDUs, continue with standard sized ones
+        if (_negotiator != nullptr && _negotiator->onCommandTimedOut(_targetEntityID, Aecpdu::HEADER_LENGTH + AaAecpdu::HeaderLength + AaAecpdu::TlvHeaderLength + _chunkSize))
+        {
+            _chunkSize = AaAecpdu::getMaximumTlvDataLength(Aecpdu::MAXIMUM_LENGTH_1722_1);
+            _retries = 0u;
+        }
+        else
+        {
+            ESP_LOGE(TAG, "Upload stalled at offset 0x%llx", static_cast<unsigned long long>(_acknowledged));
+            complete(AaCommandStatus::TimedOut, now);
+            return;
+        }
+    }
+
+    // Go back to the first byte not acknowledged, the entity acknowledges the duplicates again
+    for (auto& slot : _slots)
+    {
+        slot.inUse = false;
+    }
+    _nextOffset = _acknowledged;
+    fill(now);
+}
+
+void AaPipelinedUploader::complete(AaCommandStatus const status, AecpClock::time_point const now)
+{
+    abort();
+    auto const duration = std::chrono::duration_cast<std::chrono::milliseconds>(now - _startTime);
+    ESP_LOGI(TAG, "Upload of %zu bytes ended with status %u in %lld ms", _length, static_cast<unsigned>(status), static_cast<long long>(duration.count()));
+    if (_completedHandler)
+    {
+        _completedHandler(status, duration);
+    }
+}
@@ -0,0 +1,189 @@
+#include "acmpConnectionGraph.hpp"
+#include "esp_log.h"
+#include <cstring>
+#include <utility>
+
+static const char* TAG = "ACMP_GRAPH";
+
+/***********************************************************/
+/* AcmpConnectionGraph class definition                    */
+/***********************************************************/
+
+void AcmpConnectionGraph::setChangedHandler(ChangedHandler handler) noexcept
+{
+    _changedHandler = std::move(handler);
+}
+
+bool AcmpConnectionGraph::handleAcmpdu(Acmpdu const& acmpdu)
+{
+    // Failed commands do not tell anything about the actual state
+    if (acmpdu.getStatus() != AcmpStatus::SUCCESS)
+    {
+        return false;
+    }
+
+    auto const talker = AcmpStreamEndpoint{ acmpdu.getTalkerEntityID(), acmpdu.getTalkerUniqueID() };
+    auto const listener = AcmpStreamEndpoint{ acmpdu.getListenerEntityID(), acmpdu.getListenerUniqueID() };
+    auto const makeConnection = [&acmpdu, &talker, &listener]()
+    {
+        return Connection{ talker, listener, acmpdu.getStreamID(), acmpdu.getStreamDestAddress(), acmpdu.getStreamVlanID(), acmpdu.getFlags() };
+    };
+
+    switch (acmpdu.getMessageType())
+    {
+        case AcmpMessageType::CONNECT_RX_RESPONSE:
+        case AcmpMessageType::CONNECT_TX_RESPONSE: // Also seen for fast connect, where there is no CONNECT_RX
+        case AcmpMessageType::GET_TX_CONNECTION_RESPONSE:
+            return connect(makeConnection());
+
+        case AcmpMessageType::DISCONNECT_RX_RESPONSE:
+            return disconnect(listener);
+
+        case AcmpMessageType::DISCONNECT_TX_RESPONSE:
+        {
+            // Only drop the edge if the listener was still bound to this talker
+            auto const* const current = getListenerConnection(listener);
+            if (current != nullptr && current->talker == talker)
+            {
+                return disconnect(listener);
+            }
+            return false;
+        }
+
+        case AcmpMessageType::GET_RX_STATE_RESPONSE:
+            if (acmpdu.getConnectionCount() != 0u && talker.entityID)
+            {
+                return connect(makeConnection());
+            }
+            return disconnect(listener);
+
+        default:
+            // Commands and GET_TX_STATE_RESPONSE (no listener information)
+            return false;
+    }
+}
+
+bool AcmpConnectionGraph::connect(Connection const& connection)
+{
+    if (!connection.talker.entityID || !connection.listener.entityID)
+    {
+        ESP_LOGW(TAG, "Ignoring connection with an invalid entity ID");
+        return false;
+    }
+
+    auto const [it, inserted] = _listenerEdges.try_emplace(connection.listener, connection);
+    if (inserted)
+    {
+        _talkerEdges[connection.talker].insert(connection.listener);
+        notify(ChangeType::Connected, connection);
+        return true;
+    }
+
+    auto& current = it->second;
+    if (current.talker != connection.talker)
+    {
+        // Listener moved to another talker: report the old edge gone, then the new one
+        auto const previous = current;
+        removeTalkerEdge(previous.talker, previous.listener);
+        current = connection;
+        _talkerEdges[connection.talker].insert(connection.listener);
+        notify(ChangeType::Disconnected, previous);
+        notify(ChangeType::Connected, current);
+        return true;
+    }
+
+    if (current.streamID != connection.streamID || current.streamDestAddress != connection.streamDestAddress || current.streamVlanID != connection.streamVlanID || current.flags != connection.flags)
+    {
+        current = connection;
+        notify(ChangeType::Updated, current);
+        return true;
+    }
+
+    return false;
+}
+
+bool AcmpConnectionGraph::disconnect(AcmpStreamEndpoint const& listener)
+{
+    auto const it = _listenerEdges.find(listener);
+    if (it == _listenerEdges.end())
+    {
+        return false;
+    }
+
+    auto const previous = it->second;
+    _listenerEdges.erase(it);
+    removeTalkerEdge(previous.talker, previous.listener);
+    notify(ChangeType::Disconnected, previous);
+    return true;
+}
+
+void AcmpConnectionGraph::removeEntity(UniqueIdentifier const entityID)
+{
+    for (auto it = _listenerEdges.begin(); it != _listenerEdges.end();)
+    {
+        if (it->second.talker.entityID == entityID || it->second.listener.entityID == entityID)
+        {
+            auto const previous = it->second;
+            it = _listenerEdges.erase(it);
+            removeTalkerEdge(previous.talker, previous.listener);
+            notify(ChangeType::Disconnected, previous);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+void AcmpConnectionGraph::clear() noexcept
+{
+    _listenerEdges.clear();
+    _talkerEdges.clear();
+}
+
+AcmpConnectionGraph::Connection const* AcmpConnectionGraph::getListenerConnection(AcmpStreamEndpoint const& listener) const noexcept
+{
+    auto const it = _listenerEdges.find(listener);
+    if (it == _listenerEdges.end())
+    {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+AcmpConnectionGraph::ListenerSet const* AcmpConnectionGraph::getTalkerListeners(AcmpStreamEndpoint const& talker) const noexcept
+{
+    auto const it = _talkerEdges.find(talker);
+    if (it == _talkerEdges.end())
+    {
+        return nullptr;
+    }
+    return &it->second;
+}
+
+size_t AcmpConnectionGraph::getConnectionCount() const noexcept
+{
+    return _listenerEdges.size();
+}
+
+void AcmpConnectionGraph::notify(ChangeType const changeType, Connection const& connection)
+{
+    if (_changedHandler)
+    {
+        _changedHandler(changeType, connection);
+    }
+}
+
+void AcmpConnectionGraph::removeTalkerEdge(AcmpStreamEndpoint const& talker, AcmpStreamEndpoint const& listener)
+{
+    auto const it = _talkerEdges.find(talker);
+    if (it == _talkerEdges.end())
+    {
+        return;
+    }
+    it->second.erase(listener);
+    if (it->second.empty())
+    {
+        _talkerEdges.erase(it);
+    }
+}
@@ -0,0 +1,651 @@
+#include "acmpStateMachines.hpp"
+#include "entityEnums.hpp"
+#include "esp_log.h"
+#include <utility>
+
+static const char* TAG = "ACMP";
+
+/***********************************************************/
+/* AcmpInflightCommands class definition                   */
+/***********************************************************/
+
+AcmpInflightCommands::Command* AcmpInflightCommands::allocate() noexcept
+{
+    // Pick the next sequenceID whose slot is free, so responses can be matched without searching
+    for (size_t attempt = 0u; attempt < Capacity; ++attempt)
+    {
+        auto const sequenceID = _nextSequenceID++;
+        auto& command = _commands[slotOf(sequenceID)];
+        if (!command.inUse)
+        {
+            command = Command{};
+            command.inUse = true;
+            command.command.setSequenceID(sequenceID);
+            ++_count;
+            return &command;
+        }
+    }
+    return nullptr;
+}
+
+AcmpInflightCommands::Command* AcmpInflightCommands::find(AcmpSequenceID const sequenceID) noexcept
+{
+    auto& command = _commands[slotOf(sequenceID)];
+    if (command.inUse && command.command.getSequenceID() == sequenceID)
+    {
+        return &command;
+    }
+    return nullptr;
+}
+
+void AcmpInflightCommands::release(Command& command) noexcept
+{
+    if (command.inUse)
+    {
+        command.inUse = false;
+        --_count;
+    }
+}
+
+/***********************************************************/
+/* AcmpTalkerStateMachine class definition                 */
+/***********************************************************/
+
+AcmpTalkerStateMachine::AcmpTalkerStateMachine(UniqueIdentifier const entityID, uint16_t const talkerStreamSources, AcmpSendHandler sendHandler) noexcept
+    : _entityID(entityID), _streamCount(talkerStreamSources), _sendHandler(std::move(sendHandler))
+{
+    if (_streamCount > MaxStreams)
+    {
+        ESP_LOGW(TAG, "Talker has %u stream sources, only the first %u can be connected", _streamCount, static_cast<unsigned>(MaxStreams));
+        _streamCount = static_cast<uint16_t>(MaxStreams);
+    }
+}
+
+void AcmpTalkerStateMachine::setStreamInfo(AcmpUniqueID const talkerUniqueID, UniqueIdentifier const streamID, MacAddress const& streamDestAddress, uint16_t const streamVlanID) noexcept
+{
+    if (talkerUniqueID >= _streamCount)
+    {
+        ESP_LOGE(TAG, "Invalid talker unique ID %u", talkerUniqueID);
+        return;
+    }
+
+    auto& stream = _streams[talkerUniqueID];
+    stream.streamID = streamID;
+    stream.streamDestAddress = streamDestAddress;
+    stream.streamVlanID = streamVlanID;
+}
+
+void AcmpTalkerStateMachine::setConnectionsChangedHandler(ConnectionsChangedHandler handler) noexcept
+{
+    _connectionsChangedHandler = std::move(handler);
+}
+
+AcmpTalkerStateMachine::StreamInfo const* AcmpTalkerStateMachine::getStreamInfo(AcmpUniqueID const talkerUniqueID) const noexcept
+{
+    if (talkerUniqueID >= _streamCount)
+    {
+        return nullptr;
+    }
+    return &_streams[talkerUniqueID];
+}
+
+uint16_t AcmpTalkerStateMachine::getStreamCount() const noexcept
+{
+    return _streamCount;
+}
+
+bool AcmpTalkerStateMachine::handleAcmpdu(Acmpdu const& acmpdu)
+{
+    auto const messageType = acmpdu.getMessageType();
+
+    // Only talker commands addressed to us
+    if (isAcmpResponse(messageType) || acmpdu.getTalkerEntityID() != _entityID)
+    {
+        return false;
+    }
+    if (messageType != AcmpMessageType::CONNECT_TX_COMMAND && messageType != AcmpMessageType::DISCONNECT_TX_COMMAND && messageType != AcmpMessageType::GET_TX_STATE_COMMAND && messageType != AcmpMessageType::GET_TX_CONNECTION_COMMAND)
+    {
+        return false;
+    }
+
+    auto const talkerUniqueID = acmpdu.getTalkerUniqueID();
+    if (talkerUniqueID >= _streamCount)
+    {
+        sendResponse(acmpdu, nullptr, AcmpStatus::TALKER_UNKNOWN_ID, acmpdu.getListenerEntityID(), acmpdu.getListenerUniqueID());
+        return true;
+    }
+
+    auto& stream = _streams[talkerUniqueID];
+    switch (messageType)
+    {
+        case AcmpMessageType::CONNECT_TX_COMMAND:
+        {
+            auto const status = connectTalker(acmpdu, stream);
+            sendResponse(acmpdu, &stream, status, acmpdu.getListenerEntityID(), acmpdu.getListenerUniqueID());
+            break;
+        }
+        case AcmpMessageType::DISCONNECT_TX_COMMAND:
+        {
+            auto const status = disconnectTalker(acmpdu, stream);
+            sendResponse(acmpdu, &stream, status, acmpdu.getListenerEntityID(), acmpdu.getListenerUniqueID());
+            break;
+        }
+        case AcmpMessageType::GET_TX_STATE_COMMAND:
+            sendResponse(acmpdu, &stream, AcmpStatus::SUCCESS, acmpdu.getListenerEntityID(), acmpdu.getListenerUniqueID());
+            break;
+        case AcmpMessageType::GET_TX_CONNECTION_COMMAND:
+        {
+            // The connection_count field of the command is the index of the requested connection
+            auto const index = acmpdu.getConnectionCount();
+            if (index < stream.connectionCount)
+            {
+                auto const& connection = stream.connections[index];
+                sendResponse(acmpdu, &stream, AcmpStatus::SUCCESS, connection.listenerEntityID, connection.listenerUniqueID);
+            }
+            else
+            {
+                sendResponse(acmpdu, &stream, AcmpStatus::NO_SUCH_CONNECTION, acmpdu.getListenerEntityID(), acmpdu.getListenerUniqueID());
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return true;
+}
+
+AcmpStatus AcmpTalkerStateMachine::connectTalker(Acmpdu const& command, StreamInfo& stream) noexcept
+{
+    auto const listenerEntityID = command.getListenerEntityID();
+    auto const listenerUniqueID = command.getListenerUniqueID();
+
+    for (auto i = 0u; i < stream.connectionCount; ++i)
+    {
+        auto const& connection = stream.connections[i];
+        if (connection.listenerEntityID == listenerEntityID && connection.listenerUniqueID == listenerUniqueID)
+        {
+            // Already connected (listener retry or fast connect), nothing changes
+            return AcmpStatus::SUCCESS;
+        }
+    }
+
+    if (stream.connectionCount >= MaxListenersPerStream)
+    {
+        ESP_LOGW(TAG, "No room for another listener on talker stream");
+        return AcmpStatus::TALKER_EXCLUSIVE;
+    }
+
+    stream.connections[stream.connectionCount] = ListenerConnection{ listenerEntityID, listenerUniqueID };
+    ++stream.connectionCount;
+
+    if (_connectionsChangedHandler)
+    {
+        _connectionsChangedHandler(command.getTalkerUniqueID(), stream);
+    }
+    return AcmpStatus::SUCCESS;
+}
+
+AcmpStatus AcmpTalkerStateMachine::disconnectTalker(Acmpdu const& command, StreamInfo& stream) noexcept
+{
+    auto const listenerEntityID = command.getListenerEntityID();
+    auto const listenerUniqueID = command.getListenerUniqueID();
+
+    for (auto i = 0u; i < stream.connectionCount; ++i)
+    {
+        auto& connection = stream.connections[i];
+        if (connection.listenerEntityID == listenerEntityID && connection.listenerUniqueID == listenerUniqueID)
+        {
+            // Keep the table packed so GET_TX_CONNECTION indexes stay contiguous
+            --stream.connectionCount;
+            connection = stream.connections[stream.connectionCount];
+            stream.connections[stream.connectionCount] = ListenerConnection{};
+
+            if (_connectionsChangedHandler)
+            {
+                _connectionsChangedHandler(command.getTalkerUniqueID(), stream);
+            }
+            break;
+        }
+    }
+
+    // Disconnecting an unknown listener is not an error (Clause 8.2.2.6.2.2)
+    return AcmpStatus::SUCCESS;
+}
+
+void AcmpTalkerStateMachine::sendResponse(Acmpdu const& command, StreamInfo const* stream, AcmpStatus const status, UniqueIdentifier const listenerEntityID, AcmpUniqueID const listenerUniqueID)
+{
+    if (!_sendHandler)
+    {
+        ESP_LOGE(TAG, "No send handler, dropping talker response");
+        return;
+    }
+
+    auto response = command;
+    response.setMessageType(getAcmpResponseType(command.getMessageType()));
+    response.setStatus(status);
+    response.setListenerEntityID(listenerEntityID);
+    response.setListenerUniqueID(listenerUniqueID);
+    if (stream != nullptr)
+    {
+        response.setStreamID(stream->streamID);
+        response.setStreamDestAddress(stream->streamDestAddress);
+        response.setStreamVlanID(stream->streamVlanID);
+        response.setConnectionCount(stream->connectionCount);
+    }
+
+    _sendHandler(response);
+}
+
+/***********************************************************/
+/* AcmpListenerStateMachine class definition               */
+/***********************************************************/
+
+AcmpListenerStateMachine::AcmpListenerStateMachine(UniqueIdentifier const entityID, uint16_t const listenerStreamSinks, AcmpSendHandler sendHandler) noexcept
+    : _entityID(entityID), _streamCount(listenerStreamSinks), _sendHandler(std::move(sendHandler))
+{
+    if (_streamCount > MaxStreams)
+    {
+        ESP_LOGW(TAG, "Listener has %u stream sinks, only the first %u can be connected", _streamCount, static_cast<unsigned>(MaxStreams));
+        _streamCount = static_cast<uint16_t>(MaxStreams);
+    }
+}
+
+void AcmpListenerStateMachine::setStreamStateChangedHandler(StreamStateChangedHandler handler) noexcept
+{
+    _streamStateChangedHandler = std::move(handler);
+}
+
+void AcmpListenerStateMachine::setSaveConnectionHandler(SaveConnectionHandler handler) noexcept
+{
+    _saveConnectionHandler = std::move(handler);
+}
+
+void AcmpListenerStateMachine::restoreConnection(StreamIndex const streamIndex, SavedConnection const& savedConnection) noexcept
+{
+    if (streamIndex >= _streamCount || !savedConnection.talkerEntityID)
+    {
+        ESP_LOGW(TAG, "Ignoring invalid saved connection for listener stream %u", streamIndex);
+        return;
+    }
+    _savedConnections[streamIndex] = savedConnection;
+}
+
+std::optional<AcmpListenerStateMachine::SavedConnection> AcmpListenerStateMachine::getSavedConnection(StreamIndex const streamIndex) const noexcept
+{
+    if (streamIndex >= _streamCount)
+    {
+        return std::nullopt;
+    }
+    return _savedConnections[streamIndex];
+}
+
+void AcmpListenerStateMachine::addSavedTalkers(EntityIdFilter& filter) const noexcept
+{
+    for (auto streamIndex = StreamIndex{ 0u }; streamIndex < _streamCount; ++streamIndex)
+    {
+        if (_savedConnections[streamIndex])
+        {
+            filter.add(_savedConnections[streamIndex]->talkerEntityID);
+        }
+    }
+}
+
+AcmpListenerStateMachine::StreamInfo const* AcmpListenerStateMachine::getStreamInfo(AcmpUniqueID const listenerUniqueID) const noexcept
+{
+    if (listenerUniqueID >= _streamCount)
+    {
+        return nullptr;
+    }
+    return &_streams[listenerUniqueID];
+}
+
+uint16_t AcmpListenerStateMachine::getStreamCount() const noexcept
+{
+    return _streamCount;
+}
+
+size_t AcmpListenerStateMachine::getInflightCount() const noexcept
+{
+    return _inflight.size();
+}
+
+bool AcmpListenerStateMachine::handleAcmpdu(Acmpdu const& acmpdu, AcmpClock::time_point const now)
+{
+    auto const messageType = acmpdu.getMessageType();
+
+    if (acmpdu.getListenerEntityID() != _entityID)
+    {
+        return false;
+    }
+
+    // Talker responses to the commands we relayed
+    if (messageType == AcmpMessageType::CONNECT_TX_RESPONSE || messageType == AcmpMessageType::DISCONNECT_TX_RESPONSE)
+    {
+        handleTxResponse(acmpdu);
+        return true;
+    }
+
+    if (messageType != AcmpMessageType::CONNECT_RX_COMMAND && messageType != AcmpMessageType::DISCONNECT_RX_COMMAND && messageType != AcmpMessageType::GET_RX_STATE_COMMAND)
+    {
+        return false;
+    }
+
+    auto const listenerUniqueID = acmpdu.getListenerUniqueID();
+    if (listenerUniqueID >= _streamCount)
+    {
+        sendRxResponse(acmpdu, StreamInfo{}, AcmpStatus::LISTENER_UNKNOWN_ID);
+        return true;
+    }
+
+    auto& stream = _streams[listenerUniqueID];
+    switch (messageType)
+    {
+        case AcmpMessageType::CONNECT_RX_COMMAND:
+            handleConnectRxCommand(acmpdu, stream, now);
+            break;
+        case AcmpMessageType::DISCONNECT_RX_COMMAND:
+            handleDisconnectRxCommand(acmpdu, stream, now);
+            break;
+        case AcmpMessageType::GET_RX_STATE_COMMAND:
+            handleGetRxStateCommand(acmpdu, stream);
+            break;
+        default:
+            break;
+    }
+    return true;
+}
+
+void AcmpListenerStateMachine::checkTimeouts(AcmpClock::time_point const now)
+{
+    _inflight.forEachExpired(now, [this, now](AcmpInflightCommands::Command& inflight)
+    {
+        auto const messageType = inflight.command.getMessageType();
+
+        // First timeout: send the same command again
+        if (!inflight.retried)
+        {
+            inflight.retried = true;
+            inflight.timeout = now + getAcmpCommandTimeout(messageType);
+            if (_sendHandler)
+            {
+                _sendHandler(inflight.command);
+            }
+            return;
+        }
+
+        // Second timeout: give up and report to the controller
+        auto const original = inflight.originalCommand;
+        _inflight.release(inflight);
+
+        auto const listenerUniqueID = original.getListenerUniqueID();
+        if (listenerUniqueID >= _streamCount)
+        {
+            return;
+        }
+        auto& stream = _streams[listenerUniqueID];
+        stream.pending = false;
+
+        // Fast connect failures are silent, the saved state stays so the next ENTITY_AVAILABLE retries
+        if (stream.fastConnecting)
+        {
+            stream.fastConnecting = false;
+            ESP_LOGW(TAG, "Fast connect timed out, listener stream %u", listenerUniqueID);
+            return;
+        }
+
+        if (messageType == AcmpMessageType::DISCONNECT_TX_COMMAND)
+        {
+            disconnectListener(stream, listenerUniqueID);
+        }
+        ESP_LOGW(TAG, "Talker did not respond, listener stream %u", listenerUniqueID);
+        sendRxResponse(original, stream, AcmpStatus::LISTENER_TALKER_TIMEOUT);
+    });
+}
+
+void AcmpListenerStateMachine::onEntityAvailable(UniqueIdentifier const entityID, AcmpClock::time_point const now)
+{
+    for (auto listenerUniqueID = AcmpUniqueID{ 0u }; listenerUniqueID < _streamCount; ++listenerUniqueID)
+    {
+        auto const& saved = _savedConnections[listenerUniqueID];
+        auto& stream = _streams[listenerUniqueID];
+        if (!saved || saved->talkerEntityID != entityID || stream.connected || stream.pending)
+        {
+            continue;
+        }
+
+        // No controller involved: the listener is the originator of the CONNECT_TX
+        auto command = Acmpdu::createConnectTxCommand();
+        command.setControllerEntityID(_entityID);
+        command.setTalkerEntityID(saved->talkerEntityID);
+        command.setTalkerUniqueID(saved->talkerUniqueID);
+        command.setListenerEntityID(_entityID);
+        command.setListenerUniqueID(listenerUniqueID);
+        command.setStreamDestAddress(saved->streamDestAddress);
+        command.setStreamVlanID(saved->streamVlanID);
+        command.setFlags(static_cast<uint16_t>(saved->flags | static_cast<uint16_t>(ConnectionFlag::FastConnect)));
+
+        if (sendTxCommand(AcmpMessageType::CONNECT_TX_COMMAND, command, now))
+        {
+            stream.pending = true;
+            stream.fastConnecting = true;
+        }
+    }
+}
+
+void AcmpListenerStateMachine::handleConnectRxCommand(Acmpdu const& command, StreamInfo& stream, AcmpClock::time_point const now)
+{
+    if (stream.pending)
+    {
+        sendRxResponse(command, stream, AcmpStatus::STATE_UNAVAILABLE);
+        return;
+    }
+
+    // A listener sink can only be bound to one talker stream
+    if (stream.connected && (stream.talkerEntityID != command.getTalkerEntityID() || stream.talkerUniqueID != command.getTalkerUniqueID()))
+    {
+        sendRxResponse(command, stream, AcmpStatus::LISTENER_EXCLUSIVE);
+        return;
+    }
+
+    if (!sendTxCommand(AcmpMessageType::CONNECT_TX_COMMAND, command, now))
+    {
+        sendRxResponse(command, stream, AcmpStatus::COULD_NOT_SEND_MESSAGE);
+        return;
+    }
+    stream.pending = true;
+}
+
+void AcmpListenerStateMachine::handleDisconnectRxCommand(Acmpdu const& command, StreamInfo& stream, AcmpClock::time_point const now)
+{
+    if (stream.pending)
+    {
+        sendRxResponse(command, stream, AcmpStatus::STATE_UNAVAILABLE);
+        return;
+    }
+
+    if (!stream.connected || stream.talkerEntityID != command.getTalkerEntityID() || stream.talkerUniqueID != command.getTalkerUniqueID())
+    {
+        // A binding still waiting for its talker to come back is forgotten, so it will not fast connect later
+        auto const listenerUniqueID = command.getListenerUniqueID();
+        auto const& saved = _savedConnections[listenerUniqueID];
+        if (!stream.connected && saved && saved->talkerEntityID == command.getTalkerEntityID() && saved->talkerUniqueID == command.getTalkerUniqueID())
+        {
+            saveConnection(listenerUniqueID, std::nullopt);
+        }
+        sendRxResponse(command, stream, AcmpStatus::NOT_CONNECTED);
+        return;
+    }
+
+    if (!sendTxCommand(AcmpMessageType::DISCONNECT_TX_COMMAND, command, now))
+    {
+        sendRxResponse(command, stream, AcmpStatus::COULD_NOT_SEND_MESSAGE);
+        return;
+    }
+    stream.pending = true;
+}
+
+void AcmpListenerStateMachine::handleGetRxStateCommand(Acmpdu const& command, StreamInfo const& stream)
+{
+    sendRxResponse(command, stream, AcmpStatus::SUCCESS);
+}
+
+void AcmpListenerStateMachine::handleTxResponse(Acmpdu const& response)
+{
+    auto* const inflight = _inflight.find(response.getSequenceID());
+    if (inflight == nullptr || getAcmpResponseType(inflight->command.getMessageType()) != response.getMessageType() || inflight->command.getTalkerEntityID() != response.getTalkerEntityID())
+    {
+        // Response to another listener's command, or arriving after we gave up
+        return;
+    }
+
+    auto const original = inflight->originalCommand;
+    _inflight.release(*inflight);
+
+    auto const listenerUniqueID = original.getListenerUniqueID();
+    if (listenerUniqueID >= _streamCount)
+    {
+        return;
+    }
+
+    auto& stream = _streams[listenerUniqueID];
+    stream.pending = false;
+
+    auto const status = response.getStatus();
+    if (stream.fastConnecting)
+    {
+        stream.fastConnecting = false;
+        if (status == AcmpStatus::SUCCESS)
+        {
+            connectListener(stream, response, listenerUniqueID);
+        }
+        else
+        {
+            // The talker refused the saved binding, forget it
+            ESP_LOGW(TAG, "Fast connect refused by talker (status %u), listener stream %u", static_cast<unsigned>(status), listenerUniqueID);
+            saveConnection(listenerUniqueID, std::nullopt);
+        }
+        return;
+    }
+
+    if (status == AcmpStatus::SUCCESS)
+    {
+        if (response.getMessageType() == AcmpMessageType::CONNECT_TX_RESPONSE)
+        {
+            stream.controllerEntityID = original.getControllerEntityID();
+            connectListener(stream, response, listenerUniqueID);
+        }
+        else
+        {
+            disconnectListener(stream, listenerUniqueID);
+        }
+    }
+
+    sendRxResponse(original, stream, status);
+}
+
+bool AcmpListenerStateMachine::sendTxCommand(AcmpMessageType const messageType, Acmpdu const& rxCommand, AcmpClock::time_point const now)
+{
+    if (!_sendHandler)
+    {
+        ESP_LOGE(TAG, "No send handler, cannot reach talker");
+        return false;
+    }
+
+    auto* const inflight = _inflight.allocate();
+    if (inflight == nullptr)
+    {
+        ESP_LOGE(TAG, "Too many ACMP commands inflight");
+        return false;
+    }
+
+    // Relay the controller command to the talker, using our own sequenceID
+    auto const sequenceID = inflight->command.getSequenceID();
+    inflight->originalCommand = rxCommand;
+    inflight->command = rxCommand;
+    inflight->command.setMessageType(messageType);
+    inflight->command.setStatus(AcmpStatus::SUCCESS);
+    inflight->command.setSequenceID(sequenceID);
+    inflight->timeout = now + getAcmpCommandTimeout(messageType);
+
+    _sendHandler(inflight->command);
+    return true;
+}
+
+void AcmpListenerStateMachine::sendRxResponse(Acmpdu const& rxCommand, StreamInfo const& stream, AcmpStatus const status)
+{
+    if (!_sendHandler)
+    {
+        ESP_LOGE(TAG, "No send handler, dropping listener response");
+        return;
+    }
+
+    auto response = rxCommand;
+    response.setMessageType(getAcmpResponseType(rxCommand.getMessageType()));
+    response.setStatus(status);
+    if (stream.connected)
+    {
+        response.setTalkerEntityID(stream.talkerEntityID);
+        response.setTalkerUniqueID(stream.talkerUniqueID);
+        response.setStreamID(stream.streamID);
+        response.setStreamDestAddress(stream.streamDestAddress);
+        response.setStreamVlanID(stream.streamVlanID);
+        response.setFlags(stream.flags);
+        response.setConnectionCount(1u);
+    }
+    else if (rxCommand.getListenerUniqueID() < _streamCount && _savedConnections[rxCommand.getListenerUniqueID()])
+    {
+        response.setFlags(static_cast<uint16_t>(response.getFlags() | static_cast<uint16_t>(ConnectionFlag::SavedState)));
+        response.setConnectionCount(0u);
+    }
+    else
+    {
+        if (rxCommand.getMessageType() == AcmpMessageType::GET_RX_STATE_COMMAND)
+        {
+            response.setTalkerEntityID(UniqueIdentifier::getNullUniqueIdentifier());
+            response.setTalkerUniqueID(0u);
+        }
+        response.setConnectionCount(0u);
+    }
+
+    _sendHandler(response);
+}
+
+void AcmpListenerStateMachine::connectListener(StreamInfo& stream, Acmpdu const& txResponse, AcmpUniqueID const listenerUniqueID)
+{
+    stream.talkerEntityID = txResponse.getTalkerEntityID();
+    stream.talkerUniqueID = txResponse.getTalkerUniqueID();
+    stream.streamID = txResponse.getStreamID();
+    stream.streamDestAddress = txResponse.getStreamDestAddress();
+    stream.streamVlanID = txResponse.getStreamVlanID();
+    stream.flags = static_cast<uint16_t>(txResponse.getFlags() & ~static_cast<uint16_t>(ConnectionFlag::FastConnect));
+    stream.connected = true;
+
+    saveConnection(listenerUniqueID, SavedConnection{ stream.talkerEntityID, stream.talkerUniqueID, stream.streamDestAddress, stream.streamVlanID, stream.flags });
+
+    if (_streamStateChangedHandler)
+    {
+        _streamStateChangedHandler(listenerUniqueID, stream);
+    }
+}
+
+void AcmpListenerStateMachine::disconnectListener(StreamInfo& stream, AcmpUniqueID const listenerUniqueID)
+{
+    stream = StreamInfo{};
+
+    saveConnection(listenerUniqueID, std::nullopt);
+
+    if (_streamStateChangedHandler)
+    {
+        _streamStateChangedHandler(listenerUniqueID, stream);
+    }
+}
+
+void AcmpListenerStateMachine::saveConnection(AcmpUniqueID const listenerUniqueID, std::optional<SavedConnection> const& savedConnection)
+{
+    _savedConnections[listenerUniqueID] = savedConnection;
+
+    if (_saveConnectionHandler)
+    {
+        _saveConnectionHandler(listenerUniqueID, savedConnection);
+    }
+}
@@ -0,0 +1,275 @@
+#include "acmpSweepScheduler.hpp"
+#include "esp_log.h"
+#include <algorithm>
+#include <utility>
+
+static const char* TAG = "ACMP_SWEEP";
+
+/** Entity a command is addressed to */
+static UniqueIdentifier getTargetEntityID(Acmpdu const& acmpdu) noexcept
+{
+    auto const messageType = acmpdu.getMessageType();
+    if (messageType == AcmpMessageType::GET_RX_STATE_COMMAND || messageType == AcmpMessageType::GET_RX_STATE_RESPONSE)
+    {
+        return acmpdu.getListenerEntityID();
+    }
+    return acmpdu.getTalkerEntityID();
+}
+
+/***********************************************************/
+/* AcmpSweepScheduler class definition                     */
+/***********************************************************/
+
+AcmpSweepScheduler::AcmpSweepScheduler(UniqueIdentifier const controllerEntityID, AcmpConnectionGraph& graph, AcmpSendHandler sendHandler, Configuration const& configuration) noexcept
+    : _controllerEntityID(controllerEntityID), _graph(graph), _sendHandler(std::move(sendHandler)), _configuration(configuration)
+{
+    if (_configuration.maxInflight > AcmpInflightCommands::Capacity)
+    {
+        ESP_LOGW(TAG, "maxInflight %zu above the inflight table capacity, using %zu (see ATDECC_ACMP_MAX_INFLIGHT_COMMANDS)", _configuration.maxInflight, AcmpInflightCommands::Capacity);
+        _configuration.maxInflight = AcmpInflightCommands::Capacity;
+    }
+    if (_configuration.maxInflight == 0u)
+    {
+        _configuration.maxInflight = AcmpInflightCommands::Capacity;
+    }
+    if (_configuration.maxInflightPerEntity == 0u)
+    {
+        _configuration.maxInflightPerEntity = 1u;
+    }
+}
+
+void AcmpSweepScheduler::setSweepCompletedHandler(SweepCompletedHandler handler) noexcept
+{
+    _sweepCompletedHandler = std::move(handler);
+}
+
+void AcmpSweepScheduler::addEntity(UniqueIdentifier const entityID, uint16_t const talkerStreamSources, uint16_t const listenerStreamSinks, AcmpClock::time_point const now)
+{
+    if (!entityID)
+    {
+        ESP_LOGE(TAG, "Cannot sweep an invalid entity ID");
+        return;
+    }
+
+    // Recently online entities go last, they are served first
+    auto* existing = findEntity(entityID);
+    if (existing != nullptr)
+    {
+        _pendingCount -= existing->pending.size();
+        auto entity = std::move(*existing);
+        entity.pending.clear();
+        _entities.erase(_entities.begin() + (existing - _entities.data()));
+        _entities.push_back(std::move(entity));
+    }
+    else
+    {
+        _entities.push_back(EntitySweep{ entityID });
+    }
+    auto& entity = _entities.back();
+
+    for (auto uniqueID = AcmpUniqueID{ 0u }; uniqueID < listenerStreamSinks; ++uniqueID)
+    {
+        auto command = Acmpdu::createGetRxStateCommand();
+        command.setListenerEntityID(entityID);
+        command.setListenerUniqueID(uniqueID);
+        enqueue(entity, std::move(command), now);
+    }
+    // GET_TX_CONNECTION commands are queued once GET_TX_STATE told how many connections there are
+    for (auto uniqueID = AcmpUniqueID{ 0u }; uniqueID < talkerStreamSources; ++uniqueID)
+    {
+        auto command = Acmpdu::createGetTxStateCommand();
+        command.setTalkerEntityID(entityID);
+        command.setTalkerUniqueID(uniqueID);
+        enqueue(entity, std::move(command), now);
+    }
+
+    schedule(now);
+}
+
+void AcmpSweepScheduler::removeEntity(UniqueIdentifier const entityID) noexcept
+{
+    // The entry itself stays until its inflight commands are answered or timed out
+    auto* entity = findEntity(entityID);
+    if (entity != nullptr)
+    {
+        _pendingCount -= entity->pending.size();
+        entity->pending.clear();
+    }
+}
+
+bool AcmpSweepScheduler::handleAcmpdu(Acmpdu const& acmpdu, AcmpClock::time_point const now)
+{
+    auto const messageType = acmpdu.getMessageType();
+    if (!isAcmpResponse(messageType) || acmpdu.getControllerEntityID() != _controllerEntityID)
+    {
+        return false;
+    }
+
+    auto* inflight = _inflight.find(acmpdu.getSequenceID());
+    if (inflight == nullptr || getAcmpResponseType(inflight->command.getMessageType()) != messageType || getTargetEntityID(inflight->command) != getTargetEntityID(acmpdu))
+    {
+        return false;
+    }
+
+    auto const targetEntityID = getTargetEntityID(acmpdu);
+    _inflight.release(*inflight);
+    ++_metrics.responsesReceived;
+
+    if (acmpdu.getStatus() != AcmpStatus::SUCCESS)
+    {
+        ++_metrics.errors;
+        ESP_LOGW(TAG, "ACMP message type %u failed with status %u", static_cast<unsigned>(messageType), static_cast<unsigned>(acmpdu.getStatus()));
+    }
+    else if (messageType == AcmpMessageType::GET_TX_STATE_RESPONSE)
+    {
+        auto* entity = findEntity(targetEntityID);
+        if (entity != nullptr)
+        {
+            for (auto index = uint16_t{ 0u }; index < acmpdu.getConnectionCount(); ++index)
+            {
+                auto command = Acmpdu::createGetTxConnectionCommand();
+                command.setTalkerEntityID(targetEntityID);
+                command.setTalkerUniqueID(acmpdu.getTalkerUniqueID());
+                command.setConnectionCount(index);
+                enqueue(*entity, std::move(command), now);
+            }
+        }
+    }
+    else
+    {
+        _graph.handleAcmpdu(acmpdu);
+    }
+
+    completeCommand(targetEntityID, now);
+    return true;
+}
+
+void AcmpSweepScheduler::checkTimeouts(AcmpClock::time_point const now)
+{
+    _inflight.forEachExpired(now, [this, now](AcmpInflightCommands::Command& inflight)
+    {
+        if (!inflight.retried)
+        {
+            inflight.retried = true;
+            inflight.timeout = now + getAcmpCommandTimeout(inflight.command.getMessageType());
+            ++_metrics.retries;
+            _sendHandler(inflight.command);
+            return;
+        }
+
+        auto const targetEntityID = getTargetEntityID(inflight.command);
+        _inflight.release(inflight);
+        ++_metrics.timeouts;
+        completeCommand(targetEntityID, now);
+    });
+}
+
+AcmpSweepScheduler::Metrics const& AcmpSweepScheduler::getMetrics() const noexcept
+{
+    return _metrics;
+}
+
+bool AcmpSweepScheduler::isSweeping() const noexcept
+{
+    return _sweeping;
+}
+
+size_t AcmpSweepScheduler::getPendingCount() const noexcept
+{
+    return _pendingCount;
+}
+
+size_t AcmpSweepScheduler::getInflightCount() const noexcept
+{
+    return _inflight.size();
+}
+
+AcmpSweepScheduler::EntitySweep* AcmpSweepScheduler::findEntity(UniqueIdentifier const entityID) noexcept
+{
+    auto const it = std::find_if(_entities.begin(), _entities.end(), [entityID](EntitySweep const& entity)
+    {
+        return entity.entityID == entityID;
+    });
+    return it == _entities.end() ? nullptr : &*it;
+}
+
+void AcmpSweepScheduler::enqueue(EntitySweep& entity, Acmpdu&& command, AcmpClock::time_point const now)
+{
+    if (!_sweeping)
+    {
+        // New sweep: reset the counters, keep the last duration
+        auto const lastSweepDuration = _metrics.lastSweepDuration;
+        _metrics = Metrics{};
+        _metrics.sweepStart = now;
+        _metrics.lastSweepDuration = lastSweepDuration;
+        _sweeping = true;
+    }
+    command.setControllerEntityID(_controllerEntityID);
+    entity.pending.push_back(std::move(command));
+    ++_pendingCount;
+}
+
+void AcmpSweepScheduler::schedule(AcmpClock::time_point const now)
+{
+    if (!_sendHandler)
+    {
+        ESP_LOGE(TAG, "No send handler, cannot sweep");
+        return;
+    }
+
+    for (auto it = _entities.rbegin(); it != _entities.rend() && _inflight.size() < _configuration.maxInflight; ++it)
+    {
+        auto& entity = *it;
+        while (!entity.pending.empty() && entity.inflight < _configuration.maxInflightPerEntity && _inflight.size() < _configuration.maxInflight)
+        {
+            auto* inflight = _inflight.allocate();
+            if (inflight == nullptr)
+            {
+                return;
+            }
+            auto const sequenceID = inflight->command.getSequenceID();
+            inflight->command = std::move(entity.pending.front());
+            inflight->command.setSequenceID(sequenceID);
+            inflight->timeout = now + getAcmpCommandTimeout(inflight->command.getMessageType());
+            entity.pending.pop_front();
+            --_pendingCount;
+            ++entity.inflight;
+            ++_metrics.commandsSent;
+            _sendHandler(inflight->command);
+        }
+    }
+}
+
+void AcmpSweepScheduler::completeCommand(UniqueIdentifier const targetEntityID, AcmpClock::time_point const now)
+{
+    auto* entity = findEntity(targetEntityID);
+    if (entity != nullptr && entity->inflight != 0u)
+    {
+        --entity->inflight;
+    }
+
+    // Forget the entities that are done
+    _entities.erase(std::remove_if(_entities.begin(), _entities.end(), [](EntitySweep const& entity)
+    {
+        return entity.pending.empty() && entity.inflight == 0u;
+    }), _entities.end());
+
+    schedule(now);
+    checkSweepCompleted(now);
+}
+
+void AcmpSweepScheduler::checkSweepCompleted(AcmpClock::time_point const now)
+{
+    if (!_sweeping || _pendingCount != 0u || _inflight.size() != 0u)
+    {
+        return;
+    }
+
+    _sweeping = false;
+    _metrics.lastSweepDuration = std::chrono::duration_cast<std::chrono::milliseconds>(now - _metrics.sweepStart);
+    ESP_LOGI(TAG, "Sweep done in %lld ms: %u commands, %u timeouts, %u errors", static_cast<long long>(_metrics.lastSweepDuration.count()), static_cast<unsigned>(_metrics.commandsSent), static_cast<unsigned>(_metrics.timeouts), static_cast<unsigned>(_metrics.errors));
+    if (_sweepCompletedHandler)
+    {
+        _sweepCompletedHandler(_metrics);
+    }
+}
@@ -0,0 +1,111 @@
+#include "aecpPayloadNegotiator.hpp"
+#include "esp_log.h"
+
+static const char* TAG = "AECP_PAYLOAD";
+
+/***********************************************************/
+/* AecpPayloadNegotiator class definition                  */
+/***********************************************************/
+
+AecpPayloadNegotiator::AecpPayloadNegotiator(bool const sendBigPayloads, bool const recvBigPayloads) noexcept
+    : _sendBigPayloads(sendBigPayloads), _recvBigPayloads(recvBigPayloads)
+{
+}
+
+void AecpPayloadNegotiator::setSendBigPayloads(bool const sendBigPayloads) noexcept
+{
+    _sendBigPayloads = sendBigPayloads;
+}
+
+void AecpPayloadNegotiator::setRecvBigPayloads(bool const recvBigPayloads) noexcept
+{
+    _recvBigPayloads = recvBigPayloads;
+}
+
+void AecpPayloadNegotiator::setPeerSupport(UniqueIdentifier const peerID, Support const support)
+{
+    if (support == Support::Unknown)
+    {
+        _peers.erase(peerID);
+        return;
+    }
+    _peers[peerID] = support;
+}
+
+void AecpPayloadNegotiator::removePeer(UniqueIdentifier const peerID)
+{
+    _peers.erase(peerID);
+}
+
+bool AecpPayloadNegotiator::onAecpduReceived(UniqueIdentifier const peerID, size_t const length)
+{
+    if (length <= Aecpdu::MAXIMUM_LENGTH_1722_1)
+    {
+        return true;
+    }
+    if (!_recvBigPayloads || length > Aecpdu::MAXIMUM_LENGTH_BIG_PAYLOADS)
+    {
+        ESP_LOGW(TAG, "Dropping AECPDU of %zu bytes from 0x%llx", length, static_cast<unsigned long long>(peerID.getValue()));
+        return false;
+    }
+
+    auto& support = _peers[peerID];
+    if (support != Support::Supported)
+    {
+        ESP_LOGI(TAG, "Peer 0x%llx uses big AECP payloads", static_cast<unsigned long long>(peerID.getValue()));
+        support = Support::Supported;
+    }
+    return true;
+}
+
+bool AecpPayloadNegotiator::onCommandTimedOut(UniqueIdentifier const peerID, size_t const length)
+{
+    if (length <= Aecpdu::MAXIMUM_LENGTH_1722_1)
+    {
+        return false;
+    }
+
+    // A peer known to support big payloads just lost the command
+    auto const it = _peers.find(peerID);
+    if (it != _peers.end() && it->second != Support::Unknown)
+    {
+        return false;
+    }
+
+    ESP_LOGW(TAG, "Peer 0x%llx does not answer big AECPDUs, falling back to %zu bytes", static_cast<unsigned long long>(peerID.getValue()), Aecpdu::MAXIMUM_LENGTH_1722_1);
+    _peers[peerID] = Support::Unsupported;
+    return true;
+}
+
+AecpPayloadNegotiator::Support AecpPayloadNegotiator::getPeerSupport(UniqueIdentifier const peerID) const noexcept
+{
+    auto const it = _peers.find(peerID);
+    if (it == _peers.end())
+    {
+        return Support::Unknown;
+    }
+    return it->second;
+}
+
+size_t AecpPayloadNegotiator::getMaximumSendLength(UniqueIdentifier const peerID) const noexcept
+{
+    switch (getPeerSupport(peerID))
+    {
+        case Support::Supported:
+            return Aecpdu::MAXIMUM_LENGTH_BIG_PAYLOADS;
+        case Support::Unsupported:
+            return Aecpdu::MAXIMUM_LENGTH_1722_1;
+        default:
+            return Aecpdu::getMaximumLength(_sendBigPayloads);
+    }
+}
+
+size_t AecpPayloadNegotiator::getMaximumRecvLength() const noexcept
+{
+    return Aecpdu::getMaximumLength(_recvBigPayloads);
+}
+
+size_t AecpPayloadNegotiator::getPeerCount() const noexcept
+{
+    return _peers.size();
+}
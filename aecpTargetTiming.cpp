@@ -0,0 +1,85 @@
+#include "aecpTargetTiming.hpp"
+#include <algorithm>
+
+/***********************************************************/
+/* AecpTargetTiming class definition                       */
+/***********************************************************/
+
+AecpTargetTiming::AecpTargetTiming(Configuration const& configuration) noexcept
+    : _configuration(configuration)
+{
+    _configuration.maxWindow = std::max<uint32_t>(_configuration.maxWindow, 1u);
+    _configuration.initialWindow = std::clamp<uint32_t>(_configuration.initialWindow, 1u, _configuration.maxWindow);
+    _configuration.maxTimeout = std::max(_configuration.maxTimeout, _configuration.minTimeout);
+    _window = _configuration.initialWindow * WindowScale;
+}
+
+void AecpTargetTiming::onResponse(std::chrono::microseconds const rtt) noexcept
+{
+    auto const sample = std::max<int64_t>(rtt.count(), 0);
+    if (_smoothedRtt == 0)
+    {
+        _smoothedRtt = std::max<int64_t>(sample, 1);
+        _rttVariation = sample / 2;
+    }
+    else
+    {
+        // RFC 6298 gains: 1/4 for the deviation, 1/8 for the mean
+        auto const error = sample - _smoothedRtt;
+        _rttVariation += ((error < 0 ? -error : error) - _rttVariation) / 4;
+        _smoothedRtt = std::max<int64_t>(_smoothedRtt + error / 8, 1);
+    }
+    _backoff = 0u;
+    grow();
+}
+
+void AecpTargetTiming::onSuccess() noexcept
+{
+    grow();
+}
+
+void AecpTargetTiming::onInProgress() noexcept
+{
+    _window = std::max(_window - std::min(_window, WindowScale), WindowScale);
+}
+
+void AecpTargetTiming::onTimeout() noexcept
+{
+    _window = std::max(_window / 2u, WindowScale);
+    _backoff = std::min(_backoff + 1u, MaxBackoff);
+}
+
+std::chrono::milliseconds AecpTargetTiming::getTimeout() const noexcept
+{
+    auto timeout = _configuration.initialTimeout;
+    if (_smoothedRtt != 0)
+    {
+        // At least 1ms of deviation, so a very regular entity is not retried on the slightest jitter
+        auto const micros = _smoothedRtt + std::max<int64_t>(4 * _rttVariation, 1000);
+        timeout = std::chrono::milliseconds{ (micros + 999) / 1000 };
+    }
+    timeout = std::clamp(timeout, _configuration.minTimeout, _configuration.maxTimeout);
+    return std::min(timeout * (1 << _backoff), _configuration.maxTimeout);
+}
+
+uint32_t AecpTargetTiming::getWindow() const noexcept
+{
+    return _window / WindowScale;
+}
+
+std::chrono::microseconds AecpTargetTiming::getSmoothedRtt() const noexcept
+{
+    return std::chrono::microseconds{ _smoothedRtt };
+}
+
+std::chrono::microseconds AecpTargetTiming::getRttVariation() const noexcept
+{
+    return std::chrono::microseconds{ _rttVariation };
+}
+
+void AecpTargetTiming::grow() noexcept
+{
+    // One more command per window of responses
+    auto const window = std::max(_window / WindowScale, 1u);
+    _window = std::min(_window + WindowScale / window, _configuration.maxWindow * WindowScale);
+}
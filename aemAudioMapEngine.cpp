@@ -0,0 +1,307 @@
+#include "aemAudioMapEngine.hpp"
+#include "endian.hpp"
+#include "esp_log.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+static const char* TAG = "AEM_AUDIO_MAP";
+
+static inline uint16_t readWord(const uint8_t* ptr) noexcept
+{
+    auto word = uint16_t{ 0u };
+    std::memcpy(&word, ptr, sizeof(word));
+    return ATDECC_UNPACK_WORD(word);
+}
+
+static inline void writeWord(uint8_t* ptr, uint16_t const value) noexcept
+{
+    auto const word = ATDECC_PACK_WORD(value);
+    std::memcpy(ptr, &word, sizeof(word));
+}
+
+static inline AudioMapping readMapping(const uint8_t* ptr) noexcept
+{
+    return AudioMapping{ readWord(ptr), readWord(ptr + 2), readWord(ptr + 4), readWord(ptr + 6) };
+}
+
+static inline void writeMapping(uint8_t* ptr, AudioMapping const& mapping) noexcept
+{
+    writeWord(ptr, mapping.streamIndex);
+    writeWord(ptr + 2, mapping.streamChannel);
+    writeWord(ptr + 4, mapping.clusterOffset);
+    writeWord(ptr + 6, mapping.clusterChannel);
+}
+
+/** Mappings in one map of GET_AUDIO_MAP, at least one whatever the payload length the controller announced */
+static size_t getMappingsPerMap(size_t const maximumPayloadLength) noexcept
+{
+    auto const payloadLength = std::clamp(maximumPayloadLength, AemAudioMapEngine::AudioMapPayloadHeaderLength + AudioMapping::size(), AemAecpdu::MAXIMUM_PAYLOAD_BUFFER_LENGTH);
+    return (payloadLength - AemAudioMapEngine::AudioMapPayloadHeaderLength) / AudioMapping::size();
+}
+
+/***********************************************************/
+/* AemAudioMapEngine class definition                      */
+/***********************************************************/
+
+AemAudioMapEngine::AemAudioMapEngine(DescriptorType const portType, DescriptorIndex const portIndex, uint16_t const streamCount, uint16_t const streamChannels, uint16_t const clusterCount, uint16_t const clusterChannels, uint16_t const maxMappings)
+    : _portType(portType), _portIndex(portIndex), _streamCount(streamCount), _streamChannels(streamChannels), _clusterCount(clusterCount), _clusterChannels(clusterChannels), _maxMappings(std::min<uint16_t>(maxMappings, NoMapping - 1u))
+{
+    if (portType != DescriptorType::StreamPortInput && portType != DescriptorType::StreamPortOutput)
+    {
+        ESP_LOGE(TAG, "Audio maps only exist on stream ports");
+    }
+
+    // Everything is allocated here, commands never allocate
+    auto const destinations = portType == DescriptorType::StreamPortInput ? static_cast<size_t>(clusterCount) * clusterChannels : static_cast<size_t>(streamCount) * streamChannels;
+    _mappings.reserve(_maxMappings);
+    _destinationSlots.assign(destinations, NoMapping);
+    _commandStamps.assign(destinations, 0u);
+}
+
+void AemAudioMapEngine::setMappingsChangedHandler(MappingsChangedHandler handler) noexcept
+{
+    _mappingsChangedHandler = std::move(handler);
+}
+
+AemCommandStatus AemAudioMapEngine::handleAddAudioMappings(AemAecpdu::Payload const& command)
+{
+    auto count = uint16_t{ 0u };
+    if (auto const status = checkCommand(command, count); status != AemCommandStatus::Success)
+    {
+        return status;
+    }
+    auto const* const mappings = static_cast<const uint8_t*>(command.first) + MappingsPayloadHeaderLength;
+
+    // First pass: validate the whole command, nothing is changed if a mapping is refused
+    auto const stamp = nextCommandStamp();
+    auto newMappings = size_t{ 0u };
+    for (auto i = 0u; i < count; ++i)
+    {
+        auto const mapping = readMapping(mappings + i * AudioMapping::size());
+        if (!isValid(mapping))
+        {
+            return AemCommandStatus::BadArguments;
+        }
+        auto const destination = getDestination(mapping);
+        if (_commandStamps[destination] == stamp)
+        {
+            ESP_LOGW(TAG, "Mapping %u: destination used twice in the command", i);
+            return AemCommandStatus::BadArguments;
+        }
+        _commandStamps[destination] = stamp;
+
+        auto const slot = _destinationSlots[destination];
+        if (slot == NoMapping)
+        {
+            ++newMappings;
+        }
+        else if (_mappings[slot] != mapping)
+        {
+            ESP_LOGW(TAG, "Mapping %u: destination already mapped", i);
+            return AemCommandStatus::BadArguments;
+        }
+    }
+    if (_mappings.size() + newMappings > _maxMappings)
+    {
+        return AemCommandStatus::NoResources;
+    }
+
+    // Second pass: apply, keeping the mappings actually added
+    auto deltaCount = size_t{ 0u };
+    for (auto i = 0u; i < count; ++i)
+    {
+        auto const mapping = readMapping(mappings + i * AudioMapping::size());
+        auto& slot = _destinationSlots[getDestination(mapping)];
+        if (slot != NoMapping)
+        {
+            continue;
+        }
+        slot = static_cast<uint16_t>(_mappings.size());
+        _mappings.push_back(mapping);
+        writeMapping(_delta.data() + MappingsPayloadHeaderLength + deltaCount++ * AudioMapping::size(), mapping);
+    }
+
+    notify(AemCommandType::ADD_AUDIO_MAPPINGS, deltaCount);
+    return AemCommandStatus::Success;
+}
+
+AemCommandStatus AemAudioMapEngine::handleRemoveAudioMappings(AemAecpdu::Payload const& command)
+{
+    auto count = uint16_t{ 0u };
+    if (auto const status = checkCommand(command, count); status != AemCommandStatus::Success)
+    {
+        return status;
+    }
+    auto const* const mappings = static_cast<const uint8_t*>(command.first) + MappingsPayloadHeaderLength;
+
+    for (auto i = 0u; i < count; ++i)
+    {
+        if (!isValid(readMapping(mappings + i * AudioMapping::size())))
+        {
+            return AemCommandStatus::BadArguments;
+        }
+    }
+
+    auto deltaCount = size_t{ 0u };
+    for (auto i = 0u; i < count; ++i)
+    {
+        auto const mapping = readMapping(mappings + i * AudioMapping::size());
+        auto const destination = getDestination(mapping);
+        auto const slot = _destinationSlots[destination];
+        if (slot == NoMapping || _mappings[slot] != mapping)
+        {
+            continue;
+        }
+
+        // Move the last mapping into the hole, so the mappings stay packed
+        auto const last = _mappings.size() - 1u;
+        if (slot != last)
+        {
+            _mappings[slot] = _mappings[last];
+            _destinationSlots[getDestination(_mappings[slot])] = slot;
+        }
+        _mappings.pop_back();
+        _destinationSlots[destination] = NoMapping;
+        writeMapping(_delta.data() + MappingsPayloadHeaderLength + deltaCount++ * AudioMapping::size(), mapping);
+    }
+
+    notify(AemCommandType::REMOVE_AUDIO_MAPPINGS, deltaCount);
+    return AemCommandStatus::Success;
+}
+
+AemCommandStatus AemAudioMapEngine::handleGetAudioMap(AemAecpdu::Payload const& command, uint8_t* response, size_t const responseCapacity, size_t& responseLength, size_t const maximumPayloadLength) const noexcept
+{
+    responseLength = 0u;
+    auto const* const payload = static_cast<const uint8_t*>(command.first);
+    if (payload == nullptr || command.second < 6u)
+    {
+        return AemCommandStatus::BadArguments;
+    }
+    if (static_cast<DescriptorType>(readWord(payload)) != _portType || readWord(payload + 2) != _portIndex)
+    {
+        return AemCommandStatus::NoSuchDescriptor;
+    }
+
+    auto const mapIndex = readWord(payload + 4);
+    auto const numberOfMaps = getNumberOfMaps(maximumPayloadLength);
+    if (mapIndex >= numberOfMaps)
+    {
+        return AemCommandStatus::BadArguments;
+    }
+
+    auto const perMap = getMappingsPerMap(maximumPayloadLength);
+    auto const first = static_cast<size_t>(mapIndex) * perMap;
+    auto const numberOfMappings = std::min(perMap, _mappings.size() - std::min(first, _mappings.size()));
+    auto const length = AudioMapPayloadHeaderLength + numberOfMappings * AudioMapping::size();
+    if (response == nullptr || length > responseCapacity)
+    {
+        ESP_LOGE(TAG, "GET_AUDIO_MAP response does not fit in %zu bytes", responseCapacity);
+        return AemCommandStatus::NoResources;
+    }
+
+    writeWord(response, static_cast<uint16_t>(_portType));
+    writeWord(response + 2, _portIndex);
+    writeWord(response + 4, mapIndex);
+    writeWord(response + 6, numberOfMaps);
+    writeWord(response + 8, static_cast<uint16_t>(numberOfMappings));
+    writeWord(response + 10, 0u);
+    for (auto i = size_t{ 0u }; i < numberOfMappings; ++i)
+    {
+        writeMapping(response + AudioMapPayloadHeaderLength + i * AudioMapping::size(), _mappings[first + i]);
+    }
+    responseLength = length;
+    return AemCommandStatus::Success;
+}
+
+void AemAudioMapEngine::clear() noexcept
+{
+    _mappings.clear();
+    std::fill(_destinationSlots.begin(), _destinationSlots.end(), NoMapping);
+}
+
+AudioMapping const* AemAudioMapEngine::getMapping(uint16_t const destinationIndex, uint16_t const destinationChannel) const noexcept
+{
+    auto const channels = _portType == DescriptorType::StreamPortInput ? _clusterChannels : _streamChannels;
+    auto const destination = static_cast<size_t>(destinationIndex) * channels + destinationChannel;
+    if (destinationChannel >= channels || destination >= _destinationSlots.size() || _destinationSlots[destination] == NoMapping)
+    {
+        return nullptr;
+    }
+    return &_mappings[_destinationSlots[destination]];
+}
+
+AudioMapping const* AemAudioMapEngine::getMappings() const noexcept
+{
+    return _mappings.data();
+}
+
+size_t AemAudioMapEngine::getMappingCount() const noexcept
+{
+    return _mappings.size();
+}
+
+MapIndex AemAudioMapEngine::getNumberOfMaps(size_t const maximumPayloadLength) const noexcept
+{
+    auto const perMap = getMappingsPerMap(maximumPayloadLength);
+    // An empty map is still one (empty) map
+    return static_cast<MapIndex>(std::max<size_t>(1u, (_mappings.size() + perMap - 1u) / perMap));
+}
+
+bool AemAudioMapEngine::isValid(AudioMapping const& mapping) const noexcept
+{
+    return mapping.streamIndex < _streamCount && mapping.streamChannel < _streamChannels && mapping.clusterOffset < _clusterCount && mapping.clusterChannel < _clusterChannels;
+}
+
+size_t AemAudioMapEngine::getDestination(AudioMapping const& mapping) const noexcept
+{
+    if (_portType == DescriptorType::StreamPortInput)
+    {
+        return static_cast<size_t>(mapping.clusterOffset) * _clusterChannels + mapping.clusterChannel;
+    }
+    return static_cast<size_t>(mapping.streamIndex) * _streamChannels + mapping.streamChannel;
+}
+
+AemCommandStatus AemAudioMapEngine::checkCommand(AemAecpdu::Payload const& command, uint16_t& count) const noexcept
+{
+    auto const* const payload = static_cast<const uint8_t*>(command.first);
+    if (payload == nullptr || command.second < MappingsPayloadHeaderLength)
+    {
+        return AemCommandStatus::BadArguments;
+    }
+    if (static_cast<DescriptorType>(readWord(payload)) != _portType || readWord(payload + 2) != _portIndex)
+    {
+        return AemCommandStatus::NoSuchDescriptor;
+    }
+    count = readWord(payload + 4);
+    if (command.second < MappingsPayloadHeaderLength + static_cast<size_t>(count) * AudioMapping::size())
+    {
+        ESP_LOGW(TAG, "number_of_mappings %u does not match the payload length %zu", count, command.second);
+        return AemCommandStatus::BadArguments;
+    }
+    return AemCommandStatus::Success;
+}
+
+uint16_t AemAudioMapEngine::nextCommandStamp() noexcept
+{
+    if (++_commandStamp == 0u)
+    {
+        // Wrapped: old stamps could match again
+        std::fill(_commandStamps.begin(), _commandStamps.end(), 0u);
+        _commandStamp = 1u;
+    }
+    return _commandStamp;
+}
+
+void AemAudioMapEngine::notify(AemCommandType const commandType, size_t const deltaCount)
+{
+    if (deltaCount == 0u || !_mappingsChangedHandler)
+    {
+        return;
+    }
+    writeWord(_delta.data(), static_cast<uint16_t>(_portType));
+    writeWord(_delta.data() + 2, _portIndex);
+    writeWord(_delta.data() + 4, static_cast<uint16_t>(deltaCount));
+    writeWord(_delta.data() + 6, 0u);
+    _mappingsChangedHandler(commandType, AemAecpdu::Payload{ _delta.data(), MappingsPayloadHeaderLength + deltaCount * AudioMapping::size() });
+}
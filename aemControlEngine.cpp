@@ -0,0 +1,379 @@
+#include "aemControlEngine.hpp"
+#include "endian.hpp"
+#include "esp_log.h"
+#include <cmath>
+#include <utility>
+
+static const char* TAG = "AEM_CONTROL";
+
+namespace
+{
+enum class ControlFamily : uint8_t
+{
+    Linear,
+    Selector,
+    Array,
+    Unsupported,
+};
+
+/** Returns the family of a control type, and its element type as the LINEAR type of the same number type */
+ControlFamily getControlFamily(ControlValueType::Type const type, ControlValueType::Type& elementType) noexcept
+{
+    auto const value = static_cast<uint16_t>(type);
+    if (value <= static_cast<uint16_t>(ControlValueType::Type::ControlLinearDouble))
+    {
+        elementType = type;
+        return ControlFamily::Linear;
+    }
+    if (value >= static_cast<uint16_t>(ControlValueType::Type::ControlSelectorInt8) && value <= static_cast<uint16_t>(ControlValueType::Type::ControlSelectorDouble))
+    {
+        elementType = static_cast<ControlValueType::Type>(value - static_cast<uint16_t>(ControlValueType::Type::ControlSelectorInt8));
+        return ControlFamily::Selector;
+    }
+    if (value >= static_cast<uint16_t>(ControlValueType::Type::ControlArrayInt8) && value <= static_cast<uint16_t>(ControlValueType::Type::ControlArrayDouble))
+    {
+        elementType = static_cast<ControlValueType::Type>(value - static_cast<uint16_t>(ControlValueType::Type::ControlArrayInt8));
+        return ControlFamily::Array;
+    }
+    return ControlFamily::Unsupported;
+}
+
+/** Calls visitor with a value of the C++ type of a LINEAR element type */
+template<typename Visitor>
+auto visitElementType(ControlValueType::Type const elementType, Visitor&& visitor)
+{
+    switch (elementType)
+    {
+        case ControlValueType::Type::ControlLinearInt8:
+            return visitor(int8_t{});
+        case ControlValueType::Type::ControlLinearUInt8:
+            return visitor(uint8_t{});
+        case ControlValueType::Type::ControlLinearInt16:
+            return visitor(int16_t{});
+        case ControlValueType::Type::ControlLinearUInt16:
+            return visitor(uint16_t{});
+        case ControlValueType::Type::ControlLinearInt32:
+            return visitor(int32_t{});
+        case ControlValueType::Type::ControlLinearUInt32:
+            return visitor(uint32_t{});
+        case ControlValueType::Type::ControlLinearInt64:
+            return visitor(int64_t{});
+        case ControlValueType::Type::ControlLinearUInt64:
+            return visitor(uint64_t{});
+        case ControlValueType::Type::ControlLinearFloat:
+            return visitor(float{});
+        default:
+            return visitor(double{});
+    }
+}
+
+/** Unaligned load in host order (from the storage, or from the wire before ATDECC_UNPACK_TYPE) */
+template<typename T>
+inline T loadHost(const uint8_t* ptr) noexcept
+{
+    auto value = T{};
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+/** Checks a value against minimum/maximum/step */
+template<typename T>
+bool isInRange(T const value, T const minimum, T const maximum, T const step) noexcept
+{
+    if constexpr (std::is_floating_point<T>::value)
+    {
+        // Floating point steps are not checked, rounding makes them meaningless on the wire
+        return !std::isnan(value) && value >= minimum && value <= maximum;
+    }
+    else
+    {
+        if (value < minimum || value > maximum)
+        {
+            return false;
+        }
+        if (step == T{ 0 })
+        {
+            return true;
+        }
+        // Unsigned difference, value >= minimum so it never wraps
+        using U = std::make_unsigned_t<T>;
+        return (static_cast<U>(static_cast<U>(value) - static_cast<U>(minimum)) % static_cast<U>(step)) == 0u;
+    }
+}
+} // namespace
+
+/***********************************************************/
+/* AemControlEngine class definition                       */
+/***********************************************************/
+
+void AemControlEngine::setValuesChangedHandler(ValuesChangedHandler handler) noexcept
+{
+    _valuesChangedHandler = std::move(handler);
+}
+
+void AemControlEngine::clear() noexcept
+{
+    _controls.fill(Control{});
+    _usedStorage = 0u;
+    _controlCount = 0u;
+}
+
+bool AemControlEngine::setValues(DescriptorIndex const descriptorIndex, const void* values, size_t const length) noexcept
+{
+    auto const* const control = findControl(descriptorIndex);
+    if (control == nullptr || values == nullptr || length != static_cast<size_t>(control->valueCount) * control->valueSize)
+    {
+        return false;
+    }
+    std::memcpy(_storage.data() + control->offset + static_cast<size_t>(control->limitCount) * control->valueSize, values, length);
+    return true;
+}
+
+AemCommandStatus AemControlEngine::handleSetControl(AemAecpdu::Payload const& command, uint8_t* response, size_t const responseCapacity, size_t& responseLength)
+{
+    responseLength = 0u;
+    auto const* const payload = static_cast<const uint8_t*>(command.first);
+    if (payload == nullptr || command.second < PayloadHeaderLength)
+    {
+        ESP_LOGW(TAG, "Malformed SET_CONTROL command");
+        return AemCommandStatus::BadArguments;
+    }
+
+    auto const descriptorType = static_cast<DescriptorType>(ATDECC_UNPACK_WORD(loadHost<uint16_t>(payload)));
+    auto const descriptorIndex = ATDECC_UNPACK_TYPE(loadHost<DescriptorIndex>(payload + 2), DescriptorIndex);
+    auto const* const control = descriptorType == DescriptorType::Control ? findControl(descriptorIndex) : nullptr;
+    if (control == nullptr)
+    {
+        return AemCommandStatus::NoSuchDescriptor;
+    }
+
+    auto const status = [this, control, payload, descriptorIndex, &command]()
+    {
+        if (control->readOnly)
+        {
+            return AemCommandStatus::NotSupported;
+        }
+        auto const valuesLength = static_cast<size_t>(control->valueCount) * control->valueSize;
+        if (command.second - PayloadHeaderLength != valuesLength)
+        {
+            ESP_LOGW(TAG, "SET_CONTROL %u: %zu bytes of values, expected %zu", descriptorIndex, command.second - PayloadHeaderLength, valuesLength);
+            return AemCommandStatus::BadArguments;
+        }
+
+        auto elementType = ControlValueType::Type::Expansion;
+        auto const family = getControlFamily(control->type, elementType);
+        auto* const storage = _storage.data() + control->offset;
+        auto* const values = storage + static_cast<size_t>(control->limitCount) * control->valueSize;
+        auto const* const wire = payload + PayloadHeaderLength;
+
+        return visitElementType(elementType, [control, family, storage, values, wire](auto const tag)
+        {
+            using T = std::decay_t<decltype(tag)>;
+            // Validate everything first, so a bad command leaves the control untouched
+            for (auto i = 0u; i < control->valueCount; ++i)
+            {
+                auto const value = ATDECC_UNPACK_TYPE(loadHost<T>(wire + i * sizeof(T)), T);
+                auto valid = false;
+                if (family == ControlFamily::Selector)
+                {
+                    for (auto o = 0u; o < control->limitCount && !valid; ++o)
+                    {
+                        valid = loadHost<T>(storage + o * sizeof(T)) == value;
+                    }
+                }
+                else
+                {
+                    valid = isInRange(value, loadHost<T>(storage), loadHost<T>(storage + sizeof(T)), loadHost<T>(storage + 2 * sizeof(T)));
+                }
+                if (!valid)
+                {
+                    return AemCommandStatus::BadArguments;
+                }
+            }
+            for (auto i = 0u; i < control->valueCount; ++i)
+            {
+                auto const value = ATDECC_UNPACK_TYPE(loadHost<T>(wire + i * sizeof(T)), T);
+                std::memcpy(values + i * sizeof(T), &value, sizeof(T));
+            }
+            return AemCommandStatus::Success;
+        });
+    }();
+
+    responseLength = encodeValues(descriptorIndex, response, responseCapacity);
+    if (status == AemCommandStatus::Success && _valuesChangedHandler)
+    {
+        _valuesChangedHandler(descriptorIndex);
+    }
+    return status;
+}
+
+AemCommandStatus AemControlEngine::handleGetControl(AemAecpdu::Payload const& command, uint8_t* response, size_t const responseCapacity, size_t& responseLength) const noexcept
+{
+    responseLength = 0u;
+    auto const* const payload = static_cast<const uint8_t*>(command.first);
+    if (payload == nullptr || command.second < PayloadHeaderLength)
+    {
+        ESP_LOGW(TAG, "Malformed GET_CONTROL command");
+        return AemCommandStatus::BadArguments;
+    }
+
+    auto const descriptorType = static_cast<DescriptorType>(ATDECC_UNPACK_WORD(loadHost<uint16_t>(payload)));
+    auto const descriptorIndex = ATDECC_UNPACK_TYPE(loadHost<DescriptorIndex>(payload + 2), DescriptorIndex);
+    if (descriptorType != DescriptorType::Control || findControl(descriptorIndex) == nullptr)
+    {
+        return AemCommandStatus::NoSuchDescriptor;
+    }
+
+    responseLength = encodeValues(descriptorIndex, response, responseCapacity);
+    return responseLength != 0u ? AemCommandStatus::Success : AemCommandStatus::NoResources;
+}
+
+size_t AemControlEngine::encodeValues(DescriptorIndex const descriptorIndex, uint8_t* buffer, size_t const capacity) const noexcept
+{
+    auto const* const control = findControl(descriptorIndex);
+    if (control == nullptr || buffer == nullptr)
+    {
+        return 0u;
+    }
+    auto const length = PayloadHeaderLength + static_cast<size_t>(control->valueCount) * control->valueSize;
+    if (length > capacity)
+    {
+        ESP_LOGE(TAG, "Control %u values do not fit in %zu bytes", descriptorIndex, capacity);
+        return 0u;
+    }
+
+    auto const descriptorType = ATDECC_PACK_WORD(static_cast<uint16_t>(DescriptorType::Control));
+    auto const index = ATDECC_PACK_TYPE(descriptorIndex, DescriptorIndex);
+    std::memcpy(buffer, &descriptorType, sizeof(descriptorType));
+    std::memcpy(buffer + 2, &index, sizeof(index));
+
+    auto elementType = ControlValueType::Type::Expansion;
+    getControlFamily(control->type, elementType);
+    auto const* const values = _storage.data() + control->offset + static_cast<size_t>(control->limitCount) * control->valueSize;
+    auto* const wire = buffer + PayloadHeaderLength;
+    visitElementType(elementType, [control, values, wire](auto const tag)
+    {
+        using T = std::decay_t<decltype(tag)>;
+        for (auto i = 0u; i < control->valueCount; ++i)
+        {
+            auto const value = ATDECC_PACK_TYPE(loadHost<T>(values + i * sizeof(T)), T);
+            std::memcpy(wire + i * sizeof(T), &value, sizeof(T));
+        }
+    });
+    return length;
+}
+
+bool AemControlEngine::hasControl(DescriptorIndex const descriptorIndex) const noexcept
+{
+    return findControl(descriptorIndex) != nullptr;
+}
+
+ControlValueType AemControlEngine::getControlValueType(DescriptorIndex const descriptorIndex) const noexcept
+{
+    auto const* const control = findControl(descriptorIndex);
+    if (control == nullptr)
+    {
+        return ControlValueType{};
+    }
+    return ControlValueType{ control->readOnly, false, control->type };
+}
+
+uint16_t AemControlEngine::getValueCount(DescriptorIndex const descriptorIndex) const noexcept
+{
+    auto const* const control = findControl(descriptorIndex);
+    return control != nullptr ? control->valueCount : 0u;
+}
+
+size_t AemControlEngine::getControlCount() const noexcept
+{
+    return _controlCount;
+}
+
+size_t AemControlEngine::getUsedStorage() const noexcept
+{
+    return _usedStorage;
+}
+
+bool AemControlEngine::addControl(ControlValueType::Type const type, DescriptorIndex const descriptorIndex, bool const readOnly, const void* limits, uint16_t const limitCount, const void* defaultValue, uint16_t const valueCount)
+{
+    if (descriptorIndex >= MaxControls)
+    {
+        ESP_LOGE(TAG, "Control %u out of range, increase ATDECC_AEM_MAX_CONTROLS", descriptorIndex);
+        return false;
+    }
+    if (_controls[descriptorIndex].inUse)
+    {
+        ESP_LOGE(TAG, "Control %u already defined", descriptorIndex);
+        return false;
+    }
+    if (valueCount == 0u || limitCount == 0u)
+    {
+        ESP_LOGE(TAG, "Control %u has no value", descriptorIndex);
+        return false;
+    }
+
+    auto elementType = ControlValueType::Type::Expansion;
+    if (getControlFamily(type, elementType) == ControlFamily::Unsupported)
+    {
+        ESP_LOGE(TAG, "Control %u: unsupported value type 0x%04x", descriptorIndex, static_cast<unsigned>(type));
+        return false;
+    }
+    auto const valueSize = visitElementType(elementType, [](auto const tag)
+    {
+        return static_cast<uint8_t>(sizeof(tag));
+    });
+
+    // Every control starts 8 bytes aligned, so its values can be read in place
+    auto const offset = (_usedStorage + 7u) & ~size_t{ 7u };
+    auto const size = (static_cast<size_t>(limitCount) + valueCount) * valueSize;
+    if (offset + size > StorageSize || PayloadHeaderLength + static_cast<size_t>(valueCount) * valueSize > AemAecpdu::MAXIMUM_PAYLOAD_BUFFER_LENGTH)
+    {
+        ESP_LOGE(TAG, "No room for control %u (%zu bytes), increase ATDECC_AEM_CONTROL_STORAGE_SIZE", descriptorIndex, size);
+        return false;
+    }
+
+    auto* const storage = _storage.data() + offset;
+    std::memcpy(storage, limits, static_cast<size_t>(limitCount) * valueSize);
+    for (auto i = 0u; i < valueCount; ++i)
+    {
+        std::memcpy(storage + (static_cast<size_t>(limitCount) + i) * valueSize, defaultValue, valueSize);
+    }
+
+    auto& control = _controls[descriptorIndex];
+    control.type = type;
+    control.offset = static_cast<uint32_t>(offset);
+    control.limitCount = limitCount;
+    control.valueCount = valueCount;
+    control.valueSize = valueSize;
+    control.readOnly = readOnly;
+    control.inUse = true;
+    _usedStorage = offset + size;
+    ++_controlCount;
+    return true;
+}
+
+AemControlEngine::Control const* AemControlEngine::findControl(DescriptorIndex const descriptorIndex) const noexcept
+{
+    if (descriptorIndex >= MaxControls || !_controls[descriptorIndex].inUse)
+    {
+        return nullptr;
+    }
+    return &_controls[descriptorIndex];
+}
+
+const uint8_t* AemControlEngine::getValuePointer(DescriptorIndex const descriptorIndex, uint16_t const valueIndex, ControlValueType::Type const linearType) const noexcept
+{
+    auto const* const control = findControl(descriptorIndex);
+    if (control == nullptr || valueIndex >= control->valueCount)
+    {
+        return nullptr;
+    }
+    auto elementType = ControlValueType::Type::Expansion;
+    getControlFamily(control->type, elementType);
+    if (elementType != linearType)
+    {
+        ESP_LOGE(TAG, "Control %u: value type mismatch", descriptorIndex);
+        return nullptr;
+    }
+    return _storage.data() + control->offset + (static_cast<size_t>(control->limitCount) + valueIndex) * control->valueSize;
+}
@@ -0,0 +1,269 @@
+#include "aemCounterPoller.hpp"
+#include "esp_log.h"
+#include "protocolAemAecpdu.hpp"
+#include "protocolAemPayloads.hpp"
+#include "protocolAemPayloadSizes.hpp"
+#include <algorithm>
+#include <utility>
+
+static const char* TAG = "AEM_COUNTER_POLL";
+
+static_assert(AemCounterPoller::HistoryDepth >= 2u && AemCounterPoller::HistoryDepth <= 255u, "History depth must fit the ring indexes");
+
+/** Per second rate between two values of a counter, wrapping counters included */
+static float computeRate(DescriptorCounter const from, DescriptorCounter const to, AecpClock::duration const elapsed) noexcept
+{
+    auto const seconds = std::chrono::duration<float>(elapsed).count();
+    if (seconds <= 0.f)
+    {
+        return 0.f;
+    }
+    return static_cast<float>(static_cast<DescriptorCounter>(to - from)) / seconds;
+}
+
+/***********************************************************/
+/* AemCounterPoller class definition                       */
+/***********************************************************/
+
+AemCounterPoller::AemCounterPoller(UniqueIdentifier const controllerID, AecpSendHandler sendHandler, uint32_t const commandsPerSecond, std::chrono::milliseconds const interval, size_t const window, std::chrono::milliseconds const timeout) noexcept
+    : _commands(controllerID, std::move(sendHandler), window, timeout), _commandsPerSecond(std::max(commandsPerSecond, 1u)), _interval(interval)
+{
+}
+
+void AemCounterPoller::setCountersChangedHandler(CountersChangedHandler handler) noexcept
+{
+    _countersChangedHandler = std::move(handler);
+}
+
+void AemCounterPoller::setTimeoutHandler(AecpTimeoutHandler handler) noexcept
+{
+    _commands.setTimeoutHandler(std::move(handler));
+}
+
+bool AemCounterPoller::addTarget(UniqueIdentifier const entityID, MacAddress const& macAddress, DescriptorType const descriptorType, DescriptorIndex const descriptorIndex)
+{
+    if (findTarget(entityID, descriptorType, descriptorIndex) != nullptr)
+    {
+        return false;
+    }
+    auto& target = _targets.emplace_back();
+    target.entityID = entityID;
+    target.macAddress = macAddress;
+    target.descriptorType = descriptorType;
+    target.descriptorIndex = descriptorIndex;
+    return true;
+}
+
+void AemCounterPoller::removeEntity(UniqueIdentifier const entityID) noexcept
+{
+    _commands.releaseEntity(entityID);
+
+    // Keep the polling order, and the inflight commands of the other entities on their target
+    auto kept = size_t{ 0u };
+    auto removedBeforeNext = size_t{ 0u };
+    for (auto i = size_t{ 0u }; i < _targets.size(); ++i)
+    {
+        if (_targets[i].entityID == entityID)
+        {
+            if (i < _nextTarget)
+            {
+                ++removedBeforeNext;
+            }
+            continue;
+        }
+        if (kept != i)
+        {
+            _commands.forEach([i, kept](auto& command)
+            {
+                if (command.context == i)
+                {
+                    command.context = kept;
+                }
+            });
+            _targets[kept] = _targets[i];
+        }
+        ++kept;
+    }
+    _targets.resize(kept);
+    _nextTarget -= removedBeforeNext;
+}
+
+bool AemCounterPoller::handleAecpdu(Aecpdu const& aecpdu, AecpClock::time_point const now)
+{
+    auto const command = _commands.handleResponse(aecpdu, AemCommandType::GET_COUNTERS);
+    if (!command)
+    {
+        return false;
+    }
+    auto& target = _targets[command->context];
+    target.inflight = false;
+
+    auto const& aem = static_cast<AemAecpdu const&>(aecpdu);
+    auto const status = static_cast<AemCommandStatus>(aecpdu.getStatus());
+    auto const payload = aem.getPayload();
+    if (status != AemCommandStatus::Success || payload.second < AECP_AEM_GET_COUNTERS_RESPONSE_PAYLOAD_SIZE)
+    {
+        ++_metrics.errors;
+        return true;
+    }
+
+    auto const [descriptorType, descriptorIndex, validCounters, counters] = deserializeGetCountersResponse(status, payload);
+    if (descriptorType != target.descriptorType || descriptorIndex != target.descriptorIndex)
+    {
+        ESP_LOGW(TAG, "GET_COUNTERS response for another descriptor");
+        ++_metrics.errors;
+        return true;
+    }
+
+    ++_metrics.responses;
+    addSample(target, validCounters, counters, now);
+    return true;
+}
+
+void AemCounterPoller::poll(AecpClock::time_point const now)
+{
+    _commands.releaseExpired(now, [this](auto const& command)
+    {
+        _targets[command.context].inflight = false;
+        ++_metrics.timeouts;
+    });
+
+    // Token bucket, the burst is limited to the window
+    auto const window = static_cast<float>(_commands.getWindow());
+    _budget += _lastRefill != AecpClock::time_point{} ? std::chrono::duration<float>(now - _lastRefill).count() * static_cast<float>(_commandsPerSecond) : window;
+    _budget = std::min(_budget, window);
+    _lastRefill = now;
+
+    // At most one pass over the targets, from where the previous call stopped
+    for (auto scanned = size_t{ 0u }; scanned < _targets.size() && !_commands.isFull(); ++scanned)
+    {
+        if (_nextTarget >= _targets.size())
+        {
+            _nextTarget = 0u;
+        }
+        auto const& target = _targets[_nextTarget];
+        if (target.inflight || (target.lastPoll != AecpClock::time_point{} && now - target.lastPoll < _interval))
+        {
+            ++_nextTarget;
+            continue;
+        }
+        if (_budget < 1.f)
+        {
+            ++_metrics.throttled;
+            return;
+        }
+        if (!send(_nextTarget, now))
+        {
+            return;
+        }
+        ++_nextTarget;
+        _budget -= 1.f;
+    }
+}
+
+float AemCounterPoller::getRate(UniqueIdentifier const entityID, DescriptorType const descriptorType, DescriptorIndex const descriptorIndex, size_t const counterSlot) const noexcept
+{
+    auto const* const target = findTarget(entityID, descriptorType, descriptorIndex);
+    if (target == nullptr || target->historyCount < 2u || counterSlot >= CounterCount)
+    {
+        return 0.f;
+    }
+    auto const& newest = target->history[(target->historyHead + HistoryDepth - 1u) % HistoryDepth];
+    auto const& oldest = target->history[(target->historyHead + HistoryDepth - target->historyCount) % HistoryDepth];
+    return computeRate(oldest.counters[counterSlot], newest.counters[counterSlot], newest.time - oldest.time);
+}
+
+size_t AemCounterPoller::getHistory(UniqueIdentifier const entityID, DescriptorType const descriptorType, DescriptorIndex const descriptorIndex, Sample* samples, size_t const maxSamples) const noexcept
+{
+    auto const* const target = findTarget(entityID, descriptorType, descriptorIndex);
+    if (target == nullptr || samples == nullptr)
+    {
+        return 0u;
+    }
+    auto const count = std::min<size_t>(target->historyCount, maxSamples);
+    for (auto i = size_t{ 0u }; i < count; ++i)
+    {
+        // The most recent ones if they do not all fit
+        samples[i] = target->history[(target->historyHead + HistoryDepth - count + i) % HistoryDepth];
+    }
+    return count;
+}
+
+AemCounterPoller::Metrics const& AemCounterPoller::getMetrics() const noexcept
+{
+    return _metrics;
+}
+
+size_t AemCounterPoller::getTargetCount() const noexcept
+{
+    return _targets.size();
+}
+
+size_t AemCounterPoller::getInflightCount() const noexcept
+{
+    return _commands.size();
+}
+
+AemCounterPoller::Target const* AemCounterPoller::findTarget(UniqueIdentifier const entityID, DescriptorType const descriptorType, DescriptorIndex const descriptorIndex) const noexcept
+{
+    auto const it = std::find_if(_targets.begin(), _targets.end(), [&](Target const& target)
+    {
+        return target.entityID == entityID && target.descriptorType == descriptorType && target.descriptorIndex == descriptorIndex;
+    });
+    return it != _targets.end() ? &*it : nullptr;
+}
+
+bool AemCounterPoller::send(size_t const targetIndex, AecpClock::time_point const now)
+{
+    auto& target = _targets[targetIndex];
+    auto const ser = serializeGetCountersCommand(target.descriptorType, target.descriptorIndex);
+
+    // Marked first, the send handler may deliver the response right away
+    target.inflight = true;
+    if (!_commands.send(target.entityID, target.macAddress, AemCommandType::GET_COUNTERS, ser.data(), ser.size(), targetIndex, now))
+    {
+        target.inflight = false;
+        return false;
+    }
+    target.lastPoll = now;
+    ++_metrics.commands;
+    return true;
+}
+
+void AemCounterPoller::addSample(Target& target, DescriptorCounterValidFlag const validCounters, DescriptorCounters const& counters, AecpClock::time_point const now)
+{
+    auto changedCounters = DescriptorCounterValidFlag{ 0u };
+    CounterRates rates{};
+    if (target.historyCount == 0u)
+    {
+        changedCounters = validCounters;
+    }
+    else
+    {
+        auto const& previous = target.history[(target.historyHead + HistoryDepth - 1u) % HistoryDepth];
+        for (auto slot = size_t{ 0u }; slot < CounterCount; ++slot)
+        {
+            auto const flag = DescriptorCounterValidFlag{ 1u } << slot;
+            if ((validCounters & flag) != 0u && counters[slot] != previous.counters[slot])
+            {
+                changedCounters |= flag;
+                rates[slot] = computeRate(previous.counters[slot], counters[slot], now - previous.time);
+            }
+        }
+    }
+
+    auto& sample = target.history[target.historyHead];
+    sample.time = now;
+    sample.counters = counters;
+    target.historyHead = static_cast<uint8_t>((target.historyHead + 1u) % HistoryDepth);
+    target.historyCount = static_cast<uint8_t>(std::min<size_t>(target.historyCount + 1u, HistoryDepth));
+
+    if (changedCounters != 0u)
+    {
+        ++_metrics.changes;
+        if (_countersChangedHandler)
+        {
+            _countersChangedHandler(target.entityID, target.descriptorType, target.descriptorIndex, changedCounters, counters, rates);
+        }
+    }
+}
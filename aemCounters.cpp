@@ -0,0 +1,201 @@
+#include "aemCounters.hpp"
+#include "esp_log.h"
+#include "protocolAemPayloads.hpp"
+#include <cstring>
+
+static const char* TAG = "AEM_COUNTERS";
+
+/** Copies of all the counters before using a changing one (each counter is still exact) */
+static constexpr auto MaxSnapshotAttempts = 4u;
+
+/***********************************************************/
+/* AemCounterBlock class definition                        */
+/***********************************************************/
+
+void AemCounterBlock::incrementSlot(size_t const slot, DescriptorCounter const count) noexcept
+{
+    if (slot < CounterCount)
+    {
+        _counters[slot].fetch_add(count, std::memory_order_relaxed);
+    }
+}
+
+void AemCounterBlock::setSlot(size_t const slot, DescriptorCounter const value) noexcept
+{
+    if (slot < CounterCount)
+    {
+        _counters[slot].store(value, std::memory_order_relaxed);
+    }
+}
+
+bool AemCounterBlock::snapshot(DescriptorCounters& counters) const noexcept
+{
+    // Counters are incremented (setSlot() values are not expected to go back): two identical
+    // copies in a row mean nothing changed in between, so related counters
+    // (eg. STREAM_START / STREAM_STOP) are seen consistent.
+    for (auto i = 0u; i < CounterCount; ++i)
+    {
+        counters[i] = _counters[i].load(std::memory_order_relaxed);
+    }
+    for (auto attempt = 1u; attempt < MaxSnapshotAttempts; ++attempt)
+    {
+        auto stable = true;
+        for (auto i = 0u; i < CounterCount; ++i)
+        {
+            auto const value = _counters[i].load(std::memory_order_relaxed);
+            if (value != counters[i])
+            {
+                counters[i] = value;
+                stable = false;
+            }
+        }
+        if (stable)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+DescriptorType AemCounterBlock::getDescriptorType() const noexcept
+{
+    return _descriptorType;
+}
+
+DescriptorIndex AemCounterBlock::getDescriptorIndex() const noexcept
+{
+    return _descriptorIndex;
+}
+
+DescriptorCounterValidFlag AemCounterBlock::getValidCounters() const noexcept
+{
+    return _validCounters;
+}
+
+/***********************************************************/
+/* AemCounterBank class definition                         */
+/***********************************************************/
+
+AemCounterBlock* AemCounterBank::addBlock(DescriptorType const descriptorType, DescriptorIndex const descriptorIndex, DescriptorCounterValidFlag const validCounters) noexcept
+{
+    if (auto* const block = findBlock(descriptorType, descriptorIndex))
+    {
+        block->_validCounters |= validCounters;
+        return block;
+    }
+    if (_blockCount >= MaxBlocks)
+    {
+        ESP_LOGE(TAG, "Too many counter blocks");
+        return nullptr;
+    }
+
+    auto& block = _blocks[_blockCount++];
+    block._descriptorType = descriptorType;
+    block._descriptorIndex = descriptorIndex;
+    block._validCounters = validCounters;
+    ESP_LOGI(TAG, "Counters of descriptor %u/%u, valid 0x%08x", static_cast<unsigned>(descriptorType), descriptorIndex, static_cast<unsigned>(validCounters));
+    return &block;
+}
+
+void AemCounterBank::setUnsolicitedNotifier(AemUnsolicitedNotifier* notifier, std::chrono::milliseconds const period) noexcept
+{
+    _notifier = notifier;
+    _notificationPeriod = period;
+}
+
+AemCommandStatus AemCounterBank::handleGetCounters(AemAecpdu::Payload const& command, uint8_t* response, size_t const responseCapacity, size_t& responseLength) const noexcept
+{
+    responseLength = 0u;
+    auto const* const payload = static_cast<const uint8_t*>(command.first);
+    if (payload == nullptr || command.second < AECP_AEM_GET_COUNTERS_COMMAND_PAYLOAD_SIZE)
+    {
+        ESP_LOGW(TAG, "Malformed GET_COUNTERS command");
+        return AemCommandStatus::BadArguments;
+    }
+
+    auto descriptorType = uint16_t{ 0u };
+    auto descriptorIndex = DescriptorIndex{ 0u };
+    std::memcpy(&descriptorType, payload, sizeof(descriptorType));
+    std::memcpy(&descriptorIndex, payload + 2, sizeof(descriptorIndex));
+    auto const* const block = findBlock(static_cast<DescriptorType>(ATDECC_UNPACK_WORD(descriptorType)), ATDECC_UNPACK_WORD(descriptorIndex));
+    if (block == nullptr)
+    {
+        return AemCommandStatus::NoSuchDescriptor;
+    }
+
+    DescriptorCounters counters;
+    if (!block->snapshot(counters))
+    {
+        ESP_LOGD(TAG, "Counters of descriptor %u/%u changing while read, answering with the last values", static_cast<unsigned>(block->getDescriptorType()), block->getDescriptorIndex());
+    }
+    responseLength = encodeResponse(*block, counters, response, responseCapacity);
+    return responseLength != 0u ? AemCommandStatus::Success : AemCommandStatus::NoResources;
+}
+
+void AemCounterBank::checkNotifications(AecpClock::time_point const now)
+{
+    if (_notifier == nullptr || now < _nextNotification)
+    {
+        return;
+    }
+    // Stay on the period grid, unless too late
+    _nextNotification = (now - _nextNotification) < _notificationPeriod ? _nextNotification + _notificationPeriod : now + _notificationPeriod;
+
+    if (_notifier->getSubscriberCount() == 0u)
+    {
+        return;
+    }
+
+    std::array<uint8_t, AECP_AEM_GET_COUNTERS_RESPONSE_PAYLOAD_SIZE> payload;
+    DescriptorCounters counters;
+    for (auto i = size_t{ 0u }; i < _blockCount; ++i)
+    {
+        auto const& block = _blocks[i];
+        // Not consistent (busy counters): notified at the next period
+        if (!block.snapshot(counters) || counters == _notifiedCounters[i])
+        {
+            continue;
+        }
+        _notifiedCounters[i] = counters;
+
+        auto const length = encodeResponse(block, counters, payload.data(), payload.size());
+        if (length != 0u)
+        {
+            _notifier->notifyChanged(AemCommandType::GET_COUNTERS, block.getDescriptorType(), block.getDescriptorIndex(), AemAecpdu::Payload{ payload.data(), length }, UniqueIdentifier{}, now);
+        }
+    }
+}
+
+AemCounterBlock* AemCounterBank::findBlock(DescriptorType const descriptorType, DescriptorIndex const descriptorIndex) noexcept
+{
+    return const_cast<AemCounterBlock*>(static_cast<AemCounterBank const*>(this)->findBlock(descriptorType, descriptorIndex));
+}
+
+AemCounterBlock const* AemCounterBank::findBlock(DescriptorType const descriptorType, DescriptorIndex const descriptorIndex) const noexcept
+{
+    for (auto i = size_t{ 0u }; i < _blockCount; ++i)
+    {
+        if (_blocks[i]._descriptorType == descriptorType && _blocks[i]._descriptorIndex == descriptorIndex)
+        {
+            return &_blocks[i];
+        }
+    }
+    return nullptr;
+}
+
+size_t AemCounterBank::getBlockCount() const noexcept
+{
+    return _blockCount;
+}
+
+size_t AemCounterBank::encodeResponse(AemCounterBlock const& block, DescriptorCounters const& counters, uint8_t* buffer, size_t const capacity) const noexcept
+{
+    if (buffer == nullptr || capacity < AECP_AEM_GET_COUNTERS_RESPONSE_PAYLOAD_SIZE)
+    {
+        ESP_LOGE(TAG, "GET_COUNTERS response does not fit in %zu bytes", capacity);
+        return 0u;
+    }
+    auto const ser = serializeGetCountersResponse(block.getDescriptorType(), block.getDescriptorIndex(), block.getValidCounters(), counters);
+    std::memcpy(buffer, ser.data(), ser.usedBytes());
+    return ser.usedBytes();
+}
@@ -0,0 +1,258 @@
+#include "aemMetering.hpp"
+#include "esp_log.h"
+#include "protocolAemAecpdu.hpp"
+#include "protocolAemPayloads.hpp"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+static const char* TAG = "AEM_METER";
+
+/** Attempts to read a consistent snapshot before using a possibly torn one (levels only, no harm) */
+static constexpr auto MaxSnapshotAttempts = 4u;
+
+/***********************************************************/
+/* AemMeterBank class definition                           */
+/***********************************************************/
+
+AemMeterBank::AemMeterBank(AemControlEngine& engine) noexcept
+    : _engine(engine)
+{
+    _meterByControl.fill(InvalidMeter);
+}
+
+bool AemMeterBank::refresh(DescriptorIndex const descriptorIndex) noexcept
+{
+    if (!isMeter(descriptorIndex))
+    {
+        return false;
+    }
+    return refreshMeter(_meters[_meterByControl[descriptorIndex]]);
+}
+
+void AemMeterBank::refreshAll() noexcept
+{
+    for (auto i = 0u; i < _meterCount; ++i)
+    {
+        refreshMeter(_meters[i]);
+    }
+}
+
+bool AemMeterBank::isMeter(DescriptorIndex const descriptorIndex) const noexcept
+{
+    return descriptorIndex < _meterByControl.size() && _meterByControl[descriptorIndex] != InvalidMeter;
+}
+
+size_t AemMeterBank::getMeterCount() const noexcept
+{
+    return _meterCount;
+}
+
+AemMeterBank::MeterHandle AemMeterBank::registerMeter(DescriptorIndex const descriptorIndex, uint16_t const valueCount, uint8_t const valueSize) noexcept
+{
+    auto const handle = static_cast<MeterHandle>(_meterCount++);
+    auto& meter = _meters[handle];
+    meter.descriptorIndex = descriptorIndex;
+    meter.offset = static_cast<uint16_t>(_valueCount);
+    meter.valueCount = valueCount;
+    meter.valueSize = valueSize;
+    _valueCount += valueCount;
+    _meterByControl[descriptorIndex] = handle;
+    ESP_LOGI(TAG, "Meter %u: control %u, %u channels", handle, descriptorIndex, valueCount);
+    return handle;
+}
+
+void AemMeterBank::publishValues(MeterHandle const handle, const void* values, size_t const valueSize) noexcept
+{
+    if (handle >= _meterCount || values == nullptr)
+    {
+        return;
+    }
+    auto& meter = _meters[handle];
+    if (valueSize != meter.valueSize)
+    {
+        return;
+    }
+
+    // Sequence lock: odd while writing, the reader retries if it changed under it
+    auto const sequence = meter.sequence.load(std::memory_order_relaxed);
+    meter.sequence.store(sequence + 1u, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    auto const* const src = static_cast<const uint8_t*>(values);
+    for (auto i = 0u; i < meter.valueCount; ++i)
+    {
+        auto word = uint32_t{ 0u };
+        std::memcpy(&word, src + i * valueSize, valueSize);
+        _values[meter.offset + i].store(word, std::memory_order_relaxed);
+    }
+
+    meter.sequence.store(sequence + 2u, std::memory_order_release);
+}
+
+bool AemMeterBank::refreshMeter(Meter const& meter) noexcept
+{
+    std::array<uint8_t, MaxMeterValues * sizeof(uint32_t)> snapshot;
+
+    for (auto attempt = 0u; attempt < MaxSnapshotAttempts; ++attempt)
+    {
+        auto const before = meter.sequence.load(std::memory_order_acquire);
+        for (auto i = 0u; i < meter.valueCount; ++i)
+        {
+            auto const word = _values[meter.offset + i].load(std::memory_order_relaxed);
+            std::memcpy(snapshot.data() + i * meter.valueSize, &word, meter.valueSize);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if ((before & 1u) == 0u && meter.sequence.load(std::memory_order_relaxed) == before)
+        {
+            break;
+        }
+    }
+
+    return _engine.setValues(meter.descriptorIndex, snapshot.data(), static_cast<size_t>(meter.valueCount) * meter.valueSize);
+}
+
+/***********************************************************/
+/* AemMeterPoller class definition                         */
+/***********************************************************/
+
+AemMeterPoller::AemMeterPoller(UniqueIdentifier const controllerID, AecpSendHandler sendHandler, std::chrono::milliseconds const period, size_t const window, std::chrono::milliseconds const timeout) noexcept
+    : _commands(controllerID, std::move(sendHandler), window, timeout), _period(period)
+{
+}
+
+void AemMeterPoller::setValuesHandler(ValuesHandler handler) noexcept
+{
+    _valuesHandler = std::move(handler);
+}
+
+void AemMeterPoller::setTimeoutHandler(AecpTimeoutHandler handler) noexcept
+{
+    _commands.setTimeoutHandler(std::move(handler));
+}
+
+bool AemMeterPoller::addTarget(UniqueIdentifier const entityID, MacAddress const& macAddress, DescriptorIndex const descriptorIndex) noexcept
+{
+    auto const end = _targets.begin() + _targetCount;
+    if (std::any_of(_targets.begin(), end, [entityID, descriptorIndex](Target const& target)
+        {
+            return target.entityID == entityID && target.descriptorIndex == descriptorIndex;
+        }))
+    {
+        return false;
+    }
+    if (_targetCount >= MaxTargets)
+    {
+        ESP_LOGE(TAG, "Too many meters to poll");
+        return false;
+    }
+    _targets[_targetCount++] = Target{ entityID, macAddress, descriptorIndex };
+    return true;
+}
+
+void AemMeterPoller::removeEntity(UniqueIdentifier const entityID) noexcept
+{
+    // Keep the polling order, so the current period goes on where it was
+    auto removedBeforeNext = size_t{ 0u };
+    auto kept = size_t{ 0u };
+    for (auto i = size_t{ 0u }; i < _targetCount; ++i)
+    {
+        if (_targets[i].entityID == entityID)
+        {
+            if (i < _nextTarget)
+            {
+                ++removedBeforeNext;
+            }
+            continue;
+        }
+        _targets[kept++] = _targets[i];
+    }
+    _targetCount = kept;
+    _nextTarget -= removedBeforeNext;
+
+    _commands.releaseEntity(entityID);
+}
+
+bool AemMeterPoller::handleAecpdu(Aecpdu const& aecpdu, AecpClock::time_point const now)
+{
+    auto const command = _commands.handleResponse(aecpdu, AemCommandType::GET_CONTROL);
+    if (!command)
+    {
+        return false;
+    }
+
+    auto const& aem = static_cast<AemAecpdu const&>(aecpdu);
+    auto const payload = aem.getPayload();
+    if (static_cast<AemCommandStatus>(aecpdu.getStatus()) != AemCommandStatus::Success || payload.second < AemControlEngine::PayloadHeaderLength)
+    {
+        ++_metrics.errors;
+    }
+    else
+    {
+        ++_metrics.responses;
+        if (_valuesHandler)
+        {
+            auto const* const data = static_cast<const uint8_t*>(payload.first);
+            _valuesHandler(command->entityID, static_cast<DescriptorIndex>(command->context), data + AemControlEngine::PayloadHeaderLength, payload.second - AemControlEngine::PayloadHeaderLength);
+        }
+    }
+
+    // Use the free slot right away
+    poll(now);
+    return true;
+}
+
+void AemMeterPoller::poll(AecpClock::time_point const now)
+{
+    _commands.releaseExpired(now, [this](auto const&)
+    {
+        ++_metrics.timeouts;
+    });
+
+    if (now >= _nextCycle && _targetCount != 0u)
+    {
+        if (_nextTarget < _targetCount && _metrics.cycles != 0u)
+        {
+            // Previous period not fully sent: finish it first, the new one starts right after
+            if (!_overrun)
+            {
+                ++_metrics.overruns;
+                _overrun = true;
+            }
+        }
+        else
+        {
+            ++_metrics.cycles;
+            _overrun = false;
+            _nextTarget = 0u;
+            // Stay on the period grid, unless too late
+            _nextCycle = (now - _nextCycle) < _period ? _nextCycle + _period : now + _period;
+        }
+    }
+
+    while (_nextTarget < _targetCount)
+    {
+        auto const& target = _targets[_nextTarget];
+        auto const ser = serializeGetControlCommand(DescriptorType::Control, target.descriptorIndex);
+        if (!_commands.send(target.entityID, target.macAddress, AemCommandType::GET_CONTROL, ser.data(), ser.size(), target.descriptorIndex, now))
+        {
+            return;
+        }
+        ++_nextTarget;
+    }
+}
+
+AemMeterPoller::Metrics const& AemMeterPoller::getMetrics() const noexcept
+{
+    return _metrics;
+}
+
+size_t AemMeterPoller::getTargetCount() const noexcept
+{
+    return _targetCount;
+}
+
+size_t AemMeterPoller::getInflightCount() const noexcept
+{
+    return _commands.size();
+}
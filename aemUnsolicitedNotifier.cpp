@@ -0,0 +1,231 @@
+#include "aemUnsolicitedNotifier.hpp"
+#include "esp_log.h"
+#include <cstring>
+#include <utility>
+
+static const char* TAG = "AEM_UNSOL";
+
+/***********************************************************/
+/* AemUnsolicitedNotifier class definition                 */
+/***********************************************************/
+
+AemUnsolicitedNotifier::AemUnsolicitedNotifier(UniqueIdentifier const entityID, AecpSendHandler sendHandler, std::chrono::milliseconds const minInterval, std::chrono::milliseconds const subscriptionTimeout) noexcept
+    : _entityID(entityID), _sendHandler(std::move(sendHandler)), _minInterval(minInterval), _subscriptionTimeout(subscriptionTimeout)
+{
+    _message.setTargetEntityID(_entityID);
+    _message.setStatus(AecpStatus::SUCCESS);
+    _message.setUnsolicited(true);
+}
+
+AemCommandStatus AemUnsolicitedNotifier::registerController(UniqueIdentifier const controllerID, MacAddress const& macAddress, AecpClock::time_point const now) noexcept
+{
+    // Registering again only refreshes the registration
+    auto* subscriber = findSubscriber(controllerID);
+    if (subscriber == nullptr)
+    {
+        for (auto& s : _subscribers)
+        {
+            if (!s.inUse)
+            {
+                subscriber = &s;
+                break;
+            }
+        }
+        if (subscriber == nullptr)
+        {
+            ESP_LOGW(TAG, "No room to register controller 0x%016llx", static_cast<unsigned long long>(controllerID.getValue()));
+            return AemCommandStatus::NoResources;
+        }
+        *subscriber = Subscriber{ controllerID };
+        subscriber->inUse = true;
+        ++_subscriberCount;
+    }
+
+    subscriber->macAddress = macAddress;
+    subscriber->lastSeen = now;
+    return AemCommandStatus::Success;
+}
+
+void AemUnsolicitedNotifier::deregisterController(UniqueIdentifier const controllerID) noexcept
+{
+    auto* subscriber = findSubscriber(controllerID);
+    if (subscriber != nullptr)
+    {
+        subscriber->inUse = false;
+        --_subscriberCount;
+    }
+}
+
+void AemUnsolicitedNotifier::touchController(UniqueIdentifier const controllerID, AecpClock::time_point const now) noexcept
+{
+    auto* subscriber = findSubscriber(controllerID);
+    if (subscriber != nullptr)
+    {
+        subscriber->lastSeen = now;
+    }
+}
+
+void AemUnsolicitedNotifier::notifyChanged(AemCommandType const commandType, DescriptorType const descriptorType, DescriptorIndex const descriptorIndex, AemAecpdu::Payload const& payload, UniqueIdentifier const sourceController, AecpClock::time_point const now)
+{
+    if (_subscriberCount == 0u)
+    {
+        return;
+    }
+    if (payload.second > AemAecpdu::MAXIMUM_SEND_PAYLOAD_BUFFER_LENGTH)
+    {
+        ESP_LOGE(TAG, "Notification payload too big");
+        return;
+    }
+
+    Notification* notification = nullptr;
+    for (auto& n : _notifications)
+    {
+        if (n.inUse && n.commandType == commandType && n.descriptorType == descriptorType && n.descriptorIndex == descriptorIndex)
+        {
+            notification = &n;
+            break;
+        }
+    }
+    if (notification == nullptr)
+    {
+        notification = allocateNotification(now);
+        notification->commandType = commandType;
+        notification->descriptorType = descriptorType;
+        notification->descriptorIndex = descriptorIndex;
+    }
+
+    // Only the newest state is kept. The source controller can be skipped only if it caused all the coalesced changes.
+    if (notification->pending && notification->excludedController != sourceController)
+    {
+        notification->excludedController = UniqueIdentifier{};
+    }
+    else
+    {
+        notification->excludedController = sourceController;
+    }
+    if (payload.second != 0u && payload.first != nullptr)
+    {
+        std::memcpy(notification->payload.data(), payload.first, payload.second);
+    }
+    notification->payloadLength = payload.second;
+    notification->pending = true;
+
+    if (now - notification->lastSent >= _minInterval)
+    {
+        send(*notification, now);
+    }
+}
+
+void AemUnsolicitedNotifier::checkTimeouts(AecpClock::time_point const now)
+{
+    for (auto& subscriber : _subscribers)
+    {
+        if (subscriber.inUse && now - subscriber.lastSeen >= _subscriptionTimeout)
+        {
+            ESP_LOGI(TAG, "Registration of controller 0x%016llx expired", static_cast<unsigned long long>(subscriber.controllerID.getValue()));
+            subscriber.inUse = false;
+            --_subscriberCount;
+        }
+    }
+
+    for (auto& notification : _notifications)
+    {
+        if (!notification.inUse || now - notification.lastSent < _minInterval)
+        {
+            continue;
+        }
+        if (notification.pending)
+        {
+            send(notification, now);
+        }
+        else
+        {
+            notification.inUse = false;
+        }
+    }
+}
+
+bool AemUnsolicitedNotifier::isRegistered(UniqueIdentifier const controllerID) const noexcept
+{
+    for (auto const& subscriber : _subscribers)
+    {
+        if (subscriber.inUse && subscriber.controllerID == controllerID)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t AemUnsolicitedNotifier::getSubscriberCount() const noexcept
+{
+    return _subscriberCount;
+}
+
+AemUnsolicitedNotifier::Subscriber* AemUnsolicitedNotifier::findSubscriber(UniqueIdentifier const controllerID) noexcept
+{
+    if (!controllerID)
+    {
+        return nullptr;
+    }
+    for (auto& subscriber : _subscribers)
+    {
+        if (subscriber.inUse && subscriber.controllerID == controllerID)
+        {
+            return &subscriber;
+        }
+    }
+    return nullptr;
+}
+
+AemUnsolicitedNotifier::Notification* AemUnsolicitedNotifier::allocateNotification(AecpClock::time_point const now)
+{
+    // Prefer a free slot, then one only remembering its last send time, then flush the oldest change
+    Notification* candidate = nullptr;
+    for (auto& notification : _notifications)
+    {
+        if (!notification.inUse)
+        {
+            candidate = &notification;
+            break;
+        }
+        if (candidate == nullptr || (candidate->pending && !notification.pending) || (candidate->pending == notification.pending && notification.lastSent < candidate->lastSent))
+        {
+            candidate = &notification;
+        }
+    }
+
+    if (candidate->inUse && candidate->pending)
+    {
+        send(*candidate, now);
+    }
+    *candidate = Notification{};
+    candidate->inUse = true;
+    candidate->lastSent = now - _minInterval; // A new slot is never rate limited
+    return candidate;
+}
+
+void AemUnsolicitedNotifier::send(Notification& notification, AecpClock::time_point const now)
+{
+    notification.pending = false;
+    notification.lastSent = now;
+
+    if (!_sendHandler)
+    {
+        ESP_LOGE(TAG, "No send handler, cannot send notifications");
+        return;
+    }
+
+    _message.setCommandType(notification.commandType);
+    _message.setCommandSpecificData(notification.payload.data(), notification.payloadLength);
+    for (auto& subscriber : _subscribers)
+    {
+        if (!subscriber.inUse || (notification.excludedController && subscriber.controllerID == notification.excludedController))
+        {
+            continue;
+        }
+        _message.setControllerEntityID(subscriber.controllerID);
+        _message.setSequenceID(subscriber.nextSequenceID++);
+        _sendHandler(_message, subscriber.macAddress);
+    }
+}
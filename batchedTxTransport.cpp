@@ -0,0 +1,239 @@
+#include "batchedTxTransport.hpp"
+#include "esp_log.h"
+#include "protocolAvtpdu.hpp"
+#include <algorithm>
+
+static const char* TAG = "BATCHED_TX";
+
+/***********************************************************/
+/* BatchedTxTransport class definition                     */
+/***********************************************************/
+
+BatchedTxTransport::BatchedTxTransport(NetworkTransport& transport, Configuration const& configuration)
+    : _transport(transport), _configuration(configuration)
+{
+    _configuration.batchSize = std::max<size_t>(_configuration.batchSize, 1u);
+    for (auto& queue : _queues)
+    {
+        queue = std::make_unique<FrameRing>(_configuration.queueFrames);
+    }
+    _budget = static_cast<double>(_configuration.burstBytes);
+    _transport.setFrameHandler([this](const uint8_t* frame, size_t const length)
+    {
+        dispatchFrame(frame, length);
+    });
+}
+
+bool BatchedTxTransport::open()
+{
+    if (!_transport.open())
+    {
+        return false;
+    }
+    _macAddress = _transport.getMacAddress();
+    _lastRefill = std::chrono::steady_clock::now();
+    _open = true;
+    return true;
+}
+
+void BatchedTxTransport::close() noexcept
+{
+    if (_open)
+    {
+        // Whatever the pacing, queued frames are not lost
+        flushQueues(false);
+    }
+    _open = false;
+    _transport.close();
+}
+
+bool BatchedTxTransport::sendFrame(const uint8_t* frame, size_t const length)
+{
+    return sendFrame(classify(frame, length), frame, length);
+}
+
+bool BatchedTxTransport::joinMulticast(MacAddress const& macAddress)
+{
+    return _transport.joinMulticast(macAddress);
+}
+
+bool BatchedTxTransport::leaveMulticast(MacAddress const& macAddress)
+{
+    return _transport.leaveMulticast(macAddress);
+}
+
+size_t BatchedTxTransport::poll(std::chrono::milliseconds const timeout)
+{
+    flush();
+
+    auto wait = timeout;
+    if (getQueuedCount() != 0u)
+    {
+        // Come back when the pacing lets the next frame go
+        auto const delay = std::chrono::duration_cast<std::chrono::milliseconds>(getPacingDelay() + std::chrono::microseconds{ 999 });
+        wait = std::min(wait, delay);
+    }
+    auto const count = _transport.poll(wait);
+
+    // Responses built while handling the frames go out together
+    flush();
+    return count;
+}
+
+bool BatchedTxTransport::flush()
+{
+    return flushQueues(_configuration.pacingBitsPerSecond != 0u);
+}
+
+bool BatchedTxTransport::flushQueues(bool const paced)
+{
+    if (!_open)
+    {
+        return false;
+    }
+
+    if (paced)
+    {
+        refill(std::chrono::steady_clock::now());
+    }
+
+    auto result = true;
+    for (;;)
+    {
+        auto batch = size_t{ 0u };
+        auto held = false;
+        for (auto priority = size_t{ 0u }; priority < _queues.size() && !held && batch < _configuration.batchSize; ++priority)
+        {
+            auto& queue = *_queues[priority];
+            auto length = size_t{ 0u };
+            while (batch < _configuration.batchSize)
+            {
+                auto const* const frame = queue.peek(length);
+                if (frame == nullptr)
+                {
+                    break;
+                }
+                auto const wireBytes = static_cast<double>(std::max(length, EtherLayer2::Length + EthernetPayloadMinimumSize) + WireOverhead);
+                // Lower classes wait too, they must not overtake a held frame
+                if (paced && priority != static_cast<size_t>(TxPriority::Control) && _budget < wireBytes)
+                {
+                    ++_statistics.paced;
+                    held = true;
+                    break;
+                }
+                if (!_transport.sendFrame(frame, length))
+                {
+                    ++_statistics.errors;
+                    result = false;
+                }
+                _budget -= wireBytes;
+                queue.pop();
+                ++batch;
+            }
+        }
+
+        if (batch == 0u)
+        {
+            break;
+        }
+        ++_statistics.batches;
+        if (!_transport.flush())
+        {
+            result = false;
+        }
+        if (held)
+        {
+            break;
+        }
+    }
+    return result;
+}
+
+bool BatchedTxTransport::sendFrame(TxPriority const priority, const uint8_t* frame, size_t const length)
+{
+    auto const index = static_cast<size_t>(priority);
+    if (!_open || frame == nullptr || index >= _queues.size() || length < EtherLayer2::Length)
+    {
+        return false;
+    }
+    if (!_queues[index]->push(frame, length))
+    {
+        ++_statistics.drops[index];
+        ESP_LOGW(TAG, "TX queue %u full", static_cast<unsigned>(index));
+        return false;
+    }
+    ++_statistics.frames[index];
+    return true;
+}
+
+TxPriority BatchedTxTransport::classify(const uint8_t* frame, size_t const length) noexcept
+{
+    if (frame == nullptr || length < EtherLayer2::Length + 2u)
+    {
+        return TxPriority::Command;
+    }
+    switch (frame[EtherLayer2::Length])
+    {
+        case AVTP_SUBTYPE_ADP:
+        case AVTP_SUBTYPE_ACMP:
+            return TxPriority::Control;
+        case AVTP_SUBTYPE_AECP:
+        {
+            auto const messageType = static_cast<AecpMessageType>(frame[EtherLayer2::Length + 1] & 0x0f);
+            return messageType == AecpMessageType::ADDRESS_ACCESS_COMMAND || messageType == AecpMessageType::ADDRESS_ACCESS_RESPONSE ? TxPriority::Bulk : TxPriority::Command;
+        }
+        default:
+            return TxPriority::Command;
+    }
+}
+
+std::chrono::microseconds BatchedTxTransport::getPacingDelay() const noexcept
+{
+    if (_configuration.pacingBitsPerSecond == 0u)
+    {
+        return std::chrono::microseconds{ 0 };
+    }
+
+    // The next frame held is the first of the Command or Bulk queues, Control is never held
+    auto length = size_t{ 0u };
+    auto const* frame = _queues[static_cast<size_t>(TxPriority::Command)]->peek(length);
+    if (frame == nullptr)
+    {
+        frame = _queues[static_cast<size_t>(TxPriority::Bulk)]->peek(length);
+    }
+    if (frame == nullptr)
+    {
+        return std::chrono::microseconds{ 0 };
+    }
+
+    auto const elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - _lastRefill).count();
+    auto const budget = std::min(_budget + elapsed * static_cast<double>(_configuration.pacingBitsPerSecond) / 8.0, static_cast<double>(_configuration.burstBytes));
+    auto const missing = static_cast<double>(std::max(length, EtherLayer2::Length + EthernetPayloadMinimumSize) + WireOverhead) - budget;
+    if (missing <= 0.0)
+    {
+        return std::chrono::microseconds{ 0 };
+    }
+    return std::chrono::microseconds{ static_cast<int64_t>(missing * 8.0e6 / static_cast<double>(_configuration.pacingBitsPerSecond)) + 1 };
+}
+
+size_t BatchedTxTransport::getQueuedCount() const noexcept
+{
+    auto count = size_t{ 0u };
+    for (auto const& queue : _queues)
+    {
+        count += queue->getSize();
+    }
+    return count;
+}
+
+BatchedTxTransport::Statistics const& BatchedTxTransport::getStatistics() const noexcept
+{
+    return _statistics;
+}
+
+void BatchedTxTransport::refill(std::chrono::steady_clock::time_point const now) noexcept
+{
+    auto const elapsed = std::chrono::duration<double>(now - _lastRefill).count();
+    _lastRefill = now;
+    _budget = std::min(_budget + elapsed * static_cast<double>(_configuration.pacingBitsPerSecond) / 8.0, static_cast<double>(_configuration.burstBytes));
+}
@@ -0,0 +1,656 @@
+#include "controllerCommandScheduler.hpp"
+#include "esp_log.h"
+#include "protocolAaAecpdu.hpp"
+#include "protocolAemAecpdu.hpp"
+#include <algorithm>
+#include <utility>
+
+static const char* TAG = "CMD_SCHEDULER";
+
+/** Background classes, in round robin order */
+static constexpr std::array<CommandClass, 3> BackgroundClasses{ CommandClass::Enumeration, CommandClass::Bulk, CommandClass::Polling };
+
+/***********************************************************/
+/* ControllerCommandScheduler class definition             */
+/***********************************************************/
+
+ControllerCommandScheduler::ControllerCommandScheduler(UniqueIdentifier const controllerID, AecpSendHandler aecpSendHandler, AcmpSendHandler acmpSendHandler, Configuration const& configuration) noexcept
+    : _controllerID(controllerID), _aecpSendHandler(std::move(aecpSendHandler)), _acmpSendHandler(std::move(acmpSendHandler)), _configuration(configuration)
+{
+    for (auto& maxInflight : _configuration.maxInflight)
+    {
+        maxInflight = std::max<size_t>(maxInflight, 1u);
+    }
+    _configuration.maxBackgroundInflight = std::max<size_t>(_configuration.maxBackgroundInflight, 1u);
+    for (auto const commandClass : BackgroundClasses)
+    {
+        auto& weight = _configuration.weights[static_cast<size_t>(commandClass)];
+        weight = std::max<uint32_t>(weight, 1u);
+        _credits[static_cast<size_t>(commandClass)] = weight;
+    }
+}
+
+AecpSendHandler ControllerCommandScheduler::getAecpSendHandler()
+{
+    return [this](Aecpdu const& aecpdu, MacAddress const& destAddress)
+    {
+        sendAecpdu(classify(aecpdu), aecpdu, destAddress);
+    };
+}
+
+AecpSendHandler ControllerCommandScheduler::getAecpSendHandler(CommandClass const commandClass)
+{
+    return [this, commandClass](Aecpdu const& aecpdu, MacAddress const& destAddress)
+    {
+        sendAecpdu(commandClass, aecpdu, destAddress);
+    };
+}
+
+AcmpSendHandler ControllerCommandScheduler::getAcmpSendHandler()
+{
+    return [this](Acmpdu const& acmpdu)
+    {
+        sendAcmpdu(classify(acmpdu), acmpdu);
+    };
+}
+
+AcmpSendHandler ControllerCommandScheduler::getAcmpSendHandler(CommandClass const commandClass)
+{
+    return [this, commandClass](Acmpdu const& acmpdu)
+    {
+        sendAcmpdu(commandClass, acmpdu);
+    };
+}
+
+AecpTimeoutHandler ControllerCommandScheduler::getTimeoutHandler()
+{
+    return [this](UniqueIdentifier const entityID)
+    {
+        return getTimeout(entityID);
+    };
+}
+
+bool ControllerCommandScheduler::sendAecpdu(CommandClass const commandClass, Aecpdu const& aecpdu, MacAddress const& destAddress, AecpClock::time_point const now)
+{
+    auto const index = static_cast<size_t>(commandClass);
+    if (index >= ClassCount)
+    {
+        return false;
+    }
+
+    auto& entity = getEntity(aecpdu.getTargetEntityID());
+    auto& queue = entity.queues[index];
+    ++_metrics.classes[index].submitted;
+
+    // Retry of a command still waiting: only the latest copy goes out
+    auto const queued = std::find_if(queue.begin(), queue.end(), [&aecpdu](Command const& command)
+    {
+        return command.aecpdu && command.sequenceID == aecpdu.getSequenceID();
+    });
+    if (queued != queue.end())
+    {
+        if (auto copy = copyAecpdu(aecpdu))
+        {
+            queued->aecpdu = std::move(copy);
+        }
+        ++_metrics.classes[index].retriesMerged;
+        return true;
+    }
+
+    // Retry of a command inflight: goes out in the same slot
+    if (auto* const inflight = findInflight(entity.entityID, aecpdu.getSequenceID(), false))
+    {
+        inflight->ambiguous = true;
+        inflight->timeout = now + entity.timing.getTimeout();
+        ++_metrics.classes[index].retriesMerged;
+        _aecpSendHandler(aecpdu, destAddress);
+        return true;
+    }
+
+    Command command{};
+    command.destAddress = destAddress;
+    command.sequenceID = aecpdu.getSequenceID();
+    command.ambiguous = forgetTimedOut(entity.entityID, command.sequenceID);
+    command.queued = now;
+
+    // Nothing of the class waiting (nor of the background when in the background): no copy
+    auto const waiting = isBackground(commandClass) ? _classQueued[static_cast<size_t>(CommandClass::Enumeration)] + _classQueued[static_cast<size_t>(CommandClass::Bulk)] + _classQueued[static_cast<size_t>(CommandClass::Polling)] : _classQueued[index];
+    if (waiting == 0u && canSend(commandClass, entity))
+    {
+        transmit(commandClass, entity, command, &aecpdu, now);
+        return true;
+    }
+
+    command.aecpdu = copyAecpdu(aecpdu);
+    if (!command.aecpdu)
+    {
+        // Not a command the scheduler knows how to hold, do not delay it
+        _aecpSendHandler(aecpdu, destAddress);
+        return true;
+    }
+    if (!enqueue(commandClass, entity, std::move(command)))
+    {
+        return false;
+    }
+    dispatch(now);
+    return true;
+}
+
+bool ControllerCommandScheduler::sendAcmpdu(CommandClass const commandClass, Acmpdu const& acmpdu, AecpClock::time_point const now)
+{
+    auto const index = static_cast<size_t>(commandClass);
+    if (index >= ClassCount)
+    {
+        return false;
+    }
+
+    auto& entity = getEntity(getTargetEntityID(acmpdu));
+    auto& queue = entity.queues[index];
+    ++_metrics.classes[index].submitted;
+
+    auto const queued = std::find_if(queue.begin(), queue.end(), [&acmpdu](Command const& command)
+    {
+        return !command.aecpdu && command.sequenceID == acmpdu.getSequenceID();
+    });
+    if (queued != queue.end())
+    {
+        queued->acmpdu = acmpdu;
+        ++_metrics.classes[index].retriesMerged;
+        return true;
+    }
+
+    if (auto* const inflight = findInflight(entity.entityID, acmpdu.getSequenceID(), true))
+    {
+        inflight->ambiguous = true;
+        inflight->timeout = now + _configuration.acmpTimeout;
+        ++_metrics.classes[index].retriesMerged;
+        _acmpSendHandler(acmpdu);
+        return true;
+    }
+
+    Command command{};
+    command.acmpdu = acmpdu;
+    command.sequenceID = acmpdu.getSequenceID();
+    command.queued = now;
+
+    auto const waiting = isBackground(commandClass) ? _classQueued[static_cast<size_t>(CommandClass::Enumeration)] + _classQueued[static_cast<size_t>(CommandClass::Bulk)] + _classQueued[static_cast<size_t>(CommandClass::Polling)] : _classQueued[index];
+    if (waiting == 0u && canSend(commandClass, entity))
+    {
+        transmit(commandClass, entity, command, nullptr, now);
+        return true;
+    }
+    if (!enqueue(commandClass, entity, std::move(command)))
+    {
+        return false;
+    }
+    dispatch(now);
+    return true;
+}
+
+bool ControllerCommandScheduler::handleAecpdu(Aecpdu const& aecpdu, AecpClock::time_point const now)
+{
+    auto const messageType = aecpdu.getMessageType();
+    if ((messageType != AecpMessageType::AEM_RESPONSE && messageType != AecpMessageType::ADDRESS_ACCESS_RESPONSE) || aecpdu.getControllerEntityID() != _controllerID)
+    {
+        return false;
+    }
+    if (messageType == AecpMessageType::AEM_RESPONSE && static_cast<AemAecpdu const&>(aecpdu).getUnsolicited())
+    {
+        return false;
+    }
+
+    auto* const inflight = findInflight(aecpdu.getTargetEntityID(), aecpdu.getSequenceID(), false);
+    if (inflight == nullptr)
+    {
+        // Late response to a timed out command: the component will not resend it
+        forgetTimedOut(aecpdu.getTargetEntityID(), aecpdu.getSequenceID());
+        return false;
+    }
+    auto* const entity = findEntity(inflight->entityID);
+    if (aecpdu.getStatus() == AecpStatus::IN_PROGRESS)
+    {
+        // The final response comes later, the command stays inflight
+        inflight->timeout = now + _configuration.aecpInProgressTimeout;
+        if (!inflight->ambiguous && entity != nullptr)
+        {
+            entity->timing.onInProgress();
+        }
+        inflight->ambiguous = true;
+        return true;
+    }
+
+    if (entity != nullptr)
+    {
+        if (inflight->ambiguous)
+        {
+            entity->timing.onSuccess();
+        }
+        else
+        {
+            entity->timing.onResponse(std::chrono::duration_cast<std::chrono::microseconds>(now - inflight->sent));
+        }
+    }
+    ++_metrics.classes[static_cast<size_t>(inflight->commandClass)].completed;
+    release(*inflight);
+    dispatch(now);
+    return true;
+}
+
+bool ControllerCommandScheduler::handleAcmpdu(Acmpdu const& acmpdu, AecpClock::time_point const now)
+{
+    // Responses have odd message types
+    if ((static_cast<uint8_t>(acmpdu.getMessageType()) & 0x01) == 0u || acmpdu.getControllerEntityID() != _controllerID)
+    {
+        return false;
+    }
+
+    auto* const inflight = findInflight(getTargetEntityID(acmpdu), acmpdu.getSequenceID(), true);
+    if (inflight == nullptr)
+    {
+        return false;
+    }
+
+    ++_metrics.classes[static_cast<size_t>(inflight->commandClass)].completed;
+    release(*inflight);
+    dispatch(now);
+    return true;
+}
+
+void ControllerCommandScheduler::poll(AecpClock::time_point const now)
+{
+    _timedOut.erase(std::remove_if(_timedOut.begin(), _timedOut.end(), [now](TimedOut const& timedOut)
+    {
+        return timedOut.expires <= now;
+    }), _timedOut.end());
+
+    for (auto i = size_t{ 0u }; i < _inflight.size();)
+    {
+        if (_inflight[i].timeout <= now)
+        {
+            if (!_inflight[i].isAcmp)
+            {
+                if (auto* const entity = findEntity(_inflight[i].entityID))
+                {
+                    entity->timing.onTimeout();
+                }
+                // A resend with the same sequenceID must not give a response time sample
+                _timedOut.push_back(TimedOut{ _inflight[i].entityID, _inflight[i].sequenceID, now + _configuration.aecpRetryHold });
+            }
+            ++_metrics.classes[static_cast<size_t>(_inflight[i].commandClass)].timeouts;
+            release(_inflight[i]);
+            continue;
+        }
+        ++i;
+    }
+    dispatch(now);
+}
+
+void ControllerCommandScheduler::removeEntity(UniqueIdentifier const entityID) noexcept
+{
+    auto const it = std::find_if(_entities.begin(), _entities.end(), [entityID](std::unique_ptr<Entity> const& entity)
+    {
+        return entity->entityID == entityID;
+    });
+    if (it == _entities.end())
+    {
+        return;
+    }
+
+    auto* const entity = it->get();
+    for (auto index = size_t{ 0u }; index < ClassCount; ++index)
+    {
+        auto const count = entity->queues[index].size();
+        _classQueued[index] -= count;
+        _queuedCount -= count;
+        auto& round = _rounds[index];
+        round.erase(std::remove(round.begin(), round.end(), entity), round.end());
+    }
+    for (auto i = size_t{ 0u }; i < _inflight.size();)
+    {
+        if (_inflight[i].entityID == entityID)
+        {
+            release(_inflight[i]);
+            continue;
+        }
+        ++i;
+    }
+    _timedOut.erase(std::remove_if(_timedOut.begin(), _timedOut.end(), [entityID](TimedOut const& timedOut)
+    {
+        return timedOut.entityID == entityID;
+    }), _timedOut.end());
+    _entities.erase(it);
+}
+
+CommandClass ControllerCommandScheduler::classify(Aecpdu const& aecpdu) noexcept
+{
+    if (aecpdu.getMessageType() == AecpMessageType::ADDRESS_ACCESS_COMMAND)
+    {
+        return CommandClass::Bulk;
+    }
+    if (aecpdu.getMessageType() != AecpMessageType::AEM_COMMAND)
+    {
+        return CommandClass::Interactive;
+    }
+    switch (static_cast<AemAecpdu const&>(aecpdu).getCommandType())
+    {
+        case AemCommandType::READ_DESCRIPTOR:
+        case AemCommandType::GET_AUDIO_MAP:
+        case AemCommandType::REGISTER_UNSOLICITED_NOTIFICATION:
+            return CommandClass::Enumeration;
+        case AemCommandType::GET_AVB_INFO:
+        case AemCommandType::GET_AS_PATH:
+        case AemCommandType::GET_COUNTERS:
+            return CommandClass::Polling;
+        default:
+            return CommandClass::Interactive;
+    }
+}
+
+CommandClass ControllerCommandScheduler::classify(Acmpdu const& acmpdu) noexcept
+{
+    switch (acmpdu.getMessageType())
+    {
+        case AcmpMessageType::CONNECT_TX_COMMAND:
+        case AcmpMessageType::DISCONNECT_TX_COMMAND:
+        case AcmpMessageType::CONNECT_RX_COMMAND:
+        case AcmpMessageType::DISCONNECT_RX_COMMAND:
+            return CommandClass::Connection;
+        default:
+            return CommandClass::Enumeration;
+    }
+}
+
+void ControllerCommandScheduler::setEntityWeight(UniqueIdentifier const entityID, uint32_t const weight)
+{
+    getEntity(entityID).weight = std::max<uint32_t>(weight, 1u);
+}
+
+ControllerCommandScheduler::Metrics const& ControllerCommandScheduler::getMetrics() const noexcept
+{
+    return _metrics;
+}
+
+std::chrono::milliseconds ControllerCommandScheduler::getTimeout(UniqueIdentifier const entityID) const noexcept
+{
+    auto const* const timing = getTiming(entityID);
+    return timing != nullptr ? timing->getTimeout() : _configuration.timing.initialTimeout;
+}
+
+AecpTargetTiming const* ControllerCommandScheduler::getTiming(UniqueIdentifier const entityID) const noexcept
+{
+    auto const* const entity = findEntity(entityID);
+    return entity != nullptr ? &entity->timing : nullptr;
+}
+
+size_t ControllerCommandScheduler::getQueuedCount(CommandClass const commandClass) const noexcept
+{
+    auto const index = static_cast<size_t>(commandClass);
+    return index < ClassCount ? _classQueued[index] : 0u;
+}
+
+size_t ControllerCommandScheduler::getInflightCount(CommandClass const commandClass) const noexcept
+{
+    auto const index = static_cast<size_t>(commandClass);
+    return index < ClassCount ? _classInflight[index] : 0u;
+}
+
+bool ControllerCommandScheduler::isBackground(CommandClass const commandClass) noexcept
+{
+    return commandClass != CommandClass::Interactive && commandClass != CommandClass::Connection;
+}
+
+UniqueIdentifier ControllerCommandScheduler::getTargetEntityID(Acmpdu const& acmpdu) noexcept
+{
+    // TX commands (and their responses) go to the talker, RX ones to the listener
+    switch (acmpdu.getMessageType())
+    {
+        case AcmpMessageType::CONNECT_TX_COMMAND:
+        case AcmpMessageType::CONNECT_TX_RESPONSE:
+        case AcmpMessageType::DISCONNECT_TX_COMMAND:
+        case AcmpMessageType::DISCONNECT_TX_RESPONSE:
+        case AcmpMessageType::GET_TX_STATE_COMMAND:
+        case AcmpMessageType::GET_TX_STATE_RESPONSE:
+        case AcmpMessageType::GET_TX_CONNECTION_COMMAND:
+        case AcmpMessageType::GET_TX_CONNECTION_RESPONSE:
+            return acmpdu.getTalkerEntityID();
+        default:
+            return acmpdu.getListenerEntityID();
+    }
+}
+
+Aecpdu::UniquePointer ControllerCommandScheduler::copyAecpdu(Aecpdu const& aecpdu)
+{
+    auto const deleter = [](Aecpdu* self)
+    {
+        delete self;
+    };
+    switch (aecpdu.getMessageType())
+    {
+        case AecpMessageType::AEM_COMMAND:
+            return Aecpdu::UniquePointer{ new AemAecpdu(static_cast<AemAecpdu const&>(aecpdu)), deleter };
+        case AecpMessageType::ADDRESS_ACCESS_COMMAND:
+            return Aecpdu::UniquePointer{ new AaAecpdu(static_cast<AaAecpdu const&>(aecpdu)), deleter };
+        default:
+            return Aecpdu::UniquePointer{ nullptr, nullptr };
+    }
+}
+
+ControllerCommandScheduler::Entity& ControllerCommandScheduler::getEntity(UniqueIdentifier const entityID)
+{
+    if (auto* const entity = findEntity(entityID))
+    {
+        return *entity;
+    }
+    _entities.push_back(std::make_unique<Entity>());
+    auto& entity = *_entities.back();
+    entity.entityID = entityID;
+    entity.timing = AecpTargetTiming{ _configuration.timing };
+    return entity;
+}
+
+ControllerCommandScheduler::Entity* ControllerCommandScheduler::findEntity(UniqueIdentifier const entityID) const noexcept
+{
+    auto const it = std::find_if(_entities.begin(), _entities.end(), [entityID](std::unique_ptr<Entity> const& entity)
+    {
+        return entity->entityID == entityID;
+    });
+    return it != _entities.end() ? it->get() : nullptr;
+}
+
+ControllerCommandScheduler::Inflight* ControllerCommandScheduler::findInflight(UniqueIdentifier const entityID, uint16_t const sequenceID, bool const isAcmp) noexcept
+{
+    auto const it = std::find_if(_inflight.begin(), _inflight.end(), [entityID, sequenceID, isAcmp](Inflight const& inflight)
+    {
+        return inflight.sequenceID == sequenceID && inflight.isAcmp == isAcmp && inflight.entityID == entityID;
+    });
+    return it != _inflight.end() ? &*it : nullptr;
+}
+
+bool ControllerCommandScheduler::canSend(CommandClass const commandClass, Entity const& entity) const noexcept
+{
+    auto const index = static_cast<size_t>(commandClass);
+    if (_classInflight[index] >= _configuration.maxInflight[index])
+    {
+        return false;
+    }
+    if (!isBackground(commandClass))
+    {
+        return true;
+    }
+    return _backgroundInflight < _configuration.maxBackgroundInflight && entity.backgroundInflight < entity.timing.getWindow();
+}
+
+bool ControllerCommandScheduler::enqueue(CommandClass const commandClass, Entity& entity, Command&& command)
+{
+    auto const index = static_cast<size_t>(commandClass);
+    if (_queuedCount >= _configuration.maxQueued)
+    {
+        ++_metrics.classes[index].drops;
+        ESP_LOGW(TAG, "Command queue full, command to 0x%016llx dropped", static_cast<unsigned long long>(entity.entityID.getValue()));
+        return false;
+    }
+
+    auto& queue = entity.queues[index];
+    if (queue.empty())
+    {
+        _rounds[index].push_back(&entity);
+        entity.served[index] = 0u;
+    }
+    queue.push_back(std::move(command));
+    ++_classQueued[index];
+    ++_queuedCount;
+    ++_metrics.classes[index].queued;
+    return true;
+}
+
+void ControllerCommandScheduler::transmit(CommandClass const commandClass, Entity& entity, Command const& command, Aecpdu const* aecpdu, AecpClock::time_point const now)
+{
+    auto const index = static_cast<size_t>(commandClass);
+    auto const isAcmp = aecpdu == nullptr;
+
+    _inflight.push_back(Inflight{ entity.entityID, command.sequenceID, commandClass, isAcmp, command.ambiguous, now, now + (isAcmp ? _configuration.acmpTimeout : entity.timing.getTimeout()) });
+    ++_classInflight[index];
+    if (isBackground(commandClass))
+    {
+        ++_backgroundInflight;
+        ++entity.backgroundInflight;
+    }
+
+    auto& metrics = _metrics.classes[index];
+    metrics.maxQueueDelay = std::max(metrics.maxQueueDelay, std::chrono::duration_cast<std::chrono::microseconds>(now - command.queued));
+
+    if (isAcmp)
+    {
+        _acmpSendHandler(command.acmpdu);
+    }
+    else
+    {
+        _aecpSendHandler(*aecpdu, command.destAddress);
+    }
+}
+
+void ControllerCommandScheduler::release(Inflight const& inflight) noexcept
+{
+    auto const index = static_cast<size_t>(inflight.commandClass);
+    --_classInflight[index];
+    if (isBackground(inflight.commandClass))
+    {
+        --_backgroundInflight;
+        if (auto* const entity = findEntity(inflight.entityID))
+        {
+            --entity->backgroundInflight;
+        }
+    }
+
+    // Order does not matter, swap with the last one
+    auto const position = static_cast<size_t>(&inflight - _inflight.data());
+    _inflight[position] = _inflight.back();
+    _inflight.pop_back();
+}
+
+bool ControllerCommandScheduler::forgetTimedOut(UniqueIdentifier const entityID, uint16_t const sequenceID) noexcept
+{
+    auto const it = std::find_if(_timedOut.begin(), _timedOut.end(), [entityID, sequenceID](TimedOut const& timedOut)
+    {
+        return timedOut.sequenceID == sequenceID && timedOut.entityID == entityID;
+    });
+    if (it == _timedOut.end())
+    {
+        return false;
+    }
+    *it = _timedOut.back();
+    _timedOut.pop_back();
+    return true;
+}
+
+void ControllerCommandScheduler::dispatch(AecpClock::time_point const now)
+{
+    while (sendNext(CommandClass::Interactive, now))
+    {
+    }
+    while (sendNext(CommandClass::Connection, now))
+    {
+    }
+    while (sendNextBackground(now))
+    {
+    }
+}
+
+bool ControllerCommandScheduler::sendNext(CommandClass const commandClass, AecpClock::time_point const now)
+{
+    auto const index = static_cast<size_t>(commandClass);
+    auto& round = _rounds[index];
+    if (_classInflight[index] >= _configuration.maxInflight[index])
+    {
+        return false;
+    }
+
+    // Entities in turn, skipping the ones at their limit
+    for (auto tries = round.size(); tries != 0u; --tries)
+    {
+        auto* const entity = round.front();
+        if (!canSend(commandClass, *entity))
+        {
+            round.pop_front();
+            round.push_back(entity);
+            entity->served[index] = 0u;
+            continue;
+        }
+
+        auto& queue = entity->queues[index];
+        auto command = std::move(queue.front());
+        queue.pop_front();
+        --_classQueued[index];
+        --_queuedCount;
+
+        if (queue.empty())
+        {
+            round.pop_front();
+        }
+        else if (++entity->served[index] >= entity->weight)
+        {
+            round.pop_front();
+            round.push_back(entity);
+            entity->served[index] = 0u;
+        }
+
+        transmit(commandClass, *entity, command, command.aecpdu.get(), now);
+        return true;
+    }
+    return false;
+}
+
+bool ControllerCommandScheduler::sendNextBackground(AecpClock::time_point const now)
+{
+    if (_backgroundInflight >= _configuration.maxBackgroundInflight)
+    {
+        return false;
+    }
+
+    // Weighted round robin: each class sends up to its weight, then a new round starts
+    for (auto pass = 0u; pass < 2u; ++pass)
+    {
+        for (auto i = size_t{ 0u }; i < BackgroundClasses.size(); ++i)
+        {
+            auto const turn = (_backgroundTurn + i) % BackgroundClasses.size();
+            auto const commandClass = BackgroundClasses[turn];
+            auto& credits = _credits[static_cast<size_t>(commandClass)];
+            if (credits == 0u || !sendNext(commandClass, now))
+            {
+                continue;
+            }
+            if (--credits == 0u)
+            {
+                _backgroundTurn = (turn + 1u) % BackgroundClasses.size();
+            }
+            return true;
+        }
+
+        // Classes with credits left have nothing they can send
+        for (auto const commandClass : BackgroundClasses)
+        {
+            _credits[static_cast<size_t>(commandClass)] = _configuration.weights[static_cast<size_t>(commandClass)];
+        }
+    }
+    return false;
+}
@@ -0,0 +1,332 @@
+#include "entityAddressAccessSpace.hpp"
+#include "protocolAaAecpdu.hpp"
+#include "esp_log.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+static const char* TAG = "AA_SPACE";
+
+/***********************************************************/
+/* AaRamBackend class definition                           */
+/***********************************************************/
+
+AaRamBackend::AaRamBackend(void* base, size_t const size) noexcept
+    : _base(static_cast<const uint8_t*>(base)), _writableBase(static_cast<uint8_t*>(base)), _size(size)
+{
+}
+
+AaRamBackend::AaRamBackend(const void* base, size_t const size) noexcept
+    : _base(static_cast<const uint8_t*>(base)), _size(size)
+{
+}
+
+AaCommandStatus AaRamBackend::read(uint64_t const offset, void* data, size_t const length)
+{
+    if (offset > _size || length > _size - offset)
+    {
+        return AaCommandStatus::AddressInvalid;
+    }
+    std::memcpy(data, _base + offset, length);
+    return AaCommandStatus::Success;
+}
+
+AaCommandStatus AaRamBackend::write(uint64_t const offset, const void* data, size_t const length)
+{
+    if (_writableBase == nullptr)
+    {
+        return AaCommandStatus::Unsupported;
+    }
+    if (offset > _size || length > _size - offset)
+    {
+        return AaCommandStatus::AddressInvalid;
+    }
+    std::memcpy(_writableBase + offset, data, length);
+    return AaCommandStatus::Success;
+}
+
+#if defined(ESP_PLATFORM)
+/***********************************************************/
+/* AaPartitionBackend class definition                     */
+/***********************************************************/
+
+AaPartitionBackend::AaPartitionBackend(esp_partition_t const* partition) noexcept
+    : _partition(partition)
+{
+}
+
+AaCommandStatus AaPartitionBackend::read(uint64_t const offset, void* data, size_t const length)
+{
+    if (_partition == nullptr || offset > _partition->size || length > _partition->size - offset)
+    {
+        return AaCommandStatus::AddressInvalid;
+    }
+    auto const err = esp_partition_read(_partition, static_cast<size_t>(offset), data, length);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Partition read failed: %s", esp_err_to_name(err));
+        return AaCommandStatus::DataInvalid;
+    }
+    return AaCommandStatus::Success;
+}
+
+AaCommandStatus AaPartitionBackend::write(uint64_t const offset, const void* data, size_t const length)
+{
+    if (_partition == nullptr || offset > _partition->size || length > _partition->size - offset)
+    {
+        return AaCommandStatus::AddressInvalid;
+    }
+
+    // Erase the sectors reached for the first time, and any skipped before them (a write
+    // landing ahead of a lost chunk must not leave the chunk's sectors unerased)
+    auto const sectorSize = static_cast<size_t>(_partition->erase_size);
+    auto const end = static_cast<size_t>(offset) + length;
+    if (end > _erasedEnd)
+    {
+        auto const eraseEnd = std::min(static_cast<size_t>(_partition->size), (end + sectorSize - 1) / sectorSize * sectorSize);
+        auto const err = esp_partition_erase_range(_partition, _erasedEnd, eraseEnd - _erasedEnd);
+        if (err != ESP_OK)
+        {
+            ESP_LOGE(TAG, "Partition erase failed: %s", esp_err_to_name(err));
+            return AaCommandStatus::DataInvalid;
+        }
+        _erasedEnd = eraseEnd;
+    }
+
+    auto const err = esp_partition_write(_partition, static_cast<size_t>(offset), data, length);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Partition write failed: %s", esp_err_to_name(err));
+        return AaCommandStatus::DataInvalid;
+    }
+    return AaCommandStatus::Success;
+}
+
+void AaPartitionBackend::beginWrite()
+{
+    _erasedEnd = 0u;
+}
+#endif
+
+#if defined(__linux__)
+/***********************************************************/
+/* AaFileBackend class definition                          */
+/***********************************************************/
+
+AaFileBackend::AaFileBackend(int const fd, bool const writable) noexcept
+    : _fd(fd), _writable(writable)
+{
+}
+
+AaCommandStatus AaFileBackend::read(uint64_t const offset, void* data, size_t const length)
+{
+    auto const result = ::pread(_fd, data, length, static_cast<off_t>(offset));
+    if (result < 0 || static_cast<size_t>(result) != length)
+    {
+        return AaCommandStatus::AddressInvalid;
+    }
+    return AaCommandStatus::Success;
+}
+
+AaCommandStatus AaFileBackend::write(uint64_t const offset, const void* data, size_t const length)
+{
+    if (!_writable)
+    {
+        return AaCommandStatus::Unsupported;
+    }
+    auto const result = ::pwrite(_fd, data, length, static_cast<off_t>(offset));
+    if (result < 0 || static_cast<size_t>(result) != length)
+    {
+        ESP_LOGE(TAG, "File write failed");
+        return AaCommandStatus::DataInvalid;
+    }
+    return AaCommandStatus::Success;
+}
+#endif
+
+/***********************************************************/
+/* AaAddressSpace class definition                         */
+/***********************************************************/
+
+bool AaAddressSpace::addRegion(uint64_t const address, uint64_t const length, AaMemoryBackend& backend) noexcept
+{
+    if (length == 0u || address + (length - 1u) < address)
+    {
+        ESP_LOGE(TAG, "Invalid region length");
+        return false;
+    }
+    if (_regionCount == MaxRegions)
+    {
+        ESP_LOGE(TAG, "Too many memory regions");
+        return false;
+    }
+
+    // Keep the regions sorted, refusing overlaps
+    auto const begin = _regions.begin();
+    auto const end = begin + _regionCount;
+    auto const it = std::upper_bound(begin, end, address, [](uint64_t const a, Region const& region)
+    {
+        return a < region.address;
+    });
+    if ((it != end && address + (length - 1u) >= it->address) || (it != begin && (it - 1)->address + ((it - 1)->length - 1u) >= address))
+    {
+        ESP_LOGE(TAG, "Memory region 0x%llx overlaps another one", static_cast<unsigned long long>(address));
+        return false;
+    }
+
+    std::move_backward(it, end, end + 1);
+    *it = Region{ address, length, &backend };
+    ++_regionCount;
+    return true;
+}
+
+void AaAddressSpace::removeRegion(uint64_t const address) noexcept
+{
+    auto const begin = _regions.begin();
+    auto const end = begin + _regionCount;
+    auto const it = std::find_if(begin, end, [address](Region const& region)
+    {
+        return region.address == address;
+    });
+    if (it != end)
+    {
+        std::move(it + 1, end, it);
+        --_regionCount;
+    }
+}
+
+void AaAddressSpace::setPayloadNegotiator(AecpPayloadNegotiator* negotiator) noexcept
+{
+    _negotiator = negotiator;
+}
+
+AaCommandStatus AaAddressSpace::validate(TlvView const& tlv) const noexcept
+{
+    auto const mode = tlv.getMode();
+    if ((mode != AaMode::READ && mode != AaMode::WRITE && mode != AaMode::EXECUTE) || tlv.size() == 0u)
+    {
+        return AaCommandStatus::TlvInvalid;
+    }
+    if (_regionCount == 0u)
+    {
+        return AaCommandStatus::AddressInvalid;
+    }
+
+    auto const address = tlv.getAddress();
+    auto const& first = _regions[0];
+    auto const& last = _regions[_regionCount - 1];
+    if (address < first.address)
+    {
+        return AaCommandStatus::AddressTooLow;
+    }
+    if (address >= last.address && address - last.address >= last.length)
+    {
+        return AaCommandStatus::AddressTooHigh;
+    }
+
+    // Must fit entirely in one region
+    auto const* const region = findRegion(address);
+    if (region == nullptr || tlv.size() > region->length - (address - region->address))
+    {
+        return AaCommandStatus::AddressInvalid;
+    }
+    return AaCommandStatus::Success;
+}
+
+size_t AaAddressSpace::processCommand(const uint8_t* command, size_t const commandLength, uint8_t* response, size_t const responseCapacity)
+{
+    if (command == nullptr || response == nullptr || commandLength < Aecpdu::HEADER_LENGTH + AaAecpdu::HeaderLength)
+    {
+        ESP_LOGE(TAG, "Invalid AA command buffer");
+        return 0u;
+    }
+    // The response has the same layout as the command, READ data replacing the placeholders
+    if (responseCapacity < commandLength)
+    {
+        ESP_LOGE(TAG, "AA response buffer too small");
+        return 0u;
+    }
+
+    // Turned into the response header at the end
+    Aecpdu header;
+    header.deserialize(command, commandLength);
+    if (_negotiator != nullptr && !_negotiator->onAecpduReceived(header.getControllerEntityID(), commandLength))
+    {
+        return 0u;
+    }
+    std::memcpy(response, command, commandLength);
+
+    // Validate everything first: on error, no TLV is processed
+    auto status = AaCommandStatus::Success;
+    auto const wellFormed = AaAecpdu::forEachTlv(command, commandLength, [this, &status](TlvView const& tlv)
+    {
+        status = validate(tlv);
+        return status == AaCommandStatus::Success;
+    });
+    if (!wellFormed)
+    {
+        status = AaCommandStatus::TlvInvalid;
+    }
+
+    if (status == AaCommandStatus::Success)
+    {
+        AaAecpdu::forEachTlv(command, commandLength, [this, &status, command, response](TlvView const& tlv)
+        {
+            status = process(tlv, response + (tlv.data() - command));
+            return status == AaCommandStatus::Success;
+        });
+    }
+
+    // Turn the header into a response
+    header.setMessageType(AecpMessageType::ADDRESS_ACCESS_RESPONSE);
+    header.setStatus(static_cast<AecpStatus>(static_cast<uint8_t>(status)));
+    header.serialize(response, responseCapacity);
+
+    return commandLength;
+}
+
+size_t AaAddressSpace::getRegionCount() const noexcept
+{
+    return _regionCount;
+}
+
+AaAddressSpace::Region const* AaAddressSpace::findRegion(uint64_t const address) const noexcept
+{
+    auto const begin = _regions.begin();
+    auto const end = begin + _regionCount;
+    auto it = std::upper_bound(begin, end, address, [](uint64_t const a, Region const& region)
+    {
+        return a < region.address;
+    });
+    if (it == begin)
+    {
+        return nullptr;
+    }
+    --it;
+    if (address - it->address >= it->length)
+    {
+        return nullptr;
+    }
+    return &*it;
+}
+
+AaCommandStatus AaAddressSpace::process(TlvView const& tlv, uint8_t* responseData)
+{
+    auto const* const region = findRegion(tlv.getAddress());
+    auto const offset = tlv.getAddress() - region->address;
+
+    switch (tlv.getMode())
+    {
+        case AaMode::READ:
+            return region->backend->read(offset, responseData, tlv.size());
+        case AaMode::WRITE:
+            return region->backend->write(offset, tlv.data(), tlv.size());
+        case AaMode::EXECUTE:
+            return region->backend->execute(offset, tlv.data(), tlv.size());
+        default:
+            return AaCommandStatus::TlvInvalid;
+    }
+}
@@ -0,0 +1,230 @@
+#include "espNetworkTransport.hpp"
+
+#if defined(ESP_PLATFORM)
+
+#include "esp_log.h"
+#include "esp_idf_version.h"
+#include "protocolAvtpdu.hpp"
+#include "serialization.hpp"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+
+static const char* TAG = "TRANSPORT_ESP";
+
+/** Minimum Ethernet frame without FCS */
+static constexpr size_t MinimumFrameLength = EtherLayer2::Length + EthernetPayloadMinimumSize;
+
+/** Frames decoded per poll with deferred delivery, so the caller keeps control during a storm */
+static constexpr size_t MaxFramesPerPoll = 32u;
+
+#if defined(configTASK_NOTIFICATION_ARRAY_ENTRIES) && configTASK_NOTIFICATION_ARRAY_ENTRIES > ATDECC_RX_NOTIFY_INDEX
+#define RX_NOTIFY_TAKE(ticks) ulTaskNotifyTakeIndexed(ATDECC_RX_NOTIFY_INDEX, pdTRUE, ticks)
+#define RX_NOTIFY_GIVE(task) xTaskNotifyGiveIndexed(task, ATDECC_RX_NOTIFY_INDEX)
+#else
+// Single notification per task: a wake-up meant for another waiter of the polling task (eg. an EventLoop) may be consumed here
+#define RX_NOTIFY_TAKE(ticks) ulTaskNotifyTake(pdTRUE, ticks)
+#define RX_NOTIFY_GIVE(task) xTaskNotifyGive(task)
+#endif
+
+/***********************************************************/
+/* EspNetworkTransport class definition                    */
+/***********************************************************/
+
+EspNetworkTransport::EspNetworkTransport(esp_eth_handle_t const ethHandle, esp_netif_t* netif, bool const deferredDelivery) noexcept
+    : _ethHandle(ethHandle), _netif(netif), _deferredDelivery(deferredDelivery)
+{
+}
+
+EspNetworkTransport::~EspNetworkTransport() noexcept
+{
+    close();
+}
+
+bool EspNetworkTransport::open()
+{
+    if (_open)
+    {
+        return true;
+    }
+    if (_ethHandle == nullptr)
+    {
+        ESP_LOGE(TAG, "No Ethernet driver");
+        return false;
+    }
+
+    auto err = esp_eth_ioctl(_ethHandle, ETH_CMD_G_MAC_ADDR, _macAddress.data());
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Cannot get the MAC address: %s", esp_err_to_name(err));
+        return false;
+    }
+    if (_deferredDelivery && !_rxRing)
+    {
+        _rxRing = std::make_unique<FrameRing>();
+    }
+    err = esp_eth_update_input_path(_ethHandle, &EspNetworkTransport::onFrameReceived, this);
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Cannot set the input path: %s", esp_err_to_name(err));
+        return false;
+    }
+
+    _open = true;
+    ESP_LOGI(TAG, "Opened, MAC %02x:%02x:%02x:%02x:%02x:%02x", _macAddress[0], _macAddress[1], _macAddress[2], _macAddress[3], _macAddress[4], _macAddress[5]);
+    return true;
+}
+
+void EspNetworkTransport::close() noexcept
+{
+    if (!_open)
+    {
+        return;
+    }
+    _open = false;
+    if (_promiscuous)
+    {
+        auto promiscuous = false;
+        esp_eth_ioctl(_ethHandle, ETH_CMD_S_PROMISCUOUS, &promiscuous);
+        _promiscuous = false;
+    }
+    // Give the input path back to the IP stack, if it had it
+    if (_netif != nullptr)
+    {
+        esp_eth_update_input_path(_ethHandle, [](esp_eth_handle_t, uint8_t* buffer, uint32_t length, void* priv) -> esp_err_t
+        {
+            return esp_netif_receive(static_cast<esp_netif_t*>(priv), buffer, length, nullptr);
+        }, _netif);
+    }
+    else
+    {
+        esp_eth_update_input_path(_ethHandle, nullptr, nullptr);
+    }
+}
+
+bool EspNetworkTransport::sendFrame(const uint8_t* frame, size_t const length)
+{
+    if (!_open || frame == nullptr || length < EtherLayer2::Length || length > ETHERNET_MAX_FRAME_SIZE)
+    {
+        return false;
+    }
+
+    auto err = ESP_OK;
+    if (length < MinimumFrameLength)
+    {
+        uint8_t padded[MinimumFrameLength] = {};
+        std::memcpy(padded, frame, length);
+        err = esp_eth_transmit(_ethHandle, padded, sizeof(padded));
+    }
+    else
+    {
+        err = esp_eth_transmit(_ethHandle, const_cast<uint8_t*>(frame), length);
+    }
+    if (err != ESP_OK)
+    {
+        ESP_LOGW(TAG, "Frame not sent: %s", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+bool EspNetworkTransport::joinMulticast(MacAddress const& macAddress)
+{
+    if (_ethHandle == nullptr)
+    {
+        return false;
+    }
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+    auto const err = esp_eth_ioctl(_ethHandle, ETH_CMD_ADD_MAC_FILTER, const_cast<uint8_t*>(macAddress.data()));
+#else
+    // No multicast filter before IDF 5.3, receive everything (until close())
+    (void)macAddress;
+    auto promiscuous = true;
+    auto const err = esp_eth_ioctl(_ethHandle, ETH_CMD_S_PROMISCUOUS, &promiscuous);
+    _promiscuous = _promiscuous || err == ESP_OK;
+#endif
+    if (err != ESP_OK)
+    {
+        ESP_LOGE(TAG, "Cannot join multicast group: %s", esp_err_to_name(err));
+        return false;
+    }
+    return true;
+}
+
+bool EspNetworkTransport::leaveMulticast(MacAddress const& macAddress)
+{
+    if (_ethHandle == nullptr)
+    {
+        return false;
+    }
+#if ESP_IDF_VERSION >= ESP_IDF_VERSION_VAL(5, 3, 0)
+    return esp_eth_ioctl(_ethHandle, ETH_CMD_DEL_MAC_FILTER, const_cast<uint8_t*>(macAddress.data())) == ESP_OK;
+#else
+    (void)macAddress;
+    return true;
+#endif
+}
+
+size_t EspNetworkTransport::poll(std::chrono::milliseconds const timeout)
+{
+    if (!_rxRing)
+    {
+        // Frames are delivered from the Ethernet RX task
+        return 0u;
+    }
+
+    // Classified before queuing
+    auto const deliver = [this](const uint8_t* frame, size_t const length)
+    {
+        deliverFrame(frame, length);
+    };
+    auto count = _rxRing->drain(deliver, MaxFramesPerPoll);
+    if (count == 0u && timeout.count() != 0)
+    {
+        _pollTask = xTaskGetCurrentTaskHandle();
+        // Frames may have arrived before the task was known
+        count = _rxRing->drain(deliver, MaxFramesPerPoll);
+        if (count == 0u)
+        {
+            RX_NOTIFY_TAKE(pdMS_TO_TICKS(timeout.count()) + 1u);
+            count = _rxRing->drain(deliver, MaxFramesPerPoll);
+        }
+    }
+    return count;
+}
+
+FrameRing::Statistics EspNetworkTransport::getRxRingStatistics() const noexcept
+{
+    return _rxRing ? _rxRing->getStatistics() : FrameRing::Statistics{};
+}
+
+esp_err_t EspNetworkTransport::onFrameReceived(esp_eth_handle_t /*ethHandle*/, uint8_t* buffer, uint32_t length, void* priv)
+{
+    auto* const self = static_cast<EspNetworkTransport*>(priv);
+    if (self->_open && length >= EtherLayer2::Length && ((buffer[12] << 8) | buffer[13]) == AVTP_ETHER_TYPE)
+    {
+        if (!self->_rxRing)
+        {
+            self->dispatchFrame(buffer, length);
+        }
+        // Frames for other entities are dropped before taking a slot; only the first frame of a batch wakes the decoding task
+        else if (self->acceptFrame(buffer, length) && self->_rxRing->push(buffer, length) && self->_rxRing->getSize() == 1u)
+        {
+            if (auto const task = self->_pollTask.load())
+            {
+                RX_NOTIFY_GIVE(task);
+            }
+        }
+        std::free(buffer);
+        return ESP_OK;
+    }
+    if (self->_netif != nullptr)
+    {
+        // The IP stack takes the buffer
+        return esp_netif_receive(self->_netif, buffer, length, nullptr);
+    }
+    std::free(buffer);
+    return ESP_OK;
+}
+
+#endif // ESP_PLATFORM
@@ -0,0 +1,286 @@
+#include "eventLoop.hpp"
+
+#if defined(ESP_PLATFORM) || defined(__linux__)
+
+#include "esp_log.h"
+#include <algorithm>
+#include <utility>
+
+#if !defined(ESP_PLATFORM)
+#include <cerrno>
+#include <cstring>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#endif
+
+static const char* TAG = "EVENT_LOOP";
+
+#if !defined(ESP_PLATFORM)
+/** epoll events handled per wait */
+static constexpr int MaxEvents = 16;
+#endif
+
+/***********************************************************/
+/* EventLoop class definition                              */
+/***********************************************************/
+
+EventLoop::EventLoop()
+{
+#if !defined(ESP_PLATFORM)
+    _epoll = ::epoll_create1(EPOLL_CLOEXEC);
+    _eventFd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    _timerFd = ::timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (_epoll < 0 || _eventFd < 0 || _timerFd < 0)
+    {
+        ESP_LOGE(TAG, "Cannot create the loop descriptors: %s", std::strerror(errno));
+        return;
+    }
+    for (auto const fd : { _eventFd, _timerFd })
+    {
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (::epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) < 0)
+        {
+            ESP_LOGE(TAG, "Cannot watch the loop descriptors: %s", std::strerror(errno));
+        }
+    }
+#endif
+}
+
+EventLoop::~EventLoop() noexcept
+{
+#if !defined(ESP_PLATFORM)
+    for (auto const fd : { _timerFd, _eventFd, _epoll })
+    {
+        if (fd >= 0)
+        {
+            ::close(fd);
+        }
+    }
+#endif
+}
+
+bool EventLoop::post(Task task)
+{
+    if (!_tasks.push(std::move(task)))
+    {
+        _droppedTasks.fetch_add(1u, std::memory_order_relaxed);
+        return false;
+    }
+    // Only the first post since the loop last looked wakes it
+    if (!_wakePending.exchange(true, std::memory_order_acq_rel))
+    {
+        wake();
+    }
+    return true;
+}
+
+EventLoop::TimerId EventLoop::startTimer(std::chrono::milliseconds const delay, Task callback)
+{
+    // Relative to now, not to the last time the wheel was advanced
+    auto const now = getCurrentTick();
+    auto const late = now - std::min(now, _timers.getCurrentTick());
+    auto const ticks = static_cast<TimerWheel::Tick>(std::max<int64_t>(delay.count(), 0));
+    return _timers.start(ticks + late, std::move(callback));
+}
+
+bool EventLoop::cancelTimer(TimerId const timerId) noexcept
+{
+    return _timers.cancel(timerId);
+}
+
+void EventLoop::run()
+{
+#if defined(ESP_PLATFORM)
+    _task = xTaskGetCurrentTaskHandle();
+#endif
+    _running = true;
+    while (_running.load(std::memory_order_relaxed))
+    {
+        runOnce(Forever);
+    }
+}
+
+size_t EventLoop::runOnce(std::chrono::milliseconds const timeout)
+{
+    auto count = runReady();
+    if (count == 0u && timeout.count() != 0)
+    {
+        wait(timeout);
+        count = runReady();
+    }
+    return count;
+}
+
+void EventLoop::stop() noexcept
+{
+    _running = false;
+    wake();
+}
+
+#if defined(ESP_PLATFORM)
+bool EventLoop::start(char const* name, uint32_t const stackSize, UBaseType_t const priority, BaseType_t const core)
+{
+    TaskHandle_t task{ nullptr };
+    if (xTaskCreatePinnedToCore(&EventLoop::taskEntry, name, stackSize, this, priority, &task, core) != pdPASS)
+    {
+        ESP_LOGE(TAG, "Cannot create task %s", name);
+        return false;
+    }
+    return true;
+}
+
+void EventLoop::taskEntry(void* arg)
+{
+    auto* const loop = static_cast<EventLoop*>(arg);
+    loop->run();
+    loop->_task = nullptr;
+    vTaskDelete(nullptr);
+}
+#else
+bool EventLoop::watchFileDescriptor(int const fd, Task handler)
+{
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+    if (_epoll < 0 || ::epoll_ctl(_epoll, EPOLL_CTL_ADD, fd, &event) < 0)
+    {
+        ESP_LOGE(TAG, "Cannot watch descriptor %d: %s", fd, std::strerror(errno));
+        return false;
+    }
+    _watches.push_back(Watch{ fd, std::move(handler) });
+    return true;
+}
+
+bool EventLoop::unwatchFileDescriptor(int const fd)
+{
+    auto const it = std::find_if(_watches.begin(), _watches.end(), [fd](Watch const& watch)
+    {
+        return watch.fd == fd;
+    });
+    if (it == _watches.end())
+    {
+        return false;
+    }
+    ::epoll_ctl(_epoll, EPOLL_CTL_DEL, fd, nullptr);
+    _watches.erase(it);
+    return true;
+}
+#endif
+
+TimerWheel::Tick EventLoop::getCurrentTick() const noexcept
+{
+    return static_cast<TimerWheel::Tick>(std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - _epoch).count());
+}
+
+size_t EventLoop::getActiveTimerCount() const noexcept
+{
+    return _timers.getActiveCount();
+}
+
+uint64_t EventLoop::getDroppedTaskCount() const noexcept
+{
+    return _droppedTasks.load(std::memory_order_relaxed);
+}
+
+size_t EventLoop::runReady()
+{
+    // Cleared before looking, so a post racing with the drain wakes the next wait
+    _wakePending.store(false, std::memory_order_release);
+
+    // Bounded, so timers are not starved by a flood of posts
+    auto count = size_t{ 0u };
+    Task task;
+    while (count < QueueDepth && _tasks.pop(task))
+    {
+        task();
+        task = nullptr;
+        ++count;
+    }
+    return count + _timers.advance(getCurrentTick());
+}
+
+void EventLoop::wait(std::chrono::milliseconds const timeout)
+{
+    auto const toNext = _timers.getTicksToNextEvent();
+
+#if defined(ESP_PLATFORM)
+    auto waitMs = timeout;
+    if (toNext != TimerWheel::NoTimer)
+    {
+        auto const now = getCurrentTick();
+        auto const deadline = _timers.getCurrentTick() + toNext;
+        waitMs = std::min(waitMs, std::chrono::milliseconds{ deadline > now ? deadline - now : 0u });
+    }
+    auto const ticks = waitMs == Forever ? portMAX_DELAY : static_cast<TickType_t>((waitMs.count() + portTICK_PERIOD_MS - 1) / portTICK_PERIOD_MS);
+    ulTaskNotifyTake(pdTRUE, ticks);
+#else
+    if (_epoll < 0)
+    {
+        return;
+    }
+
+    // Only reprogrammed when the next tick needed changes
+    auto const deadline = toNext == TimerWheel::NoTimer ? TimerWheel::NoTimer : _timers.getCurrentTick() + toNext;
+    if (deadline != _armedTick)
+    {
+        itimerspec spec{};
+        if (deadline != TimerWheel::NoTimer)
+        {
+            auto const when = std::chrono::duration_cast<std::chrono::nanoseconds>((_epoch + std::chrono::milliseconds{ deadline }).time_since_epoch());
+            spec.it_value.tv_sec = static_cast<time_t>(when.count() / 1000000000);
+            spec.it_value.tv_nsec = static_cast<long>(when.count() % 1000000000);
+        }
+        ::timerfd_settime(_timerFd, TFD_TIMER_ABSTIME, &spec, nullptr);
+        _armedTick = deadline;
+    }
+
+    epoll_event events[MaxEvents];
+    auto const count = ::epoll_wait(_epoll, events, MaxEvents, timeout == Forever ? -1 : static_cast<int>(std::min<int64_t>(timeout.count(), INT32_MAX)));
+    for (auto i = 0; i < count; ++i)
+    {
+        auto const fd = events[i].data.fd;
+        if (fd == _eventFd || fd == _timerFd)
+        {
+            uint64_t value{ 0u };
+            (void)!::read(fd, &value, sizeof(value));
+            if (fd == _timerFd)
+            {
+                _armedTick = TimerWheel::NoTimer;
+            }
+            continue;
+        }
+        auto const it = std::find_if(_watches.begin(), _watches.end(), [fd](Watch const& watch)
+        {
+            return watch.fd == fd;
+        });
+        if (it != _watches.end())
+        {
+            // Copied, the handler may unwatch its own descriptor
+            auto const handler = it->handler;
+            handler();
+        }
+    }
+#endif
+}
+
+void EventLoop::wake() noexcept
+{
+#if defined(ESP_PLATFORM)
+    if (auto const task = _task.load())
+    {
+        xTaskNotifyGive(task);
+    }
+#else
+    if (_eventFd >= 0)
+    {
+        uint64_t const one{ 1u };
+        (void)!::write(_eventFd, &one, sizeof(one));
+    }
+#endif
+}
+
+#endif // ESP_PLATFORM || __linux__
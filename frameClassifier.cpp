@@ -0,0 +1,242 @@
+#include "frameClassifier.hpp"
+#include "endian.hpp"
+#include "protocolAvtpdu.hpp"
+#include "protocolDefines.hpp"
+#include <cstring>
+
+/** Offsets in the frame (Ethernet header without VLAN tag) */
+static constexpr size_t EtherTypeOffset = 12u;
+static constexpr size_t SubtypeOffset = EtherLayer2::Length;
+static constexpr size_t MessageTypeOffset = SubtypeOffset + 1u;
+static constexpr size_t IdentifierOffset = SubtypeOffset + 4u;                                        /* ADP entity_id, AECP target_entity_id */
+static constexpr size_t ControllerOffset = EtherLayer2::Length + AvtpduControl::HeaderLength;         /* AECP and ACMP controller_entity_id */
+static constexpr size_t TalkerOffset = ControllerOffset + 8u;
+static constexpr size_t ListenerOffset = ControllerOffset + 16u;
+
+/** Message type bit set in all the AECP and ACMP responses */
+static constexpr uint8_t ResponseBit = 0x01;
+
+static uint64_t loadRaw(const uint8_t* ptr) noexcept
+{
+    auto value = uint64_t{ 0u };
+    std::memcpy(&value, ptr, sizeof(value));
+    return value;
+}
+
+static uint64_t toRaw(UniqueIdentifier const entityID) noexcept
+{
+    return entityID.isValid() ? ATDECC_PACK_TYPE(entityID.getValue(), uint64_t) : uint64_t{ 0u };
+}
+
+/** 3 bit positions from one mix of the ID */
+static uint64_t mixIdentifier(uint64_t value) noexcept
+{
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+    return value;
+}
+
+/***********************************************************/
+/* EntityIdFilter class definition                         */
+/***********************************************************/
+
+void EntityIdFilter::add(UniqueIdentifier const entityID) noexcept
+{
+    auto const hash = mixIdentifier(ATDECC_PACK_TYPE(entityID.getValue(), uint64_t));
+    for (auto i = 0u; i < 3u; ++i)
+    {
+        auto const bit = (hash >> (i * 21u)) & (Bits - 1u);
+        _words[bit / 32u].fetch_or(uint32_t{ 1u } << (bit % 32u), std::memory_order_relaxed);
+    }
+}
+
+void EntityIdFilter::clear() noexcept
+{
+    for (auto& word : _words)
+    {
+        word.store(0u, std::memory_order_relaxed);
+    }
+}
+
+bool EntityIdFilter::mayContain(UniqueIdentifier const entityID) const noexcept
+{
+    return mayContainRaw(ATDECC_PACK_TYPE(entityID.getValue(), uint64_t));
+}
+
+bool EntityIdFilter::mayContainRaw(uint64_t const networkOrderID) const noexcept
+{
+    auto const hash = mixIdentifier(networkOrderID);
+    for (auto i = 0u; i < 3u; ++i)
+    {
+        auto const bit = (hash >> (i * 21u)) & (Bits - 1u);
+        if ((_words[bit / 32u].load(std::memory_order_relaxed) & (uint32_t{ 1u } << (bit % 32u))) == 0u)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+/***********************************************************/
+/* FrameClassifier class definition                        */
+/***********************************************************/
+
+void FrameClassifier::setEntityID(UniqueIdentifier const entityID) noexcept
+{
+    _entityID = toRaw(entityID);
+}
+
+void FrameClassifier::setControllerID(UniqueIdentifier const controllerID) noexcept
+{
+    _controllerID = toRaw(controllerID);
+}
+
+void FrameClassifier::setWatchFilter(EntityIdFilter const* filter) noexcept
+{
+    _watchFilter = filter;
+}
+
+FrameVerdict FrameClassifier::classify(const uint8_t* frame, size_t const length) noexcept
+{
+    if (length < EtherLayer2::Length + AvtpduControl::HeaderLength)
+    {
+        return count(FrameVerdict::TooShort);
+    }
+    if (frame[EtherTypeOffset] != (AVTP_ETHER_TYPE >> 8) || frame[EtherTypeOffset + 1] != (AVTP_ETHER_TYPE & 0xff))
+    {
+        return count(FrameVerdict::NotAtdecc);
+    }
+
+    auto const messageType = static_cast<uint8_t>(frame[MessageTypeOffset] & 0x0f);
+    switch (frame[SubtypeOffset])
+    {
+        case AVTP_SUBTYPE_ADP:
+            return count(classifyAdp(frame, messageType));
+        case AVTP_SUBTYPE_AECP:
+            return count(classifyAecp(frame, length, messageType));
+        case AVTP_SUBTYPE_ACMP:
+            return count(classifyAcmp(frame, length, messageType));
+        default:
+            return count(FrameVerdict::NotAtdecc);
+    }
+}
+
+uint32_t FrameClassifier::getCount(FrameVerdict const verdict) const noexcept
+{
+    auto const index = static_cast<size_t>(verdict);
+    return index < _counts.size() ? _counts[index].load(std::memory_order_relaxed) : 0u;
+}
+
+uint64_t FrameClassifier::getDropCount() const noexcept
+{
+    auto total = uint64_t{ 0u };
+    for (auto i = static_cast<size_t>(FrameVerdict::Accept) + 1u; i < _counts.size(); ++i)
+    {
+        total += _counts[i].load(std::memory_order_relaxed);
+    }
+    return total;
+}
+
+FrameVerdict FrameClassifier::count(FrameVerdict const verdict) noexcept
+{
+    // Single writer, no read-modify-write needed
+    auto& counter = _counts[static_cast<size_t>(verdict)];
+    counter.store(counter.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+    return verdict;
+}
+
+FrameVerdict FrameClassifier::classifyAdp(const uint8_t* frame, uint8_t const messageType) noexcept
+{
+    auto const entityID = loadRaw(frame + IdentifierOffset);
+    if (messageType == static_cast<uint8_t>(AdpMessageType::ENTITY_DISCOVER))
+    {
+        if (_entityID == 0u)
+        {
+            return FrameVerdict::MessageType;
+        }
+        return entityID == 0u || entityID == _entityID ? FrameVerdict::Accept : FrameVerdict::NotAddressed;
+    }
+
+    // ENTITY_AVAILABLE and ENTITY_DEPARTING
+    if (_controllerID != 0u)
+    {
+        return isWatched(frame + IdentifierOffset) ? FrameVerdict::Accept : FrameVerdict::NotWatched;
+    }
+    // Entity role: only the advertisements of the talkers a listener fast connects to
+    if (_entityID == 0u || _watchFilter == nullptr || messageType != static_cast<uint8_t>(AdpMessageType::ENTITY_AVAILABLE))
+    {
+        return FrameVerdict::MessageType;
+    }
+    return _watchFilter->mayContainRaw(entityID) ? FrameVerdict::Accept : FrameVerdict::NotWatched;
+}
+
+FrameVerdict FrameClassifier::classifyAecp(const uint8_t* frame, size_t const length, uint8_t const messageType) noexcept
+{
+    if ((messageType & ResponseBit) == 0u)
+    {
+        if (_entityID == 0u)
+        {
+            return FrameVerdict::MessageType;
+        }
+        return loadRaw(frame + IdentifierOffset) == _entityID ? FrameVerdict::Accept : FrameVerdict::NotAddressed;
+    }
+
+    if (_controllerID == 0u)
+    {
+        return FrameVerdict::MessageType;
+    }
+    if (length < ControllerOffset + 8u)
+    {
+        return FrameVerdict::TooShort;
+    }
+    return loadRaw(frame + ControllerOffset) == _controllerID ? FrameVerdict::Accept : FrameVerdict::NotAddressed;
+}
+
+FrameVerdict FrameClassifier::classifyAcmp(const uint8_t* frame, size_t const length, uint8_t const messageType) noexcept
+{
+    if (length < ClassifiedLength)
+    {
+        return FrameVerdict::TooShort;
+    }
+
+    auto addressed = false;
+    if (_entityID != 0u)
+    {
+        switch (static_cast<AcmpMessageType>(messageType))
+        {
+            case AcmpMessageType::CONNECT_TX_COMMAND:
+            case AcmpMessageType::DISCONNECT_TX_COMMAND:
+            case AcmpMessageType::GET_TX_STATE_COMMAND:
+            case AcmpMessageType::GET_TX_CONNECTION_COMMAND:
+                addressed = loadRaw(frame + TalkerOffset) == _entityID;
+                break;
+            case AcmpMessageType::CONNECT_RX_COMMAND:
+            case AcmpMessageType::DISCONNECT_RX_COMMAND:
+            case AcmpMessageType::GET_RX_STATE_COMMAND:
+            case AcmpMessageType::CONNECT_TX_RESPONSE:
+            case AcmpMessageType::DISCONNECT_TX_RESPONSE:
+                addressed = loadRaw(frame + ListenerOffset) == _entityID;
+                break;
+            default:
+                break;
+        }
+        if (addressed)
+        {
+            return FrameVerdict::Accept;
+        }
+    }
+
+    if ((messageType & ResponseBit) == 0u || _controllerID == 0u)
+    {
+        return _entityID != 0u ? FrameVerdict::NotAddressed : FrameVerdict::MessageType;
+    }
+    return isWatched(frame + TalkerOffset) || isWatched(frame + ListenerOffset) ? FrameVerdict::Accept : FrameVerdict::NotWatched;
+}
+
+bool FrameClassifier::isWatched(const uint8_t* entityID) const noexcept
+{
+    return _watchFilter == nullptr || _watchFilter->mayContainRaw(loadRaw(entityID));
+}
@@ -0,0 +1,40 @@
+#include "frameRing.hpp"
+
+/***********************************************************/
+/* FrameRing class definition                              */
+/***********************************************************/
+
+static size_t roundUpPowerOfTwo(size_t const capacity) noexcept
+{
+    auto size = size_t{ 2u };
+    while (size < capacity)
+    {
+        size <<= 1u;
+    }
+    return size;
+}
+
+FrameRing::FrameRing(size_t const capacity)
+    : _mask(roundUpPowerOfTwo(capacity) - 1u), _slots(new Slot[_mask + 1u])
+{
+}
+
+void FrameRing::resetHighWatermark() noexcept
+{
+    _highWatermark.store(getSize(), std::memory_order_relaxed);
+}
+
+size_t FrameRing::getSize() const noexcept
+{
+    return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+}
+
+size_t FrameRing::getCapacity() const noexcept
+{
+    return _mask + 1u;
+}
+
+FrameRing::Statistics FrameRing::getStatistics() const noexcept
+{
+    return Statistics{ _frames.load(std::memory_order_relaxed), _drops.load(std::memory_order_relaxed), _highWatermark.load(std::memory_order_relaxed), _mask + 1u };
+}
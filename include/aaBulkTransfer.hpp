@@ -0,0 +1,111 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_AABULKTRANSFER_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_AABULKTRANSFER_HPP_
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include "aecpPayloadNegotiator.hpp"
+#include "protocolAaAecpdu.hpp"
+#include "protocolAecpdu.hpp"
+#include "protocolDefines.hpp"
+#include "uniqueIdentifier.hpp"
+
+// Maximum number of AA commands inflight for a bulk transfer (can be overridden from the build)
+#ifndef ATDECC_AA_BULK_MAX_INFLIGHT
+#define ATDECC_AA_BULK_MAX_INFLIGHT 8
+#endif
+
+/**
+ * @brief Controller side bulk Address Access read or write of an address range.
+ * @details The range is split into TLVs as big as an AECPDU to the target allows (see
+ *          setPayloadNegotiator, big payloads included), with up to window commands
+ *          inflight. Responses are matched by sequenceID and copied to their place in the
+ *          destination buffer whatever their order, and each lost command is resent alone.
+ */
+class AaBulkTransfer
+{
+public:
+    static constexpr size_t MaxWindow = ATDECC_AA_BULK_MAX_INFLIGHT;
+    static constexpr size_t MaxChunkSize = AaAecpdu::getMaximumTlvDataLength(Aecpdu::MAXIMUM_LENGTH_BIG_PAYLOADS);
+
+    /** Called once when the transfer ends */
+    using CompletedHandler = std::function<void(AaCommandStatus const status, size_t const length, std::chrono::milliseconds const duration)>;
+
+    AaBulkTransfer(UniqueIdentifier const controllerID, AecpSendHandler sendHandler, size_t const window = MaxWindow, std::chrono::milliseconds const timeout = std::chrono::milliseconds{ 250 }, uint32_t const maxRetries = 3u) noexcept;
+
+    // Setters
+    void setCompletedHandler(CompletedHandler handler) noexcept;
+    /** Selects the AECPDU length per target (defaults to ALLOW_SEND/RECV_BIG_AECP_PAYLOADS if not set). Must outlive this object. */
+    void setPayloadNegotiator(AecpPayloadNegotiator* negotiator) noexcept;
+    /** See AecpTimeoutHandler */
+    void setTimeoutHandler(AecpTimeoutHandler handler) noexcept;
+
+    /** Reads length bytes at address into destination, which must stay valid until completion */
+    bool read(UniqueIdentifier const targetEntityID, MacAddress const& targetAddress, uint64_t const address, uint8_t* destination, size_t const length, AecpClock::time_point const now = AecpClock::now());
+
+    /** Writes length bytes from source at address, source must stay valid until completion */
+    bool write(UniqueIdentifier const targetEntityID, MacAddress const& targetAddress, uint64_t const address, const uint8_t* source, size_t const length, AecpClock::time_point const now = AecpClock::now());
+
+    /** Stops the transfer, the completed handler is not called */
+    void abort() noexcept;
+
+    /** Processes a received AECPDU. Returns true if it was a response to one of our commands. */
+    bool handleAecpdu(Aecpdu const& aecpdu, AecpClock::time_point const now = AecpClock::now());
+
+    /** Resends the lost commands, to be called periodically */
+    void checkTimeouts(AecpClock::time_point const now = AecpClock::now());
+
+    // Getters
+    bool isRunning() const noexcept;
+    size_t getTransferredLength() const noexcept;
+    double getBytesPerSecond(AecpClock::time_point const now = AecpClock::now()) const noexcept;
+
+private:
+    struct Slot
+    {
+        AaAecpdu message{ false };
+        size_t chunk{ 0u };
+        uint32_t retries{ 0u };
+        AecpClock::time_point timeout{};
+        bool inUse{ false };
+    };
+
+    bool start(AaMode const mode, UniqueIdentifier const targetEntityID, MacAddress const& targetAddress, uint64_t const address, size_t const length, AecpClock::time_point const now);
+    void fill(AecpClock::time_point const now);
+    void send(Slot& slot, AecpClock::time_point const now);
+    bool completeChunk(Slot& slot, AaAecpdu const& response);
+    void complete(AaCommandStatus const status, AecpClock::time_point const now);
+
+    UniqueIdentifier _controllerID{};
+    AecpSendHandler _sendHandler{};
+    size_t _window{ MaxWindow };
+    std::chrono::milliseconds _timeout{};
+    AecpTimeoutHandler _timeoutHandler{};
+    uint32_t _maxRetries{ 0u };
+    CompletedHandler _completedHandler{};
+    AecpPayloadNegotiator* _negotiator{ nullptr };
+    std::array<Slot, MaxWindow> _slots{};
+
+    // Current transfer
+    AaMode _mode{ AaMode::READ };
+    UniqueIdentifier _targetEntityID{};
+    MacAddress _targetAddress{};
+    uint64_t _address{ 0u };
+    uint8_t* _destination{ nullptr };
+    const uint8_t* _source{ nullptr };
+    size_t _length{ 0u };
+    size_t _chunkSize{ 0u };
+    size_t _chunkCount{ 0u };
+    size_t _nextChunk{ 0u };        /** Next chunk never sent */
+    size_t _completedChunks{ 0u };
+    size_t _transferred{ 0u };
+    AecpSequenceID _sequenceID{ 0u };
+    AecpClock::time_point _startTime{};
+    bool _running{ false };
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_AABULKTRANSFER_HPP_ */
@@ -0,0 +1,109 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_AAPIPELINEDUPLOADER_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_AAPIPELINEDUPLOADER_HPP_
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include "aecpPayloadNegotiator.hpp"
+#include "protocolAaAecpdu.hpp"
+#include "protocolAecpdu.hpp"
+#include "protocolDefines.hpp"
+#include "uniqueIdentifier.hpp"
+
+// Maximum number of AA WRITE commands inflight (can be overridden from the build)
+#ifndef ATDECC_AA_MAX_INFLIGHT_WRITES
+#define ATDECC_AA_MAX_INFLIGHT_WRITES 8
+#endif
+
+/**
+ * @brief Controller side upload of a memory object with Address Access WRITE.
+ * @details Keeps up to window WRITE commands inflight instead of waiting for each response.
+ *          The entity stores the data in order (see AaUploadSink): when a command is lost or
+ *          refused with DataInvalid, the upload goes back to the first unacknowledged byte.
+ *          WRITEs are as big as the target allows (see setPayloadNegotiator); if big ones are
+ *          never answered, the upload falls back to standard sized AECPDUs before failing.
+ *          START_OPERATION(Upload) and SET_MEMORY_OBJECT_LENGTH are left to the caller.
+ */
+class AaPipelinedUploader
+{
+public:
+    static constexpr size_t MaxWindow = ATDECC_AA_MAX_INFLIGHT_WRITES;
+    static constexpr size_t MaxChunkSize = AaAecpdu::getMaximumTlvDataLength(Aecpdu::MAXIMUM_LENGTH_BIG_PAYLOADS);
+
+    /** Called each time the acknowledged length progresses */
+    using ProgressHandler = std::function<void(uint64_t const acknowledgedLength, uint64_t const totalLength)>;
+
+    /** Called once when the upload ends */
+    using CompletedHandler = std::function<void(AaCommandStatus const status, std::chrono::milliseconds const duration)>;
+
+    AaPipelinedUploader(UniqueIdentifier const controllerID, AecpSendHandler sendHandler, size_t const window = MaxWindow, std::chrono::milliseconds const timeout = std::chrono::milliseconds{ 250 }, uint32_t const maxRetries = 3u) noexcept;
+
+    // Setters
+    void setProgressHandler(ProgressHandler handler) noexcept;
+    void setCompletedHandler(CompletedHandler handler) noexcept;
+    /** Selects the AECPDU length per target (defaults to ALLOW_SEND_BIG_AECP_PAYLOADS if not set). Must outlive this object. */
+    void setPayloadNegotiator(AecpPayloadNegotiator* negotiator) noexcept;
+    /** See AecpTimeoutHandler */
+    void setTimeoutHandler(AecpTimeoutHandler handler) noexcept;
+
+    /** Starts writing length bytes to address. data must stay valid until completion. */
+    bool start(UniqueIdentifier const targetEntityID, MacAddress const& targetAddress, uint64_t const address, const uint8_t* data, size_t const length, AecpClock::time_point const now = AecpClock::now());
+
+    /** Stops the upload, the completed handler is not called */
+    void abort() noexcept;
+
+    /** Processes a received AECPDU. Returns true if it was a response to one of our writes. */
+    bool handleAecpdu(Aecpdu const& aecpdu, AecpClock::time_point const now = AecpClock::now());
+
+    /** Handles the lost commands, to be called periodically */
+    void checkTimeouts(AecpClock::time_point const now = AecpClock::now());
+
+    // Getters
+    bool isRunning() const noexcept;
+    uint64_t getAcknowledgedLength() const noexcept;
+    double getBytesPerSecond(AecpClock::time_point const now = AecpClock::now()) const noexcept;
+
+private:
+    struct Slot
+    {
+        AaAecpdu message{ false };
+        uint64_t offset{ 0u };
+        size_t size{ 0u };
+        AecpClock::time_point timeout{};
+        bool inUse{ false };
+    };
+
+    void fill(AecpClock::time_point const now);
+    void rewind(AecpClock::time_point const now);
+    void complete(AaCommandStatus const status, AecpClock::time_point const now);
+
+    UniqueIdentifier _controllerID{};
+    AecpSendHandler _sendHandler{};
+    size_t _window{ MaxWindow };
+    std::chrono::milliseconds _timeout{};
+    AecpTimeoutHandler _timeoutHandler{};
+    uint32_t _maxRetries{ 0u };
+    ProgressHandler _progressHandler{};
+    CompletedHandler _completedHandler{};
+    AecpPayloadNegotiator* _negotiator{ nullptr };
+    std::array<Slot, MaxWindow> _slots{};
+
+    // Current upload
+    UniqueIdentifier _targetEntityID{};
+    MacAddress _targetAddress{};
+    uint64_t _address{ 0u };
+    const uint8_t* _data{ nullptr };
+    size_t _length{ 0u };
+    size_t _chunkSize{ 0u };
+    uint64_t _nextOffset{ 0u };    /** Next byte to send */
+    uint64_t _acknowledged{ 0u };  /** Bytes known to be stored by the entity */
+    uint32_t _retries{ 0u };       /** Go-back retries since the last progress */
+    AecpSequenceID _sequenceID{ 0u };
+    AecpClock::time_point _startTime{};
+    bool _running{ false };
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_AAPIPELINEDUPLOADER_HPP_ */
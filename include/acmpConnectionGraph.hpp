@@ -0,0 +1,103 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_ACMPCONNECTIONGRAPH_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_ACMPCONNECTIONGRAPH_HPP_
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <unordered_map>
+#include <unordered_set>
+#include "protocolAcmpdu.hpp"
+#include "protocolDefines.hpp"
+#include "uniqueIdentifier.hpp"
+
+/** One end of an ACMP connection (talker or listener stream) */
+struct AcmpStreamEndpoint
+{
+    UniqueIdentifier entityID{};
+    AcmpUniqueID uniqueID{ 0u };
+
+    constexpr friend bool operator==(AcmpStreamEndpoint const& lhs, AcmpStreamEndpoint const& rhs) noexcept
+    {
+        return lhs.entityID == rhs.entityID && lhs.uniqueID == rhs.uniqueID;
+    }
+    constexpr friend bool operator!=(AcmpStreamEndpoint const& lhs, AcmpStreamEndpoint const& rhs) noexcept
+    {
+        return !operator==(lhs, rhs);
+    }
+
+    /** Hash functor to be used for std::hash */
+    struct hash
+    {
+        std::size_t operator()(AcmpStreamEndpoint const& endpoint) const
+        {
+            return std::hash<uint64_t>()(endpoint.entityID.getValue() ^ (static_cast<uint64_t>(endpoint.uniqueID) << 48));
+        }
+    };
+};
+
+/**
+ * @brief Passive talker->listener connection graph.
+ * @details Built from the ACMP responses seen on Acmpdu::Multicast_Mac_Address, so a
+ *          controller can follow every connection of the network without polling.
+ *          Each listener stream has at most one incoming edge, each talker stream any
+ *          number of outgoing edges. Insertion and removal of an edge are O(1).
+ */
+class AcmpConnectionGraph
+{
+public:
+    struct Connection
+    {
+        AcmpStreamEndpoint talker{};
+        AcmpStreamEndpoint listener{};
+        UniqueIdentifier streamID{};
+        MacAddress streamDestAddress{};
+        uint16_t streamVlanID{ 0u };
+        uint16_t flags{ 0u };
+    };
+
+    enum class ChangeType : uint8_t
+    {
+        Connected = 0,    /** New edge */
+        Disconnected = 1, /** Edge removed */
+        Updated = 2,      /** Same edge, stream parameters changed */
+    };
+
+    using ListenerSet = std::unordered_set<AcmpStreamEndpoint, AcmpStreamEndpoint::hash>;
+
+    /** Called for every change of the graph */
+    using ChangedHandler = std::function<void(ChangeType const changeType, Connection const& connection)>;
+
+    // Setters
+    void setChangedHandler(ChangedHandler handler) noexcept;
+
+    /** Feeds a received ACMPDU (any message type). Returns true if the graph changed. */
+    bool handleAcmpdu(Acmpdu const& acmpdu);
+
+    /** Adds or updates the edge going to connection.listener. Returns true if the graph changed. */
+    bool connect(Connection const& connection);
+
+    /** Removes the edge going to a listener stream. Returns true if there was one. */
+    bool disconnect(AcmpStreamEndpoint const& listener);
+
+    /** Removes all the edges of an entity (eg. on ADP ENTITY_DEPARTING or timeout) */
+    void removeEntity(UniqueIdentifier const entityID);
+
+    /** Removes all the edges, without notification */
+    void clear() noexcept;
+
+    // Getters
+    Connection const* getListenerConnection(AcmpStreamEndpoint const& listener) const noexcept;
+    ListenerSet const* getTalkerListeners(AcmpStreamEndpoint const& talker) const noexcept;
+    size_t getConnectionCount() const noexcept;
+
+private:
+    void notify(ChangeType const changeType, Connection const& connection);
+    void removeTalkerEdge(AcmpStreamEndpoint const& talker, AcmpStreamEndpoint const& listener);
+
+    ChangedHandler _changedHandler{};
+    std::unordered_map<AcmpStreamEndpoint, Connection, AcmpStreamEndpoint::hash> _listenerEdges{}; /** listener -> its connection */
+    std::unordered_map<AcmpStreamEndpoint, ListenerSet, AcmpStreamEndpoint::hash> _talkerEdges{}; /** talker -> its listeners */
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_ACMPCONNECTIONGRAPH_HPP_ */
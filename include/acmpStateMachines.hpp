@@ -0,0 +1,272 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_ACMPSTATEMACHINES_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_ACMPSTATEMACHINES_HPP_
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <type_traits>
+#include "protocolAcmpdu.hpp"
+#include "entityModelTypes.hpp"
+#include "frameClassifier.hpp"
+#include "protocolDefines.hpp"
+#include "uniqueIdentifier.hpp"
+
+// Sizing of the fixed ACMP tables (can be overridden from the build)
+#ifndef ATDECC_ACMP_MAX_TALKER_STREAMS
+#define ATDECC_ACMP_MAX_TALKER_STREAMS 8
+#endif
+#ifndef ATDECC_ACMP_MAX_LISTENER_STREAMS
+#define ATDECC_ACMP_MAX_LISTENER_STREAMS 8
+#endif
+#ifndef ATDECC_ACMP_MAX_LISTENERS_PER_STREAM
+#define ATDECC_ACMP_MAX_LISTENERS_PER_STREAM 16
+#endif
+#ifndef ATDECC_ACMP_MAX_INFLIGHT_COMMANDS
+#define ATDECC_ACMP_MAX_INFLIGHT_COMMANDS 16
+#endif
+
+using AcmpClock = std::chrono::steady_clock;
+
+/** Called by the state machines to put an ACMPDU on the network (to Acmpdu::Multicast_Mac_Address) */
+using AcmpSendHandler = std::function<void(Acmpdu const& acmpdu)>;
+
+/** ACMP command timeouts - Clause 8.2.2 Table 8.1 */
+constexpr std::chrono::milliseconds getAcmpCommandTimeout(AcmpMessageType const messageType) noexcept
+{
+    switch (messageType)
+    {
+        case AcmpMessageType::CONNECT_TX_COMMAND:
+            return std::chrono::milliseconds{ 2000 };
+        case AcmpMessageType::DISCONNECT_TX_COMMAND:
+            return std::chrono::milliseconds{ 200 };
+        case AcmpMessageType::GET_TX_STATE_COMMAND:
+            return std::chrono::milliseconds{ 200 };
+        case AcmpMessageType::CONNECT_RX_COMMAND:
+            return std::chrono::milliseconds{ 4500 };
+        case AcmpMessageType::DISCONNECT_RX_COMMAND:
+            return std::chrono::milliseconds{ 500 };
+        case AcmpMessageType::GET_RX_STATE_COMMAND:
+            return std::chrono::milliseconds{ 200 };
+        case AcmpMessageType::GET_TX_CONNECTION_COMMAND:
+            return std::chrono::milliseconds{ 200 };
+        default:
+            return std::chrono::milliseconds{ 0 };
+    }
+}
+
+/** True if the message type is one of the *_RESPONSE types (odd values) */
+constexpr bool isAcmpResponse(AcmpMessageType const messageType) noexcept
+{
+    return (static_cast<uint8_t>(messageType) & 0x01) != 0;
+}
+
+/** Returns the *_RESPONSE message type matching a *_COMMAND message type */
+constexpr AcmpMessageType getAcmpResponseType(AcmpMessageType const commandType) noexcept
+{
+    return static_cast<AcmpMessageType>(static_cast<uint8_t>(commandType) | 0x01);
+}
+
+/** Fixed table of ACMP commands waiting for a response, indexed by sequenceID */
+class AcmpInflightCommands
+{
+public:
+    static constexpr size_t Capacity = ATDECC_ACMP_MAX_INFLIGHT_COMMANDS;
+    static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "ATDECC_ACMP_MAX_INFLIGHT_COMMANDS must be a power of two");
+
+    struct Command
+    {
+        Acmpdu command{};                    /** Command as sent on the network */
+        Acmpdu originalCommand{};            /** Command that caused this one to be sent (eg. CONNECT_RX relayed as CONNECT_TX) */
+        AcmpClock::time_point timeout{};     /** When the response is considered lost */
+        bool retried{ false };               /** The command has already been sent twice */
+        bool inUse{ false };
+    };
+
+    /**
+     * @brief Reserves a slot for a new command.
+     * @details The returned command has its sequenceID already set, chosen so that
+     *          the slot can be found back directly from the response sequenceID.
+     * @return The reserved command, or nullptr if all slots are in use.
+     */
+    Command* allocate() noexcept;
+
+    /** Returns the inflight command with the specified sequenceID, or nullptr */
+    Command* find(AcmpSequenceID const sequenceID) noexcept;
+
+    /** Releases a command slot */
+    void release(Command& command) noexcept;
+
+    /** Calls handler(Command&) for each command whose timeout is before now */
+    template<typename Handler>
+    void forEachExpired(AcmpClock::time_point const now, Handler&& handler)
+    {
+        if (_count == 0)
+        {
+            return;
+        }
+        for (auto& command : _commands)
+        {
+            if (command.inUse && command.timeout <= now)
+            {
+                handler(command);
+            }
+        }
+    }
+
+    /** Number of commands currently inflight */
+    size_t size() const noexcept
+    {
+        return _count;
+    }
+
+private:
+    static constexpr size_t slotOf(AcmpSequenceID const sequenceID) noexcept
+    {
+        return static_cast<size_t>(sequenceID) & (Capacity - 1);
+    }
+
+    std::array<Command, Capacity> _commands{};
+    size_t _count{ 0u };
+    AcmpSequenceID _nextSequenceID{ 0u };
+};
+
+/** ACMP Talker state machine - Clause 8.2.2.6 */
+class AcmpTalkerStateMachine
+{
+public:
+    static constexpr size_t MaxStreams = ATDECC_ACMP_MAX_TALKER_STREAMS;
+    static constexpr size_t MaxListenersPerStream = ATDECC_ACMP_MAX_LISTENERS_PER_STREAM;
+
+    struct ListenerConnection
+    {
+        UniqueIdentifier listenerEntityID{};
+        AcmpUniqueID listenerUniqueID{ 0u };
+    };
+
+    struct StreamInfo
+    {
+        UniqueIdentifier streamID{};
+        MacAddress streamDestAddress{};
+        uint16_t streamVlanID{ 0u };
+        uint16_t flags{ 0u };
+        uint16_t connectionCount{ 0u };
+        std::array<ListenerConnection, MaxListenersPerStream> connections{}; /** Only the first connectionCount entries are valid */
+    };
+
+    /** Called each time a listener is added to or removed from a stream */
+    using ConnectionsChangedHandler = std::function<void(AcmpUniqueID const talkerUniqueID, StreamInfo const& streamInfo)>;
+
+    AcmpTalkerStateMachine(UniqueIdentifier const entityID, uint16_t const talkerStreamSources, AcmpSendHandler sendHandler) noexcept;
+
+    // Setters
+    void setStreamInfo(AcmpUniqueID const talkerUniqueID, UniqueIdentifier const streamID, MacAddress const& streamDestAddress, uint16_t const streamVlanID) noexcept;
+    void setConnectionsChangedHandler(ConnectionsChangedHandler handler) noexcept;
+
+    // Getters
+    StreamInfo const* getStreamInfo(AcmpUniqueID const talkerUniqueID) const noexcept;
+    uint16_t getStreamCount() const noexcept;
+
+    /** Processes a received ACMPDU. Returns true if it was a command addressed to this talker. */
+    bool handleAcmpdu(Acmpdu const& acmpdu);
+
+private:
+    AcmpStatus connectTalker(Acmpdu const& command, StreamInfo& stream) noexcept;
+    AcmpStatus disconnectTalker(Acmpdu const& command, StreamInfo& stream) noexcept;
+    void sendResponse(Acmpdu const& command, StreamInfo const* stream, AcmpStatus const status, UniqueIdentifier const listenerEntityID, AcmpUniqueID const listenerUniqueID);
+
+    UniqueIdentifier _entityID{};
+    uint16_t _streamCount{ 0u };
+    AcmpSendHandler _sendHandler{};
+    ConnectionsChangedHandler _connectionsChangedHandler{};
+    std::array<StreamInfo, MaxStreams> _streams{};
+};
+
+/** ACMP Listener state machine - Clause 8.2.2.5 */
+class AcmpListenerStateMachine
+{
+public:
+    static constexpr size_t MaxStreams = ATDECC_ACMP_MAX_LISTENER_STREAMS;
+
+    struct StreamInfo
+    {
+        UniqueIdentifier talkerEntityID{};
+        AcmpUniqueID talkerUniqueID{ 0u };
+        UniqueIdentifier controllerEntityID{};
+        UniqueIdentifier streamID{};
+        MacAddress streamDestAddress{};
+        uint16_t streamVlanID{ 0u };
+        uint16_t flags{ 0u };
+        bool connected{ false };
+        bool pending{ false }; /** A CONNECT_TX or DISCONNECT_TX is waiting for the talker */
+        bool fastConnecting{ false }; /** The pending CONNECT_TX was issued by fast connect, no controller is waiting */
+    };
+
+    /** Binding of a stream saved across power cycles for fast connect - Clause 8.2.2.5.2.1 */
+    struct SavedConnection
+    {
+        UniqueIdentifier talkerEntityID{};
+        AcmpUniqueID talkerUniqueID{ 0u };
+        MacAddress streamDestAddress{};
+        uint16_t streamVlanID{ 0u };
+        uint16_t flags{ 0u };
+    };
+    static_assert(std::is_trivially_copyable<SavedConnection>::value, "SavedConnection is expected to be stored as a raw blob");
+
+    /** Called each time a stream gets connected or disconnected (to start/stop the media path) */
+    using StreamStateChangedHandler = std::function<void(AcmpUniqueID const listenerUniqueID, StreamInfo const& streamInfo)>;
+
+    /** Called when the binding of a stream must be persisted (std::nullopt when it must be erased) */
+    using SaveConnectionHandler = std::function<void(StreamIndex const streamIndex, std::optional<SavedConnection> const& savedConnection)>;
+
+    AcmpListenerStateMachine(UniqueIdentifier const entityID, uint16_t const listenerStreamSinks, AcmpSendHandler sendHandler) noexcept;
+
+    // Setters
+    void setStreamStateChangedHandler(StreamStateChangedHandler handler) noexcept;
+    void setSaveConnectionHandler(SaveConnectionHandler handler) noexcept;
+
+    /** Restores a binding loaded from persistent storage at boot, the stream will fast connect as soon as the talker is discovered */
+    void restoreConnection(StreamIndex const streamIndex, SavedConnection const& savedConnection) noexcept;
+
+    // Getters
+    StreamInfo const* getStreamInfo(AcmpUniqueID const listenerUniqueID) const noexcept;
+    std::optional<SavedConnection> getSavedConnection(StreamIndex const streamIndex) const noexcept;
+    /** Adds the talkers of the saved bindings to filter, for a FrameClassifier to let their ENTITY_AVAILABLE through (call after restoreConnection) */
+    void addSavedTalkers(EntityIdFilter& filter) const noexcept;
+    uint16_t getStreamCount() const noexcept;
+    size_t getInflightCount() const noexcept;
+
+    /** Processes a received ACMPDU. Returns true if it was addressed to this listener. */
+    bool handleAcmpdu(Acmpdu const& acmpdu, AcmpClock::time_point const now = AcmpClock::now());
+
+    /** Retries or fails the commands sent to talkers that did not get a response in time */
+    void checkTimeouts(AcmpClock::time_point const now = AcmpClock::now());
+
+    /** To be called when ADP discovers an entity (ENTITY_AVAILABLE), sends CONNECT_TX with FAST_CONNECT for the streams saved against it */
+    void onEntityAvailable(UniqueIdentifier const entityID, AcmpClock::time_point const now = AcmpClock::now());
+
+private:
+    void handleConnectRxCommand(Acmpdu const& command, StreamInfo& stream, AcmpClock::time_point const now);
+    void handleDisconnectRxCommand(Acmpdu const& command, StreamInfo& stream, AcmpClock::time_point const now);
+    void handleGetRxStateCommand(Acmpdu const& command, StreamInfo const& stream);
+    void handleTxResponse(Acmpdu const& response);
+    bool sendTxCommand(AcmpMessageType const messageType, Acmpdu const& rxCommand, AcmpClock::time_point const now);
+    void sendRxResponse(Acmpdu const& rxCommand, StreamInfo const& stream, AcmpStatus const status);
+    void connectListener(StreamInfo& stream, Acmpdu const& txResponse, AcmpUniqueID const listenerUniqueID);
+    void disconnectListener(StreamInfo& stream, AcmpUniqueID const listenerUniqueID);
+    void saveConnection(AcmpUniqueID const listenerUniqueID, std::optional<SavedConnection> const& savedConnection);
+
+    UniqueIdentifier _entityID{};
+    uint16_t _streamCount{ 0u };
+    AcmpSendHandler _sendHandler{};
+    StreamStateChangedHandler _streamStateChangedHandler{};
+    SaveConnectionHandler _saveConnectionHandler{};
+    std::array<StreamInfo, MaxStreams> _streams{};
+    std::array<std::optional<SavedConnection>, MaxStreams> _savedConnections{};
+    AcmpInflightCommands _inflight{};
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_ACMPSTATEMACHINES_HPP_ */
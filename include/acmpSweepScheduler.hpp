@@ -0,0 +1,99 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_ACMPSWEEPSCHEDULER_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_ACMPSWEEPSCHEDULER_HPP_
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <vector>
+#include "acmpConnectionGraph.hpp"
+#include "acmpStateMachines.hpp"
+#include "protocolAcmpdu.hpp"
+#include "uniqueIdentifier.hpp"
+
+/** Concurrency limits of AcmpSweepScheduler */
+struct AcmpSweepConfiguration
+{
+    size_t maxInflight{ AcmpInflightCommands::Capacity }; /** Global limit, at most AcmpInflightCommands::Capacity (ATDECC_ACMP_MAX_INFLIGHT_COMMANDS, raise it from the build for more) */
+    size_t maxInflightPerEntity{ 2u };                    /** Limit for a single target entity */
+};
+
+/**
+ * @brief Controller side discovery of the connection state of the network.
+ * @details Issues one GET_RX_STATE_COMMAND per listener stream, and one GET_TX_STATE_COMMAND
+ *          per talker stream followed by one GET_TX_CONNECTION_COMMAND per connection index.
+ *          The number of commands inflight is bounded globally and per entity, the most
+ *          recently added entity is served first, and every response is fed to the
+ *          AcmpConnectionGraph.
+ */
+class AcmpSweepScheduler
+{
+public:
+    using Configuration = AcmpSweepConfiguration;
+
+    struct Metrics
+    {
+        AcmpClock::time_point sweepStart{};                 /** Start of the current (or last) sweep */
+        std::chrono::milliseconds lastSweepDuration{ 0 };   /** From the first command to the last response */
+        uint32_t commandsSent{ 0u };
+        uint32_t responsesReceived{ 0u };
+        uint32_t retries{ 0u };
+        uint32_t timeouts{ 0u };  /** Commands given up after the retry */
+        uint32_t errors{ 0u };    /** Responses with a status other than SUCCESS */
+    };
+
+    /** Called each time all the queued commands have been answered (or timed out) */
+    using SweepCompletedHandler = std::function<void(Metrics const& metrics)>;
+
+    AcmpSweepScheduler(UniqueIdentifier const controllerEntityID, AcmpConnectionGraph& graph, AcmpSendHandler sendHandler, Configuration const& configuration = Configuration{}) noexcept;
+
+    // Setters
+    void setSweepCompletedHandler(SweepCompletedHandler handler) noexcept;
+
+    /** Queues the sweep of an entity (usually on ENTITY_AVAILABLE). An entity added again is moved ahead of the others. */
+    void addEntity(UniqueIdentifier const entityID, uint16_t const talkerStreamSources, uint16_t const listenerStreamSinks, AcmpClock::time_point const now = AcmpClock::now());
+
+    /** Drops the queued commands of an entity (usually on ENTITY_DEPARTING) */
+    void removeEntity(UniqueIdentifier const entityID) noexcept;
+
+    /** Processes a received ACMPDU. Returns true if it was a response to one of our commands. */
+    bool handleAcmpdu(Acmpdu const& acmpdu, AcmpClock::time_point const now = AcmpClock::now());
+
+    /** Retries or gives up the timed out commands, to be called periodically */
+    void checkTimeouts(AcmpClock::time_point const now = AcmpClock::now());
+
+    // Getters
+    Metrics const& getMetrics() const noexcept;
+    bool isSweeping() const noexcept;
+    size_t getPendingCount() const noexcept;
+    size_t getInflightCount() const noexcept;
+
+private:
+    struct EntitySweep
+    {
+        UniqueIdentifier entityID{};
+        std::deque<Acmpdu> pending{};   /** Commands not sent yet */
+        size_t inflight{ 0u };
+    };
+
+    EntitySweep* findEntity(UniqueIdentifier const entityID) noexcept;
+    void enqueue(EntitySweep& entity, Acmpdu&& command, AcmpClock::time_point const now);
+    void schedule(AcmpClock::time_point const now);
+    void completeCommand(UniqueIdentifier const targetEntityID, AcmpClock::time_point const now);
+    void checkSweepCompleted(AcmpClock::time_point const now);
+
+    UniqueIdentifier _controllerEntityID{};
+    AcmpConnectionGraph& _graph;
+    AcmpSendHandler _sendHandler{};
+    Configuration _configuration{};
+    SweepCompletedHandler _sweepCompletedHandler{};
+    std::vector<EntitySweep> _entities{}; /** Least recently added first */
+    AcmpInflightCommands _inflight{};
+    size_t _pendingCount{ 0u };
+    bool _sweeping{ false };
+    Metrics _metrics{};
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_ACMPSWEEPSCHEDULER_HPP_ */
@@ -0,0 +1,77 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_AECPPAYLOADNEGOTIATOR_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_AECPPAYLOADNEGOTIATOR_HPP_
+
+#pragma once
+
+#include <cstdint>
+#include <unordered_map>
+#include "protocolAecpdu.hpp"
+#include "uniqueIdentifier.hpp"
+
+/**
+ * @brief Runtime selection of the big AECP payloads mode, per peer.
+ * @details IEEE 1722.1 limits an AECPDU to Aecpdu::MAXIMUM_LENGTH_1722_1 bytes, some
+ *          entities accept up to Aecpdu::MAXIMUM_LENGTH_BIG_PAYLOADS. There is no
+ *          capability bit for it, so the support of a peer is either set by the
+ *          application (eg. from its entity model) or learnt: a peer sending a big AECPDU
+ *          supports them, a peer never answering a big AECPDU does not. Unknown peers use
+ *          the defaults selected by ALLOW_SEND/RECV_BIG_AECP_PAYLOADS.
+ *          Buffers are always sized for big payloads, only the limit of each message
+ *          changes, so both modes can be used at the same time with different peers.
+ *          Received AECPDUs are checked by AaAddressSpace (commands) and by AaBulkTransfer
+ *          and AaPipelinedUploader (responses) once a negotiator is set on them.
+ */
+class AecpPayloadNegotiator
+{
+public:
+    enum class Support : uint8_t
+    {
+        Unknown = 0,     /** Default for the send direction is used */
+        Supported = 1,   /** Set by the application, or a big AECPDU was received */
+        Unsupported = 2, /** Set by the application, or a big AECPDU was never answered */
+    };
+
+    AecpPayloadNegotiator(bool const sendBigPayloads = Aecpdu::DEFAULT_SEND_BIG_PAYLOADS, bool const recvBigPayloads = Aecpdu::DEFAULT_RECV_BIG_PAYLOADS) noexcept;
+
+    // Setters
+    /** Default for peers with an unknown support */
+    void setSendBigPayloads(bool const sendBigPayloads) noexcept;
+    /** Whether big AECPDUs are accepted at all by this entity */
+    void setRecvBigPayloads(bool const recvBigPayloads) noexcept;
+    /** Support advertised by (or configured for) a peer */
+    void setPeerSupport(UniqueIdentifier const peerID, Support const support);
+
+    /** Forgets a peer (eg. on ADP ENTITY_DEPARTING or timeout) */
+    void removePeer(UniqueIdentifier const peerID);
+
+    /**
+     * @brief Checks a received AECPDU against the limit, and learns from it.
+     * @param[in] peerID Entity which sent the AECPDU (controller of a command, target of a response).
+     * @param[in] length Length of the AECPDU, from the AECP common header.
+     * @return False if the AECPDU has to be dropped.
+     */
+    bool onAecpduReceived(UniqueIdentifier const peerID, size_t const length);
+
+    /**
+     * @brief To be called when a command got no response after all its retries.
+     * @details If the command was bigger than the 1722.1 limit and the peer was not known to
+     *          support big payloads, the peer falls back to standard sized AECPDUs.
+     * @return True if the peer fell back, in which case the command can be retried smaller.
+     */
+    bool onCommandTimedOut(UniqueIdentifier const peerID, size_t const length);
+
+    // Getters
+    Support getPeerSupport(UniqueIdentifier const peerID) const noexcept;
+    /** Maximum AECPDU length to send to a peer */
+    size_t getMaximumSendLength(UniqueIdentifier const peerID) const noexcept;
+    /** Maximum AECPDU length accepted from a peer */
+    size_t getMaximumRecvLength() const noexcept;
+    size_t getPeerCount() const noexcept;
+
+private:
+    bool _sendBigPayloads{ false };
+    bool _recvBigPayloads{ false };
+    std::unordered_map<UniqueIdentifier, Support, UniqueIdentifier::hash> _peers{};
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_AECPPAYLOADNEGOTIATOR_HPP_ */
@@ -0,0 +1,71 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_AECPTARGETTIMING_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_AECPTARGETTIMING_HPP_
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+
+/** Bounds of AecpTargetTiming */
+struct AecpTimingConfiguration
+{
+    std::chrono::milliseconds initialTimeout{ 250 };    /** Until the first response, the 1722.1 command timeout */
+    std::chrono::milliseconds minTimeout{ 20 };
+    std::chrono::milliseconds maxTimeout{ 2000 };
+    uint32_t initialWindow{ 1u };
+    uint32_t maxWindow{ 4u };
+};
+
+/**
+ * @brief Adaptive command timeout and inflight window of one AECP target entity.
+ * @details The timeout follows the response times measured on the target (smoothed mean
+ *          plus four times the smoothed deviation, as TCP does), so fast entities have their
+ *          lost commands retried quickly while slow ones are not retried while still
+ *          processing. Response times of retried commands, or of commands answered
+ *          IN_PROGRESS first, are ambiguous and must not be sampled. Each timeout doubles the
+ *          timeout until the next sample.
+ *          The window grows by one command per window of responses and is halved on a timeout
+ *          (AIMD); an IN_PROGRESS response, showing the entity is busy, takes one command off.
+ *          Fixed point, no floating point on the ESP32 path.
+ */
+class AecpTargetTiming
+{
+public:
+    using Configuration = AecpTimingConfiguration;
+
+    explicit AecpTargetTiming(Configuration const& configuration = Configuration{}) noexcept;
+
+    /** A response to a command sent once, rtt after it was sent */
+    void onResponse(std::chrono::microseconds const rtt) noexcept;
+
+    /** A response with no usable response time (retried or IN_PROGRESS command): only grows the window */
+    void onSuccess() noexcept;
+
+    /** An IN_PROGRESS response */
+    void onInProgress() noexcept;
+
+    /** A command lost (no response before the timeout) */
+    void onTimeout() noexcept;
+
+    // Getters
+    std::chrono::milliseconds getTimeout() const noexcept;
+    /** Commands allowed inflight to the target */
+    uint32_t getWindow() const noexcept;
+    /** Zero until the first sample */
+    std::chrono::microseconds getSmoothedRtt() const noexcept;
+    std::chrono::microseconds getRttVariation() const noexcept;
+
+private:
+    static constexpr uint32_t WindowScale = 256u;   /** Fixed point of the window, for the additive increase */
+    static constexpr uint32_t MaxBackoff = 6u;
+
+    void grow() noexcept;
+
+    Configuration _configuration{};
+    int64_t _smoothedRtt{ 0 };      /** us, 0 until the first sample */
+    int64_t _rttVariation{ 0 };     /** us */
+    uint32_t _backoff{ 0u };        /** Timeouts since the last sample, doubling the timeout each */
+    uint32_t _window{ 0u };         /** Commands * WindowScale */
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_AECPTARGETTIMING_HPP_ */
@@ -0,0 +1,95 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_AEMAUDIOMAPENGINE_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_AEMAUDIOMAPENGINE_HPP_
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "entityModelTypes.hpp"
+#include "protocolAemAecpdu.hpp"
+#include "protocolDefines.hpp"
+
+/**
+ * @brief Entity side dynamic audio map of one STREAM_PORT_INPUT or STREAM_PORT_OUTPUT.
+ * @details Each destination channel has at most one mapping: the cluster channel on an
+ *          input port (stream -> cluster), the stream channel on an output port
+ *          (cluster -> stream). A table indexed by destination channel gives the mapping of
+ *          a channel, so ADD/REMOVE_AUDIO_MAPPINGS are applied incrementally and conflicts
+ *          are found in O(1) per mapping. Mappings are kept packed, GET_AUDIO_MAP pages are
+ *          encoded straight from them.
+ *          Commands are applied as a whole or not at all, and the changed handler gets only
+ *          the mappings that really changed (the delta), to be sent unsolicited as is: deltas
+ *          must not be coalesced like state notifications.
+ */
+class AemAudioMapEngine
+{
+public:
+    static constexpr size_t MappingsPayloadHeaderLength = 8;   /* ADD/REMOVE: descriptor_type + descriptor_index + number_of_mappings + reserved */
+    static constexpr size_t AudioMapPayloadHeaderLength = 12;  /* GET_AUDIO_MAP: + map_index + number_of_maps */
+    static constexpr uint16_t NoMapping = 0xffff;
+
+    /** Called after a successful ADD/REMOVE_AUDIO_MAPPINGS that changed the map, with the payload of the changes */
+    using MappingsChangedHandler = std::function<void(AemCommandType const commandType, AemAecpdu::Payload const& delta)>;
+
+    /**
+     * @param[in] portType DescriptorType::StreamPortInput or DescriptorType::StreamPortOutput.
+     * @param[in] portIndex Index of the stream port descriptor.
+     * @param[in] streamCount Number of streams the port can map (valid stream_index are below).
+     * @param[in] streamChannels Maximum number of channels of a stream.
+     * @param[in] clusterCount number_of_clusters of the port (valid cluster_offset are below).
+     * @param[in] clusterChannels Maximum number of channels of a cluster.
+     * @param[in] maxMappings Maximum number of mappings of the port.
+     */
+    AemAudioMapEngine(DescriptorType const portType, DescriptorIndex const portIndex, uint16_t const streamCount, uint16_t const streamChannels, uint16_t const clusterCount, uint16_t const clusterChannels, uint16_t const maxMappings);
+
+    // Setters
+    void setMappingsChangedHandler(MappingsChangedHandler handler) noexcept;
+
+    /** Handles ADD_AUDIO_MAPPINGS, the response is the reflected command */
+    AemCommandStatus handleAddAudioMappings(AemAecpdu::Payload const& command);
+
+    /** Handles REMOVE_AUDIO_MAPPINGS, the response is the reflected command. Absent mappings are ignored. */
+    AemCommandStatus handleRemoveAudioMappings(AemAecpdu::Payload const& command);
+
+    /**
+     * @brief Handles GET_AUDIO_MAP.
+     * @param[in] maximumPayloadLength Maximum AEM payload for the controller, which gives the size of a map (at least one mapping).
+     */
+    AemCommandStatus handleGetAudioMap(AemAecpdu::Payload const& command, uint8_t* response, size_t const responseCapacity, size_t& responseLength, size_t const maximumPayloadLength = AemAecpdu::MAXIMUM_SEND_PAYLOAD_BUFFER_LENGTH) const noexcept;
+
+    /** Removes all the mappings, without notification */
+    void clear() noexcept;
+
+    // Getters
+    /** Mapping of a destination channel (cluster on an input port, stream on an output port), nullptr if not mapped */
+    AudioMapping const* getMapping(uint16_t const destinationIndex, uint16_t const destinationChannel) const noexcept;
+    AudioMapping const* getMappings() const noexcept;
+    size_t getMappingCount() const noexcept;
+    MapIndex getNumberOfMaps(size_t const maximumPayloadLength = AemAecpdu::MAXIMUM_SEND_PAYLOAD_BUFFER_LENGTH) const noexcept;
+
+private:
+    bool isValid(AudioMapping const& mapping) const noexcept;
+    size_t getDestination(AudioMapping const& mapping) const noexcept;
+    AemCommandStatus checkCommand(AemAecpdu::Payload const& command, uint16_t& count) const noexcept;
+    uint16_t nextCommandStamp() noexcept;
+    void notify(AemCommandType const commandType, size_t const deltaCount);
+
+    DescriptorType _portType{ DescriptorType::Invalid };
+    DescriptorIndex _portIndex{ 0u };
+    uint16_t _streamCount{ 0u };
+    uint16_t _streamChannels{ 0u };
+    uint16_t _clusterCount{ 0u };
+    uint16_t _clusterChannels{ 0u };
+    uint16_t _maxMappings{ 0u };
+    MappingsChangedHandler _mappingsChangedHandler{};
+
+    std::vector<AudioMapping> _mappings{};       /** Packed, capacity reserved once */
+    std::vector<uint16_t> _destinationSlots{};   /** Destination channel -> index in _mappings, or NoMapping */
+    std::vector<uint16_t> _commandStamps{};      /** Destination channel -> last command using it, to find conflicts within a command */
+    uint16_t _commandStamp{ 0u };
+    std::array<uint8_t, AemAecpdu::MAXIMUM_PAYLOAD_BUFFER_LENGTH> _delta{};
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_AEMAUDIOMAPENGINE_HPP_ */
@@ -0,0 +1,164 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_AEMCONTROLENGINE_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_AEMCONTROLENGINE_HPP_
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <initializer_list>
+#include <type_traits>
+#include "entityModelTypes.hpp"
+#include "protocolAemAecpdu.hpp"
+#include "protocolDefines.hpp"
+
+// Sizing of the control value storage (can be overridden from the build)
+#ifndef ATDECC_AEM_MAX_CONTROLS
+#define ATDECC_AEM_MAX_CONTROLS 64
+#endif
+#ifndef ATDECC_AEM_CONTROL_STORAGE_SIZE
+#define ATDECC_AEM_CONTROL_STORAGE_SIZE 4096
+#endif
+
+/**
+ * @brief Entity side storage of the CONTROL descriptor values, with SET/GET_CONTROL handling.
+ * @details Each control keeps its limits and current values in host order, in a contiguous
+ *          preallocated storage indexed by descriptor index. SET_CONTROL values are checked
+ *          (minimum, maximum, step, selector options) and decoded straight from the command
+ *          payload into the storage, GET_CONTROL responses are encoded straight from it.
+ *          LINEAR, SELECTOR and ARRAY controls of the numeric types are supported.
+ */
+class AemControlEngine
+{
+public:
+    static constexpr size_t MaxControls = ATDECC_AEM_MAX_CONTROLS;
+    static constexpr size_t StorageSize = ATDECC_AEM_CONTROL_STORAGE_SIZE;
+    static constexpr size_t PayloadHeaderLength = 4; /* descriptor_type + descriptor_index */
+
+    /** Called when a controller changed the values of a control */
+    using ValuesChangedHandler = std::function<void(DescriptorIndex const descriptorIndex)>;
+
+    // Setters
+    void setValuesChangedHandler(ValuesChangedHandler handler) noexcept;
+
+    /** Adds a LINEAR control of valueCount values sharing the same limits */
+    template<typename T>
+    bool addLinearControl(DescriptorIndex const descriptorIndex, uint16_t const valueCount, T const minimum, T const maximum, T const step, T const defaultValue, bool const readOnly = false)
+    {
+        T const limits[] = { minimum, maximum, step };
+        return addControl(getControlType<T>(ControlValueType::Type::ControlLinearInt8), descriptorIndex, readOnly, limits, 3u, &defaultValue, valueCount);
+    }
+
+    /** Adds an ARRAY control of valueCount values */
+    template<typename T>
+    bool addArrayControl(DescriptorIndex const descriptorIndex, uint16_t const valueCount, T const minimum, T const maximum, T const step, T const defaultValue, bool const readOnly = false)
+    {
+        T const limits[] = { minimum, maximum, step };
+        return addControl(getControlType<T>(ControlValueType::Type::ControlArrayInt8), descriptorIndex, readOnly, limits, 3u, &defaultValue, valueCount);
+    }
+
+    /** Adds a SELECTOR control, its value is one of options */
+    template<typename T>
+    bool addSelectorControl(DescriptorIndex const descriptorIndex, std::initializer_list<T> const options, T const defaultValue, bool const readOnly = false)
+    {
+        return addControl(getControlType<T>(ControlValueType::Type::ControlSelectorInt8), descriptorIndex, readOnly, options.begin(), static_cast<uint16_t>(options.size()), &defaultValue, 1u);
+    }
+
+    /** Removes all the controls */
+    void clear() noexcept;
+
+    /** Changes a value locally (eg. from the front panel), without checking the limits */
+    template<typename T>
+    bool setValue(DescriptorIndex const descriptorIndex, uint16_t const valueIndex, T const value) noexcept
+    {
+        auto* const ptr = const_cast<uint8_t*>(getValuePointer(descriptorIndex, valueIndex, getControlType<T>(ControlValueType::Type::ControlLinearInt8)));
+        if (ptr == nullptr)
+        {
+            return false;
+        }
+        std::memcpy(ptr, &value, sizeof(T));
+        return true;
+    }
+
+    /** Replaces all the values of a control (host order, length must match), without checking the limits */
+    bool setValues(DescriptorIndex const descriptorIndex, const void* values, size_t const length) noexcept;
+
+    /**
+     * @brief Handles a SET_CONTROL command.
+     * @details The values are only stored if all of them are valid. Unless responseLength is
+     *          0 (NoSuchDescriptor or malformed command, the command payload is to be
+     *          reflected), the response payload holds the current values whatever the status.
+     */
+    AemCommandStatus handleSetControl(AemAecpdu::Payload const& command, uint8_t* response, size_t const responseCapacity, size_t& responseLength);
+
+    /** Handles a GET_CONTROL command, same response rules as handleSetControl */
+    AemCommandStatus handleGetControl(AemAecpdu::Payload const& command, uint8_t* response, size_t const responseCapacity, size_t& responseLength) const noexcept;
+
+    /** Encodes the SET/GET_CONTROL response payload of a control (eg. for AemUnsolicitedNotifier). Returns 0 on error. */
+    size_t encodeValues(DescriptorIndex const descriptorIndex, uint8_t* buffer, size_t const capacity) const noexcept;
+
+    // Getters
+    template<typename T>
+    bool getValue(DescriptorIndex const descriptorIndex, uint16_t const valueIndex, T& value) const noexcept
+    {
+        auto const* const ptr = getValuePointer(descriptorIndex, valueIndex, getControlType<T>(ControlValueType::Type::ControlLinearInt8));
+        if (ptr == nullptr)
+        {
+            return false;
+        }
+        std::memcpy(&value, ptr, sizeof(T));
+        return true;
+    }
+    bool hasControl(DescriptorIndex const descriptorIndex) const noexcept;
+    ControlValueType getControlValueType(DescriptorIndex const descriptorIndex) const noexcept;
+    uint16_t getValueCount(DescriptorIndex const descriptorIndex) const noexcept;
+    size_t getControlCount() const noexcept;
+    size_t getUsedStorage() const noexcept;
+
+private:
+    struct Control
+    {
+        ControlValueType::Type type{ ControlValueType::Type::Expansion };
+        uint32_t offset{ 0u };      /** Of the limits in _storage, values follow */
+        uint16_t limitCount{ 0u };  /** minimum/maximum/step, or selector options */
+        uint16_t valueCount{ 0u };
+        uint8_t valueSize{ 0u };
+        bool readOnly{ false };
+        bool inUse{ false };
+    };
+
+    /** Maps T to the control type of a family (given by its Int8 type) */
+    template<typename T>
+    static constexpr ControlValueType::Type getControlType(ControlValueType::Type const family) noexcept
+    {
+        static_assert(std::is_arithmetic<T>::value && !std::is_same<T, bool>::value, "Control values are numbers");
+        using U = std::remove_cv_t<T>;
+        auto index = uint16_t{ 0u };
+        if constexpr (std::is_same<U, float>::value)
+        {
+            index = 8u;
+        }
+        else if constexpr (std::is_same<U, double>::value)
+        {
+            index = 9u;
+        }
+        else
+        {
+            index = static_cast<uint16_t>((sizeof(U) == 1 ? 0u : sizeof(U) == 2 ? 2u : sizeof(U) == 4 ? 4u : 6u) + (std::is_unsigned<U>::value ? 1u : 0u));
+        }
+        return static_cast<ControlValueType::Type>(static_cast<uint16_t>(family) + index);
+    }
+
+    bool addControl(ControlValueType::Type const type, DescriptorIndex const descriptorIndex, bool const readOnly, const void* limits, uint16_t const limitCount, const void* defaultValue, uint16_t const valueCount);
+    Control const* findControl(DescriptorIndex const descriptorIndex) const noexcept;
+    const uint8_t* getValuePointer(DescriptorIndex const descriptorIndex, uint16_t const valueIndex, ControlValueType::Type const linearType) const noexcept;
+
+    ValuesChangedHandler _valuesChangedHandler{};
+    std::array<Control, MaxControls> _controls{};
+    alignas(8) std::array<uint8_t, StorageSize> _storage{};
+    size_t _usedStorage{ 0u };
+    size_t _controlCount{ 0u };
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_AEMCONTROLENGINE_HPP_ */
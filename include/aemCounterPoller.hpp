@@ -0,0 +1,132 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_AEMCOUNTERPOLLER_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_AEMCOUNTERPOLLER_HPP_
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "aemPollingCommands.hpp"
+#include "entityModelTypes.hpp"
+#include "protocolAecpdu.hpp"
+#include "protocolDefines.hpp"
+#include "uniqueIdentifier.hpp"
+
+// Sizing of the counter poller (can be overridden from the build)
+#ifndef ATDECC_AEM_COUNTER_POLL_MAX_INFLIGHT
+#define ATDECC_AEM_COUNTER_POLL_MAX_INFLIGHT 8
+#endif
+#ifndef ATDECC_AEM_COUNTER_HISTORY_DEPTH
+#define ATDECC_AEM_COUNTER_HISTORY_DEPTH 8
+#endif
+
+/**
+ * @brief Controller side GET_COUNTERS poller, for monitoring many entities.
+ * @details Descriptors (AVB_INTERFACE, CLOCK_DOMAIN, STREAM_INPUT...) are polled round-robin,
+ *          each one at most once per interval, and all of them together within a global budget
+ *          of commands per second: adding entities makes each one polled less often instead of
+ *          sending more. The last samples of each descriptor are kept in a ring, giving the
+ *          counter rates, and only the counters that changed are reported.
+ *          See ControllerCommandScheduler to send through it.
+ */
+class AemCounterPoller
+{
+public:
+    static constexpr size_t MaxInflight = ATDECC_AEM_COUNTER_POLL_MAX_INFLIGHT;
+    static constexpr size_t HistoryDepth = ATDECC_AEM_COUNTER_HISTORY_DEPTH;
+    static constexpr size_t CounterCount = std::tuple_size<DescriptorCounters>::value;
+
+    using CounterRates = std::array<float, CounterCount>;
+
+    struct Metrics
+    {
+        uint32_t commands{ 0u };
+        uint32_t responses{ 0u };
+        uint32_t changes{ 0u };   /** Responses with at least one counter changed */
+        uint32_t errors{ 0u };    /** Responses with an error status or malformed */
+        uint32_t timeouts{ 0u };
+        uint32_t throttled{ 0u }; /** Polls delayed by the global budget */
+    };
+
+    struct Sample
+    {
+        AecpClock::time_point time{};
+        DescriptorCounters counters{};
+    };
+
+    /**
+     * @brief Called when counters of a descriptor changed.
+     * @param[in] changedCounters Valid flags of the counters that changed (all the valid ones on the first sample).
+     * @param[in] counters Counters of the new sample.
+     * @param[in] rates Per second rate of each counter since the previous sample, 0 on the first sample.
+     */
+    using CountersChangedHandler = std::function<void(UniqueIdentifier const entityID, DescriptorType const descriptorType, DescriptorIndex const descriptorIndex, DescriptorCounterValidFlag const changedCounters, DescriptorCounters const& counters, CounterRates const& rates)>;
+
+    /**
+     * @param[in] controllerID Controller sending the commands.
+     * @param[in] sendHandler Handler used to send the commands.
+     * @param[in] commandsPerSecond Global budget of GET_COUNTERS commands.
+     * @param[in] interval Minimum time between two polls of the same descriptor.
+     * @param[in] window Maximum number of commands inflight.
+     * @param[in] timeout Time after which a command is considered lost (not retried, the next poll refreshes it).
+     */
+    AemCounterPoller(UniqueIdentifier const controllerID, AecpSendHandler sendHandler, uint32_t const commandsPerSecond = 50u, std::chrono::milliseconds const interval = std::chrono::seconds{ 1 }, size_t const window = MaxInflight, std::chrono::milliseconds const timeout = std::chrono::milliseconds{ 250 }) noexcept;
+
+    // Setters
+    void setCountersChangedHandler(CountersChangedHandler handler) noexcept;
+    /** See AecpTimeoutHandler */
+    void setTimeoutHandler(AecpTimeoutHandler handler) noexcept;
+
+    /** Adds a descriptor to poll. Returns false if it is already polled. */
+    bool addTarget(UniqueIdentifier const entityID, MacAddress const& macAddress, DescriptorType const descriptorType, DescriptorIndex const descriptorIndex);
+
+    /** Stops polling all the descriptors of an entity, and forgets their history */
+    void removeEntity(UniqueIdentifier const entityID) noexcept;
+
+    /** Processes a received AECPDU. Returns true if it was a response to one of our commands. */
+    bool handleAecpdu(Aecpdu const& aecpdu, AecpClock::time_point const now = AecpClock::now());
+
+    /** Sends the polls that are due within the budget, to be called periodically */
+    void poll(AecpClock::time_point const now = AecpClock::now());
+
+    // Getters
+    /** Per second rate of a counter over the whole history of a descriptor, 0 if unknown */
+    float getRate(UniqueIdentifier const entityID, DescriptorType const descriptorType, DescriptorIndex const descriptorIndex, size_t const counterSlot) const noexcept;
+    /** Samples of a descriptor, oldest first. Returns the number of samples copied. */
+    size_t getHistory(UniqueIdentifier const entityID, DescriptorType const descriptorType, DescriptorIndex const descriptorIndex, Sample* samples, size_t const maxSamples) const noexcept;
+    Metrics const& getMetrics() const noexcept;
+    size_t getTargetCount() const noexcept;
+    size_t getInflightCount() const noexcept;
+
+private:
+    struct Target
+    {
+        UniqueIdentifier entityID{};
+        MacAddress macAddress{};
+        DescriptorType descriptorType{ DescriptorType::Invalid };
+        DescriptorIndex descriptorIndex{ 0u };
+        AecpClock::time_point lastPoll{};
+        std::array<Sample, HistoryDepth> history{};
+        uint8_t historyHead{ 0u };  /** Next sample to write */
+        uint8_t historyCount{ 0u };
+        bool inflight{ false };
+    };
+
+    Target const* findTarget(UniqueIdentifier const entityID, DescriptorType const descriptorType, DescriptorIndex const descriptorIndex) const noexcept;
+    bool send(size_t const targetIndex, AecpClock::time_point const now);
+    void addSample(Target& target, DescriptorCounterValidFlag const validCounters, DescriptorCounters const& counters, AecpClock::time_point const now);
+
+    AemPollingCommands<MaxInflight> _commands;  /** Context is the target index */
+    uint32_t _commandsPerSecond{ 0u };
+    std::chrono::milliseconds _interval{};
+    CountersChangedHandler _countersChangedHandler{};
+    std::vector<Target> _targets{};
+    size_t _nextTarget{ 0u };    /** Round-robin cursor */
+    float _budget{ 0.f };        /** Commands that can be sent now, refilled at commandsPerSecond */
+    AecpClock::time_point _lastRefill{};
+    Metrics _metrics{};
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_AEMCOUNTERPOLLER_HPP_ */
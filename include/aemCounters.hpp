@@ -0,0 +1,140 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_AEMCOUNTERS_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_AEMCOUNTERS_HPP_
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <type_traits>
+#include "aemUnsolicitedNotifier.hpp"
+#include "entityEnums.hpp"
+#include "entityModelTypes.hpp"
+#include "protocolAecpdu.hpp"
+#include "protocolAemAecpdu.hpp"
+#include "protocolDefines.hpp"
+
+// Sizing of the counter tables (can be overridden from the build)
+#ifndef ATDECC_AEM_MAX_COUNTER_BLOCKS
+#define ATDECC_AEM_MAX_COUNTER_BLOCKS 16
+#endif
+
+/**
+ * @brief Counters of one descriptor (ENTITY, AVB_INTERFACE, CLOCK_DOMAIN, STREAM_INPUT or STREAM_OUTPUT).
+ * @details One slot per bit of the counters_valid field, as in DescriptorCounters: the counter of
+ *          flag (1u << n) is slot n. Counters can be incremented from any task at packet rate,
+ *          it is a single relaxed atomic add, no lock and no lookup.
+ */
+class AemCounterBlock
+{
+public:
+    static constexpr size_t CounterCount = std::tuple_size<DescriptorCounters>::value;
+
+    /** Increments the counter of a flag (eg. AvbInterfaceCounterValidFlag::FramesRx). Any task, wait-free. */
+    template<typename FlagType>
+    void increment(FlagType const flag, DescriptorCounter const count = 1u) noexcept
+    {
+        static_assert(std::is_enum<FlagType>::value, "Counters are identified by their valid flag");
+        incrementSlot(getSlot(static_cast<DescriptorCounterValidFlag>(flag)), count);
+    }
+
+    /** Sets the value of the counter of a flag (eg. an entity specific counter mirroring another one) */
+    template<typename FlagType>
+    void set(FlagType const flag, DescriptorCounter const value) noexcept
+    {
+        static_assert(std::is_enum<FlagType>::value, "Counters are identified by their valid flag");
+        setSlot(getSlot(static_cast<DescriptorCounterValidFlag>(flag)), value);
+    }
+
+    void incrementSlot(size_t const slot, DescriptorCounter const count = 1u) noexcept;
+    void setSlot(size_t const slot, DescriptorCounter const value) noexcept;
+
+    /**
+     * @brief Copies all the counters.
+     * @details Each counter is always exact. The copy as a whole is only a state the counters had
+     *          together if it was read twice without any change (see the return value).
+     * @return True if the copy is consistent, false if the counters kept changing during all the
+     *         attempts (the copy then holds the last value read for each counter).
+     */
+    bool snapshot(DescriptorCounters& counters) const noexcept;
+
+    // Getters
+    DescriptorType getDescriptorType() const noexcept;
+    DescriptorIndex getDescriptorIndex() const noexcept;
+    DescriptorCounterValidFlag getValidCounters() const noexcept;
+
+    /** Slot of the counter of a valid flag (index of its bit) */
+    static constexpr size_t getSlot(DescriptorCounterValidFlag const flag) noexcept
+    {
+        auto slot = size_t{ 0u };
+        while (slot < CounterCount && (flag & (DescriptorCounterValidFlag{ 1u } << slot)) == 0u)
+        {
+            ++slot;
+        }
+        return slot;
+    }
+
+private:
+    friend class AemCounterBank;
+
+    std::array<std::atomic<DescriptorCounter>, CounterCount> _counters{};
+    DescriptorType _descriptorType{ DescriptorType::Invalid };
+    DescriptorIndex _descriptorIndex{ 0u };
+    DescriptorCounterValidFlag _validCounters{ 0u };
+};
+
+/**
+ * @brief Entity side counter blocks and GET_COUNTERS.
+ * @details Blocks are added once at startup, the network and audio tasks then keep a pointer to
+ *          their block and increment it directly. GET_COUNTERS responses and the optional
+ *          periodic unsolicited GET_COUNTERS notifications are built from snapshots of the
+ *          blocks, so the hot path never waits on the AECP task. A GET_COUNTERS response is
+ *          always sent, even from a snapshot that was not consistent (each counter is still
+ *          exact); a notification waits for the next period instead.
+ */
+class AemCounterBank
+{
+public:
+    static constexpr size_t MaxBlocks = ATDECC_AEM_MAX_COUNTER_BLOCKS;
+
+    /** Adds the counters of a descriptor. Returns the existing block if already added, nullptr if the table is full. */
+    AemCounterBlock* addBlock(DescriptorType const descriptorType, DescriptorIndex const descriptorIndex, DescriptorCounterValidFlag const validCounters) noexcept;
+
+    /** Adds the counters of a descriptor, from a typed set of valid flags (eg. StreamInputCounterValidFlags) */
+    template<typename FlagType>
+    AemCounterBlock* addBlock(DescriptorType const descriptorType, DescriptorIndex const descriptorIndex, EnumBitfield<FlagType> const validCounters) noexcept
+    {
+        return addBlock(descriptorType, descriptorIndex, static_cast<DescriptorCounterValidFlag>(validCounters.getValue()));
+    }
+
+    /**
+     * @brief Sends unsolicited GET_COUNTERS for the blocks that changed, at most once per period.
+     * @param[in] notifier Notifier of the registered controllers, nullptr to disable the notifications.
+     * @param[in] period Period of the notifications (Milan: at most once per second).
+     */
+    void setUnsolicitedNotifier(AemUnsolicitedNotifier* notifier, std::chrono::milliseconds const period = std::chrono::seconds{ 1 }) noexcept;
+
+    /** Handles GET_COUNTERS */
+    AemCommandStatus handleGetCounters(AemAecpdu::Payload const& command, uint8_t* response, size_t const responseCapacity, size_t& responseLength) const noexcept;
+
+    /** Sends the periodic unsolicited notifications that are due, to be called from the AECP task */
+    void checkNotifications(AecpClock::time_point const now = AecpClock::now());
+
+    // Getters
+    AemCounterBlock* findBlock(DescriptorType const descriptorType, DescriptorIndex const descriptorIndex) noexcept;
+    AemCounterBlock const* findBlock(DescriptorType const descriptorType, DescriptorIndex const descriptorIndex) const noexcept;
+    size_t getBlockCount() const noexcept;
+
+private:
+    size_t encodeResponse(AemCounterBlock const& block, DescriptorCounters const& counters, uint8_t* buffer, size_t const capacity) const noexcept;
+
+    std::array<AemCounterBlock, MaxBlocks> _blocks{};
+    std::array<DescriptorCounters, MaxBlocks> _notifiedCounters{}; /** Counters in the last notification of each block */
+    size_t _blockCount{ 0u };
+    AemUnsolicitedNotifier* _notifier{ nullptr };
+    std::chrono::milliseconds _notificationPeriod{ std::chrono::seconds{ 1 } };
+    AecpClock::time_point _nextNotification{};
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_AEMCOUNTERS_HPP_ */
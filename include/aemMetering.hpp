@@ -0,0 +1,174 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_AEMMETERING_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_AEMMETERING_HPP_
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include "aemControlEngine.hpp"
+#include "aemPollingCommands.hpp"
+#include "entityModelTypes.hpp"
+#include "protocolAecpdu.hpp"
+#include "protocolDefines.hpp"
+#include "uniqueIdentifier.hpp"
+
+// Sizing of the metering tables (can be overridden from the build)
+#ifndef ATDECC_AEM_MAX_METERS
+#define ATDECC_AEM_MAX_METERS 16
+#endif
+#ifndef ATDECC_AEM_MAX_METER_VALUES
+#define ATDECC_AEM_MAX_METER_VALUES 256
+#endif
+#ifndef ATDECC_AEM_METER_POLL_MAX_TARGETS
+#define ATDECC_AEM_METER_POLL_MAX_TARGETS 64
+#endif
+#ifndef ATDECC_AEM_METER_POLL_MAX_INFLIGHT
+#define ATDECC_AEM_METER_POLL_MAX_INFLIGHT 16
+#endif
+
+/**
+ * @brief Entity side metering controls, fed from the audio path.
+ * @details A meter is a read-only LINEAR control of AemControlEngine. The audio path
+ *          publishes its levels without locking (one writer per meter), and the AECP task
+ *          copies the last complete set of levels into the control engine with refresh()
+ *          before answering GET_CONTROL. A meter of several channels gives a controller all
+ *          of them with a single GET_CONTROL.
+ */
+class AemMeterBank
+{
+public:
+    using MeterHandle = uint16_t;
+    static constexpr MeterHandle InvalidMeter = 0xffff;
+    static constexpr size_t MaxMeters = ATDECC_AEM_MAX_METERS;
+    static constexpr size_t MaxMeterValues = ATDECC_AEM_MAX_METER_VALUES;
+
+    explicit AemMeterBank(AemControlEngine& engine) noexcept;
+
+    /** Adds a meter of valueCount channels, also added to the control engine. Returns InvalidMeter on error. */
+    template<typename T>
+    MeterHandle addMeter(DescriptorIndex const descriptorIndex, uint16_t const valueCount, T const minimum, T const maximum)
+    {
+        static_assert(sizeof(T) <= sizeof(uint32_t), "Meter values are at most 32 bits");
+        if (_meterCount >= MaxMeters || _valueCount + valueCount > MaxMeterValues || descriptorIndex >= AemControlEngine::MaxControls)
+        {
+            return InvalidMeter;
+        }
+        if (!_engine.addLinearControl<T>(descriptorIndex, valueCount, minimum, maximum, T{ 0 }, minimum, true))
+        {
+            return InvalidMeter;
+        }
+        return registerMeter(descriptorIndex, valueCount, sizeof(T));
+    }
+
+    /** Publishes the current levels of a meter (all its channels). Audio path, wait-free. */
+    template<typename T>
+    void publish(MeterHandle const meter, const T* values) noexcept
+    {
+        static_assert(sizeof(T) <= sizeof(uint32_t), "Meter values are at most 32 bits");
+        publishValues(meter, values, sizeof(T));
+    }
+
+    /** Copies the last published levels of a meter into the control engine. Returns false if it is not a meter. */
+    bool refresh(DescriptorIndex const descriptorIndex) noexcept;
+
+    /** Copies the last published levels of all the meters into the control engine */
+    void refreshAll() noexcept;
+
+    // Getters
+    bool isMeter(DescriptorIndex const descriptorIndex) const noexcept;
+    size_t getMeterCount() const noexcept;
+
+private:
+    struct Meter
+    {
+        std::atomic<uint32_t> sequence{ 0u }; /** Odd while the audio path writes */
+        DescriptorIndex descriptorIndex{ 0u };
+        uint16_t offset{ 0u };                /** Of the first channel in _values */
+        uint16_t valueCount{ 0u };
+        uint8_t valueSize{ 0u };
+    };
+
+    MeterHandle registerMeter(DescriptorIndex const descriptorIndex, uint16_t const valueCount, uint8_t const valueSize) noexcept;
+    void publishValues(MeterHandle const meter, const void* values, size_t const valueSize) noexcept;
+    bool refreshMeter(Meter const& meter) noexcept;
+
+    AemControlEngine& _engine;
+    std::array<Meter, MaxMeters> _meters{};
+    std::array<std::atomic<uint32_t>, MaxMeterValues> _values{}; /** One word per channel, whatever the value size */
+    std::array<MeterHandle, AemControlEngine::MaxControls> _meterByControl{};
+    size_t _meterCount{ 0u };
+    size_t _valueCount{ 0u };
+};
+
+/**
+ * @brief Controller side metering poller.
+ * @details Polls a list of (entity, CONTROL) meters once per period with GET_CONTROL,
+ *          keeping up to window commands inflight across all the entities instead of waiting
+ *          for each response. Lost commands are not retried, the next period refreshes them.
+ *          See ControllerCommandScheduler to send through it.
+ */
+class AemMeterPoller
+{
+public:
+    static constexpr size_t MaxTargets = ATDECC_AEM_METER_POLL_MAX_TARGETS;
+    static constexpr size_t MaxInflight = ATDECC_AEM_METER_POLL_MAX_INFLIGHT;
+
+    struct Metrics
+    {
+        uint32_t cycles{ 0u };    /** Periods started */
+        uint32_t overruns{ 0u };  /** Periods started before the previous one was fully sent */
+        uint32_t responses{ 0u };
+        uint32_t errors{ 0u };    /** Responses with an error status */
+        uint32_t timeouts{ 0u };
+    };
+
+    /** Called for each GET_CONTROL response, values are in network order as in the payload */
+    using ValuesHandler = std::function<void(UniqueIdentifier const entityID, DescriptorIndex const descriptorIndex, const uint8_t* values, size_t const length)>;
+
+    AemMeterPoller(UniqueIdentifier const controllerID, AecpSendHandler sendHandler, std::chrono::milliseconds const period = std::chrono::milliseconds{ 100 }, size_t const window = MaxInflight, std::chrono::milliseconds const timeout = std::chrono::milliseconds{ 250 }) noexcept;
+
+    // Setters
+    void setValuesHandler(ValuesHandler handler) noexcept;
+    /** See AecpTimeoutHandler */
+    void setTimeoutHandler(AecpTimeoutHandler handler) noexcept;
+
+    /** Adds a meter to poll. Returns false if the table is full or the meter already polled. */
+    bool addTarget(UniqueIdentifier const entityID, MacAddress const& macAddress, DescriptorIndex const descriptorIndex) noexcept;
+
+    /** Stops polling all the meters of an entity */
+    void removeEntity(UniqueIdentifier const entityID) noexcept;
+
+    /** Processes a received AECPDU. Returns true if it was a response to one of our commands. */
+    bool handleAecpdu(Aecpdu const& aecpdu, AecpClock::time_point const now = AecpClock::now());
+
+    /** Starts the periods and sends the commands, to be called more often than the period */
+    void poll(AecpClock::time_point const now = AecpClock::now());
+
+    // Getters
+    Metrics const& getMetrics() const noexcept;
+    size_t getTargetCount() const noexcept;
+    size_t getInflightCount() const noexcept;
+
+private:
+    struct Target
+    {
+        UniqueIdentifier entityID{};
+        MacAddress macAddress{};
+        DescriptorIndex descriptorIndex{ 0u };
+    };
+
+    AemPollingCommands<MaxInflight> _commands;  /** Context is the CONTROL descriptor index */
+    std::chrono::milliseconds _period{};
+    ValuesHandler _valuesHandler{};
+    std::array<Target, MaxTargets> _targets{};
+    size_t _targetCount{ 0u };
+    size_t _nextTarget{ 0u };       /** Next target to poll in the current period */
+    AecpClock::time_point _nextCycle{};
+    bool _overrun{ false };
+    Metrics _metrics{};
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_AEMMETERING_HPP_ */
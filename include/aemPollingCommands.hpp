@@ -0,0 +1,173 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_AEMPOLLINGCOMMANDS_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_AEMPOLLINGCOMMANDS_HPP_
+
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include "protocolAemAecpdu.hpp"
+#include "protocolDefines.hpp"
+#include "uniqueIdentifier.hpp"
+
+/**
+ * @brief Commands of a controller side AEM poller waiting for their response.
+ * @details Up to window commands are kept inflight, across all the polled entities. Lost commands
+ *          are only released, not retried (the next poll refreshes what they asked for).
+ *          Used by AemCounterPoller and AemMeterPoller.
+ */
+template<size_t Capacity>
+class AemPollingCommands
+{
+public:
+    struct Command
+    {
+        UniqueIdentifier entityID{};
+        size_t context{ 0u };                /** Set by the poller, eg. the index of the polled target */
+        AecpSequenceID sequenceID{ 0u };
+        AecpClock::time_point timeout{};     /** When the response is considered lost */
+        bool inUse{ false };
+    };
+
+    AemPollingCommands(UniqueIdentifier const controllerID, AecpSendHandler sendHandler, size_t const window, std::chrono::milliseconds const timeout) noexcept
+        : _controllerID(controllerID), _sendHandler(std::move(sendHandler)), _window(std::clamp<size_t>(window, 1u, Capacity)), _timeout(timeout)
+    {
+    }
+
+    // Setters
+    /** See AecpTimeoutHandler */
+    void setTimeoutHandler(AecpTimeoutHandler handler) noexcept
+    {
+        _timeoutHandler = std::move(handler);
+    }
+
+    /** Sends an AEM command to an entity. Returns false if window commands are already inflight. */
+    bool send(UniqueIdentifier const entityID, MacAddress const& macAddress, AemCommandType const commandType, const void* payload, size_t const payloadLength, size_t const context, AecpClock::time_point const now)
+    {
+        auto const it = std::find_if(_commands.begin(), _commands.end(), [](Command const& command)
+        {
+            return !command.inUse;
+        });
+        if (isFull() || it == _commands.end())
+        {
+            return false;
+        }
+
+        AemAecpdu message{ false };
+        message.setTargetEntityID(entityID);
+        message.setControllerEntityID(_controllerID);
+        message.setSequenceID(_sequenceID);
+        message.setStatus(AecpStatus::SUCCESS);
+        message.setCommandType(commandType);
+        message.setCommandSpecificData(payload, payloadLength);
+
+        it->entityID = entityID;
+        it->context = context;
+        it->sequenceID = _sequenceID++;
+        it->timeout = now + getAecpTimeout(_timeoutHandler, entityID, _timeout);
+        it->inUse = true;
+        ++_count;
+
+        _sendHandler(message, macAddress);
+        return true;
+    }
+
+    /** Releases and returns the command a response of commandType answers, std::nullopt if it is not for us */
+    std::optional<Command> handleResponse(Aecpdu const& aecpdu, AemCommandType const commandType) noexcept
+    {
+        if (aecpdu.getMessageType() != AecpMessageType::AEM_RESPONSE || aecpdu.getControllerEntityID() != _controllerID)
+        {
+            return std::nullopt;
+        }
+        auto const& aem = static_cast<AemAecpdu const&>(aecpdu);
+        if (aem.getCommandType() != commandType || aem.getUnsolicited())
+        {
+            return std::nullopt;
+        }
+
+        auto const it = std::find_if(_commands.begin(), _commands.end(), [&aecpdu](Command const& command)
+        {
+            return command.inUse && command.sequenceID == aecpdu.getSequenceID() && command.entityID == aecpdu.getTargetEntityID();
+        });
+        if (it == _commands.end())
+        {
+            return std::nullopt;
+        }
+        release(*it);
+        return *it;
+    }
+
+    /** Releases the commands whose timeout is before now, calling handler(Command const&) for each */
+    template<typename Handler>
+    void releaseExpired(AecpClock::time_point const now, Handler&& handler)
+    {
+        forEach([this, now, &handler](Command& command)
+        {
+            if (command.timeout <= now)
+            {
+                release(command);
+                handler(static_cast<Command const&>(command));
+            }
+        });
+    }
+
+    /** Releases the commands sent to an entity */
+    void releaseEntity(UniqueIdentifier const entityID) noexcept
+    {
+        forEach([this, entityID](Command& command)
+        {
+            if (command.entityID == entityID)
+            {
+                release(command);
+            }
+        });
+    }
+
+    /** Calls handler(Command&) for each inflight command */
+    template<typename Handler>
+    void forEach(Handler&& handler)
+    {
+        for (auto& command : _commands)
+        {
+            if (command.inUse)
+            {
+                handler(command);
+            }
+        }
+    }
+
+    // Getters
+    bool isFull() const noexcept
+    {
+        return _count >= _window;
+    }
+    size_t getWindow() const noexcept
+    {
+        return _window;
+    }
+    size_t size() const noexcept
+    {
+        return _count;
+    }
+
+private:
+    void release(Command& command) noexcept
+    {
+        command.inUse = false;
+        --_count;
+    }
+
+    UniqueIdentifier _controllerID{};
+    AecpSendHandler _sendHandler{};
+    size_t _window{ Capacity };
+    std::chrono::milliseconds _timeout{};
+    AecpTimeoutHandler _timeoutHandler{};
+    std::array<Command, Capacity> _commands{};
+    size_t _count{ 0u };
+    AecpSequenceID _sequenceID{ 0u };
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_AEMPOLLINGCOMMANDS_HPP_ */
@@ -0,0 +1,109 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_AEMUNSOLICITEDNOTIFIER_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_AEMUNSOLICITEDNOTIFIER_HPP_
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include "entityModelTypes.hpp"
+#include "protocolAecpdu.hpp"
+#include "protocolAemAecpdu.hpp"
+#include "protocolDefines.hpp"
+#include "uniqueIdentifier.hpp"
+
+// Sizing of the unsolicited notification tables (can be overridden from the build)
+#ifndef ATDECC_AEM_MAX_UNSOLICITED_SUBSCRIBERS
+#define ATDECC_AEM_MAX_UNSOLICITED_SUBSCRIBERS 8
+#endif
+#ifndef ATDECC_AEM_MAX_PENDING_NOTIFICATIONS
+#define ATDECC_AEM_MAX_PENDING_NOTIFICATIONS 8
+#endif
+
+/**
+ * @brief Entity side registry of REGISTER_UNSOLICITED_NOTIFICATION controllers.
+ * @details When a SET_* handler changes the state of the entity, it calls notifyChanged()
+ *          with the payload of its response, which is sent as an unsolicited AEM_RESPONSE
+ *          to each registered controller with that controller's own sequenceID.
+ *          Changes of the same descriptor are coalesced: at most one notification per
+ *          minimum interval is sent, carrying the last value.
+ */
+class AemUnsolicitedNotifier
+{
+public:
+    static constexpr size_t MaxSubscribers = ATDECC_AEM_MAX_UNSOLICITED_SUBSCRIBERS;
+    static constexpr size_t MaxPendingNotifications = ATDECC_AEM_MAX_PENDING_NOTIFICATIONS;
+
+    /**
+     * @param[in] entityID Entity sending the notifications.
+     * @param[in] sendHandler Handler used to send the notifications.
+     * @param[in] minInterval Minimum time between two notifications of the same descriptor state.
+     * @param[in] subscriptionTimeout Registrations not refreshed by touchController() for that long are dropped.
+     */
+    AemUnsolicitedNotifier(UniqueIdentifier const entityID, AecpSendHandler sendHandler, std::chrono::milliseconds const minInterval = std::chrono::milliseconds{ 100 }, std::chrono::milliseconds const subscriptionTimeout = std::chrono::seconds{ 62 }) noexcept;
+
+    /** Handles REGISTER_UNSOLICITED_NOTIFICATION. Returns NoResources if the registry is full. */
+    AemCommandStatus registerController(UniqueIdentifier const controllerID, MacAddress const& macAddress, AecpClock::time_point const now = AecpClock::now()) noexcept;
+
+    /** Handles DEREGISTER_UNSOLICITED_NOTIFICATION, and controllers departing */
+    void deregisterController(UniqueIdentifier const controllerID) noexcept;
+
+    /** Keeps a registration alive (any AECP command or ADP ENTITY_AVAILABLE from the controller) */
+    void touchController(UniqueIdentifier const controllerID, AecpClock::time_point const now = AecpClock::now()) noexcept;
+
+    /**
+     * @brief Reports a state change of the entity.
+     * @param[in] commandType Command type of the notification (eg. SET_CONTROL, GET_COUNTERS).
+     * @param[in] descriptorType Type of the descriptor that changed, used for coalescing.
+     * @param[in] descriptorIndex Index of the descriptor that changed, used for coalescing.
+     * @param[in] payload Response payload describing the new state.
+     * @param[in] sourceController Controller that caused the change, it already got the solicited response.
+     * @param[in] now Current time.
+     */
+    void notifyChanged(AemCommandType const commandType, DescriptorType const descriptorType, DescriptorIndex const descriptorIndex, AemAecpdu::Payload const& payload, UniqueIdentifier const sourceController = UniqueIdentifier{}, AecpClock::time_point const now = AecpClock::now());
+
+    /** Expires the registrations and sends the coalesced notifications that are due, to be called periodically */
+    void checkTimeouts(AecpClock::time_point const now = AecpClock::now());
+
+    // Getters
+    bool isRegistered(UniqueIdentifier const controllerID) const noexcept;
+    size_t getSubscriberCount() const noexcept;
+
+private:
+    struct Subscriber
+    {
+        UniqueIdentifier controllerID{};
+        MacAddress macAddress{};
+        AecpSequenceID nextSequenceID{ 0u };
+        AecpClock::time_point lastSeen{};
+        bool inUse{ false };
+    };
+
+    struct Notification
+    {
+        AemCommandType commandType{ AemCommandType::INVALID_COMMAND_TYPE };
+        DescriptorType descriptorType{ DescriptorType::Invalid };
+        DescriptorIndex descriptorIndex{ 0u };
+        std::array<uint8_t, AemAecpdu::MAXIMUM_SEND_PAYLOAD_BUFFER_LENGTH> payload{};
+        size_t payloadLength{ 0u };
+        UniqueIdentifier excludedController{}; /** Invalid when the coalesced changes came from several controllers */
+        AecpClock::time_point lastSent{};
+        bool pending{ false };                 /** Holds a change not sent yet */
+        bool inUse{ false };                   /** Also kept after sending, until minInterval elapsed */
+    };
+
+    Subscriber* findSubscriber(UniqueIdentifier const controllerID) noexcept;
+    Notification* allocateNotification(AecpClock::time_point const now);
+    void send(Notification& notification, AecpClock::time_point const now);
+
+    UniqueIdentifier _entityID{};
+    AecpSendHandler _sendHandler{};
+    std::chrono::milliseconds _minInterval{};
+    std::chrono::milliseconds _subscriptionTimeout{};
+    std::array<Subscriber, MaxSubscribers> _subscribers{};
+    size_t _subscriberCount{ 0u };
+    std::array<Notification, MaxPendingNotifications> _notifications{};
+    AemAecpdu _message{ true }; /** Reused for every notification sent */
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_AEMUNSOLICITEDNOTIFIER_HPP_ */
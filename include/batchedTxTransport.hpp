@@ -0,0 +1,110 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_BATCHEDTXTRANSPORT_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_BATCHEDTXTRANSPORT_HPP_
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include "frameRing.hpp"
+#include "networkTransport.hpp"
+
+// Sizing of the transmit queues (can be overridden from the build)
+#ifndef ATDECC_TX_QUEUE_FRAMES
+#if defined(ESP_PLATFORM)
+#define ATDECC_TX_QUEUE_FRAMES 8
+#else
+#define ATDECC_TX_QUEUE_FRAMES 128
+#endif
+#endif
+
+/** Transmit classes, sent in this order */
+enum class TxPriority : uint8_t
+{
+    Control,    /** ADP and ACMP, never paced */
+    Command,    /** AECP (AEM commands, responses and unsolicited notifications) */
+    Bulk,       /** AECP ADDRESS_ACCESS (memory object transfers) */
+    Count
+};
+
+/** Setup of a BatchedTxTransport */
+struct BatchedTxConfiguration
+{
+    size_t queueFrames{ ATDECC_TX_QUEUE_FRAMES };  /** Per priority */
+    size_t batchSize{ 32u };                       /** Frames per driver submission */
+    uint64_t pacingBitsPerSecond{ 0u };            /** Wire rate allowed to the Command and Bulk classes, 0 for no pacing */
+    size_t burstBytes{ 4500u };                    /** Wire bytes that can go out back to back when paced */
+};
+
+/** Counters of a BatchedTxTransport */
+struct BatchedTxStatistics
+{
+    std::array<uint64_t, static_cast<size_t>(TxPriority::Count)> frames{};
+    std::array<uint64_t, static_cast<size_t>(TxPriority::Count)> drops{};  /** Queue full */
+    uint64_t batches{ 0u };
+    uint64_t paced{ 0u };       /** Times frames were held back by the pacing */
+    uint64_t errors{ 0u };      /** Frames the driver refused */
+};
+
+/**
+ * @brief Decorator queuing the frames sent and handing them to the driver in batches.
+ * @details sendFrame() only queues, in the class of the frame (from its AVTP subtype and
+ *          message type), so a burst of enumeration responses or notifications built in one
+ *          go is submitted at once by flush() or poll(): one kernel call through the
+ *          PACKET_MMAP ring of a LinuxPacketTransport in deferred flush mode. Classes are sent
+ *          in strict priority, so ADP and ACMP never wait behind memory object transfers, and
+ *          the Command and Bulk classes can be paced by a token bucket to avoid micro bursts
+ *          on 100 Mbit/s links. Single thread, like the other transports: the queues are SPSC
+ *          rings, so sendFrame(), flush() and poll() must all run in one task. The frames
+ *          received are handled (and answered) from the context delivering them, so on ESP32
+ *          wrap an EspNetworkTransport in deferred delivery mode, which hands them over from
+ *          poll(); otherwise the responses are queued from the Ethernet RX task.
+ */
+class BatchedTxTransport final : public NetworkTransport
+{
+public:
+    using Configuration = BatchedTxConfiguration;
+    using Statistics = BatchedTxStatistics;
+
+    /** Preamble, FCS and inter frame gap, counted by the pacing */
+    static constexpr size_t WireOverhead = 24u;
+
+    BatchedTxTransport(NetworkTransport& transport, Configuration const& configuration = Configuration{});
+
+    bool open() override;
+    void close() noexcept override;
+    /** Queues a frame in the class given by classify() */
+    bool sendFrame(const uint8_t* frame, size_t const length) override;
+    bool joinMulticast(MacAddress const& macAddress) override;
+    bool leaveMulticast(MacAddress const& macAddress) override;
+    /** Sends the queued frames, receives (waiting no longer than the pacing needs), then sends the frames queued meanwhile */
+    size_t poll(std::chrono::milliseconds const timeout) override;
+    /** Sends the queued frames the pacing allows */
+    bool flush() override;
+
+    /** Queues a frame in a given class. Returns false if that queue is full. */
+    bool sendFrame(TxPriority const priority, const uint8_t* frame, size_t const length);
+
+    static TxPriority classify(const uint8_t* frame, size_t const length) noexcept;
+
+    // Getters
+    /** Time until the pacing lets the next queued frame go, 0 if one can go now or nothing is queued */
+    std::chrono::microseconds getPacingDelay() const noexcept;
+    size_t getQueuedCount() const noexcept;
+    Statistics const& getStatistics() const noexcept;
+
+private:
+    /** Sends the queued frames, those the pacing allows if paced */
+    bool flushQueues(bool const paced);
+    void refill(std::chrono::steady_clock::time_point const now) noexcept;
+
+    NetworkTransport& _transport;
+    Configuration _configuration{};
+    std::array<std::unique_ptr<FrameRing>, static_cast<size_t>(TxPriority::Count)> _queues{};
+    double _budget{ 0.0 };              /** Wire bytes the pacing allows right now, can go negative (Control frames) */
+    std::chrono::steady_clock::time_point _lastRefill{};
+    Statistics _statistics{};
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_BATCHEDTXTRANSPORT_HPP_ */
@@ -0,0 +1,215 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_CONTROLLERCOMMANDSCHEDULER_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_CONTROLLERCOMMANDSCHEDULER_HPP_
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "acmpStateMachines.hpp"
+#include "aecpTargetTiming.hpp"
+#include "protocolAcmpdu.hpp"
+#include "protocolAecpdu.hpp"
+#include "uniqueIdentifier.hpp"
+
+/** Priority classes of the commands sent by a controller */
+enum class CommandClass : uint8_t
+{
+    Interactive,    /** Operator actions (SET_CONTROL, SET_NAME, ACQUIRE_ENTITY, ...), strict priority */
+    Connection,     /** ACMP CONNECT/DISCONNECT, strict priority after Interactive */
+    Enumeration,    /** READ_DESCRIPTOR, GET_AUDIO_MAP, ACMP state sweeps */
+    Bulk,           /** Address Access (memory objects, firmware) */
+    Polling,        /** GET_COUNTERS, GET_AVB_INFO, metering */
+    Count
+};
+
+/** Limits of ControllerCommandScheduler */
+struct CommandSchedulerConfiguration
+{
+    static constexpr size_t ClassCount = static_cast<size_t>(CommandClass::Count);
+
+    std::array<size_t, ClassCount> maxInflight{ 8u, 4u, 8u, 4u, 4u };  /** Per class */
+    std::array<uint32_t, ClassCount> weights{ 0u, 0u, 4u, 2u, 1u };   /** Share of the background classes (Enumeration, Bulk, Polling) */
+    size_t maxBackgroundInflight{ 8u };             /** Background classes together */
+    size_t maxQueued{ 2048u };                      /** Commands waiting, all classes */
+    AecpTimingConfiguration timing{};               /** AECP timeout and background window of each entity */
+    std::chrono::milliseconds aecpInProgressTimeout{ 2000 }; /** After an IN_PROGRESS response */
+    std::chrono::milliseconds aecpRetryHold{ 8000 };         /** How long a timed out AECP command can be resent as a retry (should cover the retries of the components) */
+    std::chrono::milliseconds acmpTimeout{ 4500 };
+};
+
+/**
+ * @brief Controller side scheduling of the outgoing AECP and ACMP commands.
+ * @details Sits between the controller components and the network: they are given the
+ *          send handlers of the scheduler instead of the network ones. A command goes out
+ *          right away when its class is below its inflight limit, otherwise a copy is queued.
+ *          Interactive then Connection commands are served first, so an operator's command
+ *          never waits behind an enumeration; the background classes share
+ *          maxBackgroundInflight by weighted round robin. Within a class, the target entities
+ *          are served in turn (weight commands each), so one large entity does not delay the
+ *          others. Inflight commands are released by their response (handleAecpdu(),
+ *          handleAcmpdu()) or their timeout (poll()).
+ *          Each entity has an AecpTargetTiming fed by its AECP responses: its adaptive timeout
+ *          releases the lost commands, and its AIMD window bounds the background commands
+ *          inflight to it, so fast entities are enumerated in parallel while slow ones get
+ *          one command at a time.
+ *          A retry of a queued command replaces it, a retry of an inflight one goes out in
+ *          the same slot. A timed out AECP command is remembered for aecpRetryHold: if the
+ *          component resends it with the same sequenceID, it is sent as a new command but gives
+ *          no response time sample, since the response may be the one to the first copy (Karn).
+ *          Components time their commands from the call to the send handler: give them
+ *          getTimeoutHandler() (AaBulkTransfer, AaPipelinedUploader, AemCounterPoller,
+ *          AemMeterPoller) so they retry on the adaptive timeout of their target, and keep
+ *          their class lightly queued, since the queueing counts against that timeout.
+ *          The pollers (AemCounterPoller, AemMeterPoller) take getAecpSendHandler(CommandClass::Polling),
+ *          GET_CONTROL being Interactive by default: the Polling limit and the entity windows then
+ *          bound what is on the wire, and the window of a poller only caps the commands it matches
+ *          the responses to (MaxInflight is fine).
+ */
+class ControllerCommandScheduler
+{
+public:
+    using Configuration = CommandSchedulerConfiguration;
+    static constexpr size_t ClassCount = Configuration::ClassCount;
+
+    struct ClassMetrics
+    {
+        uint32_t submitted{ 0u };
+        uint32_t queued{ 0u };       /** Commands that could not go out right away */
+        uint32_t completed{ 0u };    /** Responses received */
+        uint32_t timeouts{ 0u };
+        uint32_t drops{ 0u };        /** Queue full */
+        uint32_t retriesMerged{ 0u };
+        std::chrono::microseconds maxQueueDelay{ 0 };
+    };
+
+    struct Metrics
+    {
+        std::array<ClassMetrics, ClassCount> classes{};
+    };
+
+    ControllerCommandScheduler(UniqueIdentifier const controllerID, AecpSendHandler aecpSendHandler, AcmpSendHandler acmpSendHandler, Configuration const& configuration = Configuration{}) noexcept;
+
+    /** Send handler classifying the AECPDUs with classify() */
+    AecpSendHandler getAecpSendHandler();
+    /** Send handler putting all the AECPDUs in a class */
+    AecpSendHandler getAecpSendHandler(CommandClass const commandClass);
+    /** Send handler classifying the ACMPDUs with classify() */
+    AcmpSendHandler getAcmpSendHandler();
+    /** Send handler putting all the ACMPDUs in a class */
+    AcmpSendHandler getAcmpSendHandler(CommandClass const commandClass);
+    /** Timeout handler following getTimeout(), for the components sending through the scheduler */
+    AecpTimeoutHandler getTimeoutHandler();
+
+    /** Sends or queues an AEM or Address Access command. Returns false if the queue is full. */
+    bool sendAecpdu(CommandClass const commandClass, Aecpdu const& aecpdu, MacAddress const& destAddress, AecpClock::time_point const now = AecpClock::now());
+
+    /** Sends or queues an ACMP command. Returns false if the queue is full. */
+    bool sendAcmpdu(CommandClass const commandClass, Acmpdu const& acmpdu, AecpClock::time_point const now = AecpClock::now());
+
+    /** Processes a received AECPDU. Returns true if it was a response to a command sent through the scheduler. */
+    bool handleAecpdu(Aecpdu const& aecpdu, AecpClock::time_point const now = AecpClock::now());
+
+    /** Processes a received ACMPDU. Returns true if it was a response to a command sent through the scheduler. */
+    bool handleAcmpdu(Acmpdu const& acmpdu, AecpClock::time_point const now = AecpClock::now());
+
+    /** Releases the timed out commands and sends the queued ones, to be called periodically */
+    void poll(AecpClock::time_point const now = AecpClock::now());
+
+    /** Drops the queued and inflight commands of an entity (usually on ENTITY_DEPARTING) */
+    void removeEntity(UniqueIdentifier const entityID) noexcept;
+
+    static CommandClass classify(Aecpdu const& aecpdu) noexcept;
+    static CommandClass classify(Acmpdu const& acmpdu) noexcept;
+
+    // Setters
+    /** Number of commands of an entity sent in a row when its turn comes (default 1) */
+    void setEntityWeight(UniqueIdentifier const entityID, uint32_t const weight);
+
+    // Getters
+    Metrics const& getMetrics() const noexcept;
+    /** Adaptive AECP timeout of an entity, the initial timeout if it was never sent a command */
+    std::chrono::milliseconds getTimeout(UniqueIdentifier const entityID) const noexcept;
+    /** Timing of an entity, nullptr if it was never sent a command */
+    AecpTargetTiming const* getTiming(UniqueIdentifier const entityID) const noexcept;
+    size_t getQueuedCount(CommandClass const commandClass) const noexcept;
+    size_t getInflightCount(CommandClass const commandClass) const noexcept;
+
+private:
+    struct Command
+    {
+        Aecpdu::UniquePointer aecpdu{ nullptr, nullptr };  /** Copy of an AECP command, nullptr for ACMP */
+        Acmpdu acmpdu{};
+        MacAddress destAddress{};
+        uint16_t sequenceID{ 0u };
+        bool ambiguous{ false };    /** Resent after a timeout */
+        AecpClock::time_point queued{};
+    };
+
+    struct Entity
+    {
+        UniqueIdentifier entityID{};
+        std::array<std::deque<Command>, ClassCount> queues{};
+        std::array<uint32_t, ClassCount> served{};  /** Commands sent in the current turn */
+        uint32_t weight{ 1u };
+        size_t backgroundInflight{ 0u };
+        AecpTargetTiming timing{};
+    };
+
+    struct Inflight
+    {
+        UniqueIdentifier entityID{};
+        uint16_t sequenceID{ 0u };
+        CommandClass commandClass{ CommandClass::Interactive };
+        bool isAcmp{ false };
+        bool ambiguous{ false };    /** Retried or IN_PROGRESS: no response time sample */
+        AecpClock::time_point sent{};
+        AecpClock::time_point timeout{};
+    };
+
+    /** AECP command released by its timeout, that the component may resend */
+    struct TimedOut
+    {
+        UniqueIdentifier entityID{};
+        uint16_t sequenceID{ 0u };
+        AecpClock::time_point expires{};
+    };
+
+    static bool isBackground(CommandClass const commandClass) noexcept;
+    static UniqueIdentifier getTargetEntityID(Acmpdu const& acmpdu) noexcept;
+    static Aecpdu::UniquePointer copyAecpdu(Aecpdu const& aecpdu);
+
+    Entity& getEntity(UniqueIdentifier const entityID);
+    Entity* findEntity(UniqueIdentifier const entityID) const noexcept;
+    Inflight* findInflight(UniqueIdentifier const entityID, uint16_t const sequenceID, bool const isAcmp) noexcept;
+    bool canSend(CommandClass const commandClass, Entity const& entity) const noexcept;
+    bool enqueue(CommandClass const commandClass, Entity& entity, Command&& command);
+    void transmit(CommandClass const commandClass, Entity& entity, Command const& command, Aecpdu const* aecpdu, AecpClock::time_point const now);
+    void release(Inflight const& inflight) noexcept;
+    /** Forgets a timed out command, returns false if it was not one */
+    bool forgetTimedOut(UniqueIdentifier const entityID, uint16_t const sequenceID) noexcept;
+    void dispatch(AecpClock::time_point const now);
+    bool sendNext(CommandClass const commandClass, AecpClock::time_point const now);
+    bool sendNextBackground(AecpClock::time_point const now);
+
+    UniqueIdentifier _controllerID{};
+    AecpSendHandler _aecpSendHandler{};
+    AcmpSendHandler _acmpSendHandler{};
+    Configuration _configuration{};
+    std::vector<std::unique_ptr<Entity>> _entities{};
+    std::array<std::deque<Entity*>, ClassCount> _rounds{};   /** Entities with queued commands, in turn order */
+    std::vector<Inflight> _inflight{};
+    std::vector<TimedOut> _timedOut{};
+    std::array<size_t, ClassCount> _classInflight{};
+    std::array<size_t, ClassCount> _classQueued{};
+    std::array<uint32_t, ClassCount> _credits{};             /** Background classes, left in the current round */
+    size_t _backgroundTurn{ 0u };
+    size_t _backgroundInflight{ 0u };
+    size_t _queuedCount{ 0u };
+    Metrics _metrics{};
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_CONTROLLERCOMMANDSCHEDULER_HPP_ */
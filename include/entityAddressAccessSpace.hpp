@@ -0,0 +1,162 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_ENTITYADDRESSACCESSSPACE_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_ENTITYADDRESSACCESSSPACE_HPP_
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include "aecpPayloadNegotiator.hpp"
+#include "entityAddressAccessTypes.hpp"
+#include "protocolDefines.hpp"
+
+#if defined(ESP_PLATFORM)
+#include "esp_partition.h"
+#endif
+
+// Maximum number of regions in an address space (can be overridden from the build)
+#ifndef ATDECC_AA_MAX_MEMORY_REGIONS
+#define ATDECC_AA_MAX_MEMORY_REGIONS 8
+#endif
+
+/** Storage behind a region of the Address Access memory map. Offsets are relative to the start of the region. */
+class AaMemoryBackend
+{
+public:
+    virtual ~AaMemoryBackend() = default;
+
+    /** Reads length bytes at offset into data */
+    virtual AaCommandStatus read(uint64_t const offset, void* data, size_t const length) = 0;
+
+    /** Writes length bytes from data at offset */
+    virtual AaCommandStatus write(uint64_t const offset, const void* data, size_t const length) = 0;
+
+    /** Called before the whole region is written again from the start (eg. an upload) */
+    virtual void beginWrite() {}
+
+    /** Handles an EXECUTE TLV, unsupported by default */
+    virtual AaCommandStatus execute(uint64_t const offset, const void* data, size_t const length)
+    {
+        (void)offset;
+        (void)data;
+        (void)length;
+        return AaCommandStatus::Unsupported;
+    }
+};
+
+/** Region backed by plain memory */
+class AaRamBackend final : public AaMemoryBackend
+{
+public:
+    /** Read-write region */
+    AaRamBackend(void* base, size_t const size) noexcept;
+
+    /** Read-only region */
+    AaRamBackend(const void* base, size_t const size) noexcept;
+
+    AaCommandStatus read(uint64_t const offset, void* data, size_t const length) override;
+    AaCommandStatus write(uint64_t const offset, const void* data, size_t const length) override;
+
+private:
+    const uint8_t* _base{ nullptr };
+    uint8_t* _writableBase{ nullptr };
+    size_t _size{ 0u };
+};
+
+#if defined(ESP_PLATFORM)
+/**
+ * @brief Region backed by a flash partition.
+ * @details Sectors are erased up to the furthest write the first time it reaches them,
+ *          so a partition can be written sequentially (eg. an upload, even with chunks
+ *          retried out of order) without a separate erase step.
+ *          Call beginWrite() before writing the partition again.
+ */
+class AaPartitionBackend final : public AaMemoryBackend
+{
+public:
+    explicit AaPartitionBackend(esp_partition_t const* partition) noexcept;
+
+    AaCommandStatus read(uint64_t const offset, void* data, size_t const length) override;
+    AaCommandStatus write(uint64_t const offset, const void* data, size_t const length) override;
+
+    /** Forgets which sectors have been erased */
+    void beginWrite() override;
+
+private:
+    esp_partition_t const* _partition{ nullptr };
+    size_t _erasedEnd{ 0u }; /** Sectors before this offset have been erased */
+};
+#endif
+
+#if defined(__linux__)
+/** Region backed by a file (the file descriptor stays owned by the caller) */
+class AaFileBackend final : public AaMemoryBackend
+{
+public:
+    AaFileBackend(int const fd, bool const writable) noexcept;
+
+    AaCommandStatus read(uint64_t const offset, void* data, size_t const length) override;
+    AaCommandStatus write(uint64_t const offset, const void* data, size_t const length) override;
+
+private:
+    int _fd{ -1 };
+    bool _writable{ false };
+};
+#endif
+
+/**
+ * @brief Address Access memory map of an entity.
+ * @details Routes the READ/WRITE/EXECUTE TLVs of an ADDRESS_ACCESS_COMMAND to the backend
+ *          registered for their address range. Data is read from the command frame and
+ *          written to the response frame directly, without intermediate buffers.
+ */
+class AaAddressSpace
+{
+public:
+    static constexpr size_t MaxRegions = ATDECC_AA_MAX_MEMORY_REGIONS;
+
+    /** Maps [address, address + length) to a backend. Returns false if the map is full or the range overlaps another region. */
+    bool addRegion(uint64_t const address, uint64_t const length, AaMemoryBackend& backend) noexcept;
+
+    /** Removes the region starting at address */
+    void removeRegion(uint64_t const address) noexcept;
+
+    /** Checks the length of received commands against the limit of their controller (any length up to the buffer if not set). Must outlive this object. */
+    void setPayloadNegotiator(AecpPayloadNegotiator* negotiator) noexcept;
+
+    /** Checks that a TLV targets a single region, without processing it */
+    AaCommandStatus validate(TlvView const& tlv) const noexcept;
+
+    /**
+     * @brief Processes a serialized ADDRESS_ACCESS_COMMAND.
+     * @details All the TLVs are validated first (TlvInvalid and address errors mean no TLV was processed),
+     *          then processed in order until one fails. The response echoes every TLV, READ TLVs being
+     *          filled straight from the backend.
+     * @param[in] command Serialized AA AECPDU command.
+     * @param[in] commandLength Length of the command.
+     * @param[out] response Buffer receiving the serialized AA AECPDU response.
+     * @param[in] responseCapacity Size of the response buffer.
+     * @return Length of the response, 0 if the command could not be answered (or was dropped by the payload negotiator).
+     */
+    size_t processCommand(const uint8_t* command, size_t const commandLength, uint8_t* response, size_t const responseCapacity);
+
+    // Getters
+    size_t getRegionCount() const noexcept;
+
+private:
+    struct Region
+    {
+        uint64_t address{ 0u };
+        uint64_t length{ 0u };
+        AaMemoryBackend* backend{ nullptr };
+    };
+
+    Region const* findRegion(uint64_t const address) const noexcept;
+    AaCommandStatus process(TlvView const& tlv, uint8_t* responseData);
+
+    std::array<Region, MaxRegions> _regions{}; /** Sorted by address */
+    size_t _regionCount{ 0u };
+    AecpPayloadNegotiator* _negotiator{ nullptr };
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_ENTITYADDRESSACCESSSPACE_HPP_ */
@@ -163,4 +163,44 @@ private:
 /** Alias for a vector of TLVs */
 using Tlvs = std::vector<Tlv>;
 
+/** Non-owning Type-Length-Value for Address Access, pointing into a received frame */
+class TlvView final
+{
+public:
+    using value_type = uint8_t;
+
+    /** Default constructor for an invalid TLV. */
+    constexpr TlvView() noexcept = default;
+
+    /** Constructor from the decoded TLV header and its memory data. */
+    constexpr TlvView(AaMode mode, uint64_t address, const value_type* data, size_t size) noexcept
+        : _mode(mode), _address(address), _data(data), _size(size)
+    {
+    }
+
+    // Getter for mode
+    AaMode getMode() const noexcept { return _mode; }
+
+    // Getter for address
+    uint64_t getAddress() const noexcept { return _address; }
+
+    // Getter for raw memory data
+    const value_type* data() const noexcept { return _data; }
+
+    // Getter for size of memory data
+    size_t size() const noexcept { return _size; }
+
+    // Check if TLV is valid
+    bool isValid() const noexcept { return _data != nullptr && _size != 0; }
+
+    // Validity operator
+    explicit operator bool() const noexcept { return isValid(); }
+
+private:
+    AaMode _mode{ AaMode::READ };       // TLV mode
+    uint64_t _address{ 0u };            // Memory address
+    const value_type* _data{ nullptr }; // Memory data, owned by the frame
+    size_t _size{ 0u };                 // Size of memory data
+};
+
 #endif /* COMPONENTS_ATDECC_INCLUDE_ENTITYADDRESSACCESSTYPES_HPP_ */
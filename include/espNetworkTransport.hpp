@@ -0,0 +1,70 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_ESPNETWORKTRANSPORT_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_ESPNETWORKTRANSPORT_HPP_
+
+#pragma once
+
+#if defined(ESP_PLATFORM)
+
+#include <atomic>
+#include <memory>
+#include "frameRing.hpp"
+#include "networkTransport.hpp"
+#include "esp_err.h"
+#include "esp_eth_driver.h"
+#include "esp_netif.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+// Task notification index poll() waits on with deferred delivery (can be overridden from the build).
+// Kept apart from index 0, used by EventLoop and most FreeRTOS code; needs
+// CONFIG_FREERTOS_TASK_NOTIFICATION_ARRAY_ENTRIES above it, else index 0 is shared.
+#ifndef ATDECC_RX_NOTIFY_INDEX
+#define ATDECC_RX_NOTIFY_INDEX 1
+#endif
+
+/**
+ * @brief NetworkTransport over an esp_eth driver.
+ * @details Takes over the input path of the driver: AVTP frames are delivered to the frame
+ *          handler from the Ethernet RX task, the other frames are given to the esp_netif
+ *          (if any) so the IP stack keeps working on the same interface.
+ *          With deferred delivery, the RX task only copies the AVTP frames into a FrameRing and
+ *          they are decoded in the task calling poll(), in batches: a discovery storm then
+ *          costs the driver one copy per frame, and overflows are counted instead of stalling it.
+ */
+class EspNetworkTransport final : public NetworkTransport
+{
+public:
+    /**
+     * @param[in] ethHandle Driver of the interface, installed and started by the application.
+     * @param[in] netif Network interface to forward the non AVTP frames to, nullptr if the interface only carries AVTP.
+     * @param[in] deferredDelivery Delivers the frames from poll() through a FrameRing, instead of from the RX task.
+     */
+    EspNetworkTransport(esp_eth_handle_t const ethHandle, esp_netif_t* netif = nullptr, bool const deferredDelivery = false) noexcept;
+    ~EspNetworkTransport() noexcept override;
+
+    bool open() override;
+    void close() noexcept override;
+    bool sendFrame(const uint8_t* frame, size_t const length) override;
+    bool joinMulticast(MacAddress const& macAddress) override;
+    bool leaveMulticast(MacAddress const& macAddress) override;
+    /** With deferred delivery, waits on task notification ATDECC_RX_NOTIFY_INDEX of the calling task when timeout is not 0 */
+    size_t poll(std::chrono::milliseconds const timeout) override;
+
+    // Getters
+    /** Counters of the deferred delivery ring, all 0 without it */
+    FrameRing::Statistics getRxRingStatistics() const noexcept;
+
+private:
+    static esp_err_t onFrameReceived(esp_eth_handle_t ethHandle, uint8_t* buffer, uint32_t length, void* priv);
+
+    esp_eth_handle_t _ethHandle{ nullptr };
+    esp_netif_t* _netif{ nullptr };
+    bool _deferredDelivery{ false };
+    bool _promiscuous{ false };                      /** Enabled by joinMulticast() (IDF before 5.3), disabled by close() */
+    std::unique_ptr<FrameRing> _rxRing{};
+    std::atomic<TaskHandle_t> _pollTask{ nullptr };  /** Woken when a frame reaches an empty ring */
+};
+
+#endif // ESP_PLATFORM
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_ESPNETWORKTRANSPORT_HPP_ */
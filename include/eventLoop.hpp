@@ -0,0 +1,126 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_EVENTLOOP_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_EVENTLOOP_HPP_
+
+#pragma once
+
+#if defined(ESP_PLATFORM) || defined(__linux__)
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "mpmcQueue.hpp"
+#include "timerWheel.hpp"
+
+#if defined(ESP_PLATFORM)
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#endif
+
+// Sizing of the event loop (can be overridden from the build)
+#ifndef ATDECC_EVENT_LOOP_QUEUE_DEPTH
+#define ATDECC_EVENT_LOOP_QUEUE_DEPTH 64
+#endif
+#ifndef ATDECC_EVENT_LOOP_MAX_TIMERS
+#if defined(ESP_PLATFORM)
+#define ATDECC_EVENT_LOOP_MAX_TIMERS 256
+#else
+#define ATDECC_EVENT_LOOP_MAX_TIMERS 4096
+#endif
+#endif
+
+/**
+ * @brief Single threaded loop running the ATDECC state machines.
+ * @details Any thread posts work to a lock-free queue and wakes the loop (FreeRTOS task
+ *          notification on ESP-IDF, eventfd on Linux) only if it is not already woken. Timers
+ *          (ADP advertise, AECP and ACMP timeouts, entity expiry...) live in one TimerWheel of
+ *          1 ms ticks, with no OS object per timer: the loop sleeps until the next tick the
+ *          wheel needs (task notification timeout on ESP-IDF, timerfd on Linux). Timers are
+ *          started and cancelled from the loop thread only, so they need no lock.
+ */
+class EventLoop
+{
+public:
+    using Task = std::function<void()>;
+    using TimerId = TimerWheel::TimerId;
+
+    static constexpr size_t QueueDepth = ATDECC_EVENT_LOOP_QUEUE_DEPTH;
+    static constexpr size_t MaxTimers = ATDECC_EVENT_LOOP_MAX_TIMERS;
+    static constexpr TimerId InvalidTimer = TimerWheel::InvalidTimer;
+    static constexpr auto Forever = std::chrono::milliseconds::max();
+
+    EventLoop();
+    /** The loop must be stopped */
+    ~EventLoop() noexcept;
+    EventLoop(EventLoop const&) = delete;
+    EventLoop& operator=(EventLoop const&) = delete;
+
+    /** Runs a task on the loop thread, from any thread. Returns false if the queue is full. */
+    bool post(Task task);
+
+    /** Runs callback on the loop thread after delay (1 ms resolution). Loop thread only. Returns InvalidTimer if all the timers are in use. */
+    TimerId startTimer(std::chrono::milliseconds const delay, Task callback);
+
+    /** Cancels a timer. Loop thread only. Returns false if it already fired. */
+    bool cancelTimer(TimerId const timerId) noexcept;
+
+    /** Runs the loop in the calling thread until stop() */
+    void run();
+
+    /** Runs the posted tasks and expired timers, waiting up to timeout for one. Returns the number run. */
+    size_t runOnce(std::chrono::milliseconds const timeout);
+
+    /** Makes run() return, from any thread */
+    void stop() noexcept;
+
+#if defined(ESP_PLATFORM)
+    /** Runs the loop in a new FreeRTOS task */
+    bool start(char const* name, uint32_t const stackSize = 4096, UBaseType_t const priority = 5, BaseType_t const core = tskNO_AFFINITY);
+#else
+    /** Calls handler on the loop thread each time fd is readable (eg. LinuxPacketTransport::getFileDescriptor()) */
+    bool watchFileDescriptor(int const fd, Task handler);
+
+    bool unwatchFileDescriptor(int const fd);
+#endif
+
+    // Getters
+    /** Time in loop ticks (ms), as used by the timers */
+    TimerWheel::Tick getCurrentTick() const noexcept;
+    size_t getActiveTimerCount() const noexcept;
+    uint64_t getDroppedTaskCount() const noexcept;
+
+private:
+    size_t runReady();
+    void wait(std::chrono::milliseconds const timeout);
+    void wake() noexcept;
+
+    MpmcQueue<Task> _tasks{ QueueDepth };
+    TimerWheel _timers{ MaxTimers };
+    std::chrono::steady_clock::time_point _epoch{ std::chrono::steady_clock::now() };
+    std::atomic<bool> _wakePending{ false };
+    std::atomic<bool> _running{ false };
+    std::atomic<uint64_t> _droppedTasks{ 0u };
+
+#if defined(ESP_PLATFORM)
+    static void taskEntry(void* arg);
+
+    std::atomic<TaskHandle_t> _task{ nullptr };
+#else
+    struct Watch
+    {
+        int fd{ -1 };
+        Task handler{};
+    };
+
+    int _epoll{ -1 };
+    int _eventFd{ -1 };
+    int _timerFd{ -1 };
+    TimerWheel::Tick _armedTick{ TimerWheel::NoTimer };
+    std::vector<Watch> _watches{};
+#endif
+};
+
+#endif // ESP_PLATFORM || __linux__
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_EVENTLOOP_HPP_ */
@@ -0,0 +1,102 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_FRAMECLASSIFIER_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_FRAMECLASSIFIER_HPP_
+
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include "uniqueIdentifier.hpp"
+
+// Size of the watch filter (can be overridden from the build)
+#ifndef ATDECC_ENTITY_FILTER_BITS
+#define ATDECC_ENTITY_FILTER_BITS 4096
+#endif
+
+/** Result of FrameClassifier::classify(), drops are counted per reason */
+enum class FrameVerdict : uint8_t
+{
+    Accept,
+    TooShort,       /** Shorter than the AVTP control header or the fields to check */
+    NotAtdecc,      /** Other EtherType or AVTP subtype */
+    MessageType,    /** Message type the local roles do not handle */
+    NotAddressed,   /** Addressed to another entity or controller */
+    NotWatched,     /** About entities not in the watch filter */
+    Count
+};
+
+/**
+ * @brief Bloom filter of entity IDs, for controllers watching many entities.
+ * @details Never misses an added entity, may accept a few others (under 2% with 3 bits per
+ *          entity and 400 entities in 4096 bits). Entities cannot be removed, clear and add
+ *          the remaining ones instead. Can be updated while a classifier uses it.
+ */
+class EntityIdFilter
+{
+public:
+    static constexpr size_t Bits = ATDECC_ENTITY_FILTER_BITS;
+    static_assert(Bits >= 64 && (Bits & (Bits - 1u)) == 0, "ATDECC_ENTITY_FILTER_BITS must be a power of 2");
+
+    void add(UniqueIdentifier const entityID) noexcept;
+    void clear() noexcept;
+
+    // Getters
+    bool mayContain(UniqueIdentifier const entityID) const noexcept;
+    /** Same, with the entity ID as read from a frame (network order) */
+    bool mayContainRaw(uint64_t const networkOrderID) const noexcept;
+
+private:
+    std::array<std::atomic<uint32_t>, Bits / 32u> _words{}; /** 32-bit words, lock-free on the ESP32 */
+};
+
+/**
+ * @brief Decides whether a received ATDECC frame is worth decoding, from its first 50 bytes.
+ * @details Every multicast ATDECC frame reaches every station, but most AECP and ACMP frames
+ *          are for other entities. The classifier only reads the EtherType, the AVTP subtype
+ *          and message type, and the entity IDs (target / controller / talker / listener,
+ *          compared in network order) against the local roles, before any PDU is built:
+ *          - Entity role: ADP ENTITY_DISCOVER for all or for it, ADP ENTITY_AVAILABLE of the
+ *            entities of the watch filter (the talkers of the saved bindings, see
+ *            AcmpListenerStateMachine::addSavedTalkers), AECP commands targeting it, ACMP
+ *            commands for its talker or listener, CONNECT/DISCONNECT_TX responses to its
+ *            listener.
+ *          - Controller role: ADP advertisements, AECP responses to its controller ID, all
+ *            ACMP responses (connection monitoring), optionally restricted to the entities of
+ *            a watch filter (leave it unset during discovery).
+ *          Single caller (the receive context); the counters can be read from any thread.
+ */
+class FrameClassifier
+{
+public:
+    /** Up to the end of the ACMP listener_entity_id */
+    static constexpr size_t ClassifiedLength = 50u;
+
+    // Setters
+    /** Local entity ID, an invalid ID disables the entity role */
+    void setEntityID(UniqueIdentifier const entityID) noexcept;
+    /** Local controller ID, an invalid ID disables the controller role */
+    void setControllerID(UniqueIdentifier const controllerID) noexcept;
+    /** Restricts the controller role to the entities of filter, nullptr for all. In the entity role, the ENTITY_AVAILABLE accepted (none if nullptr). The filter must outlive the classifier. */
+    void setWatchFilter(EntityIdFilter const* filter) noexcept;
+
+    FrameVerdict classify(const uint8_t* frame, size_t const length) noexcept;
+
+    // Getters
+    /** Counters are 32 bits (lock-free on the ESP32) and wrap around */
+    uint32_t getCount(FrameVerdict const verdict) const noexcept;
+    uint64_t getDropCount() const noexcept;
+
+private:
+    FrameVerdict count(FrameVerdict const verdict) noexcept;
+    FrameVerdict classifyAdp(const uint8_t* frame, uint8_t const messageType) noexcept;
+    FrameVerdict classifyAecp(const uint8_t* frame, size_t const length, uint8_t const messageType) noexcept;
+    FrameVerdict classifyAcmp(const uint8_t* frame, size_t const length, uint8_t const messageType) noexcept;
+    bool isWatched(const uint8_t* entityID) const noexcept;
+
+    uint64_t _entityID{ 0u };       /** Network order, 0 if no entity role */
+    uint64_t _controllerID{ 0u };   /** Network order, 0 if no controller role */
+    EntityIdFilter const* _watchFilter{ nullptr };
+    std::array<std::atomic<uint32_t>, static_cast<size_t>(FrameVerdict::Count)> _counts{};
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_FRAMECLASSIFIER_HPP_ */
@@ -0,0 +1,158 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_FRAMERING_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_FRAMERING_HPP_
+
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include "protocolDefines.hpp"
+
+// Sizing of the receive rings (can be overridden from the build)
+#ifndef ATDECC_RX_RING_FRAMES
+#if defined(ESP_PLATFORM)
+#define ATDECC_RX_RING_FRAMES 32
+#else
+#define ATDECC_RX_RING_FRAMES 1024
+#endif
+#endif
+
+/** Counters of a FrameRing */
+struct FrameRingStatistics
+{
+    uint32_t frames{ 0u };      /** Pushed (wraps around) */
+    uint32_t drops{ 0u };       /** Pushed while the ring was full (wraps around) */
+    size_t highWatermark{ 0u }; /** Most frames waiting at once */
+    size_t capacity{ 0u };
+};
+
+/**
+ * @brief Lock-free SPSC ring of preallocated Ethernet frame buffers.
+ * @details Between a receiving context (the esp_eth RX task, a Linux I/O thread) and the task
+ *          decoding the frames. Buffers are sized for ETHERNET_MAX_FRAME_SIZE, allocated once
+ *          and cache line aligned, so a frame costs one copy and no allocation. The consumer
+ *          drains in batches: one load of the producer position and one store of its own per
+ *          batch. A full ring drops the new frame (counted) rather than blocking the driver.
+ *          The capacity is rounded up to a power of 2.
+ */
+class FrameRing
+{
+public:
+    using Statistics = FrameRingStatistics;
+
+    explicit FrameRing(size_t const capacity = ATDECC_RX_RING_FRAMES);
+
+    FrameRing(FrameRing const&) = delete;
+    FrameRing& operator=(FrameRing const&) = delete;
+
+    /** Producer: copies a frame. Returns false if the ring is full or the frame too big. */
+    bool push(const uint8_t* frame, size_t const length) noexcept
+    {
+        if (length > ETHERNET_MAX_FRAME_SIZE)
+        {
+            _drops.fetch_add(1u, std::memory_order_relaxed);
+            return false;
+        }
+        auto const tail = _tail.load(std::memory_order_relaxed);
+        auto used = tail - _cachedHead;
+        if (used > _mask)
+        {
+            _cachedHead = _head.load(std::memory_order_acquire);
+            used = tail - _cachedHead;
+            if (used > _mask)
+            {
+                _drops.fetch_add(1u, std::memory_order_relaxed);
+                return false;
+            }
+        }
+        auto& slot = _slots[tail & _mask];
+        std::memcpy(slot.data, frame, length);
+        slot.length = static_cast<uint16_t>(length);
+        _tail.store(tail + 1u, std::memory_order_release);
+
+        // Producer side only, no atomic read-modify-write needed
+        _frames.store(_frames.load(std::memory_order_relaxed) + 1u, std::memory_order_relaxed);
+        if (used + 1u > _highWatermark.load(std::memory_order_relaxed))
+        {
+            // The cached position may be late, only a new maximum is worth a reload
+            _cachedHead = _head.load(std::memory_order_acquire);
+            auto const waiting = tail + 1u - _cachedHead;
+            if (waiting > _highWatermark.load(std::memory_order_relaxed))
+            {
+                _highWatermark.store(waiting, std::memory_order_relaxed);
+            }
+        }
+        return true;
+    }
+
+    /**
+     * @brief Consumer: calls handler(frame, length) for up to maxFrames frames, oldest first.
+     * @details The slots are only given back once the whole batch is handled.
+     * @return Number of frames handled.
+     */
+    template<typename Handler>
+    size_t drain(Handler&& handler, size_t const maxFrames = ~size_t{ 0u })
+    {
+        auto const head = _head.load(std::memory_order_relaxed);
+        auto const tail = _tail.load(std::memory_order_acquire);
+        auto const count = std::min<size_t>(tail - head, maxFrames);
+        for (auto i = size_t{ 0u }; i < count; ++i)
+        {
+            auto const& slot = _slots[(head + i) & _mask];
+            handler(static_cast<const uint8_t*>(slot.data), static_cast<size_t>(slot.length));
+        }
+        if (count != 0u)
+        {
+            _head.store(head + count, std::memory_order_release);
+        }
+        return count;
+    }
+
+    /** Consumer: oldest frame without removing it, nullptr if the ring is empty */
+    const uint8_t* peek(size_t& length) const noexcept
+    {
+        auto const head = _head.load(std::memory_order_relaxed);
+        if (head == _tail.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        auto const& slot = _slots[head & _mask];
+        length = slot.length;
+        return slot.data;
+    }
+
+    /** Consumer: removes the frame returned by peek() */
+    void pop() noexcept
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + 1u, std::memory_order_release);
+    }
+
+    /** Consumer: restarts the high watermark from the current occupancy */
+    void resetHighWatermark() noexcept;
+
+    // Getters
+    /** Frames waiting, approximate when called concurrently */
+    size_t getSize() const noexcept;
+    size_t getCapacity() const noexcept;
+    Statistics getStatistics() const noexcept;
+
+private:
+    struct alignas(64) Slot
+    {
+        uint16_t length{ 0u };
+        uint8_t data[ETHERNET_MAX_FRAME_SIZE];
+    };
+
+    size_t const _mask;
+    std::unique_ptr<Slot[]> _slots;
+    alignas(64) std::atomic<size_t> _tail{ 0u };      /** Written by the producer */
+    size_t _cachedHead{ 0u };                          /** Producer's copy of _head */
+    std::atomic<uint32_t> _frames{ 0u }; /** 32 bits, the widest lock-free atomic on the ESP32 */
+    std::atomic<uint32_t> _drops{ 0u };
+    std::atomic<size_t> _highWatermark{ 0u };
+    alignas(64) std::atomic<size_t> _head{ 0u };      /** Written by the consumer */
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_FRAMERING_HPP_ */
@@ -0,0 +1,74 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_LINUXPACKETTRANSPORT_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_LINUXPACKETTRANSPORT_HPP_
+
+#pragma once
+
+#if defined(__linux__) && !defined(ESP_PLATFORM)
+
+#include <string>
+#include "networkTransport.hpp"
+
+// Sizing of the PACKET_MMAP rings (can be overridden from the build)
+#ifndef ATDECC_LINUX_RX_RING_FRAMES
+#define ATDECC_LINUX_RX_RING_FRAMES 1024
+#endif
+#ifndef ATDECC_LINUX_TX_RING_FRAMES
+#define ATDECC_LINUX_TX_RING_FRAMES 256
+#endif
+
+/**
+ * @brief NetworkTransport over a Linux AF_PACKET socket (needs CAP_NET_RAW).
+ * @details The socket only receives AVTP frames, through a PACKET_MMAP RX ring read without a
+ *          system call per frame. Frames are sent through a PACKET_MMAP TX ring: sendFrame()
+ *          only copies into the ring and flush() hands all the queued frames to the kernel at
+ *          once, sendFrame() flushing right away unless deferred flush is enabled.
+ */
+class LinuxPacketTransport final : public NetworkTransport
+{
+public:
+    static constexpr size_t RxRingFrames = ATDECC_LINUX_RX_RING_FRAMES;
+    static constexpr size_t TxRingFrames = ATDECC_LINUX_TX_RING_FRAMES;
+
+    explicit LinuxPacketTransport(std::string interfaceName) noexcept;
+    ~LinuxPacketTransport() noexcept override;
+
+    bool open() override;
+    void close() noexcept override;
+    bool sendFrame(const uint8_t* frame, size_t const length) override;
+    bool joinMulticast(MacAddress const& macAddress) override;
+    bool leaveMulticast(MacAddress const& macAddress) override;
+    size_t poll(std::chrono::milliseconds const timeout) override;
+
+    /** Hands the frames queued in the TX ring to the kernel. Returns false on error. */
+    bool flush() override;
+
+    // Setters
+    /** When enabled, sendFrame() only queues and the frames go out on flush() */
+    void setDeferredFlush(bool const deferred) noexcept;
+
+    // Getters
+    /** Socket, to wait for frames in an external event loop (readable when frames are in the RX ring) */
+    int getFileDescriptor() const noexcept;
+    uint64_t getRxDropCount() const noexcept;
+
+private:
+    bool setupRings();
+    bool setMembership(MacAddress const& macAddress, int const option);
+    size_t processRxRing();
+
+    std::string _interfaceName{};
+    int _socket{ -1 };
+    int _interfaceIndex{ 0 };
+    uint8_t* _ring{ nullptr };       /** RX ring followed by TX ring */
+    size_t _ringSize{ 0u };
+    size_t _frameSize{ 0u };
+    size_t _rxHead{ 0u };
+    size_t _txHead{ 0u };
+    size_t _txPending{ 0u };         /** Frames queued since the last flush */
+    bool _deferredFlush{ false };
+    uint64_t _rxDrops{ 0u };
+};
+
+#endif // __linux__ && !ESP_PLATFORM
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_LINUXPACKETTRANSPORT_HPP_ */
@@ -0,0 +1,56 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_LOCALIZEDSTRINGTABLE_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_LOCALIZEDSTRINGTABLE_HPP_
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include "entityModelTree.hpp"
+#include "entityModelTypes.hpp"
+
+/**
+ * @brief Flat lookup of the localized strings of the selected locale.
+ * @details Selecting a LOCALE builds an array indexed by LocalizedStringReference global
+ *          offset (offset * 7 + index) over all the STRINGS descriptors of that locale, so
+ *          resolving a reference is a single array access. The array points into the
+ *          ConfigurationTree, which must outlive the table. Switching locales only rewrites
+ *          the entries coming from other STRINGS descriptors, and STRINGS descriptors
+ *          loaded after the selection are added with updateStrings().
+ */
+class LocalizedStringTable
+{
+public:
+    static constexpr size_t StringsPerDescriptor = 7;
+
+    /** Selects a locale by LOCALE descriptor index. Returns false if it does not exist. */
+    bool selectLocale(ConfigurationTree const& tree, LocaleIndex const localeIndex);
+
+    /** Selects a locale by locale_identifier (eg. "en-US"), falling back to the same language. Returns false if none matches. */
+    bool selectLocale(ConfigurationTree const& tree, AtdeccFixedString const& localeID);
+
+    /** Refreshes the entries of a STRINGS descriptor, once loaded or changed in the tree */
+    void updateStrings(ConfigurationTree const& tree, StringsIndex const stringsIndex);
+
+    /** Forgets the selected locale (eg. before the tree is destroyed) */
+    void clear() noexcept;
+
+    // Getters
+    /** String of a reference in the selected locale, an empty string if invalid or not loaded */
+    AtdeccFixedString const& resolve(LocalizedStringReference const reference) const noexcept;
+    bool hasSelectedLocale() const noexcept;
+    LocaleIndex getSelectedLocale() const noexcept;
+    size_t getStringCount() const noexcept;
+
+private:
+    void setStrings(size_t const offset, StringsNodeModels const* strings) noexcept;
+
+    ConfigurationTree const* _tree{ nullptr };          /** Tree the entries point into */
+    std::vector<AtdeccFixedString const*> _strings{};  /** Global offset -> string, nullptr if not loaded */
+    std::vector<StringsIndex> _sources{};              /** Descriptor offset -> STRINGS descriptor the entries come from */
+    std::vector<bool> _loaded{};                       /** Descriptor offset -> entries set from the tree */
+    StringsIndex _baseStringsIndex{ 0u };
+    LocaleIndex _localeIndex{ 0u };
+    bool _selected{ false };
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_LOCALIZEDSTRINGTABLE_HPP_ */
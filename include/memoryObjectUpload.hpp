@@ -0,0 +1,160 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_MEMORYOBJECTUPLOAD_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_MEMORYOBJECTUPLOAD_HPP_
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include "entityAddressAccessSpace.hpp"
+#include "entityModelTypes.hpp"
+#include "protocolAecpdu.hpp"
+#include "protocolAemAecpdu.hpp"
+#include "protocolDefines.hpp"
+#include "uniqueIdentifier.hpp"
+
+// Size of each of the two upload buffers, a multiple of the flash sector size (can be overridden from the build)
+#ifndef ATDECC_UPLOAD_BUFFER_SIZE
+#define ATDECC_UPLOAD_BUFFER_SIZE 4096
+#endif
+#ifndef ATDECC_MAX_UPLOAD_MEMORY_OBJECTS
+#define ATDECC_MAX_UPLOAD_MEMORY_OBJECTS 2
+#endif
+
+/**
+ * @brief Address Access backend receiving a memory object upload.
+ * @details AA WRITE TLVs must arrive in address order. They are gathered in one
+ *          buffer while a writer thread stores the other one to the target backend,
+ *          so the network is not stalled by flash erase/write times.
+ *          A TLV already received (retry of a lost response) is acknowledged again.
+ */
+class AaUploadSink final : public AaMemoryBackend
+{
+public:
+    static constexpr size_t BufferSize = ATDECC_UPLOAD_BUFFER_SIZE;
+
+    explicit AaUploadSink(AaMemoryBackend& target);
+    ~AaUploadSink() override;
+
+    AaUploadSink(AaUploadSink const&) = delete;
+    AaUploadSink& operator=(AaUploadSink const&) = delete;
+
+    /** Starts receiving length bytes from offset 0 */
+    void begin(uint64_t const length);
+
+    /** Stores the data still buffered and waits for the writer. Returns the first write error, if any. */
+    AaCommandStatus finish();
+
+    /** Drops the buffered data and stops accepting writes */
+    void abort();
+
+    // AaMemoryBackend overrides
+    AaCommandStatus read(uint64_t const offset, void* data, size_t const length) override;
+    AaCommandStatus write(uint64_t const offset, const void* data, size_t const length) override;
+
+    // Getters
+    bool isActive() const;
+    uint64_t getReceivedLength() const;
+    uint64_t getExpectedLength() const;
+
+private:
+    void submit(std::unique_lock<std::mutex>& lock);
+    void waitWriterIdle(std::unique_lock<std::mutex>& lock);
+    void writerThread();
+
+    AaMemoryBackend& _target;
+    std::array<std::array<uint8_t, BufferSize>, 2> _buffers{};
+    size_t _activeBuffer{ 0u };    /** Buffer being filled */
+    size_t _activeLength{ 0u };    /** Bytes in the buffer being filled */
+    uint64_t _activeOffset{ 0u };  /** Target offset of the buffer being filled */
+    uint64_t _received{ 0u };      /** Guarded by _lock, like the other upload state */
+    uint64_t _expected{ 0u };
+    bool _active{ false };
+
+    // Shared with the writer thread
+    mutable std::mutex _lock{};
+    std::condition_variable _condition{};
+    bool _writePending{ false };
+    size_t _writeBuffer{ 0u };
+    size_t _writeLength{ 0u };
+    uint64_t _writeOffset{ 0u };
+    AaCommandStatus _writeStatus{ AaCommandStatus::Success };
+    bool _stop{ false };
+    std::thread _writer{};
+};
+
+/**
+ * @brief Entity side MEMORY_OBJECT upload operations.
+ * @details Handles START_OPERATION(Upload) and ABORT_OPERATION for the registered memory objects,
+ *          whose data is then written with Address Access to an AaUploadSink mapped at the
+ *          memory object start address. Progress is reported with OPERATION_STATUS to the
+ *          controller that started the operation.
+ */
+class MemoryObjectUploadEngine
+{
+public:
+    static constexpr size_t MaxMemoryObjects = ATDECC_MAX_UPLOAD_MEMORY_OBJECTS;
+
+    /** Called when an upload ends, successfully or not (eg. to switch the OTA boot partition) */
+    using UploadCompletedHandler = std::function<void(MemoryObjectIndex const memoryObjectIndex, AaCommandStatus const status)>;
+
+    MemoryObjectUploadEngine(UniqueIdentifier const entityID, AaAddressSpace& addressSpace, AecpSendHandler sendHandler, std::chrono::milliseconds const progressInterval = std::chrono::milliseconds{ 500 }) noexcept;
+
+    // Setters
+    void setUploadCompletedHandler(UploadCompletedHandler handler) noexcept;
+
+    /** Maps a memory object (start_address and maximum_length of its descriptor) to an upload sink */
+    bool addMemoryObject(MemoryObjectIndex const memoryObjectIndex, uint64_t const startAddress, uint64_t const maximumLength, AaUploadSink& sink) noexcept;
+
+    /** Handles SET_MEMORY_OBJECT_LENGTH, giving the size of the next upload */
+    AemCommandStatus setMemoryObjectLength(MemoryObjectIndex const memoryObjectIndex, uint64_t const length) noexcept;
+
+    /** Handles START_OPERATION. On success, operationID is set to the new operation. */
+    AemCommandStatus startOperation(UniqueIdentifier const controllerID, MacAddress const& controllerAddress, DescriptorType const descriptorType, DescriptorIndex const descriptorIndex, MemoryObjectOperationType const operationType, OperationID& operationID, AecpClock::time_point const now = AecpClock::now());
+
+    /** Handles ABORT_OPERATION */
+    AemCommandStatus abortOperation(DescriptorType const descriptorType, DescriptorIndex const descriptorIndex, OperationID const operationID);
+
+    /** Sends OPERATION_STATUS and completes the upload once all the data is received, to be called periodically */
+    void checkProgress(AecpClock::time_point const now = AecpClock::now());
+
+    // Getters
+    bool isUploading() const noexcept;
+
+private:
+    struct MemoryObject
+    {
+        MemoryObjectIndex index{ 0u };
+        uint64_t startAddress{ 0u };
+        uint64_t maximumLength{ 0u };
+        uint64_t length{ 0u };
+        AaUploadSink* sink{ nullptr };
+    };
+
+    MemoryObject* findMemoryObject(MemoryObjectIndex const memoryObjectIndex) noexcept;
+    void sendOperationStatus(uint16_t const percentComplete, AecpStatus const status);
+    void completeUpload(AaCommandStatus const status);
+
+    UniqueIdentifier _entityID{};
+    AaAddressSpace& _addressSpace;
+    AecpSendHandler _sendHandler{};
+    std::chrono::milliseconds _progressInterval{};
+    UploadCompletedHandler _uploadCompletedHandler{};
+    std::array<MemoryObject, MaxMemoryObjects> _memoryObjects{};
+    size_t _memoryObjectCount{ 0u };
+
+    // Current operation
+    MemoryObject* _uploading{ nullptr };
+    OperationID _operationID{ 0u };
+    OperationID _nextOperationID{ 1u };
+    UniqueIdentifier _controllerID{};
+    MacAddress _controllerAddress{};
+    AecpSequenceID _sequenceID{ 0u };
+    AecpClock::time_point _nextStatus{};
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_MEMORYOBJECTUPLOAD_HPP_ */
@@ -0,0 +1,122 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_MPMCQUEUE_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_MPMCQUEUE_HPP_
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief Bounded lock-free multi-producer multi-consumer queue.
+ * @details Each cell carries a sequence number telling producers and consumers whose turn it
+ *          is, so a push or a pop is one CAS on the position plus the copy, without lock.
+ *          The capacity is rounded up to a power of 2. Full and empty are reported, never
+ *          waited for.
+ */
+template<typename T>
+class MpmcQueue
+{
+public:
+    explicit MpmcQueue(size_t const capacity)
+        : _mask(roundUp(capacity) - 1u), _cells(new Cell[_mask + 1u])
+    {
+        for (auto i = size_t{ 0u }; i <= _mask; ++i)
+        {
+            _cells[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpmcQueue(MpmcQueue const&) = delete;
+    MpmcQueue& operator=(MpmcQueue const&) = delete;
+
+    /** Returns false if the queue is full */
+    template<typename U>
+    bool push(U&& value)
+    {
+        auto position = _enqueuePosition.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto& cell = _cells[position & _mask];
+            auto const sequence = cell.sequence.load(std::memory_order_acquire);
+            auto const diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+            if (diff == 0)
+            {
+                if (_enqueuePosition.compare_exchange_weak(position, position + 1u, std::memory_order_relaxed))
+                {
+                    cell.value = std::forward<U>(value);
+                    cell.sequence.store(position + 1u, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = _enqueuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    /** Returns false if the queue is empty */
+    bool pop(T& value)
+    {
+        auto position = _dequeuePosition.load(std::memory_order_relaxed);
+        for (;;)
+        {
+            auto& cell = _cells[position & _mask];
+            auto const sequence = cell.sequence.load(std::memory_order_acquire);
+            auto const diff = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1u);
+            if (diff == 0)
+            {
+                if (_dequeuePosition.compare_exchange_weak(position, position + 1u, std::memory_order_relaxed))
+                {
+                    value = std::move(cell.value);
+                    cell.sequence.store(position + _mask + 1u, std::memory_order_release);
+                    return true;
+                }
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                position = _dequeuePosition.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Getters
+    size_t capacity() const noexcept
+    {
+        return _mask + 1u;
+    }
+
+private:
+    struct Cell
+    {
+        std::atomic<size_t> sequence{ 0u };
+        T value{};
+    };
+
+    static size_t roundUp(size_t const capacity) noexcept
+    {
+        auto size = size_t{ 2u };
+        while (size < capacity)
+        {
+            size <<= 1u;
+        }
+        return size;
+    }
+
+    size_t const _mask;
+    std::unique_ptr<Cell[]> _cells;
+    alignas(64) std::atomic<size_t> _enqueuePosition{ 0u };
+    alignas(64) std::atomic<size_t> _dequeuePosition{ 0u };
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_MPMCQUEUE_HPP_ */
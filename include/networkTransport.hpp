@@ -0,0 +1,83 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_NETWORKTRANSPORT_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_NETWORKTRANSPORT_HPP_
+
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include "frameClassifier.hpp"
+#include "protocolDefines.hpp"
+
+/**
+ * @brief Network access of the stack, independent of the platform.
+ * @details Works on whole Ethernet frames (destination, source, EtherType, payload), as built
+ *          from EtherLayer2 and the PDU classes. Only AVTP frames (AVTP_ETHER_TYPE) are given to
+ *          the frame handler, and only those accepted by the FrameClassifier if one is set. Backends: EspNetworkTransport (esp_eth, endpoints on ESP32) and
+ *          LinuxPacketTransport (AF_PACKET with PACKET_MMAP rings, controllers on Linux).
+ */
+class NetworkTransport
+{
+public:
+    /** Called for each AVTP frame received, the frame is only valid during the call */
+    using FrameHandler = std::function<void(const uint8_t* frame, size_t const length)>;
+
+    virtual ~NetworkTransport() noexcept = default;
+
+    /** Opens the interface. Returns false on error (logged). */
+    virtual bool open() = 0;
+
+    /** Closes the interface, no frame is delivered afterwards */
+    virtual void close() noexcept = 0;
+
+    /** Sends an Ethernet frame (without FCS), padded to the minimum size if needed. Returns false if it was not queued. */
+    virtual bool sendFrame(const uint8_t* frame, size_t const length) = 0;
+
+    /** Receives the frames of a multicast group */
+    virtual bool joinMulticast(MacAddress const& macAddress) = 0;
+
+    /** Stops receiving the frames of a multicast group */
+    virtual bool leaveMulticast(MacAddress const& macAddress) = 0;
+
+    /**
+     * @brief Delivers the received frames to the frame handler.
+     * @details Waits up to timeout for the first frame. Backends receiving in their own task
+     *          (ESP-IDF) deliver from that task and return 0 right away.
+     * @return Number of frames delivered.
+     */
+    virtual size_t poll(std::chrono::milliseconds const timeout) = 0;
+
+    /** Hands the frames queued by sendFrame() to the driver, for backends batching their sends. Returns false on error. */
+    virtual bool flush();
+
+    /** Joins the ADP and ACMP multicast groups (Adpdu::Multicast_Mac_Address, Acmpdu::Multicast_Mac_Address) */
+    bool joinAtdeccMulticast();
+
+    // Setters
+    void setFrameHandler(FrameHandler handler) noexcept;
+    /** Drops the frames the classifier rejects before they reach the frame handler, nullptr to deliver all. Set before open(). */
+    void setFrameClassifier(FrameClassifier* classifier) noexcept;
+
+    // Getters
+    MacAddress const& getMacAddress() const noexcept;
+    bool isOpen() const noexcept;
+
+protected:
+    /** Gives a received frame to the handler if it is an AVTP frame accepted by the classifier. Returns true if delivered. */
+    bool dispatchFrame(const uint8_t* frame, size_t const length) const;
+
+    /** Runs the classifier on an AVTP frame, for backends classifying before queuing. True if accepted (or no classifier). */
+    bool acceptFrame(const uint8_t* frame, size_t const length) const;
+
+    /** Gives an AVTP frame already accepted to the handler. Returns true if delivered. */
+    bool deliverFrame(const uint8_t* frame, size_t const length) const;
+
+    MacAddress _macAddress{};
+    bool _open{ false };
+
+private:
+    FrameHandler _frameHandler{};
+    FrameClassifier* _frameClassifier{ nullptr };
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_NETWORKTRANSPORT_HPP_ */
@@ -0,0 +1,105 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_PCAPFILE_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_PCAPFILE_HPP_
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include "protocolDefines.hpp"
+
+/** Classic libpcap file format, Ethernet link type only */
+namespace pcap
+{
+static constexpr uint32_t Magic = 0xa1b2c3d4;            /* Microsecond timestamps */
+static constexpr uint32_t MagicNanoseconds = 0xa1b23c4d;
+static constexpr uint16_t VersionMajor = 2;
+static constexpr uint16_t VersionMinor = 4;
+static constexpr uint32_t LinkTypeEthernet = 1;
+static constexpr size_t FileHeaderLength = 24;
+static constexpr size_t RecordHeaderLength = 16;
+} // namespace pcap
+
+/**
+ * @brief Reads the frames of a pcap file, one at a time into an internal buffer.
+ * @details Both byte orders and both timestamp resolutions are accepted. Frames bigger than
+ *          ETHERNET_MAX_FRAME_SIZE are skipped (and counted), captures truncated by the snap
+ *          length are given as captured.
+ */
+class PcapReader
+{
+public:
+    using TimeStamp = std::chrono::nanoseconds; /** Since the epoch, as recorded */
+
+    PcapReader() noexcept = default;
+    ~PcapReader() noexcept;
+    PcapReader(PcapReader const&) = delete;
+    PcapReader& operator=(PcapReader const&) = delete;
+
+    /** Opens a file and reads its header. Returns false on error (logged). */
+    bool open(char const* path);
+
+    void close() noexcept;
+
+    /** Goes back to the first frame */
+    bool rewind();
+
+    /**
+     * @brief Reads the next frame.
+     * @param[out] frame Set to the frame, valid until the next call.
+     * @param[out] length Captured length of the frame.
+     * @param[out] timeStamp Time the frame was captured.
+     * @return false at the end of the file or on error.
+     */
+    bool readFrame(const uint8_t*& frame, size_t& length, TimeStamp& timeStamp);
+
+    // Getters
+    bool isOpen() const noexcept;
+    uint64_t getSkippedCount() const noexcept;
+
+private:
+    uint32_t toHost(uint32_t const value) const noexcept;
+
+    std::FILE* _file{ nullptr };
+    bool _swapped{ false };
+    bool _nanoseconds{ false };
+    uint64_t _skipped{ 0u };
+    std::array<uint8_t, ETHERNET_MAX_FRAME_SIZE> _buffer{};
+};
+
+/**
+ * @brief Writes frames to a pcap file (microsecond timestamps, host byte order).
+ * @details Frames can be written from several threads (eg. the receive task and the sender).
+ */
+class PcapWriter
+{
+public:
+    PcapWriter() noexcept = default;
+    ~PcapWriter() noexcept;
+    PcapWriter(PcapWriter const&) = delete;
+    PcapWriter& operator=(PcapWriter const&) = delete;
+
+    /** Creates (or truncates) a file and writes its header. Returns false on error (logged). */
+    bool open(char const* path);
+
+    void close() noexcept;
+
+    /** Writes a frame captured at timeStamp. Returns false if not open or on error. */
+    bool writeFrame(const uint8_t* frame, size_t const length, std::chrono::system_clock::time_point const timeStamp = std::chrono::system_clock::now());
+
+    /** Writes the buffered frames to the file */
+    void flush() noexcept;
+
+    // Getters
+    bool isOpen() const noexcept;
+    uint64_t getFrameCount() const noexcept;
+
+private:
+    mutable std::mutex _lock{};
+    std::FILE* _file{ nullptr };
+    uint64_t _frameCount{ 0u };
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_PCAPFILE_HPP_ */
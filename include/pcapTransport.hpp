@@ -0,0 +1,116 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_PCAPTRANSPORT_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_PCAPTRANSPORT_HPP_
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include "networkTransport.hpp"
+#include "pcapFile.hpp"
+
+/** Counters of a PcapReplayTransport */
+struct PcapReplayStatistics
+{
+    uint64_t frames{ 0u };      /** Read from the file */
+    uint64_t delivered{ 0u };   /** ADP, AECP and ACMP frames given to the frame handler */
+    uint64_t ignored{ 0u };     /** Other frames */
+    uint64_t bytes{ 0u };       /** Delivered */
+    uint64_t sent{ 0u };        /** Frames sent by the stack, only recorded */
+    uint32_t loops{ 0u };       /** Times the file was replayed to the end */
+};
+
+/**
+ * @brief NetworkTransport replaying the ATDECC frames of a pcap capture.
+ * @details Reproduces field traffic (eg. network storms) offline: the ADP, AECP and ACMP
+ *          frames of the file are given to the frame handler, VLAN tag removed, either at the
+ *          recorded pace or as fast as the stack decodes them, which measures its decode
+ *          throughput on real traffic. Frames sent by the stack go nowhere, but can be
+ *          recorded with setCaptureWriter(). No multicast filtering is done.
+ */
+class PcapReplayTransport final : public NetworkTransport
+{
+public:
+    enum class Speed
+    {
+        Recorded,   /** Frames are delivered with their recorded spacing, from the first poll */
+        Maximum,    /** Frames are delivered as fast as polled */
+    };
+
+    using Statistics = PcapReplayStatistics;
+
+    /** Maximum frames delivered by a poll in Speed::Maximum, so the caller keeps control */
+    static constexpr size_t MaxFramesPerPoll = 256;
+
+    /**
+     * @param[in] path pcap file to replay.
+     * @param[in] macAddress Address of the transport, as the stack would see it on the capture interface.
+     * @param[in] speed Replay pace.
+     * @param[in] loop Replays the file again once finished.
+     */
+    PcapReplayTransport(std::string path, MacAddress const& macAddress, Speed const speed = Speed::Recorded, bool const loop = false) noexcept;
+
+    bool open() override;
+    void close() noexcept override;
+    bool sendFrame(const uint8_t* frame, size_t const length) override;
+    bool joinMulticast(MacAddress const& macAddress) override;
+    bool leaveMulticast(MacAddress const& macAddress) override;
+    size_t poll(std::chrono::milliseconds const timeout) override;
+
+    // Setters
+    /** Records the frames sent by the stack, nullptr to stop */
+    void setCaptureWriter(PcapWriter* writer) noexcept;
+
+    // Getters
+    /** True once the whole file was replayed (never when looping) */
+    bool isFinished() const noexcept;
+    Statistics const& getStatistics() const noexcept;
+
+private:
+    /** Reads the next ATDECC frame into _frame, false at the end of the file */
+    bool readNext();
+
+    std::string _path{};
+    Speed _speed{ Speed::Recorded };
+    bool _loop{ false };
+    PcapReader _reader{};
+    PcapWriter* _captureWriter{ nullptr };
+    std::array<uint8_t, ETHERNET_MAX_FRAME_SIZE> _frame{};  /** Next frame to deliver, untagged */
+    size_t _frameLength{ 0u };
+    PcapReader::TimeStamp _frameTime{};
+    PcapReader::TimeStamp _firstFrameTime{};                /** Recorded time of the first frame of the file */
+    PcapReader::TimeStamp _lastFrameTime{};
+    PcapReader::TimeStamp _loopOffset{};                    /** Recorded duration of the previous loops */
+    std::chrono::steady_clock::time_point _start{};
+    bool _started{ false };
+    bool _pending{ false };                                 /** _frame holds a frame not delivered yet */
+    bool _passHasFrames{ false };                           /** ATDECC frames found since the file was (re)started */
+    bool _finished{ false };
+    Statistics _statistics{};
+};
+
+/**
+ * @brief Decorator recording all the frames sent and received through another transport.
+ * @details The wrapped transport must not be used directly while decorated (its frame handler
+ *          is taken over). Frames are recorded as seen by the stack, before padding.
+ */
+class PcapCaptureTransport final : public NetworkTransport
+{
+public:
+    PcapCaptureTransport(NetworkTransport& transport, PcapWriter& writer);
+
+    bool open() override;
+    void close() noexcept override;
+    bool sendFrame(const uint8_t* frame, size_t const length) override;
+    bool joinMulticast(MacAddress const& macAddress) override;
+    bool leaveMulticast(MacAddress const& macAddress) override;
+    size_t poll(std::chrono::milliseconds const timeout) override;
+    bool flush() override;
+
+private:
+    NetworkTransport& _transport;
+    PcapWriter& _writer;
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_PCAPTRANSPORT_HPP_ */
@@ -7,6 +7,8 @@
 #include "UniqueIdentifier.hpp"
 #include "entityAddressAccessTypes.hpp"
 #include "esp_log.h"  // ESP-IDF logging
+#include "endian.hpp"
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -17,6 +19,12 @@ public:
     static constexpr size_t HeaderLength = 2;        /* TlvCount */
     static constexpr size_t TlvHeaderLength = 10;    /* Mode + Length + Address */
 
+    /** Maximum data length of a single TLV fitting in an AECPDU of maximumLength bytes */
+    static constexpr size_t getMaximumTlvDataLength(size_t const maximumLength) noexcept
+    {
+        return maximumLength - Aecpdu::HEADER_LENGTH - HeaderLength - TlvHeaderLength;
+    }
+
     /**
      * @brief Factory method to create a new AaAecpdu.
      * @details Creates a new AaAecpdu as a unique pointer.
@@ -62,12 +70,57 @@ public:
         return _tlvData;
     }
 
+    /** Length of the serialized AA AECPDU, header included */
+    size_t getLength() const noexcept
+    {
+        return Aecpdu::HEADER_LENGTH + HeaderLength + _tlvDataLength;
+    }
+
     /** Serialize the AA AECPDU to a buffer */
     void serialize(uint8_t* buffer, size_t length) const override;
 
     /** Deserialize the AA AECPDU from a buffer */
     void deserialize(const uint8_t* buffer, size_t length) override;
 
+    /**
+     * @brief Decodes the TLVs of a serialized AA AECPDU without copying them.
+     * @details Calls handler(TlvView const&) for each TLV, the views point into buffer.
+     *          The handler can return false to stop the iteration.
+     * @param[in] buffer Serialized AA AECPDU, as given to deserialize().
+     * @param[in] length Length of the buffer.
+     * @return False if the buffer is malformed (in which case the handler was not called).
+     */
+    template<typename Handler>
+    static bool forEachTlv(const uint8_t* buffer, size_t length, Handler&& handler)
+    {
+        if (!validateTlvs(buffer, length))
+        {
+            return false;
+        }
+
+        uint16_t tlvCount;
+        memcpy(&tlvCount, buffer + Aecpdu::HEADER_LENGTH, sizeof(tlvCount));
+        tlvCount = ATDECC_UNPACK_WORD(tlvCount);
+        auto offset = Aecpdu::HEADER_LENGTH + HeaderLength;
+        for (uint16_t i = 0; i < tlvCount; ++i)
+        {
+            auto const tlv = decodeTlv(buffer + offset);
+            offset += TlvHeaderLength + tlv.size();
+            if constexpr (std::is_same_v<decltype(handler(tlv)), bool>)
+            {
+                if (!handler(tlv))
+                {
+                    break;
+                }
+            }
+            else
+            {
+                handler(tlv);
+            }
+        }
+        return true;
+    }
+
     /**
      * Construct a Response message to this Command.
      * Returns nullptr if the message is not a Command or if no Response is possible for this messageType.
@@ -87,6 +140,12 @@ private:
     /** Destroy method for COM-like interface */
     void destroy() noexcept ;
 
+    /** Checks that the TLVs of a serialized AA AECPDU fit in the buffer */
+    static bool validateTlvs(const uint8_t* buffer, size_t length) noexcept;
+
+    /** Decodes the TLV starting at ptr (bounds already checked) */
+    static TlvView decodeTlv(const uint8_t* ptr) noexcept;
+
     // Aa header data
     Tlvs _tlvData{};
 
@@ -23,6 +23,7 @@ using UniquePointer = std::unique_ptr<T, std::function<void(T*)>>;
 class Acmpdu {
 public:
     static constexpr size_t Length = 44; // ACMPDU size in bytes
+    static constexpr size_t ControlHeaderLength = 12; // AVTP control header preceding the ACMPDU (subtype to stream_id)
     static const MacAddress Multicast_Mac_Address; // Multicast MAC Address
 
     // Factory method to create a new Acmpdu UniquePointer
@@ -56,6 +57,7 @@ public:
     void setSequenceID(AcmpSequenceID sequenceID);
     void setFlags(uint16_t flags);
     void setStreamVlanID(uint16_t streamVlanID);
+    void setStreamID(UniqueIdentifier streamID);
 
     // Getters
     AcmpMessageType getMessageType() const;
@@ -70,11 +72,18 @@ public:
     AcmpSequenceID getSequenceID() const;
     uint16_t getFlags() const;
     uint16_t getStreamVlanID() const;
+    UniqueIdentifier getStreamID() const;
 
-    // Serialization and Deserialization
+    // Serialization and Deserialization of the ACMPDU (control data only)
     void serialize(uint8_t* buffer) const;
     void deserialize(const uint8_t* buffer, size_t length);
 
+    // Serialization and Deserialization of the AVTP control header and the ACMPDU (what follows the Ethernet header)
+    // The control header carries the message type, status and stream ID; returns the serialized length, 0 on error
+    size_t serializeControl(uint8_t* buffer, size_t length) const;
+    // Returns false if the buffer is not a complete ACMP frame
+    bool deserializeControl(const uint8_t* buffer, size_t length);
+
     // Copy method for cloning an Acmpdu
     UniquePointer<Acmpdu> copy() const;
 
@@ -92,6 +101,7 @@ private:
     AcmpSequenceID _sequenceID{ 0 };
     uint16_t _flags{ 0 };
     uint16_t _streamVlanID{ 0 };
+    UniqueIdentifier _streamID{}; // Carried in the AVTP control header, see serializeControl()
 
     // Private method for initializing a new ACMPDU
     static Acmpdu* createRawAcmpdu() noexcept;
@@ -4,6 +4,8 @@
 #pragma once
 
 #include <stdint.h>
+#include <chrono>
+#include <functional>
 #include <memory>
 #include "uniqueIdentifier.hpp" 
 #include "protocolDefines.hpp"
@@ -14,21 +16,26 @@ class Aecpdu
 public:
     static constexpr size_t HEADER_LENGTH = 20;  /* Updated AECPDU Header length */
     static constexpr size_t MAXIMUM_LENGTH_1722_1 = 524; /* Maximum payload size as per specification */
-#if defined(ALLOW_SEND_BIG_AECP_PAYLOADS) || defined(ALLOW_RECV_BIG_AECP_PAYLOADS)
-    static constexpr size_t MAXIMUM_LENGTH_BIG_PAYLOADS = 1500 - 14 - 20; 
-#else
-    static constexpr size_t MAXIMUM_LENGTH_BIG_PAYLOADS = MAXIMUM_LENGTH_1722_1;
-#endif
+    static constexpr size_t MAXIMUM_LENGTH_BIG_PAYLOADS = 1500 - 14 - 20; /* Buffers are always sized for big payloads, the limit of each message is chosen per peer */
+    /* ALLOW_SEND/RECV_BIG_AECP_PAYLOADS only select the defaults, used for peers not known by an AecpPayloadNegotiator */
 #if defined(ALLOW_SEND_BIG_AECP_PAYLOADS)
-    static constexpr size_t MAXIMUM_SEND_LENGTH = MAXIMUM_LENGTH_BIG_PAYLOADS;
+    static constexpr bool DEFAULT_SEND_BIG_PAYLOADS = true;
 #else
-    static constexpr size_t MAXIMUM_SEND_LENGTH = MAXIMUM_LENGTH_1722_1;
+    static constexpr bool DEFAULT_SEND_BIG_PAYLOADS = false;
 #endif
 #if defined(ALLOW_RECV_BIG_AECP_PAYLOADS)
-    static constexpr size_t MAXIMUM_RECV_LENGTH = MAXIMUM_LENGTH_BIG_PAYLOADS;
+    static constexpr bool DEFAULT_RECV_BIG_PAYLOADS = true;
 #else
-    static constexpr size_t MAXIMUM_RECV_LENGTH = MAXIMUM_LENGTH_1722_1;
+    static constexpr bool DEFAULT_RECV_BIG_PAYLOADS = false;
 #endif
+    static constexpr size_t MAXIMUM_SEND_LENGTH = DEFAULT_SEND_BIG_PAYLOADS ? MAXIMUM_LENGTH_BIG_PAYLOADS : MAXIMUM_LENGTH_1722_1;
+    static constexpr size_t MAXIMUM_RECV_LENGTH = DEFAULT_RECV_BIG_PAYLOADS ? MAXIMUM_LENGTH_BIG_PAYLOADS : MAXIMUM_LENGTH_1722_1;
+
+    /** Maximum length of one AECPDU, depending on the big payloads support of the peer */
+    static constexpr size_t getMaximumLength(bool const bigPayloads) noexcept
+    {
+        return bigPayloads ? MAXIMUM_LENGTH_BIG_PAYLOADS : MAXIMUM_LENGTH_1722_1;
+    }
 
 
     using UniquePointer = std::unique_ptr<Aecpdu, void (*)(Aecpdu*)>;
@@ -75,4 +82,23 @@ private:
 
 };
 
+using AecpClock = std::chrono::steady_clock;
+
+/** Called to put an AECPDU on the network, to the specified destination MAC address */
+using AecpSendHandler = std::function<void(Aecpdu const& aecpdu, MacAddress const& destAddress)>;
+
+/**
+ * @brief Returns the time to wait for the response to a command sent to an entity.
+ * @details The controller components sending commands (AaBulkTransfer, AaPipelinedUploader, AemCounterPoller,
+ *          AemMeterPoller) take one with setTimeoutHandler(), typically ControllerCommandScheduler::getTimeoutHandler()
+ *          for a timeout adapted to each target. Without one, they use the fixed timeout given to their constructor.
+ */
+using AecpTimeoutHandler = std::function<std::chrono::milliseconds(UniqueIdentifier const entityID)>;
+
+/** Response timeout of a command sent to entityID: from handler if set, fallback otherwise */
+inline std::chrono::milliseconds getAecpTimeout(AecpTimeoutHandler const& handler, UniqueIdentifier const entityID, std::chrono::milliseconds const fallback)
+{
+    return handler ? handler(entityID) : fallback;
+}
+
 #endif /* COMPONENTS_ATDECC_INCLUDE_PROTOCOLAECPDU_HPP_ */
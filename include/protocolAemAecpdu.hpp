@@ -13,12 +13,19 @@ class AemAecpdu final : public Aecpdu
 {
 public:
     static constexpr size_t HEADER_LENGTH = 2; /* Unsolicited + CommandType */
+    static constexpr size_t CONTROL_HEADER_LENGTH = 24; /* AVTP control header (subtype to target_entity_id) + ControllerEntityID + SequenceID + Unsolicited + CommandType */
     static constexpr size_t MAXIMUM_PAYLOAD_LENGTH_17221 = Aecpdu::MAXIMUM_LENGTH_1722_1 - Aecpdu::HEADER_LENGTH - HEADER_LENGTH;
     static constexpr size_t MAXIMUM_PAYLOAD_BUFFER_LENGTH = Aecpdu::MAXIMUM_LENGTH_BIG_PAYLOADS - Aecpdu::HEADER_LENGTH - HEADER_LENGTH;
     static constexpr size_t MAXIMUM_SEND_PAYLOAD_BUFFER_LENGTH = Aecpdu::MAXIMUM_SEND_LENGTH - Aecpdu::HEADER_LENGTH - HEADER_LENGTH;
     static constexpr size_t MAXIMUM_RECV_PAYLOAD_BUFFER_LENGTH = Aecpdu::MAXIMUM_RECV_LENGTH - Aecpdu::HEADER_LENGTH - HEADER_LENGTH;
     static_assert(MAXIMUM_PAYLOAD_BUFFER_LENGTH >= MAXIMUM_SEND_PAYLOAD_BUFFER_LENGTH && MAXIMUM_PAYLOAD_BUFFER_LENGTH >= MAXIMUM_RECV_PAYLOAD_BUFFER_LENGTH, "Incoherent constexpr values");
 
+    /** Maximum command specific data length fitting in an AECPDU of maximumLength bytes */
+    static constexpr size_t getMaximumPayloadLength(size_t const maximumLength) noexcept
+    {
+        return maximumLength - Aecpdu::HEADER_LENGTH - HEADER_LENGTH;
+    }
+
     using Payload = std::pair<const void*, size_t>;
 
     /**
@@ -51,6 +58,12 @@ public:
     /** Deserialize the AEM AECPDU from a buffer */
     void deserialize(const uint8_t* buffer, size_t length);
 
+    /** Serialize the AVTP control header and the AEM AECPDU as they go on the wire (what follows the Ethernet header), returns the serialized length, 0 on error */
+    size_t serializeControl(uint8_t* buffer, size_t length) const;
+
+    /** Deserialize the AVTP control header and the AEM AECPDU, returns false if the buffer is not a complete AEM frame */
+    bool deserializeControl(const uint8_t* buffer, size_t length);
+
     /** Construct a Response message to this Command (changing the messageType to Response kind) */
     UniquePointer responseCopy() const;
 
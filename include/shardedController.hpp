@@ -0,0 +1,124 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_SHARDEDCONTROLLER_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_SHARDEDCONTROLLER_HPP_
+
+#pragma once
+
+#if !defined(ESP_PLATFORM)
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+#include "frameRing.hpp"
+#include "mpmcQueue.hpp"
+#include "networkTransport.hpp"
+#include "protocolDefines.hpp"
+#include "spscQueue.hpp"
+#include "uniqueIdentifier.hpp"
+
+/** Setup of a ShardedController */
+struct ShardedControllerConfiguration
+{
+    size_t workerCount{ 4u };
+    size_t ringDepth{ 1024u };                             /** Frames per worker and direction */
+    size_t taskQueueDepth{ 256u };                         /** Posted tasks per worker */
+    std::chrono::milliseconds pollTimeout{ 1 };            /** Receive wait of the I/O thread, bounds the send latency */
+    std::chrono::microseconds idleSleep{ 50 };             /** Worker sleep when it has nothing to do */
+};
+
+/** Counters of a shard */
+struct ShardStatistics
+{
+    uint64_t frames{ 0u };      /** Handed to the worker */
+    uint64_t rxDrops{ 0u };     /** Received while the worker ring was full */
+    size_t rxHighWatermark{ 0u };
+    uint64_t sent{ 0u };
+    uint64_t txDrops{ 0u };     /** Sent while the I/O ring was full */
+};
+
+/**
+ * @brief Controller mode spreading the entity state machines over worker threads.
+ * @details Each worker owns the state of the entities hashed to its shard. The I/O thread owns
+ *          the transport: it classifies each received frame by entity ID (ADP entity_id, AECP
+ *          target_entity_id, ACMP listener_entity_id) and copies it into the FrameRing of the
+ *          owning worker, then sends the frames the workers queued in their own SPSC ring.
+ *          Nothing is shared between workers and no lock is taken, so enumeration and
+ *          monitoring scale with the cores. Work for an entity (eg. starting its enumeration)
+ *          is posted to its shard with post().
+ */
+class ShardedController
+{
+public:
+    using Configuration = ShardedControllerConfiguration;
+    using Statistics = ShardStatistics;
+
+    /** Called on the worker thread owning the entity of the frame, the frame is only valid during the call */
+    using FrameHandler = std::function<void(size_t const shard, const uint8_t* frame, size_t const length)>;
+    using Task = std::function<void()>;
+
+    ShardedController(NetworkTransport& transport, FrameHandler handler, Configuration const& configuration = Configuration{});
+    /** Stops the threads */
+    ~ShardedController() noexcept;
+    ShardedController(ShardedController const&) = delete;
+    ShardedController& operator=(ShardedController const&) = delete;
+
+    /** Opens the transport, joins the ATDECC groups and starts the I/O and worker threads */
+    bool start();
+
+    void stop() noexcept;
+
+    /** Runs a task on the worker owning an entity, from any thread. Returns false if its queue is full. */
+    bool post(UniqueIdentifier const entityID, Task task);
+
+    /** Queues a frame to send. Worker thread of that shard only. Returns false if the ring is full. */
+    bool sendFrame(size_t const shard, const uint8_t* frame, size_t const length);
+
+    /** Shard owning an entity, among shardCount */
+    static size_t getShard(UniqueIdentifier const entityID, size_t const shardCount) noexcept;
+
+    // Getters
+    size_t getShardCount() const noexcept;
+    Statistics getStatistics(size_t const shard) const noexcept;
+    /** Frames that are not ADP, AECP or ACMP, or too short to classify */
+    uint64_t getUnclassifiedCount() const noexcept;
+
+private:
+    struct Frame
+    {
+        uint16_t length{ 0u };
+        std::array<uint8_t, ETHERNET_MAX_FRAME_SIZE> data{};
+    };
+
+    struct alignas(64) Shard
+    {
+        Shard(size_t const ringDepth, size_t const taskQueueDepth);
+
+        FrameRing rx;
+        SpscQueue<Frame> tx;
+        MpmcQueue<Task> tasks;
+        std::thread thread{};
+        std::atomic<uint64_t> frames{ 0u };
+        std::atomic<uint64_t> sent{ 0u };
+        std::atomic<uint64_t> txDrops{ 0u };
+    };
+
+    void dispatch(const uint8_t* frame, size_t const length);
+    void runIo();
+    void runWorker(size_t const index);
+
+    NetworkTransport& _transport;
+    FrameHandler _handler{};
+    Configuration _configuration{};
+    std::vector<std::unique_ptr<Shard>> _shards{};
+    std::thread _ioThread{};
+    std::atomic<bool> _running{ false };
+    std::atomic<uint64_t> _unclassified{ 0u };
+};
+
+#endif // !ESP_PLATFORM
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_SHARDEDCONTROLLER_HPP_ */
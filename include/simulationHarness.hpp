@@ -0,0 +1,76 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_SIMULATIONHARNESS_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_SIMULATIONHARNESS_HPP_
+
+#pragma once
+
+#if !defined(ESP_PLATFORM)
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "virtualNetwork.hpp"
+
+/** Model of the simulated entities, all built from the same one */
+struct SimulationEntityModel
+{
+    uint64_t entityModelID{ 0x001b92fffe000001ull };
+    uint16_t talkerStreamSources{ 1u };
+    uint16_t listenerStreamSinks{ 1u };
+    uint16_t descriptorCount{ 16u };   /** Descriptors read by the controller to enumerate an entity */
+    uint16_t descriptorLength{ 64u };  /** Size of each descriptor */
+};
+
+/** Parameters of a simulation run */
+struct SimulationConfiguration
+{
+    size_t entityCount{ 100u };
+    SimulationEntityModel model{};
+    VirtualNetworkConfiguration network{};
+    size_t workerThreads{ 2u };                              /** Threads running the entities, the controller runs in the caller */
+    size_t window{ 16u };                                    /** Entities enumerated and streams connected in parallel by the controller */
+    std::chrono::milliseconds commandTimeout{ 250 };         /** Before the controller resends an ACMP command, and the initial AECP timeout (adaptive afterwards) */
+    std::chrono::milliseconds timeout{ 30000 };              /** Of the whole run */
+};
+
+/** Measurements of a simulation run, durations from the start of the run */
+struct SimulationResults
+{
+    size_t entityCount{ 0u };
+    size_t discovered{ 0u };
+    size_t enumerated{ 0u };
+    size_t connected{ 0u };
+    std::chrono::microseconds adpConvergence{ 0 };  /** All the entities discovered */
+    std::chrono::microseconds enumeration{ 0 };     /** All the entities enumerated, after convergence */
+    std::chrono::microseconds connectAverage{ 0 };  /** CONNECT_RX command to response */
+    std::chrono::microseconds connectP99{ 0 };
+    std::chrono::microseconds connectMaximum{ 0 };
+    uint32_t commandRetries{ 0u };
+    uint32_t streamIdMismatches{ 0u };             /** CONNECT_RX responses not carrying the talker stream ID */
+    VirtualNetworkStatistics network{};
+    bool completed{ false };
+};
+
+/**
+ * @brief Load test of the stack with many entities and one controller in a single process.
+ * @details Runs entityCount entities built from a model on a VirtualNetwork (ADP advertising,
+ *          AEM READ_DESCRIPTOR, ACMP talker and listener state machines) and one controller
+ *          that discovers them, enumerates them and connects a stream of each one to the next
+ *          one, measuring each phase. The frames are built by the PDU classes and the controller
+ *          sends its commands through a ControllerCommandScheduler. Host builds only.
+ */
+class SimulationHarness
+{
+public:
+    using Configuration = SimulationConfiguration;
+    using Results = SimulationResults;
+
+    /** Runs one simulation */
+    static Results run(Configuration const& configuration);
+
+    /** Runs the same simulation for each entity count, to see how the stack scales */
+    static std::vector<Results> runScaling(Configuration const& configuration, std::vector<size_t> const& entityCounts);
+};
+
+#endif // !ESP_PLATFORM
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_SIMULATIONHARNESS_HPP_ */
@@ -0,0 +1,131 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_SPSCQUEUE_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_SPSCQUEUE_HPP_
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <utility>
+
+/**
+ * @brief Bounded lock-free single-producer single-consumer queue.
+ * @details Each side owns its position on its own cache line and keeps a cached copy of the
+ *          other side's position, only reloaded when the queue looks full (producer) or empty
+ *          (consumer), so the cores rarely share a line. Slots are allocated once: claim() /
+ *          publish() and front() / release() work in place, without copying the element.
+ *          The capacity is rounded up to a power of 2.
+ */
+template<typename T>
+class SpscQueue
+{
+public:
+    explicit SpscQueue(size_t const capacity)
+        : _mask(roundUp(capacity) - 1u), _slots(new T[_mask + 1u])
+    {
+    }
+
+    SpscQueue(SpscQueue const&) = delete;
+    SpscQueue& operator=(SpscQueue const&) = delete;
+
+    /** Producer: slot to fill before publish(), nullptr if the queue is full */
+    T* claim() noexcept
+    {
+        auto const tail = _tail.load(std::memory_order_relaxed);
+        if (tail - _cachedHead > _mask)
+        {
+            _cachedHead = _head.load(std::memory_order_acquire);
+            if (tail - _cachedHead > _mask)
+            {
+                return nullptr;
+            }
+        }
+        return &_slots[tail & _mask];
+    }
+
+    /** Producer: makes the claimed slot visible to the consumer */
+    void publish() noexcept
+    {
+        _tail.store(_tail.load(std::memory_order_relaxed) + 1u, std::memory_order_release);
+    }
+
+    /** Producer: returns false if the queue is full */
+    template<typename U>
+    bool push(U&& value)
+    {
+        auto* const slot = claim();
+        if (slot == nullptr)
+        {
+            return false;
+        }
+        *slot = std::forward<U>(value);
+        publish();
+        return true;
+    }
+
+    /** Consumer: oldest element, nullptr if the queue is empty */
+    T* front() noexcept
+    {
+        auto const head = _head.load(std::memory_order_relaxed);
+        if (head == _cachedTail)
+        {
+            _cachedTail = _tail.load(std::memory_order_acquire);
+            if (head == _cachedTail)
+            {
+                return nullptr;
+            }
+        }
+        return &_slots[head & _mask];
+    }
+
+    /** Consumer: frees the slot returned by front() */
+    void release() noexcept
+    {
+        _head.store(_head.load(std::memory_order_relaxed) + 1u, std::memory_order_release);
+    }
+
+    /** Consumer: returns false if the queue is empty */
+    bool pop(T& value)
+    {
+        auto* const slot = front();
+        if (slot == nullptr)
+        {
+            return false;
+        }
+        value = std::move(*slot);
+        release();
+        return true;
+    }
+
+    // Getters
+    /** Approximate when called concurrently */
+    size_t size() const noexcept
+    {
+        return _tail.load(std::memory_order_acquire) - _head.load(std::memory_order_acquire);
+    }
+
+    size_t capacity() const noexcept
+    {
+        return _mask + 1u;
+    }
+
+private:
+    static size_t roundUp(size_t const capacity) noexcept
+    {
+        auto size = size_t{ 2u };
+        while (size < capacity)
+        {
+            size <<= 1u;
+        }
+        return size;
+    }
+
+    size_t const _mask;
+    std::unique_ptr<T[]> _slots;
+    alignas(64) std::atomic<size_t> _tail{ 0u };  /** Written by the producer */
+    size_t _cachedHead{ 0u };                      /** Producer's copy of _head */
+    alignas(64) std::atomic<size_t> _head{ 0u };  /** Written by the consumer */
+    size_t _cachedTail{ 0u };                      /** Consumer's copy of _tail */
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_SPSCQUEUE_HPP_ */
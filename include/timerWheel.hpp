@@ -0,0 +1,85 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_TIMERWHEEL_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_TIMERWHEEL_HPP_
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+/**
+ * @brief Hierarchical timer wheel, in ticks (the caller chooses the tick duration).
+ * @details Levels of 64 slots, each slot of a level covering a whole turn of the level below,
+ *          so any delay up to 64^Levels ticks is handled. Starting and cancelling a timer is
+ *          O(1): timers come from a pool allocated once and are linked into their slot. When
+ *          a level wraps, the timers of the next slot of the level above are spread into it.
+ *          A bitmap per level finds the next non empty slot without scanning. Not thread safe.
+ */
+class TimerWheel
+{
+public:
+    using TimerId = uint32_t;       /** Generation (16 bits) and pool index (16 bits), 0 is never used */
+    using Callback = std::function<void()>;
+    using Tick = uint64_t;
+
+    static constexpr TimerId InvalidTimer = 0u;
+    static constexpr size_t SlotBits = 6;
+    static constexpr size_t SlotsPerLevel = size_t{ 1u } << SlotBits;
+    static constexpr size_t Levels = 4;
+    static constexpr Tick MaxDelay = (Tick{ 1u } << (SlotBits * Levels)) - 1u;
+    static constexpr Tick NoTimer = ~Tick{ 0u };
+
+    /** capacity: maximum number of running timers (at most 65535) */
+    explicit TimerWheel(size_t const capacity, Tick const now = 0u);
+
+    /** Starts a timer firing delay ticks after the current tick (at least one). Returns InvalidTimer if the pool is exhausted. */
+    TimerId start(Tick const delay, Callback callback);
+
+    /** Cancels a timer. Returns false if it already fired or was cancelled. */
+    bool cancel(TimerId const timerId) noexcept;
+
+    /** Moves to tick now, firing the expired timers in order. Callbacks can start and cancel timers. Returns the number fired. */
+    size_t advance(Tick const now);
+
+    // Getters
+    /** Ticks from the current tick until the wheel must be advanced (a timer may only be cascaded then), NoTimer if none */
+    Tick getTicksToNextEvent() const noexcept;
+    Tick getCurrentTick() const noexcept;
+    size_t getActiveCount() const noexcept;
+    size_t getCapacity() const noexcept;
+
+private:
+    static constexpr uint16_t NoEntry = 0xffff;
+
+    struct Entry
+    {
+        Callback callback{};
+        Tick expiry{ 0u };
+        uint16_t previous{ NoEntry };
+        uint16_t next{ NoEntry };   /** Also links the free entries */
+        uint16_t generation{ 1u };
+        uint8_t level{ 0u };
+        uint8_t slot{ 0u };
+        bool active{ false };
+    };
+
+    struct Level
+    {
+        std::array<uint16_t, SlotsPerLevel> heads{};
+        uint64_t occupied{ 0u };    /** Bit per non empty slot */
+    };
+
+    void link(uint16_t const index) noexcept;
+    void unlink(uint16_t const index) noexcept;
+    void cascade(size_t const level);
+    size_t expireSlot(size_t const slot);
+
+    std::vector<Entry> _entries{};
+    std::array<Level, Levels> _levels{};
+    Tick _currentTick{ 0u };
+    uint16_t _freeHead{ NoEntry };
+    size_t _activeCount{ 0u };
+};
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_TIMERWHEEL_HPP_ */
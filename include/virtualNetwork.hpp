@@ -0,0 +1,143 @@
+#ifndef COMPONENTS_ATDECC_INCLUDE_VIRTUALNETWORK_HPP_
+#define COMPONENTS_ATDECC_INCLUDE_VIRTUALNETWORK_HPP_
+
+#pragma once
+
+#if !defined(ESP_PLATFORM)
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <queue>
+#include <shared_mutex>
+#include <vector>
+#include "mpmcQueue.hpp"
+#include "networkTransport.hpp"
+#include "protocolDefines.hpp"
+
+// Sizing of the virtual network (can be overridden from the build)
+#ifndef ATDECC_VIRTUAL_NETWORK_QUEUE_DEPTH
+#define ATDECC_VIRTUAL_NETWORK_QUEUE_DEPTH 256
+#endif
+#ifndef ATDECC_VIRTUAL_NETWORK_MAX_GROUPS
+#define ATDECC_VIRTUAL_NETWORK_MAX_GROUPS 4
+#endif
+
+class VirtualNetworkTransport;
+
+/** Behavior of a VirtualNetwork */
+struct VirtualNetworkConfiguration
+{
+    std::chrono::microseconds latency{ 0 };
+    std::chrono::microseconds jitter{ 0 };         /** Random extra latency, up to this value */
+    double lossRate{ 0.0 };                        /** Probability of dropping a frame for a receiver */
+    double reorderRate{ 0.0 };                     /** Probability of delaying a frame behind the next ones */
+    std::chrono::microseconds reorderDelay{ 500 }; /** Extra latency of a reordered frame */
+    uint64_t seed{ 1u };
+};
+
+/** Counters of a VirtualNetwork */
+struct VirtualNetworkStatistics
+{
+    uint64_t sent{ 0u };
+    uint64_t delivered{ 0u };   /** Queued to a receiver (a multicast frame counts once per receiver) */
+    uint64_t lost{ 0u };        /** Dropped by the loss rate */
+    uint64_t reordered{ 0u };
+    uint64_t overflows{ 0u };   /** Dropped because a receiver queue was full */
+};
+
+/**
+ * @brief In-process Ethernet segment, to run many entities and controllers in one process.
+ * @details Frames sent by a VirtualNetworkTransport are copied once and shared by all their
+ *          receivers: the one owning the destination MAC for unicast, every endpoint that
+ *          joined the group for multicast. Each receiver has a lock-free MPMC queue, so any
+ *          thread can send. Latency, jitter, loss and reordering are applied per receiver.
+ */
+class VirtualNetwork
+{
+public:
+    using Configuration = VirtualNetworkConfiguration;
+    using Statistics = VirtualNetworkStatistics;
+
+    explicit VirtualNetwork(Configuration const& configuration = Configuration{}) noexcept;
+
+    // Getters
+    Configuration const& getConfiguration() const noexcept;
+    Statistics getStatistics() const noexcept;
+
+private:
+    friend class VirtualNetworkTransport;
+
+    struct Frame
+    {
+        std::shared_ptr<std::vector<uint8_t> const> data{};
+        std::chrono::steady_clock::time_point deliverAt{};
+    };
+
+    void attach(VirtualNetworkTransport& endpoint);
+    void detach(VirtualNetworkTransport& endpoint);
+    bool updateMembership(VirtualNetworkTransport& endpoint, MacAddress const& group, bool const join);
+    bool send(VirtualNetworkTransport const& source, const uint8_t* frame, size_t const length);
+    void enqueue(VirtualNetworkTransport& receiver, std::shared_ptr<std::vector<uint8_t> const> const& data, std::chrono::steady_clock::time_point const now);
+    uint64_t nextRandom() noexcept;
+
+    Configuration _configuration{};
+    mutable std::shared_mutex _endpointsLock{};          /** Endpoints and memberships change rarely, sends only read them */
+    std::vector<VirtualNetworkTransport*> _endpoints{};
+    std::atomic<uint64_t> _randomState{ 0u };
+    std::atomic<uint64_t> _sent{ 0u };
+    std::atomic<uint64_t> _delivered{ 0u };
+    std::atomic<uint64_t> _lost{ 0u };
+    std::atomic<uint64_t> _reordered{ 0u };
+    std::atomic<uint64_t> _overflows{ 0u };
+};
+
+/**
+ * @brief NetworkTransport attached to a VirtualNetwork.
+ * @details Frames are delivered by poll(), from a single thread per transport. Senders only push
+ *          to the lock-free queue, nothing wakes the receiver: poll() with a timeout checks the
+ *          queue every PollInterval, the simulation loops poll without a timeout and sleep when idle.
+ */
+class VirtualNetworkTransport final : public NetworkTransport
+{
+public:
+    static constexpr size_t QueueDepth = ATDECC_VIRTUAL_NETWORK_QUEUE_DEPTH;
+    static constexpr size_t MaxGroups = ATDECC_VIRTUAL_NETWORK_MAX_GROUPS;
+    static constexpr auto PollInterval = std::chrono::microseconds{ 50 };
+
+    VirtualNetworkTransport(VirtualNetwork& network, MacAddress const& macAddress);
+    ~VirtualNetworkTransport() noexcept override;
+
+    bool open() override;
+    void close() noexcept override;
+    bool sendFrame(const uint8_t* frame, size_t const length) override;
+    bool joinMulticast(MacAddress const& macAddress) override;
+    bool leaveMulticast(MacAddress const& macAddress) override;
+    size_t poll(std::chrono::milliseconds const timeout) override;
+
+private:
+    friend class VirtualNetwork;
+
+    struct LaterFirst
+    {
+        bool operator()(VirtualNetwork::Frame const& lhs, VirtualNetwork::Frame const& rhs) const noexcept
+        {
+            return lhs.deliverAt > rhs.deliverAt;
+        }
+    };
+
+    bool isMember(MacAddress const& group) const noexcept;
+    size_t deliverDue(std::chrono::steady_clock::time_point const now);
+
+    VirtualNetwork& _network;
+    MpmcQueue<VirtualNetwork::Frame> _queue{ QueueDepth };
+    std::array<MacAddress, MaxGroups> _groups{};        /** Guarded by the network endpoints lock */
+    size_t _groupCount{ 0u };
+    std::priority_queue<VirtualNetwork::Frame, std::vector<VirtualNetwork::Frame>, LaterFirst> _pending{}; /** Received, not due yet (poll thread only) */
+};
+
+#endif // !ESP_PLATFORM
+
+#endif /* COMPONENTS_ATDECC_INCLUDE_VIRTUALNETWORK_HPP_ */
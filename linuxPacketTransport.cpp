@@ -0,0 +1,319 @@
+#include "linuxPacketTransport.hpp"
+
+#if defined(__linux__) && !defined(ESP_PLATFORM)
+
+#include "esp_log.h"
+#include "protocolAvtpdu.hpp"
+#include "serialization.hpp"
+#include <arpa/inet.h>
+#include <cerrno>
+#include <cstring>
+#include <linux/if_packet.h>
+#include <net/ethernet.h>
+#include <net/if.h>
+#include <poll.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <utility>
+
+static const char* TAG = "TRANSPORT_LINUX";
+
+/** Ring frame: tpacket2_hdr + sockaddr_ll + Ethernet frame, a power of 2 so blocks hold whole frames */
+static constexpr size_t RingFrameSize = 2048u;
+/** Ring block, several frames per block */
+static constexpr size_t RingBlockSize = 1u << 16;
+/** Minimum Ethernet frame without FCS */
+static constexpr size_t MinimumFrameLength = EtherLayer2::Length + EthernetPayloadMinimumSize;
+
+static_assert(TPACKET2_HDRLEN + ETHERNET_MAX_FRAME_SIZE <= RingFrameSize, "A ring frame must hold a maximum size Ethernet frame");
+static_assert((LinuxPacketTransport::RxRingFrames % (RingBlockSize / RingFrameSize)) == 0u, "RX ring frames must fill whole blocks");
+static_assert((LinuxPacketTransport::TxRingFrames % (RingBlockSize / RingFrameSize)) == 0u, "TX ring frames must fill whole blocks");
+
+/***********************************************************/
+/* LinuxPacketTransport class definition                   */
+/***********************************************************/
+
+LinuxPacketTransport::LinuxPacketTransport(std::string interfaceName) noexcept
+    : _interfaceName(std::move(interfaceName))
+{
+}
+
+LinuxPacketTransport::~LinuxPacketTransport() noexcept
+{
+    close();
+}
+
+bool LinuxPacketTransport::open()
+{
+    if (_open)
+    {
+        return true;
+    }
+
+    _socket = ::socket(AF_PACKET, SOCK_RAW, htons(AVTP_ETHER_TYPE));
+    if (_socket < 0)
+    {
+        ESP_LOGE(TAG, "Cannot create the AF_PACKET socket: %s", std::strerror(errno));
+        return false;
+    }
+
+    ifreq ifr{};
+    std::strncpy(ifr.ifr_name, _interfaceName.c_str(), IFNAMSIZ - 1);
+    if (::ioctl(_socket, SIOCGIFINDEX, &ifr) < 0)
+    {
+        ESP_LOGE(TAG, "Unknown interface %s: %s", _interfaceName.c_str(), std::strerror(errno));
+        close();
+        return false;
+    }
+    _interfaceIndex = ifr.ifr_ifindex;
+    if (::ioctl(_socket, SIOCGIFHWADDR, &ifr) < 0)
+    {
+        ESP_LOGE(TAG, "Cannot get the MAC address of %s: %s", _interfaceName.c_str(), std::strerror(errno));
+        close();
+        return false;
+    }
+    std::memcpy(_macAddress.data(), ifr.ifr_hwaddr.sa_data, _macAddress.size());
+
+    if (!setupRings())
+    {
+        close();
+        return false;
+    }
+
+    sockaddr_ll address{};
+    address.sll_family = AF_PACKET;
+    address.sll_protocol = htons(AVTP_ETHER_TYPE);
+    address.sll_ifindex = _interfaceIndex;
+    if (::bind(_socket, reinterpret_cast<sockaddr*>(&address), sizeof(address)) < 0)
+    {
+        ESP_LOGE(TAG, "Cannot bind to %s: %s", _interfaceName.c_str(), std::strerror(errno));
+        close();
+        return false;
+    }
+
+#ifdef PACKET_IGNORE_OUTGOING
+    // Linux 4.20 and later: do not queue our own frames at all (processRxRing() filters them otherwise)
+    auto const ignoreOutgoing = int{ 1 };
+    if (::setsockopt(_socket, SOL_PACKET, PACKET_IGNORE_OUTGOING, &ignoreOutgoing, sizeof(ignoreOutgoing)) < 0)
+    {
+        ESP_LOGD(TAG, "PACKET_IGNORE_OUTGOING not supported: %s", std::strerror(errno));
+    }
+#endif
+
+    _open = true;
+    ESP_LOGI(TAG, "Opened %s, MAC %02x:%02x:%02x:%02x:%02x:%02x", _interfaceName.c_str(), _macAddress[0], _macAddress[1], _macAddress[2], _macAddress[3], _macAddress[4], _macAddress[5]);
+    return true;
+}
+
+void LinuxPacketTransport::close() noexcept
+{
+    _open = false;
+    if (_ring != nullptr)
+    {
+        ::munmap(_ring, _ringSize);
+        _ring = nullptr;
+        _ringSize = 0u;
+    }
+    if (_socket >= 0)
+    {
+        ::close(_socket);
+        _socket = -1;
+    }
+    _rxHead = 0u;
+    _txHead = 0u;
+    _txPending = 0u;
+}
+
+bool LinuxPacketTransport::sendFrame(const uint8_t* frame, size_t const length)
+{
+    if (!_open || frame == nullptr || length < EtherLayer2::Length || length > ETHERNET_MAX_FRAME_SIZE)
+    {
+        return false;
+    }
+
+    auto* const slot = _ring + (RxRingFrames + _txHead) * _frameSize;
+    auto* const header = reinterpret_cast<tpacket2_hdr*>(slot);
+    if (header->tp_status != TP_STATUS_AVAILABLE)
+    {
+        // Ring full: push what is queued, the frame is dropped if the kernel did not free the slot yet
+        flush();
+        if (header->tp_status != TP_STATUS_AVAILABLE)
+        {
+            ESP_LOGW(TAG, "TX ring full");
+            return false;
+        }
+    }
+
+    auto* const data = slot + TPACKET2_HDRLEN - sizeof(sockaddr_ll);
+    auto const frameLength = std::max(length, MinimumFrameLength);
+    std::memcpy(data, frame, length);
+    if (frameLength > length)
+    {
+        std::memset(data + length, 0, frameLength - length);
+    }
+    header->tp_len = static_cast<uint32_t>(frameLength);
+    __atomic_store_n(&header->tp_status, TP_STATUS_SEND_REQUEST, __ATOMIC_RELEASE);
+
+    _txHead = (_txHead + 1u) % TxRingFrames;
+    ++_txPending;
+    return _deferredFlush || flush();
+}
+
+bool LinuxPacketTransport::flush()
+{
+    if (!_open || _txPending == 0u)
+    {
+        return true;
+    }
+    _txPending = 0u;
+    if (::send(_socket, nullptr, 0, MSG_DONTWAIT) < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+    {
+        ESP_LOGW(TAG, "TX ring flush failed: %s", std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+bool LinuxPacketTransport::joinMulticast(MacAddress const& macAddress)
+{
+    return setMembership(macAddress, PACKET_ADD_MEMBERSHIP);
+}
+
+bool LinuxPacketTransport::leaveMulticast(MacAddress const& macAddress)
+{
+    return setMembership(macAddress, PACKET_DROP_MEMBERSHIP);
+}
+
+size_t LinuxPacketTransport::poll(std::chrono::milliseconds const timeout)
+{
+    if (!_open)
+    {
+        return 0u;
+    }
+    auto delivered = processRxRing();
+    if (delivered == 0u && timeout.count() > 0)
+    {
+        pollfd descriptor{ _socket, POLLIN, 0 };
+        if (::poll(&descriptor, 1, static_cast<int>(timeout.count())) > 0)
+        {
+            delivered = processRxRing();
+        }
+    }
+    return delivered;
+}
+
+void LinuxPacketTransport::setDeferredFlush(bool const deferred) noexcept
+{
+    _deferredFlush = deferred;
+}
+
+int LinuxPacketTransport::getFileDescriptor() const noexcept
+{
+    return _socket;
+}
+
+uint64_t LinuxPacketTransport::getRxDropCount() const noexcept
+{
+    return _rxDrops;
+}
+
+bool LinuxPacketTransport::setupRings()
+{
+    auto version = int{ TPACKET_V2 };
+    if (::setsockopt(_socket, SOL_PACKET, PACKET_VERSION, &version, sizeof(version)) < 0)
+    {
+        ESP_LOGE(TAG, "TPACKET_V2 not supported: %s", std::strerror(errno));
+        return false;
+    }
+
+    auto const framesPerBlock = RingBlockSize / RingFrameSize;
+    tpacket_req rxRequest{};
+    rxRequest.tp_block_size = RingBlockSize;
+    rxRequest.tp_frame_size = RingFrameSize;
+    rxRequest.tp_frame_nr = RxRingFrames;
+    rxRequest.tp_block_nr = RxRingFrames / framesPerBlock;
+    tpacket_req txRequest = rxRequest;
+    txRequest.tp_frame_nr = TxRingFrames;
+    txRequest.tp_block_nr = TxRingFrames / framesPerBlock;
+
+    if (::setsockopt(_socket, SOL_PACKET, PACKET_RX_RING, &rxRequest, sizeof(rxRequest)) < 0 || ::setsockopt(_socket, SOL_PACKET, PACKET_TX_RING, &txRequest, sizeof(txRequest)) < 0)
+    {
+        ESP_LOGE(TAG, "Cannot create the PACKET_MMAP rings: %s", std::strerror(errno));
+        return false;
+    }
+
+    // Both rings in one mapping, RX first
+    _frameSize = RingFrameSize;
+    _ringSize = (rxRequest.tp_block_nr + txRequest.tp_block_nr) * RingBlockSize;
+    auto* const ring = ::mmap(nullptr, _ringSize, PROT_READ | PROT_WRITE, MAP_SHARED, _socket, 0);
+    if (ring == MAP_FAILED)
+    {
+        ESP_LOGE(TAG, "Cannot map the PACKET_MMAP rings: %s", std::strerror(errno));
+        _ringSize = 0u;
+        return false;
+    }
+    _ring = static_cast<uint8_t*>(ring);
+    return true;
+}
+
+bool LinuxPacketTransport::setMembership(MacAddress const& macAddress, int const option)
+{
+    if (_socket < 0)
+    {
+        return false;
+    }
+    packet_mreq request{};
+    request.mr_ifindex = _interfaceIndex;
+    request.mr_type = PACKET_MR_MULTICAST;
+    request.mr_alen = static_cast<unsigned short>(macAddress.size());
+    std::memcpy(request.mr_address, macAddress.data(), macAddress.size());
+    if (::setsockopt(_socket, SOL_PACKET, option, &request, sizeof(request)) < 0)
+    {
+        ESP_LOGE(TAG, "Cannot change multicast membership: %s", std::strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+size_t LinuxPacketTransport::processRxRing()
+{
+    auto delivered = size_t{ 0u };
+    // Bounded to one turn of the ring, so a flood cannot keep the caller here
+    for (auto i = size_t{ 0u }; i < RxRingFrames; ++i)
+    {
+        auto* const slot = _ring + _rxHead * _frameSize;
+        auto* const header = reinterpret_cast<tpacket2_hdr*>(slot);
+        auto const status = __atomic_load_n(&header->tp_status, __ATOMIC_ACQUIRE);
+        if ((status & TP_STATUS_USER) == 0u)
+        {
+            break;
+        }
+        if ((status & TP_STATUS_LOSING) != 0u)
+        {
+            tpacket_stats stats{};
+            auto statsLength = socklen_t{ sizeof(stats) };
+            if (::getsockopt(_socket, SOL_PACKET, PACKET_STATISTICS, &stats, &statsLength) == 0)
+            {
+                _rxDrops += stats.tp_drops;
+            }
+        }
+
+        // Our own frames are looped back by the kernel when PACKET_IGNORE_OUTGOING is not supported.
+        // Filtered on the packet type: other stations may use the same MAC address (eg. in a test setup)
+        auto const* const frame = slot + header->tp_mac;
+        auto const* const address = reinterpret_cast<const sockaddr_ll*>(slot + TPACKET_ALIGN(sizeof(tpacket2_hdr)));
+        if (header->tp_snaplen >= EtherLayer2::Length && address->sll_pkttype != PACKET_OUTGOING)
+        {
+            dispatchFrame(frame, header->tp_snaplen);
+            ++delivered;
+        }
+
+        __atomic_store_n(&header->tp_status, TP_STATUS_KERNEL, __ATOMIC_RELEASE);
+        _rxHead = (_rxHead + 1u) % RxRingFrames;
+    }
+    return delivered;
+}
+
+#endif // __linux__ && !ESP_PLATFORM
@@ -0,0 +1,154 @@
+#include "localizedStringTable.hpp"
+#include "esp_log.h"
+#include <cstring>
+
+static const char* TAG = "LOCALIZED_STRINGS";
+
+/** Returned for invalid or not loaded references, so resolve() never fails */
+static const AtdeccFixedString EmptyString{};
+
+/** Length of the language part of a locale_identifier ("en" of "en-US") */
+static size_t getLanguageLength(AtdeccFixedString const& localeID) noexcept
+{
+    auto const* const data = localeID.data();
+    auto length = size_t{ 0u };
+    while (length < localeID.size() && data[length] != '\0' && data[length] != '-' && data[length] != '_')
+    {
+        ++length;
+    }
+    return length;
+}
+
+/***********************************************************/
+/* LocalizedStringTable class definition                   */
+/***********************************************************/
+
+bool LocalizedStringTable::selectLocale(ConfigurationTree const& tree, LocaleIndex const localeIndex)
+{
+    auto const localeIt = tree.localeModels.find(localeIndex);
+    if (localeIt == tree.localeModels.end())
+    {
+        ESP_LOGW(TAG, "Locale %u not found", localeIndex);
+        return false;
+    }
+
+    auto const& locale = localeIt->second.staticModel;
+    auto const descriptorCount = static_cast<size_t>(locale.numberOfStringDescriptors);
+    auto const previousCount = _tree == &tree ? _sources.size() : size_t{ 0u };
+
+    // Sized to this locale: shrinking keeps the capacity, so only a locale bigger than all the previous ones allocates
+    _sources.resize(descriptorCount);
+    _loaded.resize(descriptorCount, false);
+    _strings.resize(descriptorCount * StringsPerDescriptor, nullptr);
+
+    for (auto offset = size_t{ 0u }; offset < descriptorCount; ++offset)
+    {
+        auto const stringsIndex = static_cast<StringsIndex>(locale.baseStringDescriptorIndex + offset);
+        // STRINGS descriptors shared with the previous locale are kept as is
+        if (offset < previousCount && _loaded[offset] && _sources[offset] == stringsIndex)
+        {
+            continue;
+        }
+        _sources[offset] = stringsIndex;
+        auto const stringsIt = tree.stringsModels.find(stringsIndex);
+        setStrings(offset, stringsIt != tree.stringsModels.end() ? &stringsIt->second : nullptr);
+    }
+
+    _tree = &tree;
+    _baseStringsIndex = locale.baseStringDescriptorIndex;
+    _localeIndex = localeIndex;
+    _selected = true;
+    return true;
+}
+
+bool LocalizedStringTable::selectLocale(ConfigurationTree const& tree, AtdeccFixedString const& localeID)
+{
+    auto const languageLength = getLanguageLength(localeID);
+    auto languageMatch = tree.localeModels.end();
+
+    for (auto it = tree.localeModels.begin(); it != tree.localeModels.end(); ++it)
+    {
+        auto const& candidate = it->second.staticModel.localeID;
+        if (candidate == localeID)
+        {
+            return selectLocale(tree, it->first);
+        }
+        if (languageMatch == tree.localeModels.end() && languageLength != 0u && getLanguageLength(candidate) == languageLength && std::memcmp(candidate.data(), localeID.data(), languageLength) == 0)
+        {
+            languageMatch = it;
+        }
+    }
+
+    if (languageMatch == tree.localeModels.end())
+    {
+        ESP_LOGW(TAG, "No locale matching %.*s", static_cast<int>(localeID.size()), localeID.data());
+        return false;
+    }
+    return selectLocale(tree, languageMatch->first);
+}
+
+void LocalizedStringTable::updateStrings(ConfigurationTree const& tree, StringsIndex const stringsIndex)
+{
+    if (!_selected || _tree != &tree || stringsIndex < _baseStringsIndex)
+    {
+        return;
+    }
+    auto const offset = static_cast<size_t>(stringsIndex - _baseStringsIndex);
+    if (offset >= _sources.size())
+    {
+        return;
+    }
+    auto const stringsIt = tree.stringsModels.find(stringsIndex);
+    setStrings(offset, stringsIt != tree.stringsModels.end() ? &stringsIt->second : nullptr);
+}
+
+void LocalizedStringTable::clear() noexcept
+{
+    _strings.clear();
+    _sources.clear();
+    _loaded.clear();
+    _tree = nullptr;
+    _baseStringsIndex = 0u;
+    _localeIndex = 0u;
+    _selected = false;
+}
+
+AtdeccFixedString const& LocalizedStringTable::resolve(LocalizedStringReference const reference) const noexcept
+{
+    if (!reference.isValid())
+    {
+        return EmptyString;
+    }
+    auto const [offset, index] = reference.getOffsetIndex();
+    auto const globalOffset = static_cast<size_t>(offset) * StringsPerDescriptor + index;
+    if (globalOffset >= _strings.size() || _strings[globalOffset] == nullptr)
+    {
+        return EmptyString;
+    }
+    return *_strings[globalOffset];
+}
+
+bool LocalizedStringTable::hasSelectedLocale() const noexcept
+{
+    return _selected;
+}
+
+LocaleIndex LocalizedStringTable::getSelectedLocale() const noexcept
+{
+    return _localeIndex;
+}
+
+size_t LocalizedStringTable::getStringCount() const noexcept
+{
+    return _strings.size();
+}
+
+void LocalizedStringTable::setStrings(size_t const offset, StringsNodeModels const* strings) noexcept
+{
+    auto* const entries = _strings.data() + offset * StringsPerDescriptor;
+    for (auto i = size_t{ 0u }; i < StringsPerDescriptor; ++i)
+    {
+        entries[i] = strings != nullptr ? &strings->staticModel.strings[i] : nullptr;
+    }
+    _loaded[offset] = strings != nullptr;
+}
@@ -0,0 +1,376 @@
+#include "memoryObjectUpload.hpp"
+#include "protocolAemPayloads.hpp"
+#include "esp_log.h"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+static const char* TAG = "MO_UPLOAD";
+
+/***********************************************************/
+/* AaUploadSink class definition                           */
+/***********************************************************/
+
+AaUploadSink::AaUploadSink(AaMemoryBackend& target)
+    : _target(target)
+{
+    _writer = std::thread(&AaUploadSink::writerThread, this);
+}
+
+AaUploadSink::~AaUploadSink()
+{
+    {
+        std::lock_guard<std::mutex> lock(_lock);
+        _stop = true;
+    }
+    _condition.notify_all();
+    _writer.join();
+}
+
+void AaUploadSink::begin(uint64_t const length)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    waitWriterIdle(lock);
+
+    _activeBuffer = 0u;
+    _activeLength = 0u;
+    _activeOffset = 0u;
+    _received = 0u;
+    _expected = length;
+    _writeStatus = AaCommandStatus::Success;
+    _active = true;
+
+    _target.beginWrite();
+}
+
+AaCommandStatus AaUploadSink::finish()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    if (!_active)
+    {
+        return AaCommandStatus::Unsupported;
+    }
+    if (_activeLength != 0u)
+    {
+        submit(lock);
+    }
+    waitWriterIdle(lock);
+    _active = false;
+    return _writeStatus;
+}
+
+void AaUploadSink::abort()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    waitWriterIdle(lock);
+    _active = false;
+    _activeLength = 0u;
+}
+
+AaCommandStatus AaUploadSink::read(uint64_t const offset, void* data, size_t const length)
+{
+    return _target.read(offset, data, length);
+}
+
+AaCommandStatus AaUploadSink::write(uint64_t const offset, const void* data, size_t const length)
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    if (!_active)
+    {
+        return AaCommandStatus::Unsupported;
+    }
+    if (_writeStatus != AaCommandStatus::Success)
+    {
+        return _writeStatus;
+    }
+    // Retry of an already stored TLV
+    if (offset + length <= _received)
+    {
+        return AaCommandStatus::Success;
+    }
+    if (offset != _received)
+    {
+        ESP_LOGW(TAG, "Out of order upload data at 0x%llx, expecting 0x%llx", static_cast<unsigned long long>(offset), static_cast<unsigned long long>(_received));
+        return AaCommandStatus::DataInvalid;
+    }
+    if (length > _expected - _received)
+    {
+        return AaCommandStatus::AddressInvalid;
+    }
+
+    auto const* ptr = static_cast<const uint8_t*>(data);
+    auto remaining = length;
+    while (remaining != 0u)
+    {
+        auto const chunk = std::min(remaining, BufferSize - _activeLength);
+        std::memcpy(_buffers[_activeBuffer].data() + _activeLength, ptr, chunk);
+        _activeLength += chunk;
+        ptr += chunk;
+        remaining -= chunk;
+        if (_activeLength == BufferSize)
+        {
+            submit(lock);
+        }
+    }
+    _received += length;
+
+    return AaCommandStatus::Success;
+}
+
+bool AaUploadSink::isActive() const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _active;
+}
+
+uint64_t AaUploadSink::getReceivedLength() const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _received;
+}
+
+uint64_t AaUploadSink::getExpectedLength() const
+{
+    std::lock_guard<std::mutex> lock(_lock);
+    return _expected;
+}
+
+void AaUploadSink::submit(std::unique_lock<std::mutex>& lock)
+{
+    // Only blocks if the target is slower than the network for two buffers in a row
+    waitWriterIdle(lock);
+
+    _writeBuffer = _activeBuffer;
+    _writeLength = _activeLength;
+    _writeOffset = _activeOffset;
+    _writePending = true;
+    _condition.notify_all();
+
+    _activeBuffer ^= 1u;
+    _activeOffset += _activeLength;
+    _activeLength = 0u;
+}
+
+void AaUploadSink::waitWriterIdle(std::unique_lock<std::mutex>& lock)
+{
+    _condition.wait(lock, [this]()
+    {
+        return !_writePending;
+    });
+}
+
+void AaUploadSink::writerThread()
+{
+    std::unique_lock<std::mutex> lock(_lock);
+    while (true)
+    {
+        _condition.wait(lock, [this]()
+        {
+            return _writePending || _stop;
+        });
+        if (!_writePending)
+        {
+            return;
+        }
+
+        auto const* const buffer = _buffers[_writeBuffer].data();
+        auto const length = _writeLength;
+        auto const offset = _writeOffset;
+
+        lock.unlock();
+        auto const status = _target.write(offset, buffer, length);
+        lock.lock();
+
+        if (status != AaCommandStatus::Success && _writeStatus == AaCommandStatus::Success)
+        {
+            ESP_LOGE(TAG, "Failed to store upload data at 0x%llx", static_cast<unsigned long long>(offset));
+            _writeStatus = status;
+        }
+        _writePending = false;
+        _condition.notify_all();
+    }
+}
+
+/***********************************************************/
+/* MemoryObjectUploadEngine class definition               */
+/***********************************************************/
+
+MemoryObjectUploadEngine::MemoryObjectUploadEngine(UniqueIdentifier const entityID, AaAddressSpace& addressSpace, AecpSendHandler sendHandler, std::chrono::milliseconds const progressInterval) noexcept
+    : _entityID(entityID), _addressSpace(addressSpace), _sendHandler(std::move(sendHandler)), _progressInterval(progressInterval)
+{
+}
+
+void MemoryObjectUploadEngine::setUploadCompletedHandler(UploadCompletedHandler handler) noexcept
+{
+    _uploadCompletedHandler = std::move(handler);
+}
+
+bool MemoryObjectUploadEngine::addMemoryObject(MemoryObjectIndex const memoryObjectIndex, uint64_t const startAddress, uint64_t const maximumLength, AaUploadSink& sink) noexcept
+{
+    if (_memoryObjectCount == MaxMemoryObjects || findMemoryObject(memoryObjectIndex) != nullptr)
+    {
+        ESP_LOGE(TAG, "Cannot add memory object %u", memoryObjectIndex);
+        return false;
+    }
+    if (!_addressSpace.addRegion(startAddress, maximumLength, sink))
+    {
+        return false;
+    }
+    _memoryObjects[_memoryObjectCount++] = MemoryObject{ memoryObjectIndex, startAddress, maximumLength, 0u, &sink };
+    return true;
+}
+
+AemCommandStatus MemoryObjectUploadEngine::setMemoryObjectLength(MemoryObjectIndex const memoryObjectIndex, uint64_t const length) noexcept
+{
+    auto* memoryObject = findMemoryObject(memoryObjectIndex);
+    if (memoryObject == nullptr)
+    {
+        return AemCommandStatus::NoSuchDescriptor;
+    }
+    if (length > memoryObject->maximumLength)
+    {
+        return AemCommandStatus::BadArguments;
+    }
+    if (memoryObject == _uploading)
+    {
+        return AemCommandStatus::InProgress;
+    }
+    memoryObject->length = length;
+    return AemCommandStatus::Success;
+}
+
+AemCommandStatus MemoryObjectUploadEngine::startOperation(UniqueIdentifier const controllerID, MacAddress const& controllerAddress, DescriptorType const descriptorType, DescriptorIndex const descriptorIndex, MemoryObjectOperationType const operationType, OperationID& operationID, AecpClock::time_point const now)
+{
+    if (descriptorType != DescriptorType::MemoryObject || operationType != MemoryObjectOperationType::Upload)
+    {
+        return AemCommandStatus::NotImplemented;
+    }
+    auto* memoryObject = findMemoryObject(descriptorIndex);
+    if (memoryObject == nullptr)
+    {
+        return AemCommandStatus::NoSuchDescriptor;
+    }
+    if (_uploading != nullptr)
+    {
+        return AemCommandStatus::NoResources;
+    }
+    if (memoryObject->length == 0u)
+    {
+        ESP_LOGW(TAG, "Upload started without SET_MEMORY_OBJECT_LENGTH");
+        return AemCommandStatus::BadArguments;
+    }
+
+    memoryObject->sink->begin(memoryObject->length);
+    _uploading = memoryObject;
+    _operationID = _nextOperationID++;
+    if (_nextOperationID == 0u)
+    {
+        _nextOperationID = 1u;
+    }
+    _controllerID = controllerID;
+    _controllerAddress = controllerAddress;
+    _nextStatus = now + _progressInterval;
+
+    ESP_LOGI(TAG, "Upload of %llu bytes to memory object %u started (operation %u)", static_cast<unsigned long long>(memoryObject->length), memoryObject->index, _operationID);
+    operationID = _operationID;
+    return AemCommandStatus::Success;
+}
+
+AemCommandStatus MemoryObjectUploadEngine::abortOperation(DescriptorType const descriptorType, DescriptorIndex const descriptorIndex, OperationID const operationID)
+{
+    if (_uploading == nullptr || descriptorType != DescriptorType::MemoryObject || descriptorIndex != _uploading->index || operationID != _operationID)
+    {
+        return AemCommandStatus::BadArguments;
+    }
+
+    ESP_LOGI(TAG, "Upload to memory object %u aborted", _uploading->index);
+    _uploading->sink->abort();
+    auto const index = _uploading->index;
+    _uploading = nullptr;
+    if (_uploadCompletedHandler)
+    {
+        _uploadCompletedHandler(index, AaCommandStatus::Aborted);
+    }
+    return AemCommandStatus::Success;
+}
+
+void MemoryObjectUploadEngine::checkProgress(AecpClock::time_point const now)
+{
+    if (_uploading == nullptr)
+    {
+        return;
+    }
+
+    auto const received = _uploading->sink->getReceivedLength();
+    if (received >= _uploading->length)
+    {
+        completeUpload(_uploading->sink->finish());
+        return;
+    }
+
+    if (now >= _nextStatus)
+    {
+        // 0 to 1000 in tenths of percent, 1000 being kept for the completion
+        auto const percentComplete = static_cast<uint16_t>(std::min<uint64_t>(999u, received * 1000u / _uploading->length));
+        sendOperationStatus(percentComplete, AecpStatus::SUCCESS);
+        _nextStatus = now + _progressInterval;
+    }
+}
+
+bool MemoryObjectUploadEngine::isUploading() const noexcept
+{
+    return _uploading != nullptr;
+}
+
+MemoryObjectUploadEngine::MemoryObject* MemoryObjectUploadEngine::findMemoryObject(MemoryObjectIndex const memoryObjectIndex) noexcept
+{
+    for (size_t i = 0u; i < _memoryObjectCount; ++i)
+    {
+        if (_memoryObjects[i].index == memoryObjectIndex)
+        {
+            return &_memoryObjects[i];
+        }
+    }
+    return nullptr;
+}
+
+void MemoryObjectUploadEngine::sendOperationStatus(uint16_t const percentComplete, AecpStatus const status)
+{
+    if (!_sendHandler)
+    {
+        return;
+    }
+
+    auto const ser = serializeOperationStatusResponse(DescriptorType::MemoryObject, _uploading->index, _operationID, percentComplete);
+
+    AemAecpdu message{ true };
+    message.setTargetEntityID(_entityID);
+    message.setControllerEntityID(_controllerID);
+    message.setSequenceID(_sequenceID++);
+    message.setStatus(status);
+    message.setUnsolicited(true);
+    message.setCommandType(AemCommandType::OPERATION_STATUS);
+    message.setCommandSpecificData(ser.data(), ser.size());
+    _sendHandler(message, _controllerAddress);
+}
+
+void MemoryObjectUploadEngine::completeUpload(AaCommandStatus const status)
+{
+    auto const index = _uploading->index;
+    if (status == AaCommandStatus::Success)
+    {
+        ESP_LOGI(TAG, "Upload to memory object %u complete", index);
+        sendOperationStatus(1000u, AecpStatus::SUCCESS);
+    }
+    else
+    {
+        ESP_LOGE(TAG, "Upload to memory object %u failed", index);
+        sendOperationStatus(0u, AecpStatus::ENTITY_MISBEHAVING);
+    }
+    _uploading = nullptr;
+
+    if (_uploadCompletedHandler)
+    {
+        _uploadCompletedHandler(index, status);
+    }
+}
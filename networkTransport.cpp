@@ -0,0 +1,82 @@
+#include "networkTransport.hpp"
+#include "protocolAcmpdu.hpp"
+#include "protocolAdpdu.hpp"
+#include "protocolAvtpdu.hpp"
+#include "esp_log.h"
+#include <utility>
+
+static const char* TAG = "TRANSPORT";
+
+/***********************************************************/
+/* NetworkTransport class definition                       */
+/***********************************************************/
+
+bool NetworkTransport::joinAtdeccMulticast()
+{
+    if (!joinMulticast(Adpdu::Multicast_Mac_Address))
+    {
+        ESP_LOGE(TAG, "Cannot join the ADP multicast group");
+        return false;
+    }
+    // Same group in the current standard, only joined once
+    if (Acmpdu::Multicast_Mac_Address != Adpdu::Multicast_Mac_Address && !joinMulticast(Acmpdu::Multicast_Mac_Address))
+    {
+        ESP_LOGE(TAG, "Cannot join the ACMP multicast group");
+        return false;
+    }
+    return true;
+}
+
+bool NetworkTransport::flush()
+{
+    return true;
+}
+
+void NetworkTransport::setFrameHandler(FrameHandler handler) noexcept
+{
+    _frameHandler = std::move(handler);
+}
+
+void NetworkTransport::setFrameClassifier(FrameClassifier* classifier) noexcept
+{
+    _frameClassifier = classifier;
+}
+
+MacAddress const& NetworkTransport::getMacAddress() const noexcept
+{
+    return _macAddress;
+}
+
+bool NetworkTransport::isOpen() const noexcept
+{
+    return _open;
+}
+
+bool NetworkTransport::dispatchFrame(const uint8_t* frame, size_t const length) const
+{
+    if (frame == nullptr || length < EtherLayer2::Length)
+    {
+        return false;
+    }
+    auto const etherType = static_cast<uint16_t>((frame[12] << 8) | frame[13]);
+    if (etherType != AVTP_ETHER_TYPE || !acceptFrame(frame, length))
+    {
+        return false;
+    }
+    return deliverFrame(frame, length);
+}
+
+bool NetworkTransport::acceptFrame(const uint8_t* frame, size_t const length) const
+{
+    return _frameClassifier == nullptr || _frameClassifier->classify(frame, length) == FrameVerdict::Accept;
+}
+
+bool NetworkTransport::deliverFrame(const uint8_t* frame, size_t const length) const
+{
+    if (!_frameHandler)
+    {
+        return false;
+    }
+    _frameHandler(frame, length);
+    return true;
+}
@@ -0,0 +1,229 @@
+#include "pcapFile.hpp"
+#include "endian.hpp"
+#include "esp_log.h"
+#include <cstring>
+
+static const char* TAG = "PCAP";
+
+/** File header: magic, version_major, version_minor, thiszone, sigfigs, snaplen, network */
+struct PcapFileHeader
+{
+    uint32_t magic;
+    uint16_t versionMajor;
+    uint16_t versionMinor;
+    int32_t thisZone;
+    uint32_t sigFigs;
+    uint32_t snapLength;
+    uint32_t linkType;
+};
+static_assert(sizeof(PcapFileHeader) == pcap::FileHeaderLength, "Unexpected pcap file header size");
+
+/** Record header: ts_sec, ts_usec (or ts_nsec), incl_len, orig_len */
+struct PcapRecordHeader
+{
+    uint32_t seconds;
+    uint32_t fraction;
+    uint32_t capturedLength;
+    uint32_t originalLength;
+};
+static_assert(sizeof(PcapRecordHeader) == pcap::RecordHeaderLength, "Unexpected pcap record header size");
+
+/***********************************************************/
+/* PcapReader class definition                             */
+/***********************************************************/
+
+PcapReader::~PcapReader() noexcept
+{
+    close();
+}
+
+bool PcapReader::open(char const* path)
+{
+    close();
+    _file = std::fopen(path, "rb");
+    if (_file == nullptr)
+    {
+        ESP_LOGE(TAG, "Cannot open %s", path);
+        return false;
+    }
+
+    auto header = PcapFileHeader{};
+    if (std::fread(&header, sizeof(header), 1u, _file) != 1u)
+    {
+        ESP_LOGE(TAG, "%s: truncated header", path);
+        close();
+        return false;
+    }
+    auto const swappedMagic = endianSwap<Endianness::LittleEndian, Endianness::BigEndian, uint32_t>(header.magic);
+    _swapped = header.magic != pcap::Magic && header.magic != pcap::MagicNanoseconds;
+    auto const magic = _swapped ? swappedMagic : header.magic;
+    if (magic != pcap::Magic && magic != pcap::MagicNanoseconds)
+    {
+        ESP_LOGE(TAG, "%s: not a pcap file (pcapng is not supported)", path);
+        close();
+        return false;
+    }
+    _nanoseconds = magic == pcap::MagicNanoseconds;
+    if (toHost(header.linkType) != pcap::LinkTypeEthernet)
+    {
+        ESP_LOGE(TAG, "%s: link type %u is not Ethernet", path, toHost(header.linkType));
+        close();
+        return false;
+    }
+    _skipped = 0u;
+    return true;
+}
+
+void PcapReader::close() noexcept
+{
+    if (_file != nullptr)
+    {
+        std::fclose(_file);
+        _file = nullptr;
+    }
+}
+
+bool PcapReader::rewind()
+{
+    return _file != nullptr && std::fseek(_file, static_cast<long>(pcap::FileHeaderLength), SEEK_SET) == 0;
+}
+
+bool PcapReader::readFrame(const uint8_t*& frame, size_t& length, TimeStamp& timeStamp)
+{
+    if (_file == nullptr)
+    {
+        return false;
+    }
+
+    auto record = PcapRecordHeader{};
+    while (std::fread(&record, sizeof(record), 1u, _file) == 1u)
+    {
+        auto const capturedLength = toHost(record.capturedLength);
+        if (capturedLength > _buffer.size())
+        {
+            // Not an ATDECC frame anyway
+            ++_skipped;
+            if (std::fseek(_file, static_cast<long>(capturedLength), SEEK_CUR) != 0)
+            {
+                return false;
+            }
+            continue;
+        }
+        if (std::fread(_buffer.data(), 1u, capturedLength, _file) != capturedLength)
+        {
+            ESP_LOGW(TAG, "Truncated last record");
+            return false;
+        }
+        auto const fraction = std::chrono::nanoseconds{ toHost(record.fraction) };
+        timeStamp = std::chrono::seconds{ toHost(record.seconds) } + (_nanoseconds ? fraction : fraction * 1000);
+        frame = _buffer.data();
+        length = capturedLength;
+        return true;
+    }
+    return false;
+}
+
+bool PcapReader::isOpen() const noexcept
+{
+    return _file != nullptr;
+}
+
+uint64_t PcapReader::getSkippedCount() const noexcept
+{
+    return _skipped;
+}
+
+uint32_t PcapReader::toHost(uint32_t const value) const noexcept
+{
+    return _swapped ? endianSwap<Endianness::LittleEndian, Endianness::BigEndian, uint32_t>(value) : value;
+}
+
+/***********************************************************/
+/* PcapWriter class definition                             */
+/***********************************************************/
+
+PcapWriter::~PcapWriter() noexcept
+{
+    close();
+}
+
+bool PcapWriter::open(char const* path)
+{
+    std::lock_guard<std::mutex> const lg{ _lock };
+    if (_file != nullptr)
+    {
+        std::fclose(_file);
+    }
+    _file = std::fopen(path, "wb");
+    if (_file == nullptr)
+    {
+        ESP_LOGE(TAG, "Cannot create %s", path);
+        return false;
+    }
+
+    auto const header = PcapFileHeader{ pcap::Magic, pcap::VersionMajor, pcap::VersionMinor, 0, 0u, ETHERNET_MAX_FRAME_SIZE, pcap::LinkTypeEthernet };
+    if (std::fwrite(&header, sizeof(header), 1u, _file) != 1u)
+    {
+        ESP_LOGE(TAG, "Cannot write to %s", path);
+        std::fclose(_file);
+        _file = nullptr;
+        return false;
+    }
+    _frameCount = 0u;
+    return true;
+}
+
+void PcapWriter::close() noexcept
+{
+    std::lock_guard<std::mutex> const lg{ _lock };
+    if (_file != nullptr)
+    {
+        std::fclose(_file);
+        _file = nullptr;
+    }
+}
+
+bool PcapWriter::writeFrame(const uint8_t* frame, size_t const length, std::chrono::system_clock::time_point const timeStamp)
+{
+    if (frame == nullptr || length > ETHERNET_MAX_FRAME_SIZE)
+    {
+        return false;
+    }
+    auto const sinceEpoch = std::chrono::duration_cast<std::chrono::microseconds>(timeStamp.time_since_epoch());
+    auto const seconds = std::chrono::duration_cast<std::chrono::seconds>(sinceEpoch);
+    auto const record = PcapRecordHeader{ static_cast<uint32_t>(seconds.count()), static_cast<uint32_t>((sinceEpoch - seconds).count()), static_cast<uint32_t>(length), static_cast<uint32_t>(length) };
+
+    std::lock_guard<std::mutex> const lg{ _lock };
+    if (_file == nullptr)
+    {
+        return false;
+    }
+    if (std::fwrite(&record, sizeof(record), 1u, _file) != 1u || std::fwrite(frame, 1u, length, _file) != length)
+    {
+        ESP_LOGE(TAG, "Cannot write frame");
+        return false;
+    }
+    ++_frameCount;
+    return true;
+}
+
+void PcapWriter::flush() noexcept
+{
+    std::lock_guard<std::mutex> const lg{ _lock };
+    if (_file != nullptr)
+    {
+        std::fflush(_file);
+    }
+}
+
+bool PcapWriter::isOpen() const noexcept
+{
+    std::lock_guard<std::mutex> const lg{ _lock };
+    return _file != nullptr;
+}
+
+uint64_t PcapWriter::getFrameCount() const noexcept
+{
+    std::lock_guard<std::mutex> const lg{ _lock };
+    return _frameCount;
+}
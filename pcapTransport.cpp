@@ -0,0 +1,255 @@
+#include "pcapTransport.hpp"
+#include "esp_log.h"
+#include "protocolAvtpdu.hpp"
+#include <cstring>
+#include <thread>
+#include <utility>
+
+static const char* TAG = "PCAP_TRANSPORT";
+
+static constexpr uint16_t VlanEtherType = 0x8100;
+static constexpr size_t VlanTagLength = 4u;
+
+static uint16_t getEtherType(const uint8_t* frame, size_t const offset) noexcept
+{
+    return static_cast<uint16_t>((frame[offset] << 8) | frame[offset + 1]);
+}
+
+static bool isAtdeccSubtype(uint8_t const subtype) noexcept
+{
+    return subtype == AVTP_SUBTYPE_ADP || subtype == AVTP_SUBTYPE_AECP || subtype == AVTP_SUBTYPE_ACMP;
+}
+
+/***********************************************************/
+/* PcapReplayTransport class definition                    */
+/***********************************************************/
+
+PcapReplayTransport::PcapReplayTransport(std::string path, MacAddress const& macAddress, Speed const speed, bool const loop) noexcept
+    : _path(std::move(path)), _speed(speed), _loop(loop)
+{
+    _macAddress = macAddress;
+}
+
+bool PcapReplayTransport::open()
+{
+    if (!_reader.open(_path.c_str()))
+    {
+        return false;
+    }
+    _statistics = Statistics{};
+    _loopOffset = PcapReader::TimeStamp{ 0 };
+    _started = false;
+    _pending = false;
+    _passHasFrames = false;
+    _finished = false;
+    _open = true;
+    return true;
+}
+
+void PcapReplayTransport::close() noexcept
+{
+    _open = false;
+    _reader.close();
+}
+
+bool PcapReplayTransport::sendFrame(const uint8_t* frame, size_t const length)
+{
+    if (!_open)
+    {
+        return false;
+    }
+    ++_statistics.sent;
+    if (_captureWriter != nullptr)
+    {
+        _captureWriter->writeFrame(frame, length);
+    }
+    return true;
+}
+
+bool PcapReplayTransport::joinMulticast(MacAddress const& /*macAddress*/)
+{
+    return true;
+}
+
+bool PcapReplayTransport::leaveMulticast(MacAddress const& /*macAddress*/)
+{
+    return true;
+}
+
+size_t PcapReplayTransport::poll(std::chrono::milliseconds const timeout)
+{
+    if (!_open)
+    {
+        return 0u;
+    }
+    auto now = std::chrono::steady_clock::now();
+    if (!_started)
+    {
+        _start = now;
+        _started = true;
+    }
+    auto const deadline = now + timeout;
+
+    auto count = size_t{ 0u };
+    while (count < MaxFramesPerPoll)
+    {
+        if (!_pending && !(_pending = readNext()))
+        {
+            _finished = true;
+            break;
+        }
+
+        if (_speed == Speed::Recorded)
+        {
+            auto const due = _start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(_frameTime);
+            if (due > now)
+            {
+                // Only wait for the first frame, like a socket would
+                if (count != 0u || due > deadline)
+                {
+                    if (count == 0u && deadline > now)
+                    {
+                        std::this_thread::sleep_until(deadline);
+                    }
+                    break;
+                }
+                std::this_thread::sleep_until(due);
+                now = std::chrono::steady_clock::now();
+            }
+        }
+
+        _pending = false;
+        if (dispatchFrame(_frame.data(), _frameLength))
+        {
+            ++_statistics.delivered;
+            _statistics.bytes += _frameLength;
+            ++count;
+        }
+    }
+    return count;
+}
+
+void PcapReplayTransport::setCaptureWriter(PcapWriter* writer) noexcept
+{
+    _captureWriter = writer;
+}
+
+bool PcapReplayTransport::isFinished() const noexcept
+{
+    return _finished;
+}
+
+PcapReplayTransport::Statistics const& PcapReplayTransport::getStatistics() const noexcept
+{
+    return _statistics;
+}
+
+bool PcapReplayTransport::readNext()
+{
+    for (;;)
+    {
+        const uint8_t* frame{ nullptr };
+        auto length = size_t{ 0u };
+        auto timeStamp = PcapReader::TimeStamp{};
+        if (!_reader.readFrame(frame, length, timeStamp))
+        {
+            // Loop only if the pass had ATDECC frames, not to spin on a file without any
+            if (!_loop || !_passHasFrames || !_reader.rewind())
+            {
+                if (_statistics.frames != 0u)
+                {
+                    ESP_LOGI(TAG, "%s replayed: %llu frames, %llu delivered", _path.c_str(), static_cast<unsigned long long>(_statistics.frames), static_cast<unsigned long long>(_statistics.delivered));
+                }
+                return false;
+            }
+            ++_statistics.loops;
+            _loopOffset += _lastFrameTime - _firstFrameTime;
+            _passHasFrames = false;
+            continue;
+        }
+
+        if (_statistics.frames++ == 0u)
+        {
+            _firstFrameTime = timeStamp;
+        }
+        _lastFrameTime = timeStamp;
+
+        // Remove the VLAN tag, the stack expects the EtherType right after the addresses
+        auto etherTypeOffset = size_t{ 12u };
+        if (length >= EtherLayer2::Length + VlanTagLength && getEtherType(frame, etherTypeOffset) == VlanEtherType)
+        {
+            etherTypeOffset += VlanTagLength;
+        }
+        auto const payloadOffset = etherTypeOffset + 2u;
+        if (length <= payloadOffset || getEtherType(frame, etherTypeOffset) != AVTP_ETHER_TYPE || !isAtdeccSubtype(frame[payloadOffset]))
+        {
+            ++_statistics.ignored;
+            continue;
+        }
+
+        std::memcpy(_frame.data(), frame, 12u);
+        std::memcpy(_frame.data() + 12u, frame + etherTypeOffset, length - etherTypeOffset);
+        _frameLength = length - (etherTypeOffset - 12u);
+        _frameTime = timeStamp - _firstFrameTime + _loopOffset;
+        _passHasFrames = true;
+        return true;
+    }
+}
+
+/***********************************************************/
+/* PcapCaptureTransport class definition                   */
+/***********************************************************/
+
+PcapCaptureTransport::PcapCaptureTransport(NetworkTransport& transport, PcapWriter& writer)
+    : _transport(transport), _writer(writer)
+{
+    _transport.setFrameHandler([this](const uint8_t* frame, size_t const length)
+    {
+        _writer.writeFrame(frame, length);
+        dispatchFrame(frame, length);
+    });
+}
+
+bool PcapCaptureTransport::open()
+{
+    if (!_transport.open())
+    {
+        return false;
+    }
+    _macAddress = _transport.getMacAddress();
+    _open = true;
+    return true;
+}
+
+void PcapCaptureTransport::close() noexcept
+{
+    _open = false;
+    _transport.close();
+    _writer.flush();
+}
+
+bool PcapCaptureTransport::sendFrame(const uint8_t* frame, size_t const length)
+{
+    _writer.writeFrame(frame, length);
+    return _transport.sendFrame(frame, length);
+}
+
+bool PcapCaptureTransport::joinMulticast(MacAddress const& macAddress)
+{
+    return _transport.joinMulticast(macAddress);
+}
+
+bool PcapCaptureTransport::leaveMulticast(MacAddress const& macAddress)
+{
+    return _transport.leaveMulticast(macAddress);
+}
+
+size_t PcapCaptureTransport::poll(std::chrono::milliseconds const timeout)
+{
+    return _transport.poll(timeout);
+}
+
+bool PcapCaptureTransport::flush()
+{
+    return _transport.flush();
+}
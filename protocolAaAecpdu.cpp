@@ -1,5 +1,6 @@
 #include "protocolAaAecpdu.hpp"
 #include "esp_log.h"
+#include "endian.hpp"
 #include <cassert>
 #include <string>
 
@@ -30,18 +31,19 @@ void AaAecpdu::serialize(uint8_t* buffer, size_t length) const
     size_t offset = Aecpdu::HEADER_LENGTH;
 
     // TLV count
-    uint16_t tlvCount = static_cast<uint16_t>(_tlvData.size());
+    // Fields are in network order
+    uint16_t tlvCount = ATDECC_PACK_WORD(static_cast<uint16_t>(_tlvData.size()));
     memcpy(buffer + offset, &tlvCount, sizeof(tlvCount));
     offset += sizeof(tlvCount);
 
     // Serialize TLVs
     for (const auto& tlv : _tlvData)
     {
-        uint16_t mode_length = static_cast<uint16_t>(((static_cast<uint16_t>(tlv.getMode()) << 12) & 0xF000) | (tlv.size() & 0x0FFF));
+        uint16_t mode_length = ATDECC_PACK_WORD(static_cast<uint16_t>(((static_cast<uint16_t>(tlv.getMode()) << 12) & 0xF000) | (tlv.size() & 0x0FFF)));
         memcpy(buffer + offset, &mode_length, sizeof(mode_length));
         offset += sizeof(mode_length);
 
-        uint64_t address = tlv.getAddress();
+        uint64_t address = ATDECC_PACK_QWORD(tlv.getAddress());
         memcpy(buffer + offset, &address, sizeof(address));
         offset += sizeof(address);
 
@@ -66,6 +68,7 @@ void AaAecpdu::deserialize(const uint8_t* buffer, size_t length)
     uint16_t tlvCount;
 
     memcpy(&tlvCount, buffer + offset, sizeof(tlvCount));
+    tlvCount = ATDECC_UNPACK_WORD(tlvCount);
     offset += sizeof(tlvCount);
 
     for (uint16_t i = 0; i < tlvCount; ++i)
@@ -74,12 +77,14 @@ void AaAecpdu::deserialize(const uint8_t* buffer, size_t length)
         uint64_t address;
 
         memcpy(&mode_length, buffer + offset, sizeof(mode_length));
+        mode_length = ATDECC_UNPACK_WORD(mode_length);
         offset += sizeof(mode_length);
 
         AaMode mode = static_cast<AaMode>((mode_length & 0xF000) >> 12);
         uint16_t length = mode_length & 0x0FFF;
 
         memcpy(&address, buffer + offset, sizeof(address));
+        address = ATDECC_UNPACK_QWORD(address);
         offset += sizeof(address);
 
         Tlv tlv(mode, address, length);
@@ -93,6 +98,58 @@ void AaAecpdu::deserialize(const uint8_t* buffer, size_t length)
     ESP_LOGI(TAG, "Deserialization complete");
 }
 
+bool AaAecpdu::validateTlvs(const uint8_t* buffer, size_t length) noexcept
+{
+    if (buffer == nullptr || length < Aecpdu::HEADER_LENGTH + HeaderLength)
+    {
+        ESP_LOGW(TAG, "AA frame too short");
+        return false;
+    }
+
+    size_t offset = Aecpdu::HEADER_LENGTH;
+    uint16_t tlvCount;
+    memcpy(&tlvCount, buffer + offset, sizeof(tlvCount));
+    tlvCount = ATDECC_UNPACK_WORD(tlvCount);
+    offset += sizeof(tlvCount);
+
+    for (uint16_t i = 0; i < tlvCount; ++i)
+    {
+        if (length - offset < TlvHeaderLength)
+        {
+            ESP_LOGW(TAG, "AA frame truncated in TLV %u header", i);
+            return false;
+        }
+        uint16_t mode_length;
+        memcpy(&mode_length, buffer + offset, sizeof(mode_length));
+        offset += TlvHeaderLength;
+
+        size_t const tlvLength = ATDECC_UNPACK_WORD(mode_length) & 0x0FFF;
+        if (length - offset < tlvLength)
+        {
+            ESP_LOGW(TAG, "AA frame truncated in TLV %u data", i);
+            return false;
+        }
+        offset += tlvLength;
+    }
+    return true;
+}
+
+TlvView AaAecpdu::decodeTlv(const uint8_t* ptr) noexcept
+{
+    uint16_t mode_length;
+    uint64_t address;
+
+    memcpy(&mode_length, ptr, sizeof(mode_length));
+    memcpy(&address, ptr + sizeof(mode_length), sizeof(address));
+    mode_length = ATDECC_UNPACK_WORD(mode_length);
+    address = ATDECC_UNPACK_QWORD(address);
+
+    AaMode mode = static_cast<AaMode>((mode_length & 0xF000) >> 12);
+    size_t length = mode_length & 0x0FFF;
+
+    return TlvView{ mode, address, ptr + TlvHeaderLength, length };
+}
+
 Aecpdu::UniquePointer AaAecpdu::responseCopy() const
 {
     if (getMessageType() != AecpMessageType::ADDRESS_ACCESS_COMMAND) {
@@ -1,4 +1,5 @@
 #include "protocolAcmpdu.hpp"
+#include "endian.hpp"
 #include <cstring> // For memcpy
 
 // Multicast MAC Address for ACMPDU
@@ -109,6 +110,10 @@ void Acmpdu::setStreamVlanID(uint16_t streamVlanID) {
     _streamVlanID = streamVlanID;
 }
 
+void Acmpdu::setStreamID(UniqueIdentifier streamID) {
+    _streamID = streamID;
+}
+
 // Getters
 AcmpMessageType Acmpdu::getMessageType() const {
     return _messageType;
@@ -158,85 +163,146 @@ uint16_t Acmpdu::getStreamVlanID() const {
     return _streamVlanID;
 }
 
-// Serialization
+UniqueIdentifier Acmpdu::getStreamID() const {
+    return _streamID;
+}
+
+// Serialization (network byte order)
 void Acmpdu::serialize(uint8_t* buffer) const {
     if (buffer == nullptr) {
         ESP_LOGE("ACMPDU", "Serialization buffer is null");
         return;
     }
 
-    std::memcpy(buffer, &_controllerEntityID, sizeof(_controllerEntityID));
-    buffer += sizeof(_controllerEntityID);
+    auto const controllerEntityID = ATDECC_PACK_QWORD(_controllerEntityID.getValue());
+    std::memcpy(buffer, &controllerEntityID, sizeof(controllerEntityID));
+    buffer += sizeof(controllerEntityID);
 
-    std::memcpy(buffer, &_talkerEntityID, sizeof(_talkerEntityID));
-    buffer += sizeof(_talkerEntityID);
+    auto const talkerEntityID = ATDECC_PACK_QWORD(_talkerEntityID.getValue());
+    std::memcpy(buffer, &talkerEntityID, sizeof(talkerEntityID));
+    buffer += sizeof(talkerEntityID);
 
-    std::memcpy(buffer, &_listenerEntityID, sizeof(_listenerEntityID));
-    buffer += sizeof(_listenerEntityID);
+    auto const listenerEntityID = ATDECC_PACK_QWORD(_listenerEntityID.getValue());
+    std::memcpy(buffer, &listenerEntityID, sizeof(listenerEntityID));
+    buffer += sizeof(listenerEntityID);
 
-    std::memcpy(buffer, &_talkerUniqueID, sizeof(_talkerUniqueID));
-    buffer += sizeof(_talkerUniqueID);
+    auto const talkerUniqueID = ATDECC_PACK_TYPE(_talkerUniqueID, AcmpUniqueID);
+    std::memcpy(buffer, &talkerUniqueID, sizeof(talkerUniqueID));
+    buffer += sizeof(talkerUniqueID);
 
-    std::memcpy(buffer, &_listenerUniqueID, sizeof(_listenerUniqueID));
-    buffer += sizeof(_listenerUniqueID);
+    auto const listenerUniqueID = ATDECC_PACK_TYPE(_listenerUniqueID, AcmpUniqueID);
+    std::memcpy(buffer, &listenerUniqueID, sizeof(listenerUniqueID));
+    buffer += sizeof(listenerUniqueID);
 
     std::memcpy(buffer, _streamDestAddress.data(), _streamDestAddress.size());
-    buffer += sizeof(_streamDestAddress);
+    buffer += _streamDestAddress.size();
 
-    std::memcpy(buffer, &_connectionCount, sizeof(_connectionCount));
-    buffer += sizeof(_connectionCount);
+    auto const connectionCount = ATDECC_PACK_WORD(_connectionCount);
+    std::memcpy(buffer, &connectionCount, sizeof(connectionCount));
+    buffer += sizeof(connectionCount);
 
-    std::memcpy(buffer, &_sequenceID, sizeof(_sequenceID));
-    buffer += sizeof(_sequenceID);
+    auto const sequenceID = ATDECC_PACK_TYPE(_sequenceID, AcmpSequenceID);
+    std::memcpy(buffer, &sequenceID, sizeof(sequenceID));
+    buffer += sizeof(sequenceID);
 
-    std::memcpy(buffer, &_flags, sizeof(_flags));
-    buffer += sizeof(_flags);
+    auto const flags = ATDECC_PACK_WORD(_flags);
+    std::memcpy(buffer, &flags, sizeof(flags));
+    buffer += sizeof(flags);
 
-    std::memcpy(buffer, &_streamVlanID, sizeof(_streamVlanID));
-    buffer += sizeof(_streamVlanID);
+    auto const streamVlanID = ATDECC_PACK_WORD(_streamVlanID);
+    std::memcpy(buffer, &streamVlanID, sizeof(streamVlanID));
+    buffer += sizeof(streamVlanID);
 
     std::uint16_t reserved = 0;
     std::memcpy(buffer, &reserved, sizeof(reserved));
 }
 
-// Deserialization
+// Deserialization (network byte order)
 void Acmpdu::deserialize(const uint8_t* buffer, size_t length) {
     if (buffer == nullptr || length < Length) {
         ESP_LOGE("ACMPDU", "Buffer is null or length is insufficient for deserialization.");
+        return;
     }
 
-    std::memcpy(&_controllerEntityID, buffer, sizeof(_controllerEntityID));
-    buffer += sizeof(_controllerEntityID);
+    std::uint64_t entityID = 0;
+    std::memcpy(&entityID, buffer, sizeof(entityID));
+    _controllerEntityID.setValue(ATDECC_UNPACK_QWORD(entityID));
+    buffer += sizeof(entityID);
 
-    std::memcpy(&_talkerEntityID, buffer, sizeof(_talkerEntityID));
-    buffer += sizeof(_talkerEntityID);
+    std::memcpy(&entityID, buffer, sizeof(entityID));
+    _talkerEntityID.setValue(ATDECC_UNPACK_QWORD(entityID));
+    buffer += sizeof(entityID);
 
-    std::memcpy(&_listenerEntityID, buffer, sizeof(_listenerEntityID));
-    buffer += sizeof(_listenerEntityID);
+    std::memcpy(&entityID, buffer, sizeof(entityID));
+    _listenerEntityID.setValue(ATDECC_UNPACK_QWORD(entityID));
+    buffer += sizeof(entityID);
 
     std::memcpy(&_talkerUniqueID, buffer, sizeof(_talkerUniqueID));
+    _talkerUniqueID = ATDECC_UNPACK_TYPE(_talkerUniqueID, AcmpUniqueID);
     buffer += sizeof(_talkerUniqueID);
 
     std::memcpy(&_listenerUniqueID, buffer, sizeof(_listenerUniqueID));
+    _listenerUniqueID = ATDECC_UNPACK_TYPE(_listenerUniqueID, AcmpUniqueID);
     buffer += sizeof(_listenerUniqueID);
 
     std::memcpy(_streamDestAddress.data(), buffer, _streamDestAddress.size());
-    buffer += sizeof(_streamDestAddress);
+    buffer += _streamDestAddress.size();
 
     std::memcpy(&_connectionCount, buffer, sizeof(_connectionCount));
+    _connectionCount = ATDECC_UNPACK_WORD(_connectionCount);
     buffer += sizeof(_connectionCount);
 
     std::memcpy(&_sequenceID, buffer, sizeof(_sequenceID));
+    _sequenceID = ATDECC_UNPACK_TYPE(_sequenceID, AcmpSequenceID);
     buffer += sizeof(_sequenceID);
 
     std::memcpy(&_flags, buffer, sizeof(_flags));
+    _flags = ATDECC_UNPACK_WORD(_flags);
     buffer += sizeof(_flags);
 
     std::memcpy(&_streamVlanID, buffer, sizeof(_streamVlanID));
-    buffer += sizeof(_streamVlanID);
+    _streamVlanID = ATDECC_UNPACK_WORD(_streamVlanID);
+}
 
-    std::uint16_t reserved = 0;
-    std::memcpy(&reserved, buffer, sizeof(reserved));
+// AVTP control header followed by the ACMPDU
+size_t Acmpdu::serializeControl(uint8_t* buffer, size_t length) const {
+    if (buffer == nullptr || length < ControlHeaderLength + Length) {
+        ESP_LOGE("ACMPDU", "Buffer is null or too small for the AVTP control header and ACMPDU");
+        return 0;
+    }
+
+    buffer[0] = AVTP_SUBTYPE_ACMP;
+    buffer[1] = static_cast<uint8_t>(((AVTP_VERSION << 4) & 0x70) | (static_cast<uint8_t>(_messageType) & 0x0f));
+    auto const statusLength = ATDECC_PACK_WORD(static_cast<uint16_t>(((static_cast<uint16_t>(_status) << 11) & 0xf800) | (Length & 0x07ff)));
+    std::memcpy(buffer + 2, &statusLength, sizeof(statusLength));
+    auto const streamID = ATDECC_PACK_QWORD(_streamID.getValue());
+    std::memcpy(buffer + 4, &streamID, sizeof(streamID));
+
+    serialize(buffer + ControlHeaderLength);
+    return ControlHeaderLength + Length;
+}
+
+bool Acmpdu::deserializeControl(const uint8_t* buffer, size_t length) {
+    if (buffer == nullptr || length < ControlHeaderLength + Length || buffer[0] != AVTP_SUBTYPE_ACMP) {
+        return false;
+    }
+
+    std::uint16_t statusLength = 0;
+    std::memcpy(&statusLength, buffer + 2, sizeof(statusLength));
+    statusLength = ATDECC_UNPACK_WORD(statusLength);
+    if ((statusLength & 0x07ff) < Length) {
+        ESP_LOGW("ACMPDU", "Invalid ACMP control_data_length %u", static_cast<unsigned>(statusLength & 0x07ff));
+        return false;
+    }
+
+    std::uint64_t streamID = 0;
+    std::memcpy(&streamID, buffer + 4, sizeof(streamID));
+
+    _messageType = static_cast<AcmpMessageType>(buffer[1] & 0x0f);
+    _status = static_cast<AcmpStatus>(statusLength >> 11);
+    _streamID.setValue(ATDECC_UNPACK_QWORD(streamID));
+    deserialize(buffer + ControlHeaderLength, length - ControlHeaderLength);
+    return true;
 }
 
 // Copy method for cloning an Acmpdu
@@ -40,7 +40,7 @@ Adpdu::~Adpdu() noexcept = default;
 
 // Serialize the ADPDU fields into a buffer for transmission
 //void Adpdu::serialize(uint8_t* buffer) const noexcept
-void Adpdu::serialize(SerBuffer& buffer) const noexcept
+void Adpdu::serialize(SerBuffer& buffer) const
 {
     // Reserved fields
     uint32_t reserved0 = {0u};
@@ -50,8 +50,9 @@ void Adpdu::serialize(SerBuffer& buffer) const noexcept
 
     // load data into buffer
     buffer << entityModelID << entityCapabilities;
-	buffer << talkerStreamSources << talkerCapabilities;
-	buffer << listenerStreamSinks << listenerCapabilities;
+	// Talker and listener capabilities are 16 bits on the wire, EnumBitfield stores 32
+	buffer << talkerStreamSources << static_cast<std::uint16_t>(talkerCapabilities.getValue());
+	buffer << listenerStreamSinks << static_cast<std::uint16_t>(listenerCapabilities.getValue());
 	buffer << controllerCapabilities;
 	buffer << availableIndex;
 	buffer << gptpGrandmasterID << static_cast<std::uint32_t>(((gptpDomainNumber << 24) & 0xff000000) | (reserved0 & 0x00ffffff));
@@ -59,7 +60,7 @@ void Adpdu::serialize(SerBuffer& buffer) const noexcept
 
     // check that buffer size change is correct
     if ((buffer.size() - previousSize) != Length) {
-        ESP_LOGI("ADPDU", "Serialize error: buffer is %d but should be %d", buffer.size() - previousSize, Length);
+        ESP_LOGI("ADPDU", "Serialize error: buffer is %zu but should be %zu", buffer.size() - previousSize, Length);
     }
 }
 
@@ -69,42 +70,34 @@ void Adpdu::deserialize(const uint8_t* buffer)
     // Ensure that the buffer contains enough data to deserialize
     assert(buffer != nullptr);
 
-    // Offset to keep track of where in the buffer we're reading from
-    size_t offset = 0;
+    // Read the fields in the order serialize() packs them
+    Deserializer des(buffer, Length);
+    std::uint16_t talkerCapabilitiesValue{ 0u };
+    std::uint16_t listenerCapabilitiesValue{ 0u };
+    std::uint32_t domainReserved{ 0u };
+    des >> entityModelID >> entityCapabilities;
+    des >> talkerStreamSources >> talkerCapabilitiesValue;
+    des >> listenerStreamSinks >> listenerCapabilitiesValue;
+    des >> controllerCapabilities;
+    des >> availableIndex;
+    des >> gptpGrandmasterID >> domainReserved;
+    des >> identifyControlIndex >> interfaceIndex >> associationID;
+    // 32 bits reserved
 
-    // // FIXME missing fields
-    // // Copy fields from the buffer in the correct order
-    // memcpy(&messageType, buffer + offset, sizeof(messageType));
-    // offset += sizeof(messageType);
-    // memcpy(&validTime, buffer + offset, sizeof(validTime));
-    // offset += sizeof(validTime);
-    // memcpy(&entityID, buffer + offset, sizeof(entityID));
-    // offset += sizeof(entityID);
-    // memcpy(&entityModelID, buffer + offset, sizeof(entityModelID));
-    // offset += sizeof(entityModelID);
-    // memcpy(&entityCapabilities, buffer + offset, sizeof(entityCapabilities));
-    // offset += sizeof(entityCapabilities);
-    // memcpy(&talkerStreamSources, buffer + offset, sizeof(talkerStreamSources));
-    // offset += sizeof(talkerStreamSources);
-    // memcpy(&talkerCapabilities, buffer + offset, sizeof(talkerCapabilities));
-    // offset += sizeof(talkerCapabilities);
-    // memcpy(&listenerStreamSinks, buffer + offset, sizeof(listenerStreamSinks));
-    // offset += sizeof(listenerStreamSinks);
-    // memcpy(&listenerCapabilities, buffer + offset, sizeof(listenerCapabilities));
-    // offset += sizeof(listenerCapabilities);
-    // memcpy(&availableIndex, buffer + offset, sizeof(availableIndex));
-    // offset += sizeof(availableIndex);
-    // memcpy(&gptpGrandmasterID, buffer + offset, sizeof(gptpGrandmasterID));
-    // offset += sizeof(gptpGrandmasterID);
-    // memcpy(&gptpDomainNumber, buffer + offset, sizeof(gptpDomainNumber));
-    // offset += sizeof(gptpDomainNumber);
-    // offset += (3); // 24 bits reserved
-    // memcpy(&identifyControlIndex, buffer + offset, sizeof(identifyControlIndex));
-    // offset += sizeof(identifyControlIndex);
-    // memcpy(&interfaceIndex, buffer + offset, sizeof(interfaceIndex));
-    // offset += sizeof(interfaceIndex);
-    // memcpy(&associationID, buffer + offset, sizeof(associationID));
-    // // 32 bits reserved
+    // Fields are in network order
+    entityModelID = ATDECC_UNPACK_TYPE(entityModelID, UniqueIdentifier);
+    entityCapabilities = ATDECC_UNPACK_TYPE(entityCapabilities, EntityCapabilities);
+    talkerStreamSources = ATDECC_UNPACK_WORD(talkerStreamSources);
+    talkerCapabilities = TalkerCapabilities{ static_cast<TalkerCapability>(ATDECC_UNPACK_WORD(talkerCapabilitiesValue)) };
+    listenerStreamSinks = ATDECC_UNPACK_WORD(listenerStreamSinks);
+    listenerCapabilities = ListenerCapabilities{ static_cast<ListenerCapability>(ATDECC_UNPACK_WORD(listenerCapabilitiesValue)) };
+    controllerCapabilities = ATDECC_UNPACK_TYPE(controllerCapabilities, ControllerCapabilities);
+    availableIndex = ATDECC_UNPACK_DWORD(availableIndex);
+    gptpGrandmasterID = ATDECC_UNPACK_TYPE(gptpGrandmasterID, UniqueIdentifier);
+    gptpDomainNumber = static_cast<uint8_t>(ATDECC_UNPACK_DWORD(domainReserved) >> 24);
+    identifyControlIndex = ATDECC_UNPACK_TYPE(identifyControlIndex, ControlIndex);
+    interfaceIndex = ATDECC_UNPACK_TYPE(interfaceIndex, AvbInterfaceIndex);
+    associationID = ATDECC_UNPACK_TYPE(associationID, UniqueIdentifier);
 }
 
 // Entry point for creating a new ADPDU instance
@@ -1,5 +1,7 @@
 #include "protocolAemAecpdu.hpp"
 #include "esp_log.h"
+#include "endian.hpp"
+#include "protocolAvtpdu.hpp"
 #include <cstring> // memcpy
 
 /***********************************************************/
@@ -77,12 +79,12 @@ void AemAecpdu::serialize(uint8_t* buffer, size_t length) const
     buffer[offset + 1] = static_cast<uint8_t>(u_ct & 0xFF);     // Low byte
     offset += 2;
 
-    // Serialize the command-specific data
+    // Serialize the command-specific data (length is the limit negotiated with the peer, see AecpPayloadNegotiator)
     auto payloadLength = _commandSpecificDataLength;
-    if (payloadLength > MAXIMUM_SEND_PAYLOAD_BUFFER_LENGTH) {
+    if (payloadLength > MAXIMUM_PAYLOAD_BUFFER_LENGTH) {
         ESP_LOGW("SERIALIZE", "Payload size exceeds maximum allowed value of %zu for AemCommandType %u, clamping buffer down from %zu",
-                 MAXIMUM_SEND_PAYLOAD_BUFFER_LENGTH, static_cast<uint16_t>(_commandType), payloadLength);
-        payloadLength = std::min(payloadLength, MAXIMUM_SEND_PAYLOAD_BUFFER_LENGTH);
+                 MAXIMUM_PAYLOAD_BUFFER_LENGTH, static_cast<uint16_t>(_commandType), payloadLength);
+        payloadLength = std::min(payloadLength, MAXIMUM_PAYLOAD_BUFFER_LENGTH);
     }
 
     if (offset + payloadLength > length) {
@@ -133,17 +135,91 @@ void AemAecpdu::deserialize(const uint8_t* buffer, size_t length)
         ESP_LOGW("DESERIALIZE", "Not enough data to deserialize command-specific data");
     }
 
-    // Clamp the command-specific data length if it exceeds the maximum allowed
-    if (_commandSpecificDataLength > MAXIMUM_RECV_PAYLOAD_BUFFER_LENGTH) {
+    // Clamp the command-specific data length if it exceeds the buffer (whether big payloads are accepted from this peer is checked by AecpPayloadNegotiator)
+    if (_commandSpecificDataLength > MAXIMUM_PAYLOAD_BUFFER_LENGTH) {
         ESP_LOGW("DESERIALIZE", "Payload size exceeds maximum allowed value of %zu, clamping buffer down from %zu",
-                 MAXIMUM_RECV_PAYLOAD_BUFFER_LENGTH, _commandSpecificDataLength);
-        _commandSpecificDataLength = std::min(_commandSpecificDataLength, MAXIMUM_RECV_PAYLOAD_BUFFER_LENGTH);
+                 MAXIMUM_PAYLOAD_BUFFER_LENGTH, _commandSpecificDataLength);
+        _commandSpecificDataLength = std::min(_commandSpecificDataLength, MAXIMUM_PAYLOAD_BUFFER_LENGTH);
     }
 
     // Deserialize the payload
     std::memcpy(_commandSpecificData.data(), buffer + offset, _commandSpecificDataLength);
 }
 
+size_t AemAecpdu::serializeControl(uint8_t* buffer, size_t length) const
+{
+    auto const payloadLength = _commandSpecificDataLength;
+    if (buffer == nullptr || length < CONTROL_HEADER_LENGTH + payloadLength)
+    {
+        ESP_LOGE("AEM_AECPDU", "Buffer is null or too small for the AVTP control header and AEM AECPDU");
+        return 0u;
+    }
+
+    // control_data_length counts everything after target_entity_id
+    auto const controlDataLength = static_cast<uint16_t>(CONTROL_HEADER_LENGTH - AvtpduControl::HeaderLength + payloadLength);
+    buffer[0] = AVTP_SUBTYPE_AECP;
+    buffer[1] = static_cast<uint8_t>(((AVTP_VERSION << 4) & 0x70) | (static_cast<uint8_t>(getMessageType()) & 0x0f));
+    auto const statusLength = ATDECC_PACK_WORD(static_cast<uint16_t>(((static_cast<uint16_t>(getStatus()) << 11) & 0xf800) | (controlDataLength & 0x07ff)));
+    std::memcpy(buffer + 2, &statusLength, sizeof(statusLength));
+    auto const targetEntityID = ATDECC_PACK_QWORD(getTargetEntityID().getValue());
+    std::memcpy(buffer + 4, &targetEntityID, sizeof(targetEntityID));
+    auto const controllerEntityID = ATDECC_PACK_QWORD(getControllerEntityID().getValue());
+    std::memcpy(buffer + 12, &controllerEntityID, sizeof(controllerEntityID));
+    auto const sequenceID = ATDECC_PACK_WORD(getSequenceID());
+    std::memcpy(buffer + 20, &sequenceID, sizeof(sequenceID));
+    auto const u_ct = ATDECC_PACK_WORD(static_cast<uint16_t>(((_unsolicited << 15) & 0x8000) | (static_cast<uint16_t>(_commandType) & 0x7fff)));
+    std::memcpy(buffer + 22, &u_ct, sizeof(u_ct));
+
+    std::memcpy(buffer + CONTROL_HEADER_LENGTH, _commandSpecificData.data(), payloadLength);
+    return CONTROL_HEADER_LENGTH + payloadLength;
+}
+
+bool AemAecpdu::deserializeControl(const uint8_t* buffer, size_t length)
+{
+    if (buffer == nullptr || length < CONTROL_HEADER_LENGTH || buffer[0] != AVTP_SUBTYPE_AECP)
+    {
+        return false;
+    }
+
+    uint16_t statusLength = 0u;
+    std::memcpy(&statusLength, buffer + 2, sizeof(statusLength));
+    statusLength = ATDECC_UNPACK_WORD(statusLength);
+    auto const controlDataLength = static_cast<size_t>(statusLength & 0x07ff);
+    auto const minCDL = CONTROL_HEADER_LENGTH - AvtpduControl::HeaderLength;
+    if (controlDataLength < minCDL || AvtpduControl::HeaderLength + controlDataLength > length)
+    {
+        ESP_LOGW("AEM_AECPDU", "Invalid AEM control_data_length %zu", controlDataLength);
+        return false;
+    }
+    auto const payloadLength = controlDataLength - minCDL;
+    if (payloadLength > MAXIMUM_PAYLOAD_BUFFER_LENGTH)
+    {
+        ESP_LOGW("AEM_AECPDU", "Payload size exceeds maximum allowed value of %zu", MAXIMUM_PAYLOAD_BUFFER_LENGTH);
+        return false;
+    }
+
+    uint64_t targetEntityID = 0u;
+    std::memcpy(&targetEntityID, buffer + 4, sizeof(targetEntityID));
+    uint64_t controllerEntityID = 0u;
+    std::memcpy(&controllerEntityID, buffer + 12, sizeof(controllerEntityID));
+    uint16_t sequenceID = 0u;
+    std::memcpy(&sequenceID, buffer + 20, sizeof(sequenceID));
+    uint16_t u_ct = 0u;
+    std::memcpy(&u_ct, buffer + 22, sizeof(u_ct));
+    u_ct = ATDECC_UNPACK_WORD(u_ct);
+
+    setMessageType(static_cast<AecpMessageType>(buffer[1] & 0x0f));
+    setStatus(static_cast<AecpStatus>(statusLength >> 11));
+    setTargetEntityID(UniqueIdentifier{ ATDECC_UNPACK_QWORD(targetEntityID) });
+    setControllerEntityID(UniqueIdentifier{ ATDECC_UNPACK_QWORD(controllerEntityID) });
+    setSequenceID(ATDECC_UNPACK_WORD(sequenceID));
+    _unsolicited = ((u_ct & 0x8000) >> 15) != 0;
+    _commandType = static_cast<AemCommandType>(u_ct & 0x7fff);
+    _commandSpecificDataLength = payloadLength;
+    std::memcpy(_commandSpecificData.data(), buffer + CONTROL_HEADER_LENGTH, payloadLength);
+    return true;
+}
+
 Aecpdu::UniquePointer AemAecpdu::responseCopy() const
 {
     if (getMessageType() != AecpMessageType::AEM_COMMAND)
@@ -2394,7 +2394,7 @@ Serializer<AECP_AEM_GET_COUNTERS_COMMAND_PAYLOAD_SIZE> serializeGetCountersComma
 
     ser << descriptorType << descriptorIndex;
 
-    ESP_LOGI("AEM", "serializeGetCountersCommand: DescriptorType: %hu, DescriptorIndex: %hu", (uint16_t)descriptorType, (uint16_t)descriptorIndex);
+    ESP_LOGD("AEM", "serializeGetCountersCommand: DescriptorType: %hu, DescriptorIndex: %hu", (uint16_t)descriptorType, (uint16_t)descriptorIndex);
     return ser;
 }
 
@@ -2448,12 +2448,12 @@ Serializer<AECP_AEM_GET_COUNTERS_RESPONSE_PAYLOAD_SIZE> serializeGetCountersResp
 	return ser;
 }
 
-std::tuple<DescriptorType, DescriptorIndex, DescriptorCounterValidFlag, DescriptorCounters> deserializeGetCountersResponse(uint8_t const status, AemAecpdu::Payload const& payload)
+std::tuple<DescriptorType, DescriptorIndex, DescriptorCounterValidFlag, DescriptorCounters> deserializeGetCountersResponse(AemCommandStatus const status, AemAecpdu::Payload const& payload)
 {
 	auto* const commandPayload = payload.first;
 	auto const commandPayloadLength = payload.second;
 
-	checkResponsePayload(payload, status, AECP_AEM_GET_COUNTERS_COMMAND_PAYLOAD_SIZE, AECP_AEM_GET_COUNTERS_RESPONSE_PAYLOAD_SIZE);
+	checkResponsePayload(payload, static_cast<uint8_t>(status), AECP_AEM_GET_COUNTERS_COMMAND_PAYLOAD_SIZE, AECP_AEM_GET_COUNTERS_RESPONSE_PAYLOAD_SIZE);
 
 	// Check payload
 	Deserializer des(commandPayload, commandPayloadLength);
@@ -2469,14 +2469,20 @@ std::tuple<DescriptorType, DescriptorIndex, DescriptorCounterValidFlag, Descript
 	for (auto& counter : counters)
 	{
 		des >> counter;
+		counter = ATDECC_UNPACK_TYPE(counter, DescriptorCounter);
 	}
 
+	// Fields are in network order
+	descriptorType = static_cast<DescriptorType>(ATDECC_UNPACK_WORD(static_cast<uint16_t>(descriptorType)));
+	descriptorIndex = ATDECC_UNPACK_WORD(descriptorIndex);
+	validCounters = ATDECC_UNPACK_TYPE(validCounters, DescriptorCounterValidFlag);
+
 	if (des.usedBytes() != AECP_AEM_GET_COUNTERS_RESPONSE_PAYLOAD_SIZE)
 	{
 		ESP_LOGI("AEM", "deserializeGetCountersResponse: Used bytes do not match protocol constant, DescriptorType: %hu", (uint16_t)descriptorType);
 	}
 
-	ESP_LOGI("AEM", "deserializeGetCountersResponse: DescriptorType: %hu, DescriptorIndex: %hu", (uint16_t)descriptorType, (uint16_t)descriptorIndex);
+	ESP_LOGD("AEM", "deserializeGetCountersResponse: DescriptorType: %hu, DescriptorIndex: %hu", (uint16_t)descriptorType, (uint16_t)descriptorIndex);
 
 	return std::make_tuple(descriptorType, descriptorIndex, validCounters, counters);
 }
@@ -38,6 +38,7 @@ void EtherLayer2::deserialize(const uint8_t* buffer)
     memcpy(&srcAddress, buffer + offset, sizeof(srcAddress));
     offset += sizeof(srcAddress);
     memcpy(&etherType, buffer + offset, sizeof(etherType));
+    etherType = ATDECC_UNPACK_WORD(etherType);
 }
 
 // Copy method to create a deep copy of the current EtherHeader instance
@@ -100,15 +101,22 @@ void AvtpduControl::deserialize(const uint8_t* buffer)
     // Ensure that the buffer contains enough data to deserialize
     assert(buffer != nullptr);
 
-    // Offset to keep track of where in the buffer we're reading from
-    size_t offset = 0;
-
-    // Copy fields from the buffer in the correct order
-    memcpy(&controlData, buffer + offset, sizeof(controlData));
-    offset += sizeof(controlData);
-    memcpy(&status, buffer + offset, sizeof(status));
-    offset += sizeof(status);
-    memcpy(&controlDataLength, buffer + offset, sizeof(controlDataLength));
-		offset += sizeof(controlDataLength);
-    memcpy(&streamID, buffer + offset, sizeof(streamID));
+    // Read the fields in the order serialize() packs them
+    Deserializer des(buffer, HeaderLength);
+    std::uint8_t cdSubType{ 0u };
+    std::uint8_t svVersionControlData{ 0u };
+    std::uint16_t statusLength{ 0u };
+    des >> cdSubType >> svVersionControlData >> statusLength >> streamID;
+
+    // Fields are in network order
+    statusLength = ATDECC_UNPACK_WORD(statusLength);
+    streamID = ATDECC_UNPACK_QWORD(streamID);
+
+    cd = (cdSubType & 0x80) != 0;
+    subType = cdSubType & 0x7f;
+    headerSpecific = (svVersionControlData & 0x80) != 0;
+    version = (svVersionControlData >> 4) & 0x07;
+    controlData = svVersionControlData & 0x0f;
+    status = static_cast<uint8_t>(statusLength >> 11);
+    controlDataLength = statusLength & 0x07ff;
 }
\ No newline at end of file
@@ -0,0 +1,251 @@
+#include "shardedController.hpp"
+
+#if !defined(ESP_PLATFORM)
+
+#include "esp_log.h"
+#include "protocolAvtpdu.hpp"
+#include <algorithm>
+#include <cstring>
+#include <utility>
+
+static const char* TAG = "SHARDED_CTRL";
+
+/** Entity IDs in the frame: AVTP control header entity_id / target_entity_id, ACMP listener_entity_id */
+static constexpr size_t ControlIdentifierOffset = EtherLayer2::Length + 4u;
+static constexpr size_t AcmpListenerOffset = EtherLayer2::Length + AvtpduControl::HeaderLength + 16u;
+
+/** Posted tasks run per worker iteration, so frames are not starved */
+static constexpr size_t MaxTasksPerIteration = 64u;
+
+static uint64_t readIdentifier(const uint8_t* frame) noexcept
+{
+    auto value = uint64_t{ 0u };
+    for (auto i = 0u; i < 8u; ++i)
+    {
+        value = (value << 8) | frame[i];
+    }
+    return value;
+}
+
+/***********************************************************/
+/* ShardedController class definition                      */
+/***********************************************************/
+
+ShardedController::Shard::Shard(size_t const ringDepth, size_t const taskQueueDepth)
+    : rx(ringDepth), tx(ringDepth), tasks(taskQueueDepth)
+{
+}
+
+ShardedController::ShardedController(NetworkTransport& transport, FrameHandler handler, Configuration const& configuration)
+    : _transport(transport), _handler(std::move(handler)), _configuration(configuration)
+{
+    _configuration.workerCount = std::max<size_t>(_configuration.workerCount, 1u);
+    _shards.reserve(_configuration.workerCount);
+    for (auto i = size_t{ 0u }; i < _configuration.workerCount; ++i)
+    {
+        _shards.push_back(std::make_unique<Shard>(_configuration.ringDepth, _configuration.taskQueueDepth));
+    }
+}
+
+ShardedController::~ShardedController() noexcept
+{
+    stop();
+}
+
+bool ShardedController::start()
+{
+    if (_running)
+    {
+        return true;
+    }
+    _transport.setFrameHandler([this](const uint8_t* frame, size_t const length)
+    {
+        dispatch(frame, length);
+    });
+    if (!_transport.open() || !_transport.joinAtdeccMulticast())
+    {
+        ESP_LOGE(TAG, "Cannot open the transport");
+        _transport.close();
+        return false;
+    }
+
+    _running = true;
+    for (auto i = size_t{ 0u }; i < _shards.size(); ++i)
+    {
+        _shards[i]->thread = std::thread{ [this, i]()
+        {
+            runWorker(i);
+        } };
+    }
+    _ioThread = std::thread{ [this]()
+    {
+        runIo();
+    } };
+    ESP_LOGI(TAG, "Started with %zu workers", _shards.size());
+    return true;
+}
+
+void ShardedController::stop() noexcept
+{
+    if (!_running.exchange(false))
+    {
+        return;
+    }
+    if (_ioThread.joinable())
+    {
+        _ioThread.join();
+    }
+    for (auto& shard : _shards)
+    {
+        if (shard->thread.joinable())
+        {
+            shard->thread.join();
+        }
+    }
+    _transport.close();
+}
+
+bool ShardedController::post(UniqueIdentifier const entityID, Task task)
+{
+    return _shards[getShard(entityID, _shards.size())]->tasks.push(std::move(task));
+}
+
+bool ShardedController::sendFrame(size_t const shard, const uint8_t* frame, size_t const length)
+{
+    if (shard >= _shards.size() || frame == nullptr || length > ETHERNET_MAX_FRAME_SIZE)
+    {
+        return false;
+    }
+    auto& owner = *_shards[shard];
+    auto* const slot = owner.tx.claim();
+    if (slot == nullptr)
+    {
+        owner.txDrops.fetch_add(1u, std::memory_order_relaxed);
+        return false;
+    }
+    std::memcpy(slot->data.data(), frame, length);
+    slot->length = static_cast<uint16_t>(length);
+    owner.tx.publish();
+    return true;
+}
+
+size_t ShardedController::getShard(UniqueIdentifier const entityID, size_t const shardCount) noexcept
+{
+    // Entity IDs of a vendor only differ in a few bits, mix them all before reducing
+    auto value = entityID.getValue();
+    value ^= value >> 33;
+    value *= 0xff51afd7ed558ccdull;
+    value ^= value >> 33;
+    value *= 0xc4ceb9fe1a85ec53ull;
+    value ^= value >> 33;
+    return static_cast<size_t>(value % shardCount);
+}
+
+size_t ShardedController::getShardCount() const noexcept
+{
+    return _shards.size();
+}
+
+ShardedController::Statistics ShardedController::getStatistics(size_t const shard) const noexcept
+{
+    if (shard >= _shards.size())
+    {
+        return Statistics{};
+    }
+    auto const& owner = *_shards[shard];
+    auto const rx = owner.rx.getStatistics();
+    return Statistics{ owner.frames.load(std::memory_order_relaxed), rx.drops, rx.highWatermark, owner.sent.load(std::memory_order_relaxed), owner.txDrops.load(std::memory_order_relaxed) };
+}
+
+uint64_t ShardedController::getUnclassifiedCount() const noexcept
+{
+    return _unclassified.load(std::memory_order_relaxed);
+}
+
+void ShardedController::dispatch(const uint8_t* frame, size_t const length)
+{
+    if (length < EtherLayer2::Length + AvtpduControl::HeaderLength || length > ETHERNET_MAX_FRAME_SIZE)
+    {
+        _unclassified.fetch_add(1u, std::memory_order_relaxed);
+        return;
+    }
+
+    auto identifierOffset = ControlIdentifierOffset;
+    switch (frame[EtherLayer2::Length])
+    {
+        case AVTP_SUBTYPE_ADP:
+        case AVTP_SUBTYPE_AECP:
+            break;
+        case AVTP_SUBTYPE_ACMP:
+            // Connections are listener state
+            identifierOffset = AcmpListenerOffset;
+            if (length < AcmpListenerOffset + 8u)
+            {
+                _unclassified.fetch_add(1u, std::memory_order_relaxed);
+                return;
+            }
+            break;
+        default:
+            _unclassified.fetch_add(1u, std::memory_order_relaxed);
+            return;
+    }
+
+    // Drops are counted by the ring
+    _shards[getShard(UniqueIdentifier{ readIdentifier(frame + identifierOffset) }, _shards.size())]->rx.push(frame, length);
+}
+
+void ShardedController::runIo()
+{
+    while (_running.load(std::memory_order_relaxed))
+    {
+        _transport.poll(_configuration.pollTimeout);
+
+        for (auto& shard : _shards)
+        {
+            while (auto const* const frame = shard->tx.front())
+            {
+                if (_transport.sendFrame(frame->data.data(), frame->length))
+                {
+                    shard->sent.fetch_add(1u, std::memory_order_relaxed);
+                }
+                shard->tx.release();
+            }
+        }
+        // All the shards' frames in one submission for batching transports
+        _transport.flush();
+    }
+}
+
+void ShardedController::runWorker(size_t const index)
+{
+    auto& shard = *_shards[index];
+    Task task;
+    while (_running.load(std::memory_order_relaxed))
+    {
+        auto busy = false;
+        for (auto i = size_t{ 0u }; i < MaxTasksPerIteration && shard.tasks.pop(task); ++i)
+        {
+            task();
+            task = nullptr;
+            busy = true;
+        }
+
+        // Bounded by the ring, so posted tasks are not starved either
+        auto const frames = shard.rx.drain([this, index](const uint8_t* frame, size_t const length)
+        {
+            _handler(index, frame, length);
+        }, shard.rx.getCapacity());
+        if (frames != 0u)
+        {
+            shard.frames.fetch_add(frames, std::memory_order_relaxed);
+            busy = true;
+        }
+
+        if (!busy)
+        {
+            std::this_thread::sleep_for(_configuration.idleSleep);
+        }
+    }
+}
+
+#endif // !ESP_PLATFORM
@@ -0,0 +1,679 @@
+#include "simulationHarness.hpp"
+
+#if !defined(ESP_PLATFORM)
+
+#include "acmpStateMachines.hpp"
+#include "controllerCommandScheduler.hpp"
+#include "entityModelTypes.hpp"
+#include "esp_log.h"
+#include "protocolAcmpdu.hpp"
+#include "protocolAdpdu.hpp"
+#include "protocolAemAecpdu.hpp"
+#include "protocolAemPayloads.hpp"
+#include "protocolAvtpdu.hpp"
+#include "serialization.hpp"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <thread>
+
+static const char* TAG = "SIMULATION";
+
+using SimulationClock = std::chrono::steady_clock;
+
+static constexpr uint64_t EntityIDBase = 0x020000fffe000000ull;
+static constexpr uint64_t ControllerID = 0x020000fffeffffffull;
+static constexpr auto DiscoverInterval = std::chrono::milliseconds{ 200 };
+static constexpr auto IdleSleep = std::chrono::microseconds{ 20 }; /** When idle, nothing signals the arrivals (see VirtualNetworkTransport) */
+
+/** Descriptor contents (the simulated entities only care about their size) */
+static std::array<uint8_t, AemAecpdu::MAXIMUM_SEND_PAYLOAD_BUFFER_LENGTH> const DescriptorPadding{};
+
+static MacAddress makeMacAddress(uint32_t const index) noexcept
+{
+    return MacAddress{ { 0x02, 0x00, static_cast<uint8_t>(index >> 24), static_cast<uint8_t>(index >> 16), static_cast<uint8_t>(index >> 8), static_cast<uint8_t>(index) } };
+}
+
+/** Writes the Ethernet header of an AVTP frame, returns its length */
+static size_t writeEthernetHeader(uint8_t* frame, MacAddress const& destination, MacAddress const& source)
+{
+    EtherLayer2 header;
+    header.setDestAddress(destination);
+    header.setSrcAddress(source);
+    header.setEtherType(AVTP_ETHER_TYPE);
+    SerBuffer ser;
+    header.serialize(ser);
+    std::memcpy(frame, ser.data(), ser.size());
+    return ser.size();
+}
+
+/** Sends an ADPDU to the ADP multicast group */
+static void sendAdpdu(NetworkTransport& transport, Adpdu& adpdu)
+{
+    adpdu.setDestAddress(Adpdu::Multicast_Mac_Address);
+    adpdu.setSrcAddress(transport.getMacAddress());
+    SerBuffer ser;
+    serialize<EtherLayer2>(adpdu, ser);
+    serialize<AvtpduControl>(adpdu, ser);
+    serialize<Adpdu>(adpdu, ser);
+    transport.sendFrame(ser.data(), ser.size());
+}
+
+static bool readAdpdu(const uint8_t* frame, size_t const length, Adpdu& adpdu)
+{
+    if (length < EtherLayer2::Length + AvtpduControl::HeaderLength + Adpdu::Length)
+    {
+        return false;
+    }
+    deserialize<EtherLayer2>(&adpdu, frame);
+    deserialize<AvtpduControl>(&adpdu, frame + EtherLayer2::Length);
+    deserialize<Adpdu>(&adpdu, frame + EtherLayer2::Length + AvtpduControl::HeaderLength);
+    return true;
+}
+
+/** Sends an AEM AECPDU to an entity or a controller */
+static void sendAemAecpdu(NetworkTransport& transport, AemAecpdu const& aecpdu, MacAddress const& destination)
+{
+    std::array<uint8_t, ETHERNET_MAX_FRAME_SIZE> frame{};
+    auto const headerLength = writeEthernetHeader(frame.data(), destination, transport.getMacAddress());
+    auto const length = aecpdu.serializeControl(frame.data() + headerLength, frame.size() - headerLength);
+    if (length != 0u)
+    {
+        transport.sendFrame(frame.data(), headerLength + length);
+    }
+}
+
+static bool readAemAecpdu(const uint8_t* frame, size_t const length, AemAecpdu& aecpdu)
+{
+    return length > EtherLayer2::Length && aecpdu.deserializeControl(frame + EtherLayer2::Length, length - EtherLayer2::Length);
+}
+
+/** Sends an ACMPDU to the ACMP multicast group */
+static void sendAcmpdu(NetworkTransport& transport, Acmpdu const& acmpdu)
+{
+    std::array<uint8_t, EtherLayer2::Length + Acmpdu::ControlHeaderLength + Acmpdu::Length> frame{};
+    auto const headerLength = writeEthernetHeader(frame.data(), Acmpdu::Multicast_Mac_Address, transport.getMacAddress());
+    auto const length = acmpdu.serializeControl(frame.data() + headerLength, frame.size() - headerLength);
+    transport.sendFrame(frame.data(), headerLength + length);
+}
+
+static bool readAcmpdu(const uint8_t* frame, size_t const length, Acmpdu& acmpdu)
+{
+    return length > EtherLayer2::Length && acmpdu.deserializeControl(frame + EtherLayer2::Length, length - EtherLayer2::Length);
+}
+
+/** Stream ID of the talker stream sources of an entity */
+static UniqueIdentifier makeStreamID(uint64_t const entityID, uint16_t const stream) noexcept
+{
+    return UniqueIdentifier{ (entityID << 16) | stream };
+}
+
+/***********************************************************/
+/* Simulated entity                                        */
+/***********************************************************/
+
+namespace
+{
+class SimulatedEntity
+{
+public:
+    SimulatedEntity(VirtualNetwork& network, uint32_t const index, SimulationEntityModel const& model)
+        : _model(model)
+        , _entityID(EntityIDBase + index)
+        , _transport(network, makeMacAddress(index))
+        , _talker(_entityID, model.talkerStreamSources, [this](Acmpdu const& acmpdu) { sendAcmpdu(_transport, acmpdu); })
+        , _listener(_entityID, model.listenerStreamSinks, [this](Acmpdu const& acmpdu) { sendAcmpdu(_transport, acmpdu); })
+    {
+        for (auto stream = uint16_t{ 0u }; stream < model.talkerStreamSources; ++stream)
+        {
+            _talker.setStreamInfo(stream, makeStreamID(_entityID.getValue(), stream), MacAddress{ { 0x91, 0xe0, 0xf0, 0x00, static_cast<uint8_t>(index >> 8), static_cast<uint8_t>(index) } }, 2u);
+        }
+        _transport.setFrameHandler([this](const uint8_t* frame, size_t const length)
+        {
+            onFrame(frame, length);
+        });
+    }
+
+    /** From the worker thread, before step() */
+    void start()
+    {
+        _transport.open();
+        _transport.joinAtdeccMulticast();
+        sendEntityAvailable();
+    }
+
+    /** Processes the received frames, returns true if there was something to do */
+    bool step(SimulationClock::time_point const now)
+    {
+        auto const delivered = _transport.poll(std::chrono::milliseconds{ 0 });
+        _listener.checkTimeouts(now);
+        return delivered != 0u;
+    }
+
+private:
+    void onFrame(const uint8_t* frame, size_t const length)
+    {
+        switch (frame[EtherLayer2::Length])
+        {
+            case AVTP_SUBTYPE_ADP:
+            {
+                Adpdu adpdu;
+                if (readAdpdu(frame, length, adpdu) && adpdu.getMessageType() == AdpMessageType::ENTITY_DISCOVER)
+                {
+                    auto const entityID = adpdu.getEntityID();
+                    if (entityID.getValue() == 0u || entityID == _entityID)
+                    {
+                        sendEntityAvailable();
+                    }
+                }
+                break;
+            }
+            case AVTP_SUBTYPE_AECP:
+            {
+                AemAecpdu command{ false };
+                if (readAemAecpdu(frame, length, command) && command.getMessageType() == AecpMessageType::AEM_COMMAND && command.getTargetEntityID() == _entityID)
+                {
+                    EtherLayer2 header;
+                    header.deserialize(frame);
+                    handleAemCommand(command, header.getSrcAddress());
+                }
+                break;
+            }
+            case AVTP_SUBTYPE_ACMP:
+            {
+                Acmpdu acmpdu;
+                if (readAcmpdu(frame, length, acmpdu))
+                {
+                    _talker.handleAcmpdu(acmpdu);
+                    _listener.handleAcmpdu(acmpdu);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    void sendEntityAvailable()
+    {
+        Adpdu adpdu;
+        adpdu.setMessageType(AdpMessageType::ENTITY_AVAILABLE);
+        adpdu.setValidTime(31u);
+        adpdu.setEntityID(_entityID);
+        adpdu.setEntityModelID(UniqueIdentifier{ _model.entityModelID });
+        adpdu.setTalkerStreamSources(_model.talkerStreamSources);
+        adpdu.setListenerStreamSinks(_model.listenerStreamSinks);
+        adpdu.setAvailableIndex(_availableIndex++);
+        sendAdpdu(_transport, adpdu);
+    }
+
+    void handleAemCommand(AemAecpdu const& command, MacAddress const& controllerAddress)
+    {
+        if (command.getCommandType() != AemCommandType::READ_DESCRIPTOR)
+        {
+            return;
+        }
+        auto [configurationIndex, descriptorType, descriptorIndex] = deserializeReadDescriptorCommand(command.getPayload());
+        // Fields are in network order
+        configurationIndex = ATDECC_UNPACK_WORD(configurationIndex);
+        descriptorType = static_cast<DescriptorType>(ATDECC_UNPACK_WORD(static_cast<uint16_t>(descriptorType)));
+        descriptorIndex = ATDECC_UNPACK_WORD(descriptorIndex);
+        auto const exists = (descriptorType == DescriptorType::Entity && descriptorIndex == 0u) || (descriptorType == DescriptorType::AudioCluster && descriptorIndex + 1u < _model.descriptorCount);
+
+        // The command fields are reflected, followed by the descriptor on success
+        auto response = command.responseCopy();
+        auto& aemResponse = static_cast<AemAecpdu&>(*response);
+        if (exists)
+        {
+            auto ser = serializeReadDescriptorCommonResponse(configurationIndex, descriptorType, descriptorIndex);
+            ser.packBuffer(DescriptorPadding.data(), std::min({ size_t{ _model.descriptorLength }, AemAecpdu::MAXIMUM_PAYLOAD_LENGTH_17221 - ser.usedBytes(), ser.remaining() }));
+            aemResponse.setCommandSpecificData(ser.data(), ser.usedBytes());
+        }
+        else
+        {
+            aemResponse.setStatus(AecpStatus::NO_SUCH_DESCRIPTOR);
+        }
+        sendAemAecpdu(_transport, aemResponse, controllerAddress);
+    }
+
+    SimulationEntityModel _model{};
+    UniqueIdentifier _entityID{};
+    VirtualNetworkTransport _transport;
+    AcmpTalkerStateMachine _talker;
+    AcmpListenerStateMachine _listener;
+    uint32_t _availableIndex{ 0u };
+};
+
+/***********************************************************/
+/* Simulated controller                                    */
+/***********************************************************/
+
+class SimulatedController
+{
+public:
+    SimulatedController(VirtualNetwork& network, SimulationConfiguration const& configuration)
+        : _configuration(configuration)
+        , _transport(network, makeMacAddress(0xffffffffu))
+        , _scheduler(UniqueIdentifier{ ControllerID }, [this](Aecpdu const& aecpdu, MacAddress const& destAddress) { sendAemAecpdu(_transport, static_cast<AemAecpdu const&>(aecpdu), destAddress); }, [this](Acmpdu const& acmpdu) { sendAcmpdu(_transport, acmpdu); }, makeSchedulerConfiguration(configuration))
+        , _remotes(configuration.entityCount)
+        , _connections(configuration.model.talkerStreamSources != 0u && configuration.model.listenerStreamSinks != 0u && configuration.entityCount > 1u ? configuration.entityCount : 0u)
+    {
+        _transport.setFrameHandler([this](const uint8_t* frame, size_t const length)
+        {
+            onFrame(frame, length);
+        });
+    }
+
+    /** Before the entities start, so that their first advertisements are received */
+    void start()
+    {
+        _transport.open();
+        _transport.joinAtdeccMulticast();
+    }
+
+    SimulationResults run()
+    {
+        auto results = SimulationResults{};
+        results.entityCount = _configuration.entityCount;
+
+        auto const start = SimulationClock::now();
+        auto const deadline = start + _configuration.timeout;
+        auto phase = Phase::Discovery;
+        auto phaseStart = start;
+        auto nextDiscover = start;
+
+        auto now = start;
+        while (phase != Phase::Done && now < deadline)
+        {
+            auto const delivered = _transport.poll(std::chrono::milliseconds{ 0 });
+            now = SimulationClock::now();
+            _scheduler.poll(now);
+
+            switch (phase)
+            {
+                case Phase::Discovery:
+                    if (_discovered == _remotes.size())
+                    {
+                        results.adpConvergence = std::chrono::duration_cast<std::chrono::microseconds>(now - start);
+                        phase = Phase::Enumeration;
+                        phaseStart = now;
+                    }
+                    else if (now >= nextDiscover)
+                    {
+                        sendEntityDiscover();
+                        nextDiscover = now + DiscoverInterval;
+                    }
+                    break;
+                case Phase::Enumeration:
+                    enumerate(now);
+                    if (_enumerated == _remotes.size())
+                    {
+                        results.enumeration = std::chrono::duration_cast<std::chrono::microseconds>(now - phaseStart);
+                        phase = Phase::Connection;
+                        phaseStart = now;
+                    }
+                    break;
+                case Phase::Connection:
+                    connect(now);
+                    if (_connectionsDone == _connections.size())
+                    {
+                        phase = Phase::Done;
+                    }
+                    break;
+                default:
+                    break;
+            }
+
+            if (delivered == 0u)
+            {
+                std::this_thread::sleep_for(IdleSleep);
+            }
+        }
+
+        results.discovered = _discovered;
+        results.enumerated = _enumerated;
+        results.connected = _connected;
+        results.commandRetries = _retries;
+        results.streamIdMismatches = _streamIdMismatches;
+        results.completed = phase == Phase::Done;
+        if (!_latencies.empty())
+        {
+            std::sort(_latencies.begin(), _latencies.end());
+            auto total = std::chrono::microseconds{ 0 };
+            for (auto const latency : _latencies)
+            {
+                total += latency;
+            }
+            results.connectAverage = total / static_cast<int64_t>(_latencies.size());
+            results.connectP99 = _latencies[(_latencies.size() - 1u) * 99u / 100u];
+            results.connectMaximum = _latencies.back();
+        }
+        _transport.close();
+        return results;
+    }
+
+private:
+    enum class Phase
+    {
+        Discovery,
+        Enumeration,
+        Connection,
+        Done,
+    };
+
+    struct Remote
+    {
+        MacAddress macAddress{};
+        bool discovered{ false };
+        bool enumerating{ false };
+        bool enumerated{ false };
+        uint16_t nextDescriptor{ 0u };
+        uint16_t sequenceID{ 0u };
+        SimulationClock::time_point sentAt{};
+    };
+
+    struct Connection
+    {
+        bool started{ false };
+        bool done{ false };
+        uint16_t sequenceID{ 0u };
+        SimulationClock::time_point firstSentAt{};
+        SimulationClock::time_point sentAt{};
+    };
+
+    static CommandSchedulerConfiguration makeSchedulerConfiguration(SimulationConfiguration const& configuration)
+    {
+        auto schedulerConfiguration = CommandSchedulerConfiguration{};
+        schedulerConfiguration.maxInflight[static_cast<size_t>(CommandClass::Connection)] = configuration.window;
+        schedulerConfiguration.maxInflight[static_cast<size_t>(CommandClass::Enumeration)] = configuration.window;
+        schedulerConfiguration.maxBackgroundInflight = configuration.window;
+        schedulerConfiguration.timing.initialTimeout = configuration.commandTimeout;
+        schedulerConfiguration.acmpTimeout = configuration.commandTimeout;
+        return schedulerConfiguration;
+    }
+
+    void onFrame(const uint8_t* frame, size_t const length)
+    {
+        switch (frame[EtherLayer2::Length])
+        {
+            case AVTP_SUBTYPE_ADP:
+            {
+                Adpdu adpdu;
+                if (readAdpdu(frame, length, adpdu) && adpdu.getMessageType() == AdpMessageType::ENTITY_AVAILABLE)
+                {
+                    if (auto* const remote = findRemote(adpdu.getEntityID().getValue()))
+                    {
+                        if (!remote->discovered)
+                        {
+                            remote->discovered = true;
+                            remote->macAddress = adpdu.getSrcAddress();
+                            ++_discovered;
+                        }
+                    }
+                }
+                break;
+            }
+            case AVTP_SUBTYPE_AECP:
+            {
+                AemAecpdu response{ true };
+                if (readAemAecpdu(frame, length, response) && response.getMessageType() == AecpMessageType::AEM_RESPONSE && response.getControllerEntityID().getValue() == ControllerID)
+                {
+                    _scheduler.handleAecpdu(response);
+                    handleAemResponse(response);
+                }
+                break;
+            }
+            case AVTP_SUBTYPE_ACMP:
+            {
+                Acmpdu acmpdu;
+                if (readAcmpdu(frame, length, acmpdu) && acmpdu.getMessageType() == AcmpMessageType::CONNECT_RX_RESPONSE && acmpdu.getControllerEntityID().getValue() == ControllerID)
+                {
+                    _scheduler.handleAcmpdu(acmpdu);
+                    handleConnectRxResponse(acmpdu);
+                }
+                break;
+            }
+            default:
+                break;
+        }
+    }
+
+    Remote* findRemote(uint64_t const entityID) noexcept
+    {
+        auto const index = entityID - EntityIDBase;
+        return entityID >= EntityIDBase && index < _remotes.size() ? &_remotes[index] : nullptr;
+    }
+
+    void sendEntityDiscover()
+    {
+        Adpdu adpdu;
+        adpdu.setMessageType(AdpMessageType::ENTITY_DISCOVER);
+        sendAdpdu(_transport, adpdu);
+    }
+
+    void enumerate(SimulationClock::time_point const now)
+    {
+        for (auto index = size_t{ 0u }; index < _remotes.size(); ++index)
+        {
+            auto& remote = _remotes[index];
+            if (remote.enumerating && now - remote.sentAt >= _scheduler.getTimeout(UniqueIdentifier{ EntityIDBase + index }))
+            {
+                ++_retries;
+                sendReadDescriptor(remote, now);
+            }
+        }
+        while (_enumerating < _configuration.window && _nextToEnumerate < _remotes.size())
+        {
+            auto& remote = _remotes[_nextToEnumerate++];
+            remote.enumerating = true;
+            ++_enumerating;
+            readNextDescriptor(remote, now);
+        }
+    }
+
+    void readNextDescriptor(Remote& remote, SimulationClock::time_point const now)
+    {
+        remote.sequenceID = _sequenceID++;
+        sendReadDescriptor(remote, now);
+    }
+
+    /** Retries keep the sequence ID, so the scheduler sees them as retries */
+    void sendReadDescriptor(Remote& remote, SimulationClock::time_point const now)
+    {
+        auto const index = static_cast<size_t>(&remote - _remotes.data());
+        auto const descriptorType = remote.nextDescriptor == 0u ? DescriptorType::Entity : DescriptorType::AudioCluster;
+        auto const descriptorIndex = static_cast<DescriptorIndex>(remote.nextDescriptor == 0u ? 0u : remote.nextDescriptor - 1u);
+        auto const payload = serializeReadDescriptorCommand(0u, descriptorType, descriptorIndex);
+
+        AemAecpdu command{ false };
+        command.setTargetEntityID(UniqueIdentifier{ EntityIDBase + index });
+        command.setControllerEntityID(UniqueIdentifier{ ControllerID });
+        command.setSequenceID(remote.sequenceID);
+        command.setCommandType(AemCommandType::READ_DESCRIPTOR);
+        command.setCommandSpecificData(payload.data(), payload.usedBytes());
+        remote.sentAt = now;
+        _scheduler.sendAecpdu(CommandClass::Enumeration, command, remote.macAddress, now);
+    }
+
+    void handleAemResponse(AemAecpdu const& response)
+    {
+        auto* const remote = findRemote(response.getTargetEntityID().getValue());
+        if (remote == nullptr || !remote->enumerating || response.getSequenceID() != remote->sequenceID)
+        {
+            return;
+        }
+        ++remote->nextDescriptor;
+        if (remote->nextDescriptor < _configuration.model.descriptorCount)
+        {
+            readNextDescriptor(*remote, SimulationClock::now());
+            return;
+        }
+        remote->enumerating = false;
+        remote->enumerated = true;
+        --_enumerating;
+        ++_enumerated;
+    }
+
+    void connect(SimulationClock::time_point const now)
+    {
+        for (auto& connection : _connections)
+        {
+            if (connection.started && !connection.done && now - connection.sentAt >= _configuration.commandTimeout)
+            {
+                ++_retries;
+                sendConnectRx(connection, now);
+            }
+        }
+        while (_connecting < _configuration.window && _nextToConnect < _connections.size())
+        {
+            auto& connection = _connections[_nextToConnect++];
+            connection.started = true;
+            connection.firstSentAt = now;
+            connection.sequenceID = _sequenceID++;
+            ++_connecting;
+            sendConnectRx(connection, now);
+        }
+    }
+
+    /** Retries keep the sequence ID, so the scheduler sees them as retries */
+    void sendConnectRx(Connection& connection, SimulationClock::time_point const now)
+    {
+        // Listener n listens to the first stream of entity n + 1
+        auto const listener = static_cast<size_t>(&connection - _connections.data());
+        auto const talker = (listener + 1u) % _remotes.size();
+        connection.sentAt = now;
+
+        auto acmpdu = Acmpdu::createConnectRxCommand();
+        acmpdu.setControllerEntityID(UniqueIdentifier{ ControllerID });
+        acmpdu.setTalkerEntityID(UniqueIdentifier{ EntityIDBase + talker });
+        acmpdu.setListenerEntityID(UniqueIdentifier{ EntityIDBase + listener });
+        acmpdu.setTalkerUniqueID(0u);
+        acmpdu.setListenerUniqueID(0u);
+        acmpdu.setSequenceID(connection.sequenceID);
+        _scheduler.sendAcmpdu(CommandClass::Connection, acmpdu, now);
+    }
+
+    void handleConnectRxResponse(Acmpdu const& response)
+    {
+        auto const listener = response.getListenerEntityID().getValue() - EntityIDBase;
+        if (listener >= _connections.size())
+        {
+            return;
+        }
+        auto& connection = _connections[listener];
+        if (!connection.started || connection.done || response.getSequenceID() != connection.sequenceID)
+        {
+            return;
+        }
+        connection.done = true;
+        --_connecting;
+        ++_connectionsDone;
+        if (response.getStatus() == AcmpStatus::SUCCESS)
+        {
+            // The stream ID travels in the AVTP control header, from the talker through the listener
+            auto const talker = EntityIDBase + (listener + 1u) % _remotes.size();
+            if (response.getStreamID() != makeStreamID(talker, 0u))
+            {
+                ++_streamIdMismatches;
+            }
+            ++_connected;
+            _latencies.push_back(std::chrono::duration_cast<std::chrono::microseconds>(SimulationClock::now() - connection.firstSentAt));
+        }
+    }
+
+    SimulationConfiguration _configuration{};
+    VirtualNetworkTransport _transport;
+    ControllerCommandScheduler _scheduler;
+    std::vector<Remote> _remotes{};
+    std::vector<Connection> _connections{};
+    std::vector<std::chrono::microseconds> _latencies{};
+    size_t _discovered{ 0u };
+    size_t _enumerating{ 0u };
+    size_t _enumerated{ 0u };
+    size_t _nextToEnumerate{ 0u };
+    size_t _connecting{ 0u };
+    size_t _connectionsDone{ 0u };
+    size_t _connected{ 0u };
+    size_t _nextToConnect{ 0u };
+    uint32_t _retries{ 0u };
+    uint32_t _streamIdMismatches{ 0u };
+    uint16_t _sequenceID{ 0u };
+};
+} // namespace
+
+/***********************************************************/
+/* SimulationHarness class definition                      */
+/***********************************************************/
+
+SimulationHarness::Results SimulationHarness::run(Configuration const& configuration)
+{
+    VirtualNetwork network{ configuration.network };
+
+    std::vector<std::unique_ptr<SimulatedEntity>> entities;
+    entities.reserve(configuration.entityCount);
+    for (auto i = size_t{ 0u }; i < configuration.entityCount; ++i)
+    {
+        entities.push_back(std::make_unique<SimulatedEntity>(network, static_cast<uint32_t>(i), configuration.model));
+    }
+
+    // Controller listening before the entities start, so it sees their first advertisements
+    SimulatedController controller{ network, configuration };
+    controller.start();
+
+    std::atomic<bool> running{ true };
+    std::vector<std::thread> workers;
+    auto const workerCount = std::max<size_t>(configuration.workerThreads, 1u);
+    for (auto worker = size_t{ 0u }; worker < workerCount; ++worker)
+    {
+        workers.emplace_back([&entities, &running, worker, workerCount]()
+        {
+            for (auto i = worker; i < entities.size(); i += workerCount)
+            {
+                entities[i]->start();
+            }
+            while (running.load(std::memory_order_relaxed))
+            {
+                auto busy = false;
+                auto const now = SimulationClock::now();
+                for (auto i = worker; i < entities.size(); i += workerCount)
+                {
+                    busy |= entities[i]->step(now);
+                }
+                if (!busy)
+                {
+                    std::this_thread::sleep_for(IdleSleep);
+                }
+            }
+        });
+    }
+
+    auto results = controller.run();
+    running = false;
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+    results.network = network.getStatistics();
+
+    ESP_LOGI(TAG, "%zu entities: discovered %zu in %lld us, enumerated %zu in %lld us, connected %zu (avg %lld us, p99 %lld us, max %lld us), %u retries, %u stream ID mismatches, %llu frames",
+        results.entityCount, results.discovered, static_cast<long long>(results.adpConvergence.count()), results.enumerated, static_cast<long long>(results.enumeration.count()),
+        results.connected, static_cast<long long>(results.connectAverage.count()), static_cast<long long>(results.connectP99.count()), static_cast<long long>(results.connectMaximum.count()),
+        results.commandRetries, results.streamIdMismatches, static_cast<unsigned long long>(results.network.sent));
+    return results;
+}
+
+std::vector<SimulationHarness::Results> SimulationHarness::runScaling(Configuration const& configuration, std::vector<size_t> const& entityCounts)
+{
+    std::vector<Results> results;
+    results.reserve(entityCounts.size());
+    for (auto const entityCount : entityCounts)
+    {
+        auto runConfiguration = configuration;
+        runConfiguration.entityCount = entityCount;
+        results.push_back(run(runConfiguration));
+    }
+    return results;
+}
+
+#endif // !ESP_PLATFORM
@@ -0,0 +1,227 @@
+#include "timerWheel.hpp"
+#include "esp_log.h"
+#include <algorithm>
+#include <utility>
+
+static const char* TAG = "TIMER_WHEEL";
+
+static constexpr uint64_t SlotMask = TimerWheel::SlotsPerLevel - 1u;
+
+/***********************************************************/
+/* TimerWheel class definition                             */
+/***********************************************************/
+
+TimerWheel::TimerWheel(size_t const capacity, Tick const now)
+    : _entries(std::min<size_t>(capacity, NoEntry)), _currentTick(now)
+{
+    for (auto& level : _levels)
+    {
+        level.heads.fill(NoEntry);
+    }
+    // All the entries are free
+    for (auto i = size_t{ 0u }; i < _entries.size(); ++i)
+    {
+        _entries[i].next = i + 1u < _entries.size() ? static_cast<uint16_t>(i + 1u) : NoEntry;
+    }
+    _freeHead = _entries.empty() ? NoEntry : 0u;
+}
+
+TimerWheel::TimerId TimerWheel::start(Tick const delay, Callback callback)
+{
+    if (_freeHead == NoEntry)
+    {
+        ESP_LOGE(TAG, "No free timer (%zu running)", _activeCount);
+        return InvalidTimer;
+    }
+    auto const index = _freeHead;
+    auto& entry = _entries[index];
+    _freeHead = entry.next;
+
+    entry.callback = std::move(callback);
+    entry.expiry = _currentTick + std::clamp<Tick>(delay, 1u, MaxDelay);
+    entry.active = true;
+    link(index);
+    ++_activeCount;
+    return (static_cast<TimerId>(entry.generation) << 16) | index;
+}
+
+bool TimerWheel::cancel(TimerId const timerId) noexcept
+{
+    auto const index = static_cast<uint16_t>(timerId & 0xffff);
+    if (index >= _entries.size())
+    {
+        return false;
+    }
+    auto& entry = _entries[index];
+    if (!entry.active || entry.generation != static_cast<uint16_t>(timerId >> 16))
+    {
+        return false;
+    }
+    unlink(index);
+    entry.active = false;
+    entry.callback = nullptr;
+    entry.generation = entry.generation == 0xffff ? 1u : entry.generation + 1u;
+    entry.next = _freeHead;
+    _freeHead = index;
+    --_activeCount;
+    return true;
+}
+
+size_t TimerWheel::advance(Tick const now)
+{
+    auto fired = size_t{ 0u };
+    while (_currentTick < now)
+    {
+        // Skip the ticks without anything to do
+        auto const toNext = getTicksToNextEvent();
+        if (toNext == NoTimer || toNext > now - _currentTick)
+        {
+            _currentTick = now;
+            break;
+        }
+        _currentTick += toNext;
+
+        if ((_currentTick & SlotMask) == 0u)
+        {
+            for (auto level = size_t{ 1u }; level < Levels; ++level)
+            {
+                auto const slot = (_currentTick >> (SlotBits * level)) & SlotMask;
+                cascade(level);
+                if (slot != 0u)
+                {
+                    break;
+                }
+            }
+        }
+        fired += expireSlot(_currentTick & SlotMask);
+    }
+    return fired;
+}
+
+TimerWheel::Tick TimerWheel::getTicksToNextEvent() const noexcept
+{
+    if (_activeCount == 0u)
+    {
+        return NoTimer;
+    }
+
+    auto const position = static_cast<unsigned>(_currentTick & SlotMask);
+    auto result = NoTimer;
+
+    // Level 0 slots are always ahead of the current one: rotate so the next slot is bit 0
+    auto const occupied = _levels[0].occupied;
+    if (occupied != 0u)
+    {
+        auto const rotated = position == SlotMask ? occupied : (occupied >> (position + 1u)) | (occupied << (SlotMask - position));
+        result = static_cast<Tick>(__builtin_ctzll(rotated)) + 1u;
+    }
+
+    // Timers of the upper levels may come down at the next turn of level 0
+    for (auto level = size_t{ 1u }; level < Levels; ++level)
+    {
+        if (_levels[level].occupied != 0u)
+        {
+            result = std::min<Tick>(result, SlotsPerLevel - position);
+            break;
+        }
+    }
+    return result;
+}
+
+TimerWheel::Tick TimerWheel::getCurrentTick() const noexcept
+{
+    return _currentTick;
+}
+
+size_t TimerWheel::getActiveCount() const noexcept
+{
+    return _activeCount;
+}
+
+size_t TimerWheel::getCapacity() const noexcept
+{
+    return _entries.size();
+}
+
+void TimerWheel::link(uint16_t const index) noexcept
+{
+    auto& entry = _entries[index];
+    auto const delta = entry.expiry - _currentTick;
+    auto level = size_t{ 0u };
+    while (level + 1u < Levels && delta >= (Tick{ 1u } << (SlotBits * (level + 1u))))
+    {
+        ++level;
+    }
+    auto const slot = static_cast<uint8_t>((entry.expiry >> (SlotBits * level)) & SlotMask);
+
+    auto& head = _levels[level].heads[slot];
+    entry.level = static_cast<uint8_t>(level);
+    entry.slot = slot;
+    entry.previous = NoEntry;
+    entry.next = head;
+    if (head != NoEntry)
+    {
+        _entries[head].previous = index;
+    }
+    head = index;
+    _levels[level].occupied |= uint64_t{ 1u } << slot;
+}
+
+void TimerWheel::unlink(uint16_t const index) noexcept
+{
+    auto& entry = _entries[index];
+    auto& level = _levels[entry.level];
+    if (entry.previous != NoEntry)
+    {
+        _entries[entry.previous].next = entry.next;
+    }
+    else
+    {
+        level.heads[entry.slot] = entry.next;
+    }
+    if (entry.next != NoEntry)
+    {
+        _entries[entry.next].previous = entry.previous;
+    }
+    if (level.heads[entry.slot] == NoEntry)
+    {
+        level.occupied &= ~(uint64_t{ 1u } << entry.slot);
+    }
+}
+
+void TimerWheel::cascade(size_t const level)
+{
+    auto const slot = (_currentTick >> (SlotBits * level)) & SlotMask;
+    auto& levelSlots = _levels[level];
+    auto index = levelSlots.heads[slot];
+    levelSlots.heads[slot] = NoEntry;
+    levelSlots.occupied &= ~(uint64_t{ 1u } << slot);
+
+    // Closer now, so they land in a lower level
+    while (index != NoEntry)
+    {
+        auto const next = _entries[index].next;
+        link(index);
+        index = next;
+    }
+}
+
+size_t TimerWheel::expireSlot(size_t const slot)
+{
+    auto fired = size_t{ 0u };
+    auto& level = _levels[0];
+    while (level.heads[slot] != NoEntry)
+    {
+        auto const index = level.heads[slot];
+        auto& entry = _entries[index];
+        // Released before the call, so the callback can start timers (even reusing this entry)
+        auto callback = std::move(entry.callback);
+        cancel((static_cast<TimerId>(entry.generation) << 16) | index);
+        if (callback)
+        {
+            callback();
+        }
+        ++fired;
+    }
+    return fired;
+}
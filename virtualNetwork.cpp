@@ -0,0 +1,263 @@
+#include "virtualNetwork.hpp"
+
+#if !defined(ESP_PLATFORM)
+
+#include "esp_log.h"
+#include "protocolAvtpdu.hpp"
+#include "serialization.hpp"
+#include <algorithm>
+#include <mutex>
+#include <thread>
+
+static const char* TAG = "VIRTUAL_NET";
+
+/** Minimum Ethernet frame without FCS */
+static constexpr size_t MinimumFrameLength = EtherLayer2::Length + EthernetPayloadMinimumSize;
+
+/** Uniform value in [0, 1) from 64 random bits */
+static double toUnit(uint64_t const value) noexcept
+{
+    return static_cast<double>(value >> 11) * (1.0 / 9007199254740992.0);
+}
+
+/***********************************************************/
+/* VirtualNetwork class definition                         */
+/***********************************************************/
+
+VirtualNetwork::VirtualNetwork(Configuration const& configuration) noexcept
+    : _configuration(configuration), _randomState(configuration.seed)
+{
+}
+
+VirtualNetwork::Configuration const& VirtualNetwork::getConfiguration() const noexcept
+{
+    return _configuration;
+}
+
+VirtualNetwork::Statistics VirtualNetwork::getStatistics() const noexcept
+{
+    auto statistics = Statistics{};
+    statistics.sent = _sent.load(std::memory_order_relaxed);
+    statistics.delivered = _delivered.load(std::memory_order_relaxed);
+    statistics.lost = _lost.load(std::memory_order_relaxed);
+    statistics.reordered = _reordered.load(std::memory_order_relaxed);
+    statistics.overflows = _overflows.load(std::memory_order_relaxed);
+    return statistics;
+}
+
+void VirtualNetwork::attach(VirtualNetworkTransport& endpoint)
+{
+    std::unique_lock<std::shared_mutex> lock{ _endpointsLock };
+    if (std::find(_endpoints.begin(), _endpoints.end(), &endpoint) == _endpoints.end())
+    {
+        _endpoints.push_back(&endpoint);
+    }
+}
+
+void VirtualNetwork::detach(VirtualNetworkTransport& endpoint)
+{
+    std::unique_lock<std::shared_mutex> lock{ _endpointsLock };
+    _endpoints.erase(std::remove(_endpoints.begin(), _endpoints.end(), &endpoint), _endpoints.end());
+}
+
+bool VirtualNetwork::updateMembership(VirtualNetworkTransport& endpoint, MacAddress const& group, bool const join)
+{
+    std::unique_lock<std::shared_mutex> lock{ _endpointsLock };
+    auto const begin = endpoint._groups.begin();
+    auto const end = begin + endpoint._groupCount;
+    auto const it = std::find(begin, end, group);
+    if (join)
+    {
+        if (it != end)
+        {
+            return true;
+        }
+        if (endpoint._groupCount >= VirtualNetworkTransport::MaxGroups)
+        {
+            ESP_LOGE(TAG, "Too many multicast groups");
+            return false;
+        }
+        endpoint._groups[endpoint._groupCount++] = group;
+        return true;
+    }
+    if (it != end)
+    {
+        *it = endpoint._groups[--endpoint._groupCount];
+    }
+    return true;
+}
+
+bool VirtualNetwork::send(VirtualNetworkTransport const& source, const uint8_t* frame, size_t const length)
+{
+    auto data = std::make_shared<std::vector<uint8_t>>(std::max(length, MinimumFrameLength), uint8_t{ 0u });
+    std::copy(frame, frame + length, data->begin());
+    auto const shared = std::shared_ptr<std::vector<uint8_t> const>{ std::move(data) };
+    auto const now = std::chrono::steady_clock::now();
+    _sent.fetch_add(1u, std::memory_order_relaxed);
+
+    MacAddress destination;
+    std::copy(frame, frame + destination.size(), destination.begin());
+    auto const multicast = (destination[0] & 0x01) != 0u;
+
+    std::shared_lock<std::shared_mutex> lock{ _endpointsLock };
+    for (auto* const endpoint : _endpoints)
+    {
+        if (endpoint == &source)
+        {
+            continue;
+        }
+        if (multicast ? endpoint->isMember(destination) : endpoint->getMacAddress() == destination)
+        {
+            enqueue(*endpoint, shared, now);
+            if (!multicast)
+            {
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+void VirtualNetwork::enqueue(VirtualNetworkTransport& receiver, std::shared_ptr<std::vector<uint8_t> const> const& data, std::chrono::steady_clock::time_point const now)
+{
+    if (_configuration.lossRate > 0.0 && toUnit(nextRandom()) < _configuration.lossRate)
+    {
+        _lost.fetch_add(1u, std::memory_order_relaxed);
+        return;
+    }
+
+    auto delay = std::chrono::duration_cast<std::chrono::steady_clock::duration>(_configuration.latency);
+    if (_configuration.jitter.count() > 0)
+    {
+        delay += std::chrono::microseconds{ static_cast<int64_t>(nextRandom() % static_cast<uint64_t>(_configuration.jitter.count() + 1)) };
+    }
+    if (_configuration.reorderRate > 0.0 && toUnit(nextRandom()) < _configuration.reorderRate)
+    {
+        delay += _configuration.reorderDelay;
+        _reordered.fetch_add(1u, std::memory_order_relaxed);
+    }
+
+    if (!receiver._queue.push(Frame{ data, now + delay }))
+    {
+        _overflows.fetch_add(1u, std::memory_order_relaxed);
+        return;
+    }
+    _delivered.fetch_add(1u, std::memory_order_relaxed);
+}
+
+uint64_t VirtualNetwork::nextRandom() noexcept
+{
+    // splitmix64 over an atomic counter: lock-free, and reproducible from the seed for a given send order
+    auto z = _randomState.fetch_add(0x9e3779b97f4a7c15ull, std::memory_order_relaxed) + 0x9e3779b97f4a7c15ull;
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+/***********************************************************/
+/* VirtualNetworkTransport class definition                */
+/***********************************************************/
+
+VirtualNetworkTransport::VirtualNetworkTransport(VirtualNetwork& network, MacAddress const& macAddress)
+    : _network(network)
+{
+    _macAddress = macAddress;
+}
+
+VirtualNetworkTransport::~VirtualNetworkTransport() noexcept
+{
+    close();
+}
+
+bool VirtualNetworkTransport::open()
+{
+    if (!_open)
+    {
+        _network.attach(*this);
+        _open = true;
+    }
+    return true;
+}
+
+void VirtualNetworkTransport::close() noexcept
+{
+    if (_open)
+    {
+        _network.detach(*this);
+        _open = false;
+    }
+}
+
+bool VirtualNetworkTransport::sendFrame(const uint8_t* frame, size_t const length)
+{
+    if (!_open || frame == nullptr || length < EtherLayer2::Length || length > ETHERNET_MAX_FRAME_SIZE)
+    {
+        return false;
+    }
+    return _network.send(*this, frame, length);
+}
+
+bool VirtualNetworkTransport::joinMulticast(MacAddress const& macAddress)
+{
+    return _network.updateMembership(*this, macAddress, true);
+}
+
+bool VirtualNetworkTransport::leaveMulticast(MacAddress const& macAddress)
+{
+    return _network.updateMembership(*this, macAddress, false);
+}
+
+size_t VirtualNetworkTransport::poll(std::chrono::milliseconds const timeout)
+{
+    auto now = std::chrono::steady_clock::now();
+    auto delivered = deliverDue(now);
+    if (delivered != 0u || timeout.count() <= 0)
+    {
+        return delivered;
+    }
+
+    auto const deadline = now + timeout;
+    while (delivered == 0u && now < deadline)
+    {
+        // Until the next check, or the earliest delayed frame if due before
+        auto wakeUp = std::min(deadline, now + PollInterval);
+        if (!_pending.empty())
+        {
+            wakeUp = std::min(wakeUp, _pending.top().deliverAt);
+        }
+        std::this_thread::sleep_until(wakeUp);
+        now = std::chrono::steady_clock::now();
+        delivered = deliverDue(now);
+    }
+    return delivered;
+}
+
+bool VirtualNetworkTransport::isMember(MacAddress const& group) const noexcept
+{
+    auto const end = _groups.begin() + _groupCount;
+    return std::find(_groups.begin(), end, group) != end;
+}
+
+size_t VirtualNetworkTransport::deliverDue(std::chrono::steady_clock::time_point const now)
+{
+    auto frame = VirtualNetwork::Frame{};
+    while (_queue.pop(frame))
+    {
+        _pending.push(std::move(frame));
+    }
+
+    auto delivered = size_t{ 0u };
+    while (!_pending.empty() && _pending.top().deliverAt <= now)
+    {
+        // Keep the frame alive during the handler, the heap entry goes away first
+        auto const data = _pending.top().data;
+        _pending.pop();
+        if (_open && dispatchFrame(data->data(), data->size()))
+        {
+            ++delivered;
+        }
+    }
+    return delivered;
+}
+
+#endif // !ESP_PLATFORM